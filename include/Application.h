@@ -19,6 +19,7 @@
 #include "socket/UdpSocket.h"
 #include "socket/TcpSocket.h"
 #include "asn1/BerOid.h"
+#include "notify/NotificationReceiver.h"
 
 // Defines
 #define SOC_ALIGN               0x1000
@@ -76,6 +77,7 @@ class Application {
         std::shared_ptr<UdpSocket> trapv3Sock;
         std::shared_ptr<UdpSocket> syslogUdpSock;
         std::shared_ptr<TcpSocket> syslogTcpSock;
+        std::shared_ptr<NotificationReceiver> receiver;
         std::vector<PduField> pduFields;
 		Application();
 		virtual ~Application();
@@ -97,6 +99,7 @@ class Application {
         inline std::shared_ptr<UdpSocket> getTrapv3Sock() { return trapv3Sock; }
         inline std::shared_ptr<UdpSocket> getSyslogUdpSock() { return syslogUdpSock; }
         inline std::shared_ptr<TcpSocket> getSyslogTcpSock() { return syslogTcpSock; }
+        inline std::shared_ptr<NotificationReceiver> getReceiver() { return receiver; }
         inline std::vector<PduField> &getPduFields() { return pduFields; }
 };
 
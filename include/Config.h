@@ -13,8 +13,9 @@
 #define CONFIG_PATH             "config.dat"
 #define DEFAULT_SNMP_PORT       1161
 #define DEFAULT_TRAP_PORT       1162
-#define DEFAULT_TRAP_LIMIT      30
-#define DEFAULT_SYSLOG_LIMIT    30
+#define DEFAULT_TRAP_LIMIT      10000
+#define DEFAULT_SYSLOG_LIMIT    10000
+#define MAX_LOG_LIMIT           99999   /**< Records kept by a log, at most (the numpad takes 5 digits) */
 #define DEFAULT_TIMEOUT         10
 #define DEFAULT_SYSLOG_PORT     5140
 
@@ -16,6 +16,8 @@
 #include "gui/EditTextView.h"
 #include "controller/SnmpParamsController.h"
 #include "controller/RestConfOpController.h"
+#include "snmp/SnmpPoller.h"
+#include "snmp/SnmpTable.h"
 
 namespace NetMan {
 
@@ -32,6 +34,8 @@ class Utils {
         static std::shared_ptr<json_t> loadJsonList(const std::string &path);
         static bool endsWith(const std::string &mainStr, const std::string &toMatch);
         static void sendSnmpPdu(SnmpThreadParams *params);
+        static void fetchSnmpTable(SnmpThreadParams *params, std::shared_ptr<SnmpTable> table);
+        static std::shared_ptr<SnmpPoller> pollSnmpOids(SnmpThreadParams *params, const std::vector<CompactOid> &oids, u32 interval, SnmpPollerCallback callback, void *args);
         static void sendRestConf(std::shared_ptr<RestConfParams> params);
 };
 
@@ -0,0 +1,91 @@
+/**
+ * @file BerArena.h
+ * @brief Monotonic arena for BER field trees
+ */
+
+#ifndef BERARENA_H_
+#define BERARENA_H_
+
+// Includes C/C++
+#include <stddef.h>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Own includes
+#include <3ds/types.h>
+
+// Defines
+#define BERARENA_CHUNK_SIZE		(4 << 10)
+
+namespace NetMan {
+
+/**
+ * @class BerArena
+ * @brief Monotonic allocator: memory is only given back all at once, with reset()
+ * @note Chunks are kept between resets, so a PDU which is reused does not touch the heap once warmed up
+ */
+class BerArena {
+	private:
+		std::vector<u8*> chunks;
+		std::vector<u32> chunkSizes;
+		u32 curChunk;			/**< Chunk being used */
+		u32 offset;				/**< First free byte in the current chunk */
+		u32 used;				/**< Bytes given since the last reset */
+		u32 peak;				/**< Maximum bytes given between two resets */
+		u32 capacity;			/**< Bytes held in chunks */
+		BerArena(const BerArena &) = delete;
+		BerArena &operator=(const BerArena &) = delete;
+	public:
+		BerArena();
+		~BerArena();
+		void *allocate(size_t size, size_t alignment);
+		void reset();
+		inline u32 getUsed() { return used; }
+		inline u32 getPeak() { return peak; }
+		inline u32 getCapacity() { return capacity; }
+		inline u32 getNChunks() { return chunks.size(); }
+};
+
+/**
+ * @class BerArenaAllocator
+ * @brief Standard allocator over a BerArena, falling back to the heap if there is no arena
+ * @note Each allocator keeps the arena alive, so objects living in it never outlive their memory
+ */
+template <class T>
+class BerArenaAllocator {
+	public:
+		typedef T value_type;
+		std::shared_ptr<BerArena> arena;
+		BerArenaAllocator(const std::shared_ptr<BerArena> &arena = nullptr) : arena(arena) { }
+		template <class U> BerArenaAllocator(const BerArenaAllocator<U> &other) : arena(other.arena) { }
+		T *allocate(size_t n) {
+			if(arena == nullptr) return static_cast<T*>(::operator new(n * sizeof(T)));
+			return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+		}
+		void deallocate(T *ptr, size_t n) {
+			if(arena == nullptr) ::operator delete(ptr);
+		}
+};
+
+template <class T, class U>
+inline bool operator==(const BerArenaAllocator<T> &a, const BerArenaAllocator<U> &b) { return a.arena == b.arena; }
+
+template <class T, class U>
+inline bool operator!=(const BerArenaAllocator<T> &a, const BerArenaAllocator<U> &b) { return a.arena != b.arena; }
+
+/**
+ * @brief Create a BER field inside an arena
+ * @param arena	Arena used for the field, or nullptr to use the heap
+ * @param args	Constructor arguments
+ * @return The created field
+ */
+template <class T, class... Args>
+inline std::shared_ptr<T> makeBerField(const std::shared_ptr<BerArena> &arena, Args&&... args) {
+	if(arena == nullptr) return std::make_shared<T>(std::forward<Args>(args)...);
+	return std::allocate_shared<T>(BerArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+}
+
+#endif
@@ -11,6 +11,9 @@
 
 // Own includes
 #include <3ds/types.h>
+#include "asn1/BerWriter.h"
+#include "asn1/BerArena.h"
+#include "asn1/BerView.h"
 
 // Defines
 #define BER_TAG_CLASS(x)		((x) << 6)
@@ -46,9 +49,12 @@ class BerField {
 		void parseTag(u8 **out);
 		void parseLength(u8 **out);
 		virtual void parseData(u8 **out) = 0;
+		u32 encode(BerWriter &writer);
+		virtual void encodeData(BerWriter &writer) = 0;
 		virtual std::string print() = 0;
 		virtual ~BerField() { }
-		static std::shared_ptr<BerField> decode(u8 **data);
+		static std::shared_ptr<BerField> decode(u8 **data, const std::shared_ptr<BerArena> &arena = nullptr);
+		static BerStatus validate(const BerView &view);
 };
 
 }
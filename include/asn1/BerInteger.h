@@ -11,6 +11,7 @@
 
 // Own includes
 #include "asn1/BerField.h"
+#include "asn1/BerView.h"
 
 // Defines
 #define BER_TAGCLASS_INTEGER 	BER_TAG_UNIVERSAL
@@ -25,13 +26,19 @@ namespace NetMan {
  */
 class BerInteger: public BerField {
 	private:
-		std::unique_ptr<u8> value;
+		u64 value;		/**< Value, sign extended if it is signed */
 		bool sign;
+		void setValue(u64 value, bool sign);
 	public:
 		BerInteger(void *value, u8 len, bool sign, u8 tagOptions = BER_TAGCLASS_INTEGER, u32 tag = BER_TAG_INTEGER);
+		BerInteger(u64 value, bool sign, u8 tagOptions = BER_TAGCLASS_INTEGER, u32 tag = BER_TAG_INTEGER);
 		void parseData(u8 **out);
-		static std::shared_ptr<BerInteger> decode(u8 **data, bool sign);
+		void encodeData(BerWriter &writer) override;
+		static std::shared_ptr<BerInteger> decode(u8 **data, bool sign, const std::shared_ptr<BerArena> &arena = nullptr);
 		static void decodeIntegerValue(u8 **data, u8 len, bool sign, u8 *dest, u8 maxlen);
+		static u64 decodeValue(const u8 *in, u32 len, bool sign);
+		static BerStatus tryDecodeValue(const u8 *in, u32 len, bool sign, u64 *value);
+		static u8 getEncodedLength(u64 value, bool sign);
 		std::string print() override;
 		u32 getValueU32();
 		s32 getValueS32();
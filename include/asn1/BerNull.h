@@ -25,7 +25,8 @@ class BerNull : public BerField {
 	public:
 		BerNull(u8 tagOptions = BER_TAGCLASS_NULL, u32 tag = BER_TAG_NULL);
 		void parseData(u8 **out);
-		static std::shared_ptr<BerNull> decode(u8 **data);
+		void encodeData(BerWriter &writer) override;
+		static std::shared_ptr<BerNull> decode(u8 **data, const std::shared_ptr<BerArena> &arena = nullptr);
 		virtual ~BerNull();
 		std::string print() override;
 };
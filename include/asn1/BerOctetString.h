@@ -28,7 +28,8 @@ class BerOctetString: public BerField {
 	public:
 		BerOctetString(const std::string &value, u8 tagOptions = BER_TAGCLASS_OCTETSTRING, u32 tag = BER_TAG_OCTETSTRING);
 		void parseData(u8 **out);
-		static std::shared_ptr<BerOctetString> decode(u8 **data);
+		void encodeData(BerWriter &writer) override;
+		static std::shared_ptr<BerOctetString> decode(u8 **data, const std::shared_ptr<BerArena> &arena = nullptr);
 		virtual ~BerOctetString();
 		std::string print() override;
 		std::string &getValue();
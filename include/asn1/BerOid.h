@@ -13,6 +13,7 @@
 
 // Own includes
 #include "asn1/BerField.h"
+#include "asn1/CompactOid.h"
 
 // Defines
 #define BER_TAGCLASS_OID 	BER_TAG_UNIVERSAL
@@ -25,17 +26,20 @@ namespace NetMan {
  */
 class BerOid: public BerField {
 	private:
-		std::vector<u32> oid;
-		void parseOid(std::vector<u32> &oid);
+		CompactOid oid;
+		void parseOid();
 	public:
 		BerOid(u8 tagOptions = BER_TAGCLASS_OID, u32 tag = BER_TAG_OID);
 		BerOid(const std::string &oidString, u8 tagOptions = BER_TAGCLASS_OID, u32 tag = BER_TAG_OID);
         BerOid(const std::vector<u32> &oid, u8 tagOptions = BER_TAGCLASS_OID, u32 tag = BER_TAG_OID);
+		BerOid(const CompactOid &oid, u8 tagOptions = BER_TAGCLASS_OID, u32 tag = BER_TAG_OID);
 		void parseData(u8 **out);
+		void encodeData(BerWriter &writer) override;
         void addElement(u32 n);
         void editLastElement(u32 n);
+		inline const CompactOid &getOid() const { return oid; }
 		virtual ~BerOid();
-		static std::shared_ptr<BerOid> decode(u8** data);
+		static std::shared_ptr<BerOid> decode(u8** data, const std::shared_ptr<BerArena> &arena = nullptr);
 		std::string print() override;
 };
 
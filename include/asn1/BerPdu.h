@@ -14,6 +14,9 @@
 #include "asn1/BerField.h"
 #include "socket/UdpSocket.h"
 
+// Defines
+#define BERPDU_MAX_SIZE		(64 << 10)		/**< Size of the buffer used to send PDUs */
+
 namespace NetMan {
 
 /**
@@ -23,14 +26,19 @@ namespace NetMan {
 class BerPdu {
 	private:
 		void addField(std::shared_ptr<BerField> field);
+		std::unique_ptr<u8[]> sendBuffer;		/**< Encoding buffer, reused between sends */
 	protected:
 		std::vector<std::shared_ptr<BerField>> fields;
+		std::shared_ptr<BerArena> arena;		/**< Arena for the field trees of this PDU */
+		u8 *getSendBuffer();
 		void send(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port);
 	public:
 		BerPdu();
 		virtual ~BerPdu();
 		virtual void clear();
+		std::shared_ptr<BerArena> getArena();
 		std::unique_ptr<u8> serialize(u32 *pdu_size, u8 alignment = 1);
+		u8 *encode(u8 *buffer, u32 bufferSize, u32 *pduSize, u8 alignment = 1);
 		friend class Snmpv3Pdu;
 };
 
@@ -25,12 +25,14 @@ namespace NetMan {
  */
 class BerSequence: public BerField {
 	private:
-		std::vector<std::shared_ptr<BerField>> children;
+		std::vector<std::shared_ptr<BerField>, BerArenaAllocator<std::shared_ptr<BerField>>> children;
 	public:
-		BerSequence(u8 tagOptions = BER_TAGCLASS_SEQUENCE, u32 tag = BER_TAG_SEQUENCE);
+		BerSequence(u8 tagOptions = BER_TAGCLASS_SEQUENCE, u32 tag = BER_TAG_SEQUENCE, const std::shared_ptr<BerArena> &arena = nullptr);
 		void addChild(std::shared_ptr<BerField> child);
+		inline void reserve(u32 n) { children.reserve(n); }
 		std::shared_ptr<BerField> getChild(u16 i);
 		void parseData(u8 **out);
+		void encodeData(BerWriter &writer) override;
 		u32 getTotalSize() override;
         inline u32 getNChildren(){ return this->children.size(); }
 		~BerSequence();
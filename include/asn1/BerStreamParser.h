@@ -0,0 +1,62 @@
+/**
+ * @file BerStreamParser.h
+ * @brief Resumable push parser for BER messages received in chunks
+ */
+
+#ifndef BERSTREAMPARSER_H_
+#define BERSTREAMPARSER_H_
+
+// Includes C/C++
+#include <vector>
+
+// Own includes
+#include <3ds/types.h>
+#include "asn1/BerView.h"
+
+// Defines
+#define BERSTREAM_HEADER_SIZE	6			/**< Tag octet, length octet and up to 4 length octets */
+
+namespace NetMan {
+
+/**
+ * @enum BerStreamState
+ */
+enum BerStreamState {
+	BERSTREAM_TAG = 0,
+	BERSTREAM_LENGTH,
+	BERSTREAM_LONG_LENGTH,
+	BERSTREAM_CONTENTS,
+	BERSTREAM_DONE,
+	BERSTREAM_ERROR,
+};
+
+/**
+ * @class BerStreamParser
+ * @brief Takes byte chunks of any size and gives complete top level TLVs
+ * @note Only single octet tags and definite lengths (up to 4 octets) are supported, as in BerView
+ */
+class BerStreamParser {
+	private:
+		std::vector<u8> buffer;				/**< Message being reassembled */
+		u8 header[BERSTREAM_HEADER_SIZE];	/**< Tag and length octets read so far */
+		u32 headerSize;
+		u32 lengthSize;						/**< Octets of a long length */
+		u32 contentLength;
+		u32 maxMessageSize;					/**< Maximum size of a whole TLV */
+		BerStreamState state;
+		BerView message;
+		void fail(const char *error);
+		void startContents();
+	public:
+		BerStreamParser(u32 maxMessageSize);
+		u32 push(const u8 *data, u32 size);
+		inline bool hasMessage() const { return state == BERSTREAM_DONE; }
+		inline const BerView &getMessage() const { return message; }
+		inline BerStreamState getState() const { return state; }
+		inline u32 getMaxMessageSize() const { return maxMessageSize; }
+		void reset();
+};
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file BerView.h
+ * @brief Zero-copy BER field view
+ */
+
+#ifndef BERVIEW_H_
+#define BERVIEW_H_
+
+// Includes C/C++
+#include <string>
+
+// Own includes
+#include <3ds/types.h>
+#include "asn1/CompactOid.h"
+
+namespace NetMan {
+
+/**
+ * @enum BerStatus
+ * @brief Result of the non-throwing BER decoding functions
+ */
+enum BerStatus {
+	BER_OK = 0,
+	BER_ERROR_TRUNCATED,		/**< Field goes beyond the buffer */
+	BER_ERROR_LONG_TAG,			/**< Multi octet tag */
+	BER_ERROR_LENGTH,			/**< Indefinite or too long length */
+	BER_ERROR_TAG,				/**< Unexpected or unknown tag */
+	BER_ERROR_VALUE,			/**< Malformed contents */
+	BER_NSTATUS,
+};
+
+/**
+ * @class BerView
+ * @brief Non-owning view of a BER encoded field, pointing into the original buffer
+ * @note A view is only valid while the buffer it points to is alive and unmodified
+ */
+class BerView {
+	private:
+		const u8 *data;		/**< Beginning of the field (tag octet) */
+		const u8 *value;	/**< Beginning of the field contents */
+		u32 length;			/**< Length of the field contents */
+		u8 tag;				/**< Identifier octet (class, structured flag and tag number) */
+	public:
+		BerView();
+		BerView(const u8 *data, u32 size);
+		static BerStatus parse(const u8 *data, u32 size, BerView *view);
+		static const char *getStatusString(BerStatus status);
+		inline u8 getTag() const { return tag; }
+		inline u32 getLength() const { return length; }
+		inline const u8 *getData() const { return data; }
+		inline const u8 *getValue() const { return value; }
+		inline const u8 *getEnd() const { return value + length; }
+		inline u32 getTagAndLengthSize() const { return value - data; }
+		inline u32 getTotalSize() const { return (value - data) + length; }
+		inline bool isEmpty() const { return data == NULL; }
+		u32 getValueU32() const;
+		s32 getValueS32() const;
+		u64 getValueU64() const;
+		s64 getValueS64() const;
+		BerStatus getInteger(bool sign, u64 *value) const;
+		CompactOid getOid() const;
+		bool equals(const std::string &text) const;
+		std::string getString() const;
+		std::string print() const;
+};
+
+/**
+ * @class BerReader
+ * @brief Cursor used to walk consecutive BER fields without copying them
+ */
+class BerReader {
+	private:
+		const u8 *ptr;		/**< Current read position */
+		const u8 *end;		/**< End of the readable area */
+	public:
+		BerReader(const u8 *data, u32 size);
+		BerReader(const BerView &view);
+		inline bool hasNext() const { return ptr < end; }
+		inline const u8 *getPosition() const { return ptr; }
+		inline u32 getRemaining() const { return end - ptr; }
+		BerStatus tryNext(BerView *view);
+		BerStatus tryNext(u8 tag, BerView *view);
+		BerView next();
+		BerView next(u8 tag);
+};
+
+}
+
+#endif
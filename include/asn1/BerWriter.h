@@ -0,0 +1,40 @@
+/**
+ * @file BerWriter.h
+ * @brief Reverse BER encoder
+ */
+
+#ifndef BERWRITER_H_
+#define BERWRITER_H_
+
+// Own includes
+#include <3ds/types.h>
+
+namespace NetMan {
+
+/**
+ * @class BerWriter
+ * @brief Writes BER fields from the end of a buffer towards its beginning
+ * @note Contents are written before their tag and length, so every length is known when it is emitted
+ */
+class BerWriter {
+	private:
+		u8 *base;		/**< Beginning of the buffer */
+		u8 *ptr;		/**< First written byte */
+		u8 *end;		/**< End of the buffer */
+	public:
+		BerWriter(u8 *buffer, u32 size);
+		inline u8 *getData() const { return ptr; }
+		inline u32 getSize() const { return end - ptr; }
+		inline u32 getRemaining() const { return ptr - base; }
+		inline void reset() { ptr = end; }
+		void writeByte(u8 value);
+		void writeBytes(const void *data, u32 length);
+		void writeZeros(u32 length);
+		void skip(u32 length);
+		void writeLength(u32 length);
+		void writeTag(u8 tagOptions, u32 tag);
+};
+
+}
+
+#endif
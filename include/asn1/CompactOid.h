@@ -0,0 +1,72 @@
+/**
+ * @file CompactOid.h
+ * @brief Compact OBJECT IDENTIFIER, stored in its BER encoded form
+ */
+
+#ifndef COMPACTOID_H_
+#define COMPACTOID_H_
+
+// Includes C/C++
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Own includes
+#include <3ds/types.h>
+
+// Defines
+#define COMPACTOID_INLINE_SIZE	32		/**< Encoded bytes stored without using the heap */
+
+namespace NetMan {
+
+/**
+ * @class CompactOid
+ * @brief OID stored as its BER encoded arcs, with a small buffer optimization
+ * @note Arcs are numbered as in the dotted representation, so the first encoded arc holds arcs 0 and 1
+ */
+class CompactOid {
+	private:
+		u8 inlineData[COMPACTOID_INLINE_SIZE];
+		u8 *data;				/**< inlineData or a heap buffer */
+		u16 length;				/**< Encoded length */
+		u16 capacity;			/**< Size of data */
+		void reserve(u32 size);
+		u32 skipArcs(u32 nArcs) const;
+	public:
+		CompactOid();
+		CompactOid(const u8 *encoded, u32 length);
+		CompactOid(const std::string &oidString);
+		CompactOid(const std::vector<u32> &arcs);
+		CompactOid(const CompactOid &other);
+		CompactOid &operator=(const CompactOid &other);
+		~CompactOid();
+		inline const u8 *getData() const { return data; }
+		inline u32 getLength() const { return length; }
+		inline bool isEmpty() const { return length == 0; }
+		u32 getNArcs() const;
+		u32 getArc(u32 i) const;
+		void append(u32 arc);
+		void append(const CompactOid &suffix, u32 firstArc = 2);
+		void truncate(u32 nArcs);
+		void clear();
+		int compare(const CompactOid &other) const;
+		bool isPrefixOf(const CompactOid &other) const;
+		u32 hash() const;
+		std::string print() const;
+		static std::string print(const u8 *encoded, u32 length);
+		inline bool operator==(const CompactOid &other) const { return compare(other) == 0; }
+		inline bool operator!=(const CompactOid &other) const { return compare(other) != 0; }
+		inline bool operator<(const CompactOid &other) const { return compare(other) < 0; }
+};
+
+/**
+ * @struct CompactOidHash
+ * @brief Hash functor, to use CompactOids as keys of unordered containers
+ */
+typedef struct {
+	size_t operator()(const CompactOid &oid) const { return oid.hash(); }
+} CompactOidHash;
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file OidCodec.h
+ * @brief Word-at-a-time base 128 codec for OID arcs
+ */
+
+#ifndef OIDCODEC_H_
+#define OIDCODEC_H_
+
+// Includes C/C++
+#include <string.h>
+
+// Own includes
+#include <3ds/types.h>
+
+// Defines
+#define OIDCODEC_MAX_ARC_SIZE	5			/**< Octets needed by a 32 bit arc */
+#define OIDCODEC_HIGH_BITS		0x80808080	/**< Bit 7 of every octet in a word */
+
+namespace NetMan {
+
+/**
+ * @class OidCodec
+ * @brief Encodes and decodes base 128 OID arcs, handling up to a word of octets per step
+ * @note Words are read in little endian order, as both the ARM11 and x86 hosts are little endian
+ */
+class OidCodec {
+	private:
+		static const u8 arcSizes[33];
+		static u32 decodeSlow(const u8 *in, u32 length, u32 *arc);
+	public:
+		/**
+		 * @brief Get the encoded size of an arc
+		 * @param arc Arc value
+		 * @return Number of octets (1 to 5)
+		 */
+		static inline u32 getArcSize(u32 arc) {
+			return arcSizes[arc == 0 ? 0 : 32 - __builtin_clz(arc)];
+		}
+
+		/**
+		 * @brief Read up to 4 octets as a little endian word
+		 * @param in		Input buffer
+		 * @param length	Readable octets
+		 * @return The word, padded with zeros
+		 */
+		static inline u32 loadWord(const u8 *in, u32 length) {
+			u32 word = 0;
+			memcpy(&word, in, length < 4 ? length : 4);
+			return word;
+		}
+
+		/**
+		 * @brief Get the arc terminators of a word (octets with bit 7 down)
+		 * @param word Word, as given by loadWord
+		 * @return Bit 7 of each octet set if that octet ends an arc
+		 */
+		static inline u32 getTerminators(u32 word) {
+			return ~word & OIDCODEC_HIGH_BITS;
+		}
+
+		static u32 encodeArc(u32 arc, u8 *out);
+		static u32 encodeArcs(const u32 *arcs, u32 nArcs, u8 *out);
+		static u32 decodeArc(const u8 *in, u32 length, u32 *arc);
+		static u32 decodeArcs(const u8 *in, u32 length, u32 *arcs, u32 maxArcs, u32 *consumed = NULL);
+		static u32 countArcs(const u8 *in, u32 length);
+};
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file Bench.h
+ * @brief Micro benchmark helper
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+// Includes C/C++
+#include <string>
+
+// Includes 3DS
+#include <3ds/types.h>
+
+// Defines
+//#define BENCH_ALLOCS true					/**< Count heap allocations (replaces the global operator new) */
+#define BENCH_LOG_PATH		"log.txt"
+#define BENCH_RESULTS_PATH	"bench.jsonl"	/**< Machine-readable results, one JSON object per line */
+
+namespace NetMan {
+
+/**
+ * @struct BenchResult
+ */
+typedef struct {
+	std::string name;
+	u32 iterations;
+	u64 ticks;
+	u32 allocs;
+	u32 allocBytes;
+	u32 peakBytes;
+} BenchResult;
+
+/**
+ * @class Bench
+ */
+class Bench {
+	public:
+		typedef void (*BenchFunc)(void *args);
+		static bool isCountingAllocs();
+		static u32 getAllocCount();
+		static u32 getAllocBytes();
+		static u32 getLiveBytes();
+		static BenchResult run(const std::string &name, u32 iterations, BenchFunc func, void *args);
+		static void log(const BenchResult &result, const std::string &path = BENCH_LOG_PATH);
+		static void logText(const std::string &text, const std::string &path = BENCH_LOG_PATH);
+		static void logRate(const BenchResult &result, u32 itemsPerOp, const std::string &unit, const std::string &path = BENCH_LOG_PATH);
+		static void logJson(const BenchResult &result, u32 itemsPerOp, u32 bytesPerOp, const std::string &path = BENCH_RESULTS_PATH);
+};
+
+}
+
+#endif
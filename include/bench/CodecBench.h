@@ -0,0 +1,61 @@
+/**
+ * @file CodecBench.h
+ * @brief BER/SNMP codec benchmark suite, run over a corpus of SNMP messages
+ */
+
+#ifndef _CODECBENCH_H_
+#define _CODECBENCH_H_
+
+// Includes C/C++
+#include <string>
+#include <vector>
+
+// Includes 3DS
+#include <3ds/types.h>
+
+// Own includes
+#include "bench/Bench.h"
+
+// Defines
+#define CODECBENCH_CORPUS_PATH      "romfs:/bench/"
+#define CODECBENCH_CORPUS_EXT       ".ber"
+
+namespace NetMan {
+
+/**
+ * @struct CodecBenchMessage
+ */
+typedef struct {
+    std::string name;           /**< Corpus file name, without extension */
+    std::vector<u8> data;       /**< Whole BER encoded message */
+    u32 iterations;             /**< Times each message benchmark is run */
+} CodecBenchMessage;
+
+/**
+ * @class CodecBench
+ * @brief Measures encode and decode throughput, and allocations per message, of the BER types and SNMP PDUs
+ * @note The run*() micro benchmarks compare the codec against the code it replaced, over a captured GetResponse.
+ * @note The corpus holds SNMPv1/v2c GET, GETBULK and TRAP messages, and SNMPv3 messages using
+ *       authPriv (user "bench", MD5 + DES) and authNoPriv (user "benchsha", SHA1), both with password "benchauthpass"
+ *       (and "benchprivpass" for privacy). Those users are registered in the user store while the suite runs.
+ *       SNMPv3 requests are also sent to the discard port of the local host, to measure whole sends.
+ */
+class CodecBench {
+    private:
+        static void loadCorpus(const std::string &path, std::vector<CodecBenchMessage> &corpus);
+        static void runFields(const std::vector<CodecBenchMessage> &corpus, const std::string &resultsPath);
+        static void runMessage(const CodecBenchMessage &message, const std::string &resultsPath);
+    public:
+        static void run(const std::string &corpusPath = CODECBENCH_CORPUS_PATH, const std::string &resultsPath = BENCH_RESULTS_PATH);
+        static void runBerView();
+        static void runBerWriter();
+        static void runBerArena();
+        static void runCompactOid();
+        static void runOidCodec();
+        static void runBerStream();
+        static void runDecodeStatus();
+};
+
+}
+
+#endif
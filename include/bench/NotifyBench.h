@@ -0,0 +1,32 @@
+/**
+ * @file NotifyBench.h
+ * @brief Trap and syslog storage benchmarks
+ */
+
+#ifndef _NOTIFYBENCH_H_
+#define _NOTIFYBENCH_H_
+
+// Own includes
+#include "bench/Bench.h"
+
+// Defines
+#define NOTIFYBENCH_LOG_NAME        "benchlog"      /**< EventLog written by runEventLog() */
+#define NOTIFYBENCH_INFORM_PORT     10162           /**< Loopback port informs are sent to by runInform() */
+
+namespace NetMan {
+
+/**
+ * @class NotifyBench
+ * @brief Measures the event log, the trap deduplicator and the trap rules, as the NotificationReceiver uses them
+ */
+class NotifyBench {
+    public:
+        static void runEventLog();
+        static void runTrapDedup();
+        static void runTrapRules();
+        static void runInform();
+};
+
+}
+
+#endif
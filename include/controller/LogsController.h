@@ -7,6 +7,8 @@
 
 // Includes C/C++
 #include <memory>
+#include <string>
+#include <vector>
 
 // Includes jansson
 #include <jansson.h>
@@ -14,6 +16,7 @@
 // Own includes
 #include "GuiController.h"
 #include "gui/ListView.h"
+#include "notify/EventLog.h"
 
 namespace NetMan {
 
@@ -22,15 +25,29 @@ namespace NetMan {
  */
 class LogsController : public GuiController {
     private:
-        std::shared_ptr<json_t> root;
+        std::shared_ptr<EventLog> log;
+        u32 begin;                      /**< Oldest listed record */
+        u32 end;                        /**< Index after the newest listed record */
+        EventLogFilter filter;
+        std::string filterText;
+        bool syslogMode;                /**< List the syslog log instead of the trap logs */
+        std::string routeLog;           /**< Route log listed instead of the trap log, or empty */
+        u32 pageStart;                  /**< First element of the shown page */
+        std::vector<u32> page;          /**< Record indexes of the shown page */
         ListViewFillParams *fillParams;
     public:
         LogsController();
         virtual ~LogsController();
-        void loadJsonList(const std::string &path);
-        inline std::shared_ptr<json_t> getJson() { return root; }
+        void loadLog();
+        bool setFilter(const std::string &text);
+        bool loadPage(u32 startElement, u32 count);
+        bool getRecordIndex(u32 element, u32 *index);
+        inline std::shared_ptr<EventLog> getLog() { return log; }
+        inline const std::string &getFilterText() { return filterText; }
+        inline const std::vector<u32> &getPage() { return page; }
         inline void setFillParams(ListViewFillParams *params) { fillParams = params; }
         inline ListViewFillParams *getFillParams() { return fillParams; }
+        inline void setSyslogMode(bool syslogMode) { this->syslogMode = syslogMode; }
 };
 
 }
@@ -9,6 +9,9 @@
 #include "SnmpParamsController.h"
 #include "gui/EditTextView.h"
 #include "gui/ListView.h"
+#include "gui/TextView.h"
+#include "snmp/SnmpPoller.h"
+#include "snmp/SnmpTable.h"
 
 namespace NetMan {
 
@@ -22,21 +25,38 @@ typedef struct {
     std::shared_ptr<EditTextView> valueEditText;
 } SnmpTableIcons;
 
+/**
+ * @struct SnmpTableWatch
+ * @brief Last polled values of the watched row, written by the poller thread
+ */
+typedef struct {
+    LightLock lock;
+    std::vector<std::string> values;    /**< By column */
+    bool changed;                       /**< If there are values not shown yet */
+} SnmpTableWatch;
+
 /**
  * @class SnmpTableController
  */
 class SnmpTableController : public GuiController {
     private:
         static std::shared_ptr<SnmpThreadParams> snmpParams;
+        static std::shared_ptr<SnmpTable> table;
+        static std::shared_ptr<SnmpPoller> poller;
+        static SnmpTableWatch watch;
+        std::shared_ptr<TextView> rowText;
         ListViewFillParams *fillParams;
         std::vector<SnmpTableIcons> tableIcons;
-        u32 tableIndex;
+        static u32 tableIndex;
         u32 currentField;
     public:
         SnmpTableController();
         inline std::shared_ptr<SnmpThreadParams> getSnmpParams() { return snmpParams; }
-        inline void resetSnmpParams() { snmpParams = nullptr; }
+        inline void resetSnmpParams() { snmpParams = nullptr; table = nullptr; poller = nullptr; }
+        inline std::shared_ptr<SnmpTable> getTable() { return table; }
+        inline std::shared_ptr<TextView> getRowText() { return rowText; }
         virtual ~SnmpTableController();
+        void initialize(std::vector<std::shared_ptr<GuiView>> &views) override;
         inline ListViewFillParams *getFillParams() { return fillParams; }
         inline void setFillParams(ListViewFillParams *params) { fillParams = params; }
         inline void clearIcons() { tableIcons.clear(); }
@@ -45,6 +65,10 @@ class SnmpTableController : public GuiController {
         inline void setCurrentField(u32 field) { currentField = field; }
         inline u32 getCurrentField() { return currentField; }
         inline u32 *getTableIndex() { return &tableIndex; }
+        void startWatch();
+        inline void stopWatch() { poller = nullptr; }
+        inline bool isWatching() { return poller != nullptr; }
+        bool updateWatch();
 };
 
 }
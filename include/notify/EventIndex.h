@@ -0,0 +1,69 @@
+/**
+ * @file EventIndex.h
+ * @brief In-memory secondary index of an EventLog
+ */
+
+#ifndef EVENTINDEX_H_
+#define EVENTINDEX_H_
+
+// Includes C/C++
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// Includes 3DS
+#include <3ds/types.h>
+
+// Defines
+#define EVENTINDEX_BUCKET_MS			60000			/**< Width of the time buckets, in ms */
+#define EVENTINDEX_HASH_BASIS			14695981039346656037ULL	/**< Initial 64-bit FNV-1a hash */
+
+namespace NetMan {
+
+/**
+ * @struct EventIndexList
+ * @brief Indexes of the records having some key, oldest first
+ */
+typedef struct {
+	std::vector<u32> indexes;
+	u32 start;									/**< First index still stored, the ones before it are pruned */
+} EventIndexList;
+
+/**
+ * @struct EventIndexBucket
+ * @brief First record received in a time bucket
+ */
+typedef struct {
+	u64 bucket;									/**< Reception time / EVENTINDEX_BUCKET_MS */
+	u32 firstIndex;
+} EventIndexBucket;
+
+/**
+ * @class EventIndex
+ * @brief Lists of the records having each key, and the first record of each time bucket
+ * @note Keys are 64-bit hashes of a kind and a value, see hash(). Records must be added in index order,
+ *       so every list stays sorted and a query only walks the lists of its keys. Not thread safe.
+ */
+class EventIndex {
+	private:
+		std::unordered_map<u64, EventIndexList> lists;
+		std::deque<EventIndexBucket> buckets;	/**< Oldest first, only the buckets having records */
+		u32 begin;								/**< Oldest indexed record */
+		u32 end;								/**< Index after the newest indexed record */
+		u32 nEntries;							/**< Stored list entries, pruned ones included */
+	public:
+		EventIndex();
+		void clear();
+		void add(u32 index, u64 time, const u64 *keys, u32 nKeys);
+		void prune(u32 begin);
+		u32 findTime(u64 time);
+		u32 query(const u64 *keys, u32 nKeys, u32 begin, u32 end, u32 skip, u32 count, std::vector<u32> &indexes);
+		inline u32 getNKeys() { return lists.size(); }
+		inline u32 getNEntries() { return nEntries; }
+		static u64 hash(u8 kind, const void *data, u32 size);
+		static u64 hashBytes(u64 hash, const void *data, u32 size);
+};
+
+}
+
+#endif
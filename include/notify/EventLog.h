@@ -0,0 +1,171 @@
+/**
+ * @file EventLog.h
+ * @brief Append-only log of received events
+ */
+
+#ifndef EVENTLOG_H_
+#define EVENTLOG_H_
+
+// Includes C/C++
+#include <stdio.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+
+// Includes 3DS
+#include <3ds.h>
+
+// Own includes
+#include "notify/EventIndex.h"
+
+// Defines
+#define EVENTLOG_SEGMENT_EXT			".seg"
+#define EVENTLOG_INDEX_EXT				".idx"
+#define EVENTLOG_MAGIC					0x474C4D4E		/**< "NMLG" */
+#define EVENTLOG_INDEX_MAGIC			0x58494D4E		/**< "NMIX" */
+#define EVENTLOG_HEADER_SIZE			8				/**< Segment header: magic, index of its first record */
+#define EVENTLOG_RECORD_HEADER_SIZE		8				/**< Record header: payload length, payload checksum */
+#define EVENTLOG_MAX_RECORD_SIZE		(64 << 10)
+#define EVENTLOG_MAX_BYTES				(32 << 20)		/**< Default size limit of a log */
+#define EVENTLOG_SEGMENT_BYTES			(256 << 10)		/**< Default size limit of a segment */
+#define EVENTLOG_MIN_SEGMENTS			4				/**< Segments a full log is split into, at least */
+#define EVENTLOG_CHECKPOINT_STRIDE		32				/**< Records between known offsets */
+#define EVENTLOG_MAX_KEYS				15				/**< Keys stored with a record, at most */
+
+// Defines record key kinds
+#define EVENTLOG_KEY_SOURCE				0				/**< Sender IP, only used for indexing */
+#define EVENTLOG_KEY_TRAPOID			1				/**< Encoded snmpTrapOID.0 value */
+#define EVENTLOG_KEY_ENTERPRISE			2				/**< Encoded trap enterprise OID */
+#define EVENTLOG_KEY_FACILITY			3				/**< Syslog facility, in decimal */
+#define EVENTLOG_KEY_SEVERITY			4				/**< Syslog severity, in decimal */
+#define EVENTLOG_KEY_APPNAME			5				/**< Syslog APP-NAME */
+#define EVENTLOG_KEY_MSGID				6				/**< Syslog MSGID */
+#define EVENTLOG_KEY_TAG				7				/**< Tag added by a trap rule */
+
+namespace NetMan {
+
+/**
+ * @struct EventLogKey
+ * @brief Value a record can be searched by
+ */
+typedef struct {
+	u8 kind;								/**< EVENTLOG_KEY_* */
+	std::string value;
+} EventLogKey;
+
+/**
+ * @struct EventLogRecord
+ * @brief Stored event
+ */
+typedef struct {
+	u8 type;								/**< NOTIFY_* */
+	u64 time;								/**< Reception time, in osGetTime() ms */
+	in_addr_t source;						/**< Sender IP, or 0 if unknown */
+	std::string name;						/**< Name shown in the log list */
+	std::vector<std::string> fields;		/**< Decoded fields, as text */
+	std::vector<EventLogKey> keys;			/**< Indexed values, the source and time are always indexed */
+} EventLogRecord;
+
+/**
+ * @struct EventLogFilter
+ * @brief Records to look for
+ */
+typedef struct {
+	u64 fromTime;							/**< Oldest reception time, or 0. Rounded down to EVENTINDEX_BUCKET_MS */
+	u64 toTime;								/**< Newest reception time, or 0. Rounded up to EVENTINDEX_BUCKET_MS */
+	in_addr_t source;						/**< Sender IP, or 0 for any */
+	std::vector<EventLogKey> keys;			/**< Keys the records must all have */
+} EventLogFilter;
+
+/**
+ * @struct EventLogSegment
+ * @brief Segment file, with the offsets of some of its records
+ */
+typedef struct {
+	u32 id;									/**< File number */
+	u32 firstIndex;							/**< Index of the first record */
+	u32 nRecords;
+	u32 size;								/**< File size, header included */
+	std::vector<u32> checkpoints;			/**< Offset of every EVENTLOG_CHECKPOINT_STRIDE-th record */
+} EventLogSegment;
+
+/**
+ * @class EventLog
+ * @brief Log stored as a directory of segment files, where records are only appended
+ * @note Each record is its length and checksum followed by its payload, so appending costs the same whatever the log size.
+ *       The oldest segment is deleted once the others hold maxRecords records, or the log is over maxBytes.
+ *       On opening, the newest segment is cut at its first incomplete or corrupt record, which is what a crash leaves.
+ *       Records are indexed from the first one ever appended. One thread appends, any thread can read.
+ *       The keys of the records are kept in an EventIndex, updated on every append. When a segment is full its keys
+ *       are also saved in an index file next to it, so opening the log does not decode the old records.
+ */
+class EventLog {
+	private:
+		std::string path;
+		u32 maxRecords;
+		u32 maxBytes;
+		u32 segmentBytes;
+		std::deque<EventLogSegment> segments;	/**< Oldest first */
+		FILE *tail;								/**< Newest segment, open for appending */
+		bool resumeTail;						/**< If the newest segment found on opening can be appended to */
+		u32 end;								/**< Index of the next record */
+		u32 flushedEnd;							/**< Records before it can be read */
+		u32 nBytes;
+		std::vector<u8> buffer;
+		EventIndex index;
+		std::vector<u8> tailKeys;				/**< Keys of the newest segment records, as stored in its index file */
+		LightLock lock;
+		std::string getSegmentPath(u32 id, const char *ext = EVENTLOG_SEGMENT_EXT);
+		bool readKeys(u32 id, std::vector<u8> &keys);
+		void writeKeys(const EventLogSegment &segment);
+		bool scanSegment(u32 id, bool isTail, bool useKeys, EventLogSegment &segment, std::vector<u8> &keys);
+		void indexSegment(const EventLogSegment &segment, const std::vector<u8> &keys);
+		u32 getFirstIndex();
+		void openSegment();
+		void trim();
+	public:
+		EventLog(const std::string &path, u32 maxRecords, u32 maxBytes = EVENTLOG_MAX_BYTES, u32 segmentBytes = EVENTLOG_SEGMENT_BYTES);
+		virtual ~EventLog();
+		void open();
+		void close();
+		u32 append(const EventLogRecord &record);
+		void flush();
+		void setMaxRecords(u32 maxRecords);
+		u32 getBegin();
+		u32 getEnd();
+		bool locate(u32 index, std::string &segmentPath, u32 *offset, u32 *skip, u32 *segmentEnd);
+		u32 query(const EventLogFilter &filter, u32 begin, u32 end, u32 skip, u32 count, std::vector<u32> &indexes);
+		inline u32 getNBytes() { return nBytes; }
+		static u32 encode(const EventLogRecord &record, std::vector<u8> &data);
+		static bool decode(const u8 *data, u32 size, EventLogRecord &record);
+		static u32 checksum(const u8 *data, u32 size);
+		static u32 hashKeys(in_addr_t source, const std::vector<EventLogKey> &keys, u64 *hashes);
+};
+
+/**
+ * @class EventLogIterator
+ * @brief Reads the records of an EventLog in order, from some index
+ * @note Records dropped by the retention while iterating end the iteration
+ */
+class EventLogIterator {
+	private:
+		std::shared_ptr<EventLog> log;
+		FILE *file;
+		u32 index;
+		u32 segmentEnd;							/**< Index after the last record of the open segment */
+		std::vector<u8> buffer;
+		void closeFile();
+		bool skip(u32 nRecords);
+	public:
+		EventLogIterator(std::shared_ptr<EventLog> log, u32 index);
+		virtual ~EventLogIterator();
+		void seek(u32 index);
+		bool next(EventLogRecord &record);
+		inline u32 getIndex() { return index; }
+};
+
+}
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file NotificationReceiver.h
+ * @brief Reception of traps and syslogs
+ */
+
+#ifndef NOTIFICATIONRECEIVER_H_
+#define NOTIFICATIONRECEIVER_H_
+
+// Includes C/C++
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Includes 3DS
+#include <3ds.h>
+
+// Includes jansson
+#include <jansson.h>
+
+// Own includes
+#include "notify/EventLog.h"
+#include "notify/SpscRing.h"
+#include "notify/TrapDeduplicator.h"
+#include "notify/TrapRules.h"
+#include "snmp/Snmpv1Pdu.h"
+#include "snmp/Snmpv2Pdu.h"
+#include "snmp/Snmpv3Pdu.h"
+#include "syslog/SyslogPdu.h"
+#include "socket/UdpSocket.h"
+#include "socket/TcpSocket.h"
+
+// Defines
+#define NOTIFY_RING_SIZE			64			/**< Events waiting for the UI */
+#define NOTIFY_BATCH_SIZE			32			/**< Packets read from a socket before looking at the others */
+#define NOTIFY_WAIT_MS				100			/**< Longest wait for packets, so that stop() is not delayed */
+#define NOTIFY_SUMMARY_SIZE			64
+#define NOTIFY_SWEEP_MS				1000		/**< Time between sweeps of the trap deduplicator */
+#define NOTIFY_STACKSIZE			(32 << 10)
+#define NOTIFY_TRAPLOG_PATH			"traplog"
+#define NOTIFY_SYSLOG_PATH			"syslog"
+#define NOTIFY_ROUTELOG_PREFIX		"traplog-"	/**< Followed by the log name of a route rule */
+#define NOTIFY_RULES_PATH			"traprules.json"
+
+// Defines event types
+#define NOTIFY_TRAPV1				0
+#define NOTIFY_TRAPV2				1
+#define NOTIFY_TRAPV3				2
+#define NOTIFY_INFORMV3				3
+#define NOTIFY_SYSLOG_UDP			4
+#define NOTIFY_SYSLOG_TCP			5
+#define NOTIFY_TRAP_SUMMARY			6
+#define NOTIFY_TRAP_ALERT			7
+
+namespace NetMan {
+
+/**
+ * @struct NotificationEvent
+ * @brief Summary of a received trap or syslog, for the UI
+ */
+typedef struct {
+	u8 type;								/**< NOTIFY_* */
+	u64 time;								/**< Reception time, in osGetTime() ms */
+	in_addr_t source;						/**< Sender IP, or 0 if unknown */
+	char summary[NOTIFY_SUMMARY_SIZE];		/**< Text to show */
+} NotificationEvent;
+
+/**
+ * @class NotificationReceiver
+ * @brief Receives, decodes and stores the traps and syslogs from its own thread, in two EventLogs
+ * @note Each socket is drained in batches as soon as select() reports it. The UI gets a summary of each event
+ *       through a lock-free ring, and the events it does not take in time are dropped and counted.
+ *       Repeated traps and trap storms are only counted, and stored as summaries, see TrapDeduplicator.
+ *       Traps are first matched against the user rules, which may drop, tag, route them to another log, or raise alerts.
+ */
+class NotificationReceiver {
+	private:
+		std::shared_ptr<UdpSocket> trapv1Sock;
+		std::shared_ptr<UdpSocket> trapv2Sock;
+		std::shared_ptr<UdpSocket> trapv3Sock;
+		std::shared_ptr<UdpSocket> syslogUdpSock;
+		std::shared_ptr<TcpSocket> syslogTcpSock;
+		std::shared_ptr<Snmpv1Pdu> snmpv1Pdu;
+		std::shared_ptr<Snmpv2Pdu> snmpv2Pdu;
+		std::shared_ptr<Snmpv3Pdu> snmpv3Pdu;
+		std::shared_ptr<SyslogPdu> syslogPdu;
+		std::shared_ptr<EventLog> trapLog;
+		std::shared_ptr<EventLog> syslogLog;
+		std::unordered_map<std::string, std::shared_ptr<EventLog>> routeLogs;	/**< By route rule log name */
+		std::shared_ptr<TrapRuleSet> rules;
+		TrapRuleMatch ruleMatch;				/**< Rules matched by the last routed trap */
+		EventLogRecord record;					/**< Reused for every stored event */
+		TrapDeduplicator dedup;
+		u64 lastSweep;
+		SpscRing<NotificationEvent, NOTIFY_RING_SIZE> events;
+		Thread thread;
+		volatile bool running;
+		u32 nReceived;
+		void publish(u8 type, in_addr_t source, const char *text);
+		void addKey(u8 kind, const std::string &value);
+		void setTrapKeys(const CompactOid &trapOid, const CompactOid &enterprise);
+		void setSyslogKeys();
+		void appendRecord(std::shared_ptr<EventLog> log, u8 type, in_addr_t source, const char *name);
+		void store(std::shared_ptr<EventLog> log, std::shared_ptr<json_t> json, u8 type, in_addr_t source, const char *name);
+		bool admitTrap(in_addr_t source, const CompactOid &trapOid, const SnmpVarBind *varBinds, u32 nVarBinds);
+		std::shared_ptr<EventLog> getRouteLog(const std::string &name);
+		std::shared_ptr<EventLog> routeTrap(in_addr_t source, bool hasTrapOid, const CompactOid &trapOid, const CompactOid &enterprise,
+			const SnmpVarBind *varBinds, u32 nVarBinds);
+		void publishTrap(u8 type, in_addr_t source, const char *text);
+		void flushTrapLogs();
+		void loadRules();
+		void storeSummaries();
+		void drainTraps(std::shared_ptr<Snmpv1Pdu> pdu, std::shared_ptr<UdpSocket> sock, u8 type);
+		void drainTrapsv3();
+		void drainSyslogUdp();
+		void drainSyslogTcp();
+		static void threadMain(void *args);
+	public:
+		NotificationReceiver(std::shared_ptr<UdpSocket> trapv1Sock, std::shared_ptr<UdpSocket> trapv2Sock, std::shared_ptr<UdpSocket> trapv3Sock,
+			std::shared_ptr<UdpSocket> syslogUdpSock, std::shared_ptr<TcpSocket> syslogTcpSock);
+		virtual ~NotificationReceiver();
+		bool step(u32 waitMs);
+		void start();
+		void stop();
+		inline bool popEvent(NotificationEvent &event) { return events.pop(event); }
+		inline std::shared_ptr<EventLog> getTrapLog() { return trapLog; }
+		inline std::shared_ptr<EventLog> getSyslogLog() { return syslogLog; }
+		std::shared_ptr<EventLog> findRouteLog(const std::string &name);
+		std::vector<std::string> getRouteLogNames();
+		inline u32 getNDropped() { return events.getNDropped(); }
+		inline u32 getNReceived() { return nReceived; }
+		inline bool isRunning() { return running; }
+};
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * @file SpscRing.h
+ * @brief Bounded lock-free single producer, single consumer ring
+ */
+
+#ifndef SPSCRING_H_
+#define SPSCRING_H_
+
+// Includes 3DS
+#include <3ds/types.h>
+
+namespace NetMan {
+
+/**
+ * @class SpscRing
+ * @brief Fixed size queue between one producer thread and one consumer thread, without locks
+ * @note head is only written by the producer and tail by the consumer. The indexes run freely and
+ *       are masked on access, so N must be a power of two. When the ring is full, the new item is
+ *       dropped and counted, so the producer never waits for the consumer.
+ */
+template <typename T, u32 N>
+class SpscRing {
+	static_assert(N != 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+	private:
+		T slots[N];
+		u32 head;							/**< Next slot to write */
+		u32 tail;							/**< Next slot to read */
+		u32 nDropped;						/**< Items pushed while full */
+	public:
+		SpscRing() : head(0), tail(0), nDropped(0) { }
+
+		/**
+		 * @brief Add an item, from the producer thread
+		 * @param item Item to copy into the ring
+		 * @return false if the ring was full and the item was dropped
+		 */
+		bool push(const T &item) {
+			u32 h = __atomic_load_n(&this->head, __ATOMIC_RELAXED);
+			if(h - __atomic_load_n(&this->tail, __ATOMIC_ACQUIRE) >= N) {
+				__atomic_store_n(&this->nDropped, this->nDropped + 1, __ATOMIC_RELAXED);
+				return false;
+			}
+			this->slots[h & (N - 1)] = item;
+			__atomic_store_n(&this->head, h + 1, __ATOMIC_RELEASE);		// Publish the slot
+			return true;
+		}
+
+		/**
+		 * @brief Take the oldest item, from the consumer thread
+		 * @param item Taken item (output)
+		 * @return false if the ring was empty
+		 */
+		bool pop(T &item) {
+			u32 t = __atomic_load_n(&this->tail, __ATOMIC_RELAXED);
+			if(t == __atomic_load_n(&this->head, __ATOMIC_ACQUIRE)) return false;
+			item = this->slots[t & (N - 1)];
+			__atomic_store_n(&this->tail, t + 1, __ATOMIC_RELEASE);		// Give the slot back
+			return true;
+		}
+
+		inline u32 getSize() { return __atomic_load_n(&this->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&this->tail, __ATOMIC_ACQUIRE); }
+		inline u32 getNDropped() { return __atomic_load_n(&this->nDropped, __ATOMIC_RELAXED); }
+		static inline u32 getCapacity() { return N; }
+};
+
+}
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ * @file TrapDeduplicator.h
+ * @brief Suppression of repeated traps and trap storms
+ */
+
+#ifndef TRAPDEDUPLICATOR_H_
+#define TRAPDEDUPLICATOR_H_
+
+// Includes C/C++
+#include <deque>
+#include <arpa/inet.h>
+
+// Includes 3DS
+#include <3ds/types.h>
+
+// Own includes
+#include "asn1/CompactOid.h"
+#include "snmp/SnmpVarBind.h"
+
+// Defines
+#define TRAPDEDUP_SETS				64				/**< Sets of the repeated traps table, power of two */
+#define TRAPDEDUP_WAYS				4				/**< Traps per set */
+#define TRAPDEDUP_SOURCE_SETS		16				/**< Sets of the sources table, power of two */
+#define TRAPDEDUP_SOURCE_WAYS		4				/**< Sources per set */
+#define TRAPDEDUP_MAX_SUMMARIES		64				/**< Summaries waiting to be stored */
+#define TRAPDEDUP_WINDOW_MS			60000			/**< Default window, in ms */
+#define TRAPDEDUP_RATE				10				/**< Default new traps per second accepted from a source */
+#define TRAPDEDUP_BURST				30				/**< Default new traps accepted at once from a source */
+#define TRAPDEDUP_SYSUPTIME_OID		"1.3.6.1.2.1.1.3.0"
+
+// Defines summary types
+#define TRAPDEDUP_REPEATED			0				/**< Repeats of a trap */
+#define TRAPDEDUP_RATE_LIMITED		1				/**< New traps of a source over its rate */
+
+namespace NetMan {
+
+/**
+ * @enum TrapVerdict
+ * @brief What to do with a received trap
+ */
+enum TrapVerdict {
+	TRAP_ACCEPT = 0,			/**< New trap, to store and show */
+	TRAP_DUPLICATE,				/**< Repeat of a recent trap, only counted */
+	TRAP_RATE_LIMITED,			/**< Its source is over its rate, only counted */
+	TRAP_LIMIT_TRIPPED,			/**< Like TRAP_RATE_LIMITED, and the first one of the source */
+};
+
+/**
+ * @struct TrapDedupEntry
+ * @brief Recently received trap
+ */
+typedef struct {
+	u64 key;					/**< Hash of the source, trap OID and key VarBinds, 0 if free */
+	in_addr_t source;
+	u64 firstSeen;				/**< First reception in the current window */
+	u64 lastSeen;
+	u32 nRepeats;				/**< Receptions suppressed in the current window */
+	CompactOid trapOid;
+} TrapDedupEntry;
+
+/**
+ * @struct TrapRateEntry
+ * @brief Token bucket of a source
+ */
+typedef struct {
+	in_addr_t source;			/**< 0 if free */
+	u32 tokens;					/**< In 1/1000 of a trap */
+	u64 lastRefill;
+	u64 firstDrop;				/**< First trap dropped in the current window */
+	u64 lastDrop;
+	u32 nDropped;				/**< Traps dropped in the current window */
+} TrapRateEntry;
+
+/**
+ * @struct TrapSummary
+ * @brief Suppressed traps, to store in place of them
+ */
+typedef struct {
+	u8 type;					/**< TRAPDEDUP_REPEATED or TRAPDEDUP_RATE_LIMITED */
+	in_addr_t source;
+	CompactOid trapOid;			/**< Repeated trap OID, empty for rate limits */
+	u64 firstSeen;
+	u64 lastSeen;
+	u32 count;					/**< Suppressed traps */
+} TrapSummary;
+
+/**
+ * @class TrapDeduplicator
+ * @brief Decides which received traps are stored, so that a storm costs a bounded work per second
+ * @note A trap is identified by its source, trap OID and VarBinds, leaving out sysUpTime.0, counters and time ticks.
+ *       The traps seen in the last window are kept in a set associative table: a repeat only updates its entry,
+ *       and the repeats of each window are reported by one summary. New traps take a token from the bucket of their
+ *       source, and the ones finding it empty are dropped and reported by one summary per window.
+ *       Both tables have a fixed size, the least recently seen entry is replaced, after reporting it. Not thread safe.
+ */
+class TrapDeduplicator {
+	private:
+		TrapDedupEntry entries[TRAPDEDUP_SETS * TRAPDEDUP_WAYS];
+		TrapRateEntry sources[TRAPDEDUP_SOURCE_SETS * TRAPDEDUP_SOURCE_WAYS];
+		std::deque<TrapSummary> summaries;
+		u32 windowMs;
+		u32 rate;
+		u32 burst;
+		u32 nDuplicates;
+		u32 nRateLimited;
+		u32 nLostSummaries;
+		static u64 getKey(in_addr_t source, const CompactOid &trapOid, const SnmpVarBind *varBinds, u32 nVarBinds);
+		void addSummary(u8 type, in_addr_t source, const CompactOid &trapOid, u64 firstSeen, u64 lastSeen, u32 count);
+		void closeEntry(TrapDedupEntry &entry);
+		void closeSource(TrapRateEntry &source);
+		bool takeToken(in_addr_t source, u64 now, bool *tripped);
+	public:
+		TrapDeduplicator(u32 windowMs = TRAPDEDUP_WINDOW_MS, u32 rate = TRAPDEDUP_RATE, u32 burst = TRAPDEDUP_BURST);
+		void clear();
+		TrapVerdict check(in_addr_t source, const CompactOid &trapOid, const SnmpVarBind *varBinds, u32 nVarBinds, u64 now);
+		void sweep(u64 now);
+		bool popSummary(TrapSummary &summary);
+		inline u32 getNDuplicates() { return nDuplicates; }
+		inline u32 getNRateLimited() { return nRateLimited; }
+		inline u32 getNLostSummaries() { return nLostSummaries; }
+};
+
+}
+
+#endif
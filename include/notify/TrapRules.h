@@ -0,0 +1,189 @@
+/**
+ * @file TrapRules.h
+ * @brief User defined trap filtering and routing rules
+ */
+
+#ifndef TRAPRULES_H_
+#define TRAPRULES_H_
+
+// Includes C/C++
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+
+// Includes 3DS
+#include <3ds/types.h>
+
+// Includes jansson
+#include <jansson.h>
+
+// Own includes
+#include "asn1/CompactOid.h"
+#include "snmp/SnmpVarBind.h"
+
+// Defines
+#define TRAPRULES_MAX_RULES			1024			/**< Rules in a rule set, at most */
+#define TRAPRULES_MAX_VARBINDS		8				/**< VarBind conditions of a rule, at most */
+#define TRAPRULES_MAX_TAGS			8				/**< Tags added to a trap, at most */
+#define TRAPRULES_MAX_NAME			32				/**< Length of tags and log names, at most */
+
+// Defines rule actions
+#define TRAPRULE_DROP				0				/**< Do not store nor show the trap */
+#define TRAPRULE_TAG				1				/**< Store the trap with a tag */
+#define TRAPRULE_ROUTE				2				/**< Store the trap in another log */
+#define TRAPRULE_ALERT				3				/**< Show an alert instead of the usual notice */
+
+// Defines rule conditions, bits of the rule masks
+#define TRAPRULE_COND_TRAPOID		0
+#define TRAPRULE_COND_ENTERPRISE	1
+#define TRAPRULE_COND_SOURCE		2
+#define TRAPRULE_COND_VARBIND		3				/**< First VarBind condition */
+
+namespace NetMan {
+
+/**
+ * @struct TrapRuleVarBind
+ * @brief VarBind condition of a rule
+ */
+typedef struct {
+	std::string oid;							/**< VarBind OID prefix */
+	std::string value;							/**< Number, IP address, OID or string value, empty for any value */
+} TrapRuleVarBind;
+
+/**
+ * @struct TrapRule
+ * @brief Rule, as written by the user. Empty conditions match every trap.
+ */
+typedef struct {
+	std::string name;
+	u8 action;									/**< TRAPRULE_* */
+	std::string trapOid;						/**< Trap OID prefix */
+	std::string enterprise;						/**< Enterprise OID prefix */
+	std::string source;							/**< Source subnet, as a.b.c.d/len */
+	std::vector<TrapRuleVarBind> varBinds;		/**< Every one must be matched by some VarBind */
+	std::string argument;						/**< Tag, log name or alert text */
+} TrapRule;
+
+/**
+ * @struct TrapRuleMatch
+ * @brief Actions of the rules matched by a trap
+ */
+typedef struct {
+	bool drop;
+	const TrapRule *route;						/**< Log to store the trap in, or NULL for the trap log */
+	std::vector<const TrapRule*> tags;
+	std::vector<const TrapRule*> alerts;
+} TrapRuleMatch;
+
+/**
+ * @struct TrapRuleRef
+ * @brief Condition of a rule, stored in the rule set tables
+ */
+typedef struct {
+	u16 rule;
+	u8 condition;								/**< TRAPRULE_COND_* */
+} TrapRuleRef;
+
+/**
+ * @struct TrapRuleValue
+ * @brief VarBind value of a condition, in the forms a received value is compared with
+ */
+typedef struct {
+	bool isAny;									/**< Every value matches */
+	std::string text;							/**< OCTET STRING contents */
+	bool isNumber;
+	s64 number;									/**< INTEGER, Counter, Gauge or TimeTicks value */
+	bool isAddress;
+	in_addr_t address;							/**< IpAddress value */
+	CompactOid oid;								/**< OBJECT IDENTIFIER value, or empty */
+} TrapRuleValue;
+
+/**
+ * @struct TrapRuleState
+ * @brief Conditions of a rule met by the trap being matched
+ */
+typedef struct {
+	u32 generation;								/**< Trap the mask belongs to */
+	u32 mask;
+} TrapRuleState;
+
+/**
+ * @struct TrapTrieNode
+ * @brief Node of a TrapRuleTrie, whose edges and conditions are stored in ranges of shared arrays
+ */
+typedef struct {
+	u32 firstEdge;
+	u32 firstRef;
+	u16 nEdges;
+	u16 nRefs;
+} TrapTrieNode;
+
+/**
+ * @struct TrapTrieEdge
+ * @brief Edge of a TrapRuleTrie
+ */
+typedef struct {
+	u8 byte;
+	u32 node;
+} TrapTrieEdge;
+
+/**
+ * @class TrapRuleTrie
+ * @brief Trie of encoded OID prefixes, each with the rule conditions it belongs to
+ * @note Encoded arcs are prefix free, so a byte prefix ending on an arc boundary is also an arc prefix.
+ *       Prefixes are inserted first, then compile() packs the trie, whose edges are sorted and binary searched.
+ */
+class TrapRuleTrie {
+	private:
+		std::vector<TrapTrieNode> nodes;
+		std::vector<TrapTrieEdge> edges;
+		std::vector<TrapRuleRef> refs;
+		std::vector<std::vector<TrapTrieEdge>> newEdges;	/**< Edges of each node, until compiled */
+		std::vector<std::vector<TrapRuleRef>> newRefs;		/**< Conditions of each node, until compiled */
+	public:
+		TrapRuleTrie();
+		void insert(const CompactOid &prefix, TrapRuleRef ref);
+		void compile();
+		void match(const u8 *data, u32 length, std::vector<TrapRuleRef> &matched) const;
+		inline u32 getNNodes() const { return nodes.size(); }
+};
+
+/**
+ * @class TrapRuleSet
+ * @brief Compiled rules, matched against a trap in a time that depends on its OIDs and not on the number of rules
+ * @note Each condition is stored in a table: OID prefixes in tries over their encoded bytes, subnets in a hash table
+ *       per prefix length. A trap looks its OIDs and source up, and only the rules met there are counted. A rule is
+ *       matched when every condition is met. Every matched rule adds its tags and alerts, and the first matched
+ *       drop or route rule decides where the trap goes. match() is not thread safe.
+ */
+class TrapRuleSet {
+	private:
+		std::vector<TrapRule> rules;
+		std::vector<u32> masks;								/**< Conditions of each rule */
+		std::vector<std::vector<TrapRuleValue>> values;		/**< VarBind values of each rule */
+		TrapRuleTrie trapOids;
+		TrapRuleTrie enterprises;
+		TrapRuleTrie varBindOids;
+		std::unordered_map<u64, std::vector<TrapRuleRef>> subnets;	/**< Key is the prefix length << 32 | network */
+		std::vector<u8> prefixLengths;						/**< Used in subnets, longest first */
+		std::vector<u16> always;							/**< Rules without conditions */
+		std::vector<TrapRuleState> states;
+		std::vector<TrapRuleRef> matched;
+		std::vector<u16> touched;							/**< Rules with a condition met by the current trap */
+		u32 generation;
+		void hit(u16 rule, u32 mask);
+		static bool matchValue(const TrapRuleValue &expected, const VarBindValue &value);
+	public:
+		TrapRuleSet();
+		TrapRuleSet(const std::vector<TrapRule> &rules);
+		void match(in_addr_t source, const CompactOid &trapOid, const CompactOid &enterprise,
+			const SnmpVarBind *varBinds, u32 nVarBinds, TrapRuleMatch &result);
+		inline u32 getNRules() const { return rules.size(); }
+		static void parse(json_t *root, std::vector<TrapRule> &rules);
+		static bool parseSubnet(const std::string &text, u32 *network, u8 *length);
+};
+
+}
+
+#endif
@@ -6,9 +6,51 @@
 #ifndef SNMP_H_
 #define SNMP_H_
 
+// Own includes
+#include "asn1/BerView.h"
+
 // General SNMP defines
 //#define SNMP_DEBUG				true
 #define SNMP_MAX_PDU_SIZE		(64 << 10)
 #define SNMP_PDU_ANY            0xFFFFFFFF
 
+namespace NetMan {
+
+/**
+ * @enum SnmpStatus
+ * @brief Result of the non-throwing SNMP decoding functions (BER errors keep their BerStatus value)
+ */
+enum SnmpStatus {
+	SNMP_OK = BER_OK,
+	SNMP_ERROR_TRUNCATED = BER_ERROR_TRUNCATED,
+	SNMP_ERROR_LONG_TAG = BER_ERROR_LONG_TAG,
+	SNMP_ERROR_LENGTH = BER_ERROR_LENGTH,
+	SNMP_ERROR_TAG = BER_ERROR_TAG,
+	SNMP_ERROR_VALUE = BER_ERROR_VALUE,
+	SNMP_ERROR_TIMEOUT = BER_NSTATUS,	/**< Nothing received */
+	SNMP_ERROR_RECV,
+	SNMP_ERROR_SOURCE_IP,
+	SNMP_ERROR_SOURCE_PORT,
+	SNMP_ERROR_VERSION,
+	SNMP_ERROR_COMMUNITY,
+	SNMP_ERROR_PDU_TYPE,
+	SNMP_ERROR_REQUEST_ID,
+	SNMP_ERROR_RESPONSE,				/**< Well formed response with a non-zero error-status */
+	SNMP_ERROR_NOT_NOTIFICATION,
+	SNMP_ERROR_SECURITY,				/**< SNMPv3 message rejected by the security model, or a REPORT */
+	SNMP_ERROR_SEND,					/**< The acknowledgement of an inform could not be sent */
+};
+
+/**
+ * @struct SnmpResult
+ */
+typedef struct {
+	SnmpStatus status;
+	u32 offset;				/**< Offset of the offending field in the message */
+	u32 errorStatus;		/**< error-status of the response, for SNMP_ERROR_RESPONSE */
+	u32 errorIndex;			/**< error-index of the response, for SNMP_ERROR_RESPONSE */
+} SnmpResult;
+
+}
+
 #endif
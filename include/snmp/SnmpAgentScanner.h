@@ -39,9 +39,10 @@ class SnmpAgentScanner {
         std::shared_ptr<BerOid> oid[SNMPAGENT_NOID];
         std::shared_ptr<BerNull> nullVal;
         std::unordered_map<in_addr_t, SnmpAgentEntry> agents;
-        std::string &getStringFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i);
+        const VarBindValue &getVarBindValue(std::shared_ptr<Snmpv1Pdu> pdu, u8 i, VarBindType type);
+        std::string getStringFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i);
         std::string getOidFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i);
-        std::shared_ptr<BerInteger> getIntegerFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i);
+        u32 getIntegerFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i);
     public:
         SnmpAgentScanner();
         void scanAgents(in_addr_t baseIP, u16 nhosts, u16 port, u8 version, u8 maxRequests, u8 timeout, u8 *progress);
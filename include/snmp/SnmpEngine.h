@@ -0,0 +1,107 @@
+/**
+ * @file SnmpEngine.h
+ * @brief Asynchronous SNMP request multiplexer
+ */
+
+#ifndef SNMPENGINE_H_
+#define SNMPENGINE_H_
+
+// Includes C/C++
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Own includes
+#include "snmp/Snmpv2Pdu.h"
+#include "snmp/Snmpv3Pdu.h"
+#include "socket/UdpSocket.h"
+
+// Defines
+#define SNMPENGINE_DEFAULT_TIMEOUT	1000		/**< Time to wait for each try, in ms */
+#define SNMPENGINE_DEFAULT_RETRIES	2			/**< Retransmissions before giving up */
+#define SNMPENGINE_MAX_REQUEST_ID	0x7FFFFFFF	/**< request-id is a signed INTEGER */
+
+namespace NetMan {
+
+/**
+ * @struct SnmpEngineResponse
+ * @brief Outcome of a request, given to its completion callback
+ */
+typedef struct {
+	u32 requestID;						/**< Request ID (msgID for SNMPv3) */
+	SnmpResult result;					/**< SNMP_OK, SNMP_ERROR_TIMEOUT or the decoding result */
+	std::string errorText;				/**< Error description, if result is not SNMP_OK */
+	u8 pduType;							/**< Received PDU type */
+	u32 size;							/**< Received message size */
+	std::shared_ptr<Snmpv1Pdu> pdu;		/**< PDU used for the request, holding the received VarBinds (SNMPv1/v2c) */
+	std::shared_ptr<Snmpv3Pdu> v3pdu;	/**< PDU used for the request, holding the received VarBinds (SNMPv3) */
+	void *args;							/**< Callback arguments */
+} SnmpEngineResponse;
+
+/**
+ * @brief Completion callback of a request
+ * @param response Request outcome. The received VarBinds are valid until the engine receives again.
+ */
+typedef void (*SnmpEngineCallback)(SnmpEngineResponse *response);
+
+/**
+ * @struct SnmpEngineRequest
+ * @brief Outstanding request
+ */
+typedef struct {
+	std::vector<u8> message;			/**< Encoded message, sent again on retries */
+	in_addr_t ip;						/**< Agent IP */
+	u16 port;							/**< Agent port */
+	u64 deadline;						/**< When the current try times out, in osGetTime() ms */
+	u32 timeout;						/**< Time to wait for each try, in ms */
+	u8 retries;							/**< Remaining retransmissions */
+	std::shared_ptr<Snmpv1Pdu> pdu;
+	std::shared_ptr<Snmpv3Pdu> v3pdu;
+	std::string requestPdu;				/**< SNMPv3 PDU, encoded again if the agent reports other engine parameters */
+	bool resent;						/**< If it was already encoded again */
+	SnmpEngineCallback callback;
+	void *args;
+} SnmpEngineRequest;
+
+/**
+ * @class SnmpEngine
+ * @brief Keeps many SNMP requests in flight over a single UDP socket, routing the responses by request ID
+ * @note The engine is not thread safe, every call must be done from the same thread.
+ *       SNMPv3 requests use the agent engine kept in Snmpv3EngineCache, and are sent once more when the agent
+ *       reports an unknown engine ID or a message out of its time window.
+ *       Several requests can share a PDU, as long as their callbacks read its VarBinds before sending it again.
+ */
+class SnmpEngine {
+	private:
+		std::shared_ptr<UdpSocket> sock;
+		std::unique_ptr<u8[]> recvBuffer;
+		std::unordered_map<u32, SnmpEngineRequest> requests;	/**< Outstanding requests, by request ID */
+		u32 requestID;											/**< Last used request ID */
+		u32 timeout;
+		u8 retries;
+		u32 generateRequestID();
+		void addRequest(u32 id, u8 *data, u32 size, in_addr_t ip, u16 port, SnmpEngineCallback callback, void *args, std::shared_ptr<Snmpv1Pdu> pdu, std::shared_ptr<Snmpv3Pdu> v3pdu);
+		static bool peekRequestID(const u8 *data, u32 size, u32 *id);
+		u32 dispatch(u32 size);
+		bool resend(SnmpEngineRequest &request);
+		u32 checkTimeouts(u64 now);
+		void complete(u32 id, const SnmpResult &result, u8 pduType, u32 size, const std::string &errorText);
+	public:
+		SnmpEngine(u32 timeout = SNMPENGINE_DEFAULT_TIMEOUT, u8 retries = SNMPENGINE_DEFAULT_RETRIES);
+		u32 sendRequest(std::shared_ptr<Snmpv1Pdu> pdu, u32 type, in_addr_t ip, u16 port, SnmpEngineCallback callback, void *args = NULL);
+		u32 sendBulkRequest(std::shared_ptr<Snmpv2Pdu> pdu, u32 nonRepeaters, u32 maxRepetitions, in_addr_t ip, u16 port, SnmpEngineCallback callback, void *args = NULL);
+		u32 sendRequest(std::shared_ptr<Snmpv3Pdu> pdu, u32 type, in_addr_t ip, u16 port, SnmpEngineCallback callback, void *args = NULL, u32 nonRepeaters = 0, u32 maxRepetitions = 0);
+		bool cancel(u32 id);
+		u32 poll(u32 waitMs = 0);
+		void wait(u32 id);
+		void waitAll();
+		inline bool isPending(u32 id) { return this->requests.count(id) != 0; }
+		inline u32 getNPending() { return this->requests.size(); }
+		inline u32 getTimeout() { return this->timeout; }
+		inline std::shared_ptr<UdpSocket> getSocket() { return this->sock; }
+};
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file SnmpPlanner.h
+ * @brief Coalescing of SNMP GET requests
+ */
+
+#ifndef SNMPPLANNER_H_
+#define SNMPPLANNER_H_
+
+// Includes C/C++
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Own includes
+#include "snmp/SnmpEngine.h"
+#include "asn1/CompactOid.h"
+
+// Defines
+#define SNMPPLANNER_DEFAULT_MAX_SIZE	1472	/**< Message size assumed for SNMPv1/v2c agents (an Ethernet frame) */
+#define SNMPPLANNER_HEADER_SIZE			32		/**< SNMPv1/v2c message overhead, besides the community */
+#define SNMPPLANNER_V3_HEADER_SIZE		160		/**< SNMPv3 message overhead, with usual engine ID, user name and USM parameters */
+#define SNMPPLANNER_VALUE_SIZE			24		/**< First guess of the encoded size of a received value */
+
+namespace NetMan {
+
+/**
+ * @brief Called once for each planned GET
+ * @param varBind	Received VarBind, or NULL if the GET failed
+ * @param result	Request result
+ * @param errorText	Error description, if result is not SNMP_OK
+ * @param args		Callback arguments
+ * @note The planner must not be flushed from the callback, as sending a request drops the received VarBinds
+ */
+typedef void (*SnmpPlannerCallback)(const SnmpVarBind *varBind, const SnmpResult &result, const std::string &errorText, void *args);
+
+/**
+ * @struct SnmpPlannerWaiter
+ * @brief Caller waiting for an OID
+ */
+typedef struct {
+	SnmpPlannerCallback callback;
+	void *args;
+} SnmpPlannerWaiter;
+
+/**
+ * @struct SnmpPlannedOid
+ * @brief OID to get, with everyone that asked for it
+ */
+typedef struct {
+	CompactOid oid;
+	std::vector<SnmpPlannerWaiter> waiters;
+} SnmpPlannedOid;
+
+/**
+ * @struct SnmpPlannerTarget
+ * @brief Agent and security context, with the GETs not sent yet
+ */
+typedef struct {
+	std::shared_ptr<Snmpv1Pdu> pdu;
+	std::shared_ptr<Snmpv3Pdu> v3pdu;
+	in_addr_t ip;
+	u16 port;
+	u32 maxSize;										/**< Largest message the agent can send */
+	u32 headerSize;										/**< Estimated message overhead */
+	u32 valueSize;										/**< Average encoded size of the received values */
+	bool tooBig;										/**< The agent answered tooBig, so maxSize is an estimation */
+	std::vector<SnmpPlannedOid> pending;
+	std::unordered_map<CompactOid, u32, CompactOidHash> pendingMap;	/**< Position in pending, by OID */
+} SnmpPlannerTarget;
+
+/**
+ * @struct SnmpPlannerBatch
+ * @brief GETs sent in the same request
+ */
+typedef struct {
+	u32 target;
+	u32 size;											/**< Estimated response size */
+	std::vector<SnmpPlannedOid> oids;
+} SnmpPlannerBatch;
+
+/**
+ * @class SnmpPlanner
+ * @brief Merges the GETs for the same agent and security context into as few requests as the agent message size allows
+ * @note Requests answered with tooBig are split in halves and sent again. Failing VarBinds of SNMPv1 requests
+ *       are reported to their callers only, and the rest of the request is sent again.
+ */
+class SnmpPlanner {
+	private:
+		std::shared_ptr<SnmpEngine> engine;
+		std::vector<SnmpPlannerTarget> targets;
+		std::unordered_map<u32, SnmpPlannerBatch> batches;	/**< Outstanding requests, by request ID */
+		u32 findTarget(std::shared_ptr<Snmpv1Pdu> pdu, std::shared_ptr<Snmpv3Pdu> v3pdu, in_addr_t ip, u16 port);
+		void addGet(u32 target, const CompactOid &oid, SnmpPlannerCallback callback, void *args);
+		u32 getVarBindSize(const SnmpPlannerTarget &target, const CompactOid &oid);
+		void sendBatch(SnmpPlannerBatch &batch);
+		void splitBatch(SnmpPlannerBatch &batch);
+		static void failOids(const std::vector<SnmpPlannedOid> &oids, u32 start, u32 end, const SnmpResult &result, const std::string &errorText);
+		static void onResponse(SnmpEngineResponse *response);
+		void handleResponse(SnmpEngineResponse *response, SnmpPlannerBatch &batch);
+	public:
+		SnmpPlanner(std::shared_ptr<SnmpEngine> engine);
+		void get(std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port, const CompactOid &oid, SnmpPlannerCallback callback, void *args = NULL);
+		void get(std::shared_ptr<Snmpv3Pdu> pdu, in_addr_t ip, u16 port, const CompactOid &oid, SnmpPlannerCallback callback, void *args = NULL);
+		void setMaxSize(std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port, u32 maxSize);
+		u32 flush();
+		void wait();
+		inline u32 getNOutstanding() { return batches.size(); }
+};
+
+}
+
+#endif
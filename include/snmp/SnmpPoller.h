@@ -0,0 +1,143 @@
+/**
+ * @file SnmpPoller.h
+ * @brief Periodic SNMP polling
+ */
+
+#ifndef SNMPPOLLER_H_
+#define SNMPPOLLER_H_
+
+// Includes C/C++
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Includes 3DS
+#include <3ds.h>
+
+// Own includes
+#include "snmp/SnmpPlanner.h"
+#include "snmp/TimingWheel.h"
+
+// Defines
+#define SNMPPOLLER_TICK_MS				10			/**< Scheduling resolution, in ms */
+#define SNMPPOLLER_MAX_AGENT_POLLS		2			/**< Polls in flight to the same agent */
+#define SNMPPOLLER_STACKSIZE			(16 << 10)
+
+namespace NetMan {
+
+/**
+ * @struct SnmpPollSample
+ * @brief Value received for a polled OID
+ */
+typedef struct {
+	u32 target;								/**< Poll target ID */
+	u32 index;								/**< OID position in the target */
+	const SnmpVarBind *varBind;				/**< Received VarBind, or NULL if the GET failed */
+	SnmpResult result;						/**< Request result */
+	u64 time;								/**< Reception time, in osGetTime() ms */
+	bool hasRate;							/**< If rate is valid (counters with a previous sample) */
+	double rate;							/**< Counter increase per second since the previous sample */
+} SnmpPollSample;
+
+/**
+ * @brief Called for each polled OID
+ * @param sample	Received sample
+ * @param args		Callback arguments
+ * @note It is called from the poller thread, with the poller locked, so it must not call the poller
+ */
+typedef void (*SnmpPollerCallback)(const SnmpPollSample *sample, void *args);
+
+class SnmpPoller;
+
+/**
+ * @struct SnmpPolledOid
+ * @brief Polled OID, with its last counter value
+ */
+typedef struct {
+	CompactOid oid;
+	SnmpPoller *poller;
+	u32 target;								/**< Poll target ID */
+	u32 index;								/**< Position in the target */
+	u64 lastValue;
+	u64 lastTime;
+	bool hasLast;							/**< If lastValue holds a counter */
+} SnmpPolledOid;
+
+/**
+ * @struct SnmpPollTarget
+ * @brief OIDs polled together from an agent
+ */
+typedef struct {
+	TimingWheelTimer timer;
+	SnmpPoller *poller;
+	u32 id;
+	u32 agent;								/**< Agent position */
+	u32 interval;							/**< Poll interval, in ms */
+	u64 nextTime;							/**< Next poll time, in osGetTime() ms */
+	std::vector<SnmpPolledOid> oids;
+	u32 nWaiting;							/**< OIDs of the current poll not received yet */
+	bool polling;
+	bool queued;							/**< Waiting for a free poll slot of its agent */
+	bool active;							/**< false once removed */
+	u32 nOverruns;							/**< Polls skipped because the previous one was still running */
+	SnmpPollerCallback callback;
+	void *args;
+} SnmpPollTarget;
+
+/**
+ * @struct SnmpPollAgent
+ * @brief Agent and security context shared by some poll targets
+ */
+typedef struct {
+	std::shared_ptr<Snmpv1Pdu> pdu;
+	std::shared_ptr<Snmpv3Pdu> v3pdu;
+	in_addr_t ip;
+	u16 port;
+	u32 nPolling;							/**< Polls in flight */
+	std::deque<u32> waiting;				/**< Targets waiting for a free poll slot */
+} SnmpPollAgent;
+
+/**
+ * @class SnmpPoller
+ * @brief Polls sets of OIDs at fixed intervals, from its own thread
+ * @note Targets are scheduled in a timing wheel, starting at a random point of their interval so that they
+ *       do not poll all at once. The GETs due at the same time are merged by a SnmpPlanner.
+ *       Once started, the engine must not be used by anyone else.
+ */
+class SnmpPoller {
+	private:
+		std::shared_ptr<SnmpEngine> engine;
+		SnmpPlanner planner;
+		TimingWheel wheel;
+		std::vector<std::shared_ptr<SnmpPollTarget>> targets;	/**< Poll targets, by ID (nullptr once removed) */
+		std::vector<SnmpPollAgent> agents;
+		u32 maxAgentPolls;
+		LightLock lock;
+		Thread thread;
+		volatile bool running;
+		u32 nPolls;
+		u32 findAgent(std::shared_ptr<Snmpv1Pdu> pdu, std::shared_ptr<Snmpv3Pdu> v3pdu, in_addr_t ip, u16 port);
+		u32 createTarget(u32 agent, const std::vector<CompactOid> &oids, u32 interval, SnmpPollerCallback callback, void *args);
+		void startPoll(SnmpPollTarget *target);
+		void finishPoll(SnmpPollTarget *target);
+		static bool computeRate(SnmpPolledOid &oid, const VarBindValue &value, u64 time, double *rate);
+		static void onTimer(void *args);
+		static void onValue(const SnmpVarBind *varBind, const SnmpResult &result, const std::string &errorText, void *args);
+		static void threadMain(void *args);
+	public:
+		SnmpPoller(std::shared_ptr<SnmpEngine> engine, u32 tickMs = SNMPPOLLER_TICK_MS, u32 maxAgentPolls = SNMPPOLLER_MAX_AGENT_POLLS);
+		virtual ~SnmpPoller();
+		u32 addTarget(std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port, const std::vector<CompactOid> &oids, u32 interval, SnmpPollerCallback callback, void *args = NULL);
+		u32 addTarget(std::shared_ptr<Snmpv3Pdu> pdu, in_addr_t ip, u16 port, const std::vector<CompactOid> &oids, u32 interval, SnmpPollerCallback callback, void *args = NULL);
+		void removeTarget(u32 id);
+		void step(u32 waitMs);
+		void start();
+		void stop();
+		inline bool isRunning() { return running; }
+		inline u32 getNPolls() { return nPolls; }
+		u32 getNOverruns(u32 id);
+};
+
+}
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file SnmpTable.h
+ * @brief Whole SNMP table retrieval, stored by columns
+ */
+
+#ifndef SNMPTABLE_H_
+#define SNMPTABLE_H_
+
+// Includes C/C++
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Own includes
+#include "snmp/Mib.h"
+#include "snmp/SnmpWalk.h"
+#include "asn1/CompactOid.h"
+
+// Defines
+#define SNMPTABLE_MAX_WALKS		8		/**< Columns walked at the same time */
+
+namespace NetMan {
+
+/**
+ * @enum SnmpIndexType
+ * @brief How an INDEX object is encoded in the instance OID (RFC 2578, section 7.7)
+ */
+enum SnmpIndexType {
+	SNMPINDEX_INTEGER = 0,			/**< A single arc */
+	SNMPINDEX_IPADDRESS,			/**< Four arcs */
+	SNMPINDEX_STRING,				/**< One arc per octet, preceded by the length unless fixed size or IMPLIED */
+	SNMPINDEX_OID,					/**< The arcs, preceded by their number unless IMPLIED */
+};
+
+/**
+ * @struct SnmpTableIndex
+ * @brief INDEX object of a table
+ */
+typedef struct {
+	std::string name;
+	SnmpIndexType type;
+	u32 size;						/**< Length of fixed size strings, or 0 */
+	bool implied;					/**< IMPLIED keyword, only valid for the last object */
+} SnmpTableIndex;
+
+/**
+ * @struct SnmpTableColumn
+ * @brief Column of a table, holding the value of every row
+ */
+typedef struct {
+	std::string name;
+	CompactOid oid;
+	char type;						/**< Type of the values, with the same characters as PduField, or '\0' if unknown */
+	std::vector<std::string> values;	/**< Printed values, by row ("" for rows without this column) */
+} SnmpTableColumn;
+
+/**
+ * @class SnmpTable
+ * @brief Fetches all the rows of a table, walking its columns in parallel, and keeps them in memory
+ */
+class SnmpTable {
+	private:
+		std::vector<SnmpTableColumn> columns;
+		std::vector<SnmpTableIndex> indexes;
+		std::vector<CompactOid> rows;								/**< Row instances, as OID suffixes */
+		std::unordered_map<CompactOid, u32, CompactOidHash> rowMap;	/**< Row position, by instance */
+		void parseIndexes(std::shared_ptr<Mib> mib, const std::string &entryName);
+		u32 getRow(const CompactOid &instance);
+		void addValue(u32 column, const SnmpVarBind *varBind);
+		void sortRows();
+		static bool addVarBind(const SnmpVarBind *varBind, void *args);
+		template<class T> void fetchColumns(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<T> pdu, in_addr_t ip, u16 port);
+	public:
+		SnmpTable(std::shared_ptr<Mib> mib, const std::string &tableName);
+		void fetch(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port);
+		void fetch(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<Snmpv3Pdu> pdu, in_addr_t ip, u16 port);
+		void clear();
+		inline u32 getNColumns() { return columns.size(); }
+		inline const SnmpTableColumn &getColumn(u32 column) { return columns[column]; }
+		inline u32 getNRows() { return rows.size(); }
+		inline const std::string &getValue(u32 column, u32 row) { return columns[column].values[row]; }
+		inline const std::vector<SnmpTableIndex> &getIndexes() { return indexes; }
+		CompactOid getInstanceOid(u32 column, u32 row);
+		std::string printIndex(u32 row);
+};
+
+}
+
+#endif
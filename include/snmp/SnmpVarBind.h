@@ -0,0 +1,81 @@
+/**
+ * @file SnmpVarBind.h
+ * @brief Typed SNMP VarBind values
+ */
+
+#ifndef SNMPVARBIND_H_
+#define SNMPVARBIND_H_
+
+// Includes C/C++
+#include <memory>
+#include <string>
+
+// Own includes
+#include <3ds/types.h>
+#include "asn1/BerArena.h"
+#include "asn1/BerField.h"
+#include "asn1/BerView.h"
+#include "asn1/CompactOid.h"
+
+namespace NetMan {
+
+/**
+ * @enum VarBindType
+ * @brief Kind of value held by a VarBindValue
+ */
+enum VarBindType {
+	VARBIND_NULL = 0,
+	VARBIND_INTEGER,				/**< INTEGER */
+	VARBIND_UNSIGNED,				/**< Counter32, Gauge32 and TimeTicks (see getTag()) */
+	VARBIND_COUNTER64,				/**< Counter64 */
+	VARBIND_OCTETS,					/**< OCTET STRING, IpAddress and Opaque (see getTag()) */
+	VARBIND_OID,					/**< OBJECT IDENTIFIER */
+	VARBIND_NOSUCHOBJECT,			/**< noSuchObject exception */
+	VARBIND_NOSUCHINSTANCE,			/**< noSuchInstance exception */
+	VARBIND_ENDOFMIBVIEW,			/**< endOfMibView exception */
+};
+
+/**
+ * @class VarBindValue
+ * @brief Decoded VarBind value, stored as a tagged union
+ * @note Octet strings and OIDs point into the received message, so they are only valid until the next reception
+ */
+class VarBindValue {
+	private:
+		union {
+			s64 integer;
+			u64 uinteger;
+			const u8 *data;
+		};
+		u32 length;			/**< Contents length, for octet strings and OIDs */
+		u8 type;			/**< VarBindType */
+		u8 tag;				/**< Identifier octet */
+	public:
+		VarBindValue();
+		static BerStatus decode(const BerView &view, VarBindValue *value);
+		inline VarBindType getType() const { return (VarBindType)type; }
+		inline u8 getTag() const { return tag; }
+		inline bool isException() const { return type >= VARBIND_NOSUCHOBJECT; }
+		inline s64 getInteger() const { return integer; }
+		inline u64 getUnsigned() const { return uinteger; }
+		inline const u8 *getOctets() const { return data; }
+		inline u32 getLength() const { return length; }
+		std::string getString() const;
+		CompactOid getOid() const;
+		bool equals(const std::string &text) const;
+		std::string print() const;
+		std::shared_ptr<BerField> toBerField(const std::shared_ptr<BerArena> &arena = nullptr) const;
+};
+
+/**
+ * @struct SnmpVarBind
+ * @brief Received VarBind, pointing into the received PDU
+ */
+typedef struct {
+	BerView oid;
+	VarBindValue value;
+} SnmpVarBind;
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file SnmpWalk.h
+ * @brief Adaptive SNMP subtree walk
+ */
+
+#ifndef SNMPWALK_H_
+#define SNMPWALK_H_
+
+// Includes C/C++
+#include <memory>
+#include <string>
+
+// Own includes
+#include "snmp/SnmpEngine.h"
+#include "asn1/CompactOid.h"
+
+// Defines
+#define SNMPWALK_INITIAL_REPETITIONS	10			/**< max-repetitions of the first GetBulkRequest */
+#define SNMPWALK_MAX_REPETITIONS		4096		/**< Upper bound for max-repetitions */
+#define SNMPWALK_TARGET_SIZE			(48 << 10)	/**< Response size the walk tries not to exceed, in bytes */
+
+namespace NetMan {
+
+/**
+ * @brief Called for each VarBind inside the walked subtree, in order
+ * @param varBind	Received VarBind, valid only during the call
+ * @param args		Callback arguments
+ * @return false to stop the walk
+ */
+typedef bool (*SnmpWalkCallback)(const SnmpVarBind *varBind, void *args);
+
+/**
+ * @class SnmpWalk
+ * @brief Retrieves every object under an OID, with GetBulkRequests (GetNextRequests for SNMPv1 PDUs)
+ * @note max-repetitions is tuned after each response, from its size, the round trip time, tooBig errors
+ *       and the number of VarBinds the agent is willing to return
+ */
+class SnmpWalk {
+	private:
+		std::shared_ptr<SnmpEngine> engine;
+		std::shared_ptr<Snmpv1Pdu> pdu;
+		std::shared_ptr<Snmpv3Pdu> v3pdu;
+		in_addr_t ip;
+		u16 port;
+		bool bulk;								/**< GetBulkRequest or GetNextRequest */
+		CompactOid root;						/**< Walked subtree */
+		CompactOid lastOid;						/**< Last received OID, asked for in the next request */
+		SnmpWalkCallback callback;
+		void *args;
+		u32 requestID;							/**< Outstanding request, or 0 */
+		u64 sendTime;							/**< When the outstanding request was sent, in osGetTime() ms */
+		u32 repetitions;						/**< max-repetitions of the next request */
+		u32 repetitionsLimit;					/**< max-repetitions known to work with this agent */
+		u32 nRequests;
+		u32 nVarBinds;
+		bool running;
+		SnmpResult result;
+		std::string errorText;
+		void initialize(std::shared_ptr<SnmpEngine> engine, in_addr_t ip, u16 port);
+		void sendNext();
+		bool shrink();
+		void adapt(u32 nReceived, u32 size, u32 rtt);
+		bool handleVarBinds(const SnmpVarBind *varBinds, u32 n);
+		void finish(const SnmpResult &result, const std::string &errorText);
+		static void onResponse(SnmpEngineResponse *response);
+	public:
+		SnmpWalk(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port);
+		SnmpWalk(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<Snmpv3Pdu> pdu, in_addr_t ip, u16 port);
+		~SnmpWalk();
+		void start(const CompactOid &root, SnmpWalkCallback callback, void *args = NULL);
+		void run(const CompactOid &root, SnmpWalkCallback callback, void *args = NULL);
+		void stop();
+		inline bool isRunning() { return running; }
+		inline const SnmpResult &getResult() { return result; }
+		inline const std::string &getErrorText() { return errorText; }
+		inline u32 getNRequests() { return nRequests; }
+		inline u32 getNVarBinds() { return nVarBinds; }
+		inline u32 getRepetitions() { return repetitions; }
+};
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 
 // Includes C/C++
 #include <memory>
+#include <vector>
 
 // Includes jansson
 #include <jansson.h>
@@ -18,7 +19,10 @@
 #include "asn1/BerOid.h"
 #include "asn1/BerNull.h"
 #include "asn1/BerOctetString.h"
+#include "asn1/BerView.h"
+#include "asn1/CompactOid.h"
 #include "Snmp.h"
+#include "SnmpVarBind.h"
 
 // Defines
 #define SNMPV1_VERSION			0
@@ -49,6 +53,20 @@
 #define SNMPV1_TAGCLASS_OPAQUE		 	BER_TAG_APPLICATION		/* OCTET STRING */
 #define SNMPV1_TAG_OPAQUE				4
 
+// Defines trap fields
+#define SNMPV1_TRAP_ENTERPRISE		0
+#define SNMPV1_TRAP_AGENTADDR		1
+#define SNMPV1_TRAP_GENERIC			2
+#define SNMPV1_TRAP_SPECIFIC		3
+#define SNMPV1_TRAP_TIMESTAMP		4
+#define SNMPV1_TRAP_NFIELDS			5
+#define SNMPV1_TRAP_ENTERPRISESPECIFIC	6	/**< Generic trap number of the enterprise specific traps */
+
+// Defines notification OIDs (RFC 3584)
+#define SNMP_TRAPOID_OID			"1.3.6.1.6.3.1.1.4.1.0"		/**< snmpTrapOID.0 */
+#define SNMP_TRAPENTERPRISE_OID		"1.3.6.1.6.3.1.1.4.3.0"		/**< snmpTrapEnterprise.0 */
+#define SNMP_TRAPS_OID				"1.3.6.1.6.3.1.1.5"			/**< snmpTraps, parent of the generic traps */
+
 namespace NetMan {
 
 /**
@@ -60,26 +78,52 @@ class Snmpv1Pdu: public BerPdu {
 		std::shared_ptr<BerSequence> varBindList;
 		std::shared_ptr<BerSequence> generateHeader(u32 ver);
 		std::shared_ptr<BerSequence> generateRequest(u32 type);
-		static std::shared_ptr<BerSequence> recvResponse(u8 **ptr, bool checkResponseID, u32 reqID, u8 *pduType, u32 expectedPduType = SNMPV1_GETRESPONSE);
-		static void addVarBind(std::shared_ptr<BerSequence> vbList, std::shared_ptr<BerOid> oid, std::shared_ptr<BerField> value);
-		void checkHeader(u8 **ptr);
+		static SnmpResult makeResult(SnmpStatus status, const u8 *base, const u8 *at);
+		static SnmpResult readField(BerReader &reader, const u8 *base, u8 tag, BerView *view);
+		static SnmpResult readInteger(BerReader &reader, const u8 *base, u32 *value);
+		static SnmpResult decodeResponse(BerReader &reader, const u8 *base, bool checkResponseID, u32 *reqID, u8 *pduType, u32 expectedPduType, std::vector<SnmpVarBind> &varBinds);
+		static SnmpResult decodeVarBindList(BerReader &reader, const u8 *base, std::vector<SnmpVarBind> &varBinds);
+		static std::shared_ptr<BerSequence> buildVarBindList(const std::vector<SnmpVarBind> &varBinds, const std::shared_ptr<BerArena> &arena = nullptr);
+		static void addVarBind(std::shared_ptr<BerSequence> vbList, std::shared_ptr<BerOid> oid, std::shared_ptr<BerField> value, const std::shared_ptr<BerArena> &arena = nullptr);
+		SnmpResult checkHeader(BerReader &reader, const u8 *base);
+		SnmpResult recvPacket(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 *size);
+		u8 *getRecvBuffer();
+		u32 generateRequestID();
+		void clearTrapFields();
 		static u32 requestID;
 		u32 reqID;
+		u32 fixedReqID;									/**< Request ID used by the next requests, or 0 to use the global counter */
 		std::string community;
+		std::unique_ptr<u8[]> recvBuffer;				/**< Reception buffer, reused between PDUs */
+		std::vector<SnmpVarBind> varBinds;				/**< Received VarBinds, pointing into recvBuffer */
+		BerView trapFields[SNMPV1_TRAP_NFIELDS];		/**< Received SNMPv1 trap fields */
 	public:
 		Snmpv1Pdu(const std::string &community);
 		void clear() override;
 		void emptyVarBindList();
 		void addVarBind(std::shared_ptr<BerOid> oid, std::shared_ptr<BerField> value);
+		u8 *encodeRequest(u32 type, u32 *size);
 		virtual void sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port);
 		virtual u8 recvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t, u16 port, u32 expectedPduType = SNMPV1_GETRESPONSE);
-		virtual void recvTrap(std::shared_ptr<UdpSocket> sock);
-		std::shared_ptr<BerField> getVarBind(u16 i);
-        std::shared_ptr<BerOid> getVarBindOid(u16 i);
-        inline u32 getNVarBinds() { return this->varBindList->getNChildren(); }
+		void recvTrap(std::shared_ptr<UdpSocket> sock);
+		u8 parseResponse(const u8 *data, u32 size, bool checkResponseID, u32 expectedPduType = SNMPV1_GETRESPONSE);
+		void parseTrap(const u8 *data, u32 size);
+		SnmpResult tryParseResponse(const u8 *data, u32 size, bool checkResponseID, u32 expectedPduType, u8 *pduType);
+		SnmpResult tryParseTrap(const u8 *data, u32 size);
+		SnmpResult tryRecvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 expectedPduType, u8 *pduType);
+		virtual SnmpResult tryRecvTrap(std::shared_ptr<UdpSocket> sock);
+		static std::string getErrorString(const SnmpResult &result);
+		static void checkResult(const SnmpResult &result);
+		inline u32 getNVarBinds() { return this->varBinds.size(); }
+		inline const SnmpVarBind *getVarBinds() { return this->varBinds.data(); }
+		inline const SnmpVarBind &getVarBind(u16 i) { return this->varBinds[i]; }
+		inline const BerView &getTrapField(u8 i) { return this->trapFields[i]; }
+		virtual bool getTrapOid(CompactOid &trapOid, CompactOid &enterprise);
         virtual std::shared_ptr<json_t> serializeTrap();
 		~Snmpv1Pdu();
         inline static void setGlobalRequestID(u32 rid) { Snmpv1Pdu::requestID = rid; }
+		inline void setRequestID(u32 rid) { this->fixedReqID = rid; this->reqID = rid; }
+		inline const std::string &getCommunity() { return this->community; }
 };
 
 }
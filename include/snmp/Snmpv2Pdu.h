@@ -61,10 +61,14 @@ namespace NetMan {
 class Snmpv2Pdu: public Snmpv1Pdu {
 	private:
 		std::shared_ptr<BerSequence> generateBulkRequest(u32 nonRepeaters, u32 maxRepetitions);
+		static bool findTrapOid(const std::vector<SnmpVarBind> &varBinds, CompactOid &trapOid, CompactOid &enterprise);
+		bool sendInformAck(std::shared_ptr<UdpSocket> sock);
 	public:
 		Snmpv2Pdu(const std::string &community);
+        u8 *encodeBulkRequest(u32 nonRepeaters, u32 maxRepetitions, u32 *size);
         virtual void sendBulkRequest(u32 nonRepeaters, u32 maxRepetitions, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port);
-		virtual void recvTrap(std::shared_ptr<UdpSocket> sock) override;
+		SnmpResult tryRecvTrap(std::shared_ptr<UdpSocket> sock) override;
+		bool getTrapOid(CompactOid &trapOid, CompactOid &enterprise) override;
         std::shared_ptr<json_t> serializeTrap() override;
 		~Snmpv2Pdu();
 		friend class Snmpv3Pdu;
@@ -26,8 +26,10 @@ class Snmpv3AuthMD5 : public Snmpv3AuthProto {
     public:
         Snmpv3AuthMD5();
         virtual ~Snmpv3AuthMD5();
-        void createHash(const u8 *data, u32 length, Snmpv3SecurityParams &params, std::shared_ptr<u8> keyptr) override;
-        std::shared_ptr<u8> passwordToKey(const std::string &password, Snmpv3SecurityParams &params) override;
+        void initContext(const u8 *key, Snmpv3AuthContext &context) override;
+        void createHash(const u8 *data, u32 length, u8 *hash, const Snmpv3AuthContext &context) override;
+        std::shared_ptr<u8> passwordToMasterKey(const std::string &password) override;
+        std::shared_ptr<u8> localizeKey(std::shared_ptr<u8> masterKey, const std::string &engineID) override;
 };
 
 }
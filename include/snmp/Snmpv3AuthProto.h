@@ -13,22 +13,42 @@
 // Includes 3DS
 #include <3ds.h>
 
+// Includes mbedtls
+#include <mbedtls/md5.h>
+#include <mbedtls/sha1.h>
+
 // Own includes
 #include "Snmpv3Pdu.h"
 
 // Defines
 #define SNMPV3_AUTH_KEYLENGTH   64
+#define SNMPV3_AUTH_HASHLENGTH  12      /**< HMAC-96 */
 
 namespace NetMan {
 
+/**
+ * @struct Snmpv3AuthContext
+ * @brief HMAC hash states with the key pads already hashed, so each message only hashes its own data
+ */
+typedef struct {
+    union {
+        mbedtls_md5_context md5[2];     /**< Inner and outer MD5 states */
+        mbedtls_sha1_context sha1[2];   /**< Inner and outer SHA1 states */
+    };
+} Snmpv3AuthContext;
+
 /**
  * @class Snmpv3AuthProto
+ * @note Deriving a master key hashes 1 MB, so Snmpv3UserStore keeps the derived keys
  */
 class Snmpv3AuthProto {
     public:
-        virtual void createHash(const u8 *data, u32 length, Snmpv3SecurityParams &params, std::shared_ptr<u8> keyptr) = 0;
-        bool authenticate(const u8 *data, u32 length, Snmpv3SecurityParams &params, std::shared_ptr<u8> keyptr);
-        virtual std::shared_ptr<u8> passwordToKey(const std::string &password, Snmpv3SecurityParams &params) = 0;
+        virtual void initContext(const u8 *key, Snmpv3AuthContext &context) = 0;
+        virtual void createHash(const u8 *data, u32 length, u8 *hash, const Snmpv3AuthContext &context) = 0;
+        bool authenticate(const u8 *data, u32 length, Snmpv3SecurityParams &params, const Snmpv3AuthContext &context);
+        virtual std::shared_ptr<u8> passwordToMasterKey(const std::string &password) = 0;
+        virtual std::shared_ptr<u8> localizeKey(std::shared_ptr<u8> masterKey, const std::string &engineID) = 0;
+        std::shared_ptr<u8> passwordToKey(const std::string &password, Snmpv3SecurityParams &params);
 };
 
 }
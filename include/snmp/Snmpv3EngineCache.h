@@ -0,0 +1,65 @@
+/**
+ * @file Snmpv3EngineCache.h
+ * @brief Cache of the SNMPv3 agent engines
+ */
+
+#ifndef SNMPV3ENGINECACHE_H_
+#define SNMPV3ENGINECACHE_H_
+
+// Includes C/C++
+#include <string>
+#include <unordered_map>
+#include <arpa/inet.h>
+
+// Includes 3DS
+#include <3ds.h>
+
+// Defines
+#define SNMPV3_ENGINECACHE_PATH			"enginecache.dat"
+#define SNMPV3_ENGINECACHE_MAX_ENTRIES	256				/**< Agents kept, the least recently synchronized one is dropped */
+#define SNMPV3_ENGINECACHE_MAX_DRIFT	10				/**< Difference with the estimated engineTime that is saved again, in seconds */
+#define SNMPV3_ENGINECACHE_MAX_TIME		0x7FFFFFFF		/**< Highest snmpEngineTime */
+
+namespace NetMan {
+
+/**
+ * @struct Snmpv3EngineCacheEntry
+ * @brief Authoritative engine of an agent
+ */
+typedef struct {
+	std::string engineID;
+	u32 engineBoots;
+	u32 engineTime;						/**< snmpEngineTime when it was received */
+	u64 receivedAt;						/**< Reception time, in osGetTime() ms */
+} Snmpv3EngineCacheEntry;
+
+/**
+ * @class Snmpv3EngineCache
+ * @brief Keeps the engineID, engineBoots and engineTime of each agent, so SNMPv3 requests do not need a discovery first
+ * @note engineTime is estimated from the local clock. Entries are refreshed with the notInTimeWindow and unknownEngineID
+ *       reports, and with the authenticated responses. It is saved across runs, and can be used from several threads.
+ */
+class Snmpv3EngineCache {
+	private:
+		std::unordered_map<u64, Snmpv3EngineCacheEntry> entries;	/**< By agent address */
+		LightLock lock;
+		Snmpv3EngineCache();
+		static inline u64 getKey(in_addr_t ip, u16 port) { return ((u64)ip << 16) | port; }
+		static u32 estimateTime(const Snmpv3EngineCacheEntry &entry, u64 now);
+		void evict();
+		void saveLocked();
+		virtual ~Snmpv3EngineCache();
+	public:
+		void load();
+		void save();
+		bool get(in_addr_t ip, u16 port, std::string &engineID, u32 *engineBoots, u32 *engineTime);
+		void update(in_addr_t ip, u16 port, const std::string &engineID, u32 engineBoots, u32 engineTime);
+		void remove(in_addr_t ip, u16 port);
+		void clear();
+		inline u32 getNEntries() { return entries.size(); }
+		static Snmpv3EngineCache &getInstance();
+};
+
+}
+
+#endif
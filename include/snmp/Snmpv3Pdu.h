@@ -17,6 +17,8 @@
 // Defines
 #define SNMPV3_VERSION			3
 #define SNMPV3_USM_MODEL		3
+#define SNMPV3_MAX_MSG_SIZE		65507		/**< Largest message that fits in an UDP datagram */
+#define SNMPV3_MIN_MSG_SIZE		484			/**< Smallest msgMaxSize allowed (RFC 3412) */
 
 // Defines flags
 #define SNMPV3_FLAG_REPORTABLE	(1 << 2)	/**< Use it in messages which need a response */
@@ -25,6 +27,7 @@
 
 // Defines error status
 #define SNMPV3_SECMODEL_MISMATCH	"1.3.6.1.6.3.15.1.1.1.0"
+#define SNMPV3_NOT_IN_TIME_WINDOW	"1.3.6.1.6.3.15.1.1.2.0"
 #define SNMPV3_USERNAME_MISMATCH	"1.3.6.1.6.3.15.1.1.3.0"
 #define SNMPV3_ENGINEID_MISMATCH	"1.3.6.1.6.3.15.1.1.4.0"
 #define SNMPV3_AUTH_WRONG			"1.3.6.1.6.3.15.1.1.5.0"
@@ -55,22 +58,46 @@ class Snmpv3Pdu: public BerPdu {
 		std::shared_ptr<BerSequence> varBindList;
 		static u32 requestID;
 		u32 reqID;
-		std::shared_ptr<BerSequence> generateHeader(u32 type, bool reportable, std::shared_ptr<BerField> scopedPDU);
-		std::shared_ptr<BerSequence> generateScopedPdu(std::shared_ptr<BerSequence> pdu);
-		std::shared_ptr<BerOctetString> checkHeader(u8 **ptr, bool checkMsgID, Snmpv3SecurityParams &params, std::shared_ptr<UdpSocket> sock, u8 *flags);
+		u32 fixedReqID;									/**< msgID used by the next requests, or 0 to use the global counter */
+		void writeHeader(BerWriter &writer, u8 flags, u8 **authParams);
+		std::shared_ptr<BerSequence> generateScopedPdu(std::shared_ptr<BerField> pdu);
+		u8 *encodeMessage(u32 type, std::shared_ptr<BerSequence> scopedPdu, u32 *size);
+		std::unique_ptr<u8[]> recvBuffer;				/**< Reception buffer, reused between PDUs */
+		std::vector<SnmpVarBind> varBinds;				/**< Received VarBinds, pointing into the received message */
+		SnmpResult pduResult;							/**< Decoding result of the last scoped PDU */
+		u32 maxSize;									/**< msgMaxSize sent in the requests */
+		u32 agentMaxSize;								/**< msgMaxSize of the last response, or 0 */
+		std::string requestPdu;							/**< Encoded SNMP PDU of the last request */
+		bool engineSynced;								/**< If the last message updated the authoritative engine parameters */
+		BerView checkHeader(BerReader &message, bool checkMsgID, Snmpv3SecurityParams &params, std::shared_ptr<UdpSocket> sock, u8 *flags);
+		void sendInformAck(std::shared_ptr<UdpSocket> sock);
 		static void sendReportTo(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, const std::string &reasonOid, const Snmpv3SecurityParams &params);
 	public:
 		Snmpv3Pdu(const std::string &engineID, const std::string &contextName, const std::string &userName);
 		void clear() override;
 		void addVarBind(std::shared_ptr<BerOid> oid, std::shared_ptr<BerField> value);
-        inline u32 getNVarBinds() { return this->varBindList->getNChildren(); }
+		u8 *encodeRequest(u32 type, u32 *size, u32 nonRepeaters = 0, u32 maxRepetitions = 0);
+		u8 *encodeRequest(const std::string &pdu, u32 *size);
 		void sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 nonRepeaters = 0, u32 maxRepetitions = 0);
 		u8 recvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 expectedPduType = SNMPV1_GETRESPONSE);
+		u8 parseResponse(u8 *data, u32 size, bool checkMsgID, u32 expectedPduType = SNMPV1_GETRESPONSE, std::shared_ptr<UdpSocket> sock = nullptr);
+		inline u32 getNVarBinds() { return this->varBinds.size(); }
+		inline const SnmpVarBind *getVarBinds() { return this->varBinds.data(); }
+		inline const SnmpVarBind &getVarBind(u16 i) { return this->varBinds[i]; }
+		inline const SnmpResult &getPduResult() { return this->pduResult; }
+		inline void setMaxSize(u32 maxSize) { this->maxSize = maxSize; }
+		inline u32 getAgentMaxSize() { return this->agentMaxSize; }
+		inline const std::string &getRequestPdu() { return this->requestPdu; }
+		void setEngine(const std::string &engineID, u32 engineBoots, u32 engineTime);
+		inline const std::string &getEngineID() { return this->secParams.msgAuthoritativeEngineID; }
+		inline u32 getEngineBoots() { return this->secParams.msgAuthoritativeEngineBoots; }
+		inline u32 getEngineTime() { return this->secParams.msgAuthoritativeEngineTime; }
+		inline bool isEngineSynced() { return this->engineSynced; }
 		bool recvTrap(std::shared_ptr<UdpSocket> sock);
+		bool getTrapOid(CompactOid &trapOid, CompactOid &enterprise);
 		void sendBulkRequest(u32 nonRepeaters, u32 maxRepetitions, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port);
-		std::shared_ptr<BerField> getVarBind(u16 i);
-        std::shared_ptr<BerOid> getVarBindOid(u16 i);
         std::shared_ptr<json_t> serializeTrap();
+		inline void setRequestID(u32 rid) { this->fixedReqID = rid; this->reqID = rid; }
 		~Snmpv3Pdu();
 };
 
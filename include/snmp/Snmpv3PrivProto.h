@@ -20,11 +20,12 @@ namespace NetMan {
 
 /**
  * @class Snmpv3PrivProto
+ * @note Payloads are encrypted and decrypted in place, inside the message buffers
  */
 class Snmpv3PrivProto {
     public:
-        virtual std::shared_ptr<BerOctetString> encrypt(const u8 *data, u32 length, Snmpv3SecurityParams &params, std::shared_ptr<u8> userKey) = 0;
-        virtual std::unique_ptr<u8> decrypt(std::shared_ptr<BerOctetString> data, Snmpv3SecurityParams &params, std::shared_ptr<u8> userKey) = 0;
+        virtual void encrypt(u8 *data, u32 length, Snmpv3SecurityParams &params, std::shared_ptr<u8> userKey) = 0;
+        virtual void decrypt(u8 *data, u32 length, const Snmpv3SecurityParams &params, std::shared_ptr<u8> userKey) = 0;
 };
 
 }
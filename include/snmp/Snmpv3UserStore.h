@@ -19,6 +19,7 @@
 
 // Defines
 #define SNMPV3_USERSTORE_PATH   "userstore.dat"
+#define SNMPV3_KEYCACHE_ENGINES 64          /**< Localized keys kept per user */
 
 // Defines authentication protocols
 #define SNMPV3_AUTHPROTO_NONE   0
@@ -38,23 +39,59 @@ typedef struct {
     u32 privProto;
 }Snmpv3UserStoreEntry;
 
+/**
+ * @struct Snmpv3LocalizedKeys
+ * @brief Keys of an user, localized to an engine
+ */
+typedef struct {
+    std::shared_ptr<u8> authKey;
+    std::shared_ptr<u8> privKey;
+    std::shared_ptr<Snmpv3AuthContext> authContext;     /**< HMAC states of authKey */
+} Snmpv3LocalizedKeys;
+
+/**
+ * @struct Snmpv3KeyCacheEntry
+ * @brief Keys derived from the passwords of an user
+ */
+typedef struct {
+    u32 authProto;                      /**< Protocols the keys are derived for */
+    u32 privProto;
+    std::string authPass;               /**< Passwords the keys come from */
+    std::string privPass;
+    std::shared_ptr<u8> authMasterKey;
+    std::shared_ptr<u8> privMasterKey;
+    std::unordered_map<std::string, Snmpv3LocalizedKeys> localizedKeys;    /**< By engine ID */
+} Snmpv3KeyCacheEntry;
+
 /**
  * @class Snmpv3UserStore
+ * @note The master keys of each user are derived when it is added or loaded, and localized once per engine.
+ *       The user table and the key cache are locked, as the UI, request and receiver threads use them at the same time,
+ *       so users are returned as copies.
  */
 class Snmpv3UserStore {
     private:
         std::unordered_map<std::string, Snmpv3UserStoreEntry> userTable;
+        std::unordered_map<std::string, Snmpv3KeyCacheEntry> keyCache;     /**< By user name */
+        LightLock keyCacheLock;
         Snmpv3UserStore();
+        Snmpv3UserStoreEntry &findUser(const std::string &name);
+        Snmpv3KeyCacheEntry &deriveMasterKeys(const std::string &name, const Snmpv3UserStoreEntry &user);
+        Snmpv3LocalizedKeys getLocalizedKeys(const std::string &name, const std::string &engineID);
         virtual ~Snmpv3UserStore();
     public:
         void load();
         void save();
         void addUser(const std::string &name, const Snmpv3UserStoreEntry &entry);
         void removeUser(const std::string &name);
-        Snmpv3UserStoreEntry &getUser(const std::string &name);
-        inline std::unordered_map<std::string, Snmpv3UserStoreEntry> &getUserTable() { return userTable; }
+        Snmpv3UserStoreEntry getUser(const std::string &name);
+        std::unordered_map<std::string, Snmpv3UserStoreEntry> getUserTable();
         std::shared_ptr<Snmpv3AuthProto> getAuthProto(const Snmpv3UserStoreEntry &user);
         std::shared_ptr<Snmpv3PrivProto> getPrivProto(const Snmpv3UserStoreEntry &user);
+        std::shared_ptr<u8> getAuthKey(const std::string &name, const std::string &engineID);
+        std::shared_ptr<u8> getPrivKey(const std::string &name, const std::string &engineID);
+        std::shared_ptr<Snmpv3AuthContext> getAuthContext(const std::string &name, const std::string &engineID);
+        void clearKeyCache();
         static Snmpv3UserStore &getInstance();
         u32 getAuthProtoID(const std::string &text);
         u32 getPrivProtoID(const std::string &text);
@@ -0,0 +1,72 @@
+/**
+ * @file TimingWheel.h
+ * @brief Hierarchical timing wheel
+ */
+
+#ifndef TIMINGWHEEL_H_
+#define TIMINGWHEEL_H_
+
+// Includes 3DS
+#include <3ds/types.h>
+
+// Defines
+#define TIMINGWHEEL_LEVELS		4								/**< Wheels, each one with ticks SLOTS times longer */
+#define TIMINGWHEEL_SLOT_BITS	6
+#define TIMINGWHEEL_SLOTS		(1 << TIMINGWHEEL_SLOT_BITS)	/**< Slots per wheel */
+#define TIMINGWHEEL_SLOT_MASK	(TIMINGWHEEL_SLOTS - 1)
+#define TIMINGWHEEL_MAX_TICKS	((1ULL << (TIMINGWHEEL_LEVELS * TIMINGWHEEL_SLOT_BITS)) - 1)	/**< Longest delay, in ticks */
+
+namespace NetMan {
+
+/**
+ * @brief Called when a timer expires
+ * @param args Timer arguments
+ */
+typedef void (*TimingWheelCallback)(void *args);
+
+/**
+ * @struct TimingWheelTimer
+ * @brief Timer, linked into a wheel slot
+ * @note The timer is owned by the caller, and must not move while scheduled
+ */
+typedef struct TimingWheelTimer {
+	struct TimingWheelTimer *prev;
+	struct TimingWheelTimer *next;			/**< NULL if not scheduled */
+	u64 expires;							/**< Expiration tick */
+	TimingWheelCallback callback;
+	void *args;
+} TimingWheelTimer;
+
+/**
+ * @class TimingWheel
+ * @brief Keeps any number of timers with O(1) scheduling and cancelling
+ * @note Timers far in the future wait in the coarse wheels, and go down to the finer ones as their time approaches
+ */
+class TimingWheel {
+	private:
+		TimingWheelTimer slots[TIMINGWHEEL_LEVELS][TIMINGWHEEL_SLOTS];	/**< List heads */
+		u64 tick;							/**< Current tick */
+		u64 tickTime;						/**< Time of the current tick, in ms */
+		u32 tickMs;
+		u32 nTimers;
+		void link(TimingWheelTimer *timer);
+		static void unlink(TimingWheelTimer *timer);
+		static void moveList(TimingWheelTimer *from, TimingWheelTimer *to);
+		void cascade(u32 level);
+		u32 step();
+	public:
+		TimingWheel(u32 tickMs, u64 now);
+		TimingWheel(const TimingWheel&) = delete;
+		TimingWheel &operator=(const TimingWheel&) = delete;
+		static void initTimer(TimingWheelTimer *timer, TimingWheelCallback callback, void *args);
+		void schedule(TimingWheelTimer *timer, u64 delayMs);
+		void cancel(TimingWheelTimer *timer);
+		u32 advance(u64 now);
+		inline bool isScheduled(const TimingWheelTimer *timer) { return timer->next != NULL; }
+		inline u32 getNTimers() { return nTimers; }
+		inline u32 getTickMs() { return tickMs; }
+};
+
+}
+
+#endif
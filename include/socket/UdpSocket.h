@@ -13,6 +13,12 @@
 // Includes 3DS
 #include <3ds/types.h>
 
+// Defines tryRecvPacket errors
+#define UDPSOCKET_ERROR_TIMEOUT			(-1)
+#define UDPSOCKET_ERROR_RECV			(-2)
+#define UDPSOCKET_ERROR_SOURCE_IP		(-3)
+#define UDPSOCKET_ERROR_SOURCE_PORT		(-4)
+
 namespace NetMan {
 
 /**
@@ -28,7 +34,9 @@ class UdpSocket {
         UdpSocket(u32 timeoutSecs);
         void sendPacket(void *data, u32 size, in_addr_t ip, u16 port);
         u32 recvPacket(void *data, u32 size, in_addr_t ip = 0, u16 port = 0);
+        s32 tryRecvPacket(void *data, u32 size, in_addr_t ip = 0, u16 port = 0);
         void bindTo(u16 port);
+        void setTimeoutMs(u32 timeoutMs);
         inline in_addr_t getLastOrigin() { return this->lastOrigin; }
         inline in_port_t getLastPort() { return this->lastPort; }
         inline int getDescriptor() { return fd; }
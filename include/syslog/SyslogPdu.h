@@ -126,6 +126,11 @@ class SyslogPdu {
         void recvLog(std::shared_ptr<TcpSocket> sock);
         void print();
         std::shared_ptr<json_t> serialize();
+        inline u8 getFacility() { return priority >> 3; }
+        inline u8 getSeverity() { return priority & 7; }
+        inline const std::string &getHostname() { return hostname; }
+        inline const std::string &getAppName() { return appname; }
+        inline const std::string &getMsgId() { return msgid; }
         virtual ~SyslogPdu();
 };
 
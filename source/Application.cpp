@@ -128,6 +128,16 @@ void Application::initialize(const std::string &layoutPath) {
         syslogUdpSock = nullptr;
     }
 
+    // Receive traps and logs in the background
+    try {
+        receiver = std::make_shared<NotificationReceiver>(trapv1Sock, trapv2Sock, trapv3Sock, syslogUdpSock, syslogTcpSock);
+        receiver->start();
+    } catch (const std::bad_alloc &e) {
+        this->fatalError(e.what(), 1);
+    } catch (const std::runtime_error &e) {
+        this->fatalError(e.what(), 1);
+    }
+
 	// Inicialization done
 	init = true;
 }
@@ -275,6 +285,9 @@ Application::~Application() {
     // Unload resources
     unloadResources();
 
+    // Stop receiving before closing the sockets
+    receiver = nullptr;
+
 	// Terminate sockets
 	socExit();
     httpcExit();
@@ -12,6 +12,9 @@
 #include "Application.h"
 #include "snmp/Snmpv2Pdu.h"
 #include "snmp/Snmpv3Pdu.h"
+#include "snmp/SnmpEngine.h"
+#include "snmp/SnmpWalk.h"
+#include "snmp/SnmpPlanner.h"
 #include "asn1/BerInteger.h"
 #include "Config.h"
 #include "restconf/RestConfClient.h"
@@ -207,9 +210,155 @@ static std::shared_ptr<BerField> prepareSetField(u32 i) {
     return currentField;
 }
 
+/**
+ * @brief Keep the outcome of a request sent by sendSnmpPdu()
+ * @param response Request outcome
+ */
+static void storeSnmpResponse(SnmpEngineResponse *response) {
+    *(SnmpEngineResponse*)response->args = *response;
+}
+
+/**
+ * @brief Check the outcome of a request sent by sendSnmpPdu()
+ * @param response Request outcome
+ */
+static void checkSnmpResponse(const SnmpEngineResponse &response) {
+    if(response.result.status != SNMP_OK) {
+        throw std::runtime_error(response.errorText);
+    }
+}
+
+/**
+ * @brief Show the received VarBinds in the PDU fields
+ * @param varBinds  Received VarBinds
+ * @param nVarBinds Number of received VarBinds
+ * @param session   SNMP session parameters
+ */
+static void showSnmpResponse(const SnmpVarBind *varBinds, u32 nVarBinds, std::shared_ptr<SnmpSessionParams> session) {
+
+    auto& pduFields = Application::getInstance().getPduFields();
+
+    if(session->pduType == SNMPV2_GETBULKREQUEST) {
+        for(u32 i = 0; i < nVarBinds; i++) {
+            if(i < session->nonRepeaters) {
+                pduFields[i].value = varBinds[i].value.print();
+            } else if(i == session->nonRepeaters) {
+                pduFields[i].value = std::to_string(nVarBinds - session->nonRepeaters) + " fields";
+            } else {
+                PduField field;
+                field.oidText = varBinds[session->nonRepeaters].oid.print();
+                field.value = varBinds[i].value.print();
+                pduFields.push_back(field);
+            }
+        }
+    } else {
+        for(u32 i = 0; i < pduFields.size() && i < nVarBinds; i++) {
+            pduFields[i].value = varBinds[i].value.print();
+        }
+    }
+}
+
+/**
+ * @brief Add a walked VarBind to the PDU fields
+ * @param varBind   Received VarBind
+ * @param args      Unused
+ * @return true, to walk the whole subtree
+ */
+static bool addWalkedField(const SnmpVarBind *varBind, void *args) {
+    PduField field;
+    field.oidText = varBind->oid.print();
+    field.value = varBind->value.print();
+    Application::getInstance().getPduFields().push_back(field);
+    return true;
+}
+
+/**
+ * @brief Walk the subtree of each repeater field, adding the found objects to the PDU fields
+ * @param walk      Walk used for the subtrees
+ * @param session   SNMP session parameters
+ */
+static void walkSnmpFields(SnmpWalk &walk, std::shared_ptr<SnmpSessionParams> session) {
+
+    auto& pduFields = Application::getInstance().getPduFields();
+    u32 nFields = pduFields.size();
+
+    for(u32 i = session->nonRepeaters; i < nFields; i++) {
+        u32 first = pduFields.size();
+        walk.run(pduFields[i].oid->getOid(), addWalkedField);
+        if(walk.getResult().status != SNMP_OK) {
+            throw std::runtime_error(walk.getErrorText());
+        }
+        pduFields[i].value = std::to_string(pduFields.size() - first) + " fields";
+    }
+}
+
+/**
+ * @struct PlannedField
+ * @brief PDU field waiting for a planned GET
+ */
+typedef struct {
+    PduField *field;
+    std::string *errorText;     /**< First error of the request */
+} PlannedField;
+
+/**
+ * @brief Store the value of a planned GET in its PDU field
+ * @param varBind   Received VarBind, or NULL if the GET failed
+ * @param result    Request result
+ * @param errorText Error description
+ * @param args      Planned field
+ */
+static void storePlannedField(const SnmpVarBind *varBind, const SnmpResult &result, const std::string &errorText, void *args) {
+    PlannedField *planned = (PlannedField*)args;
+    if(varBind != NULL) {
+        planned->field->value = varBind->value.print();
+    } else if(planned->errorText->empty()) {
+        *planned->errorText = planned->field->oidText + ": " + errorText;
+    }
+}
+
+/**
+ * @brief Build the PDU of a community (non-USM) session
+ * @param params    Request parameters
+ * @return A SNMPv2c PDU if the session sends GetBulkRequests, as v1 agents do not know them, or a SNMPv1 PDU
+ */
+static std::shared_ptr<Snmpv1Pdu> makeCommunityPdu(SnmpThreadParams *params) {
+    if(params->session->pduType == SNMPV2_GETBULKREQUEST) {
+        return std::make_shared<Snmpv2Pdu>(params->community);
+    }
+    return std::make_shared<Snmpv1Pdu>(params->community);
+}
+
+/**
+ * @brief Get the value of each PDU field, in as few requests as the agent allows
+ * @param engine    Engine used for the requests
+ * @param pdu       PDU used for the requests
+ * @param ip        Agent IP
+ * @param port      Agent port
+ */
+template<class T> static void getSnmpFields(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<T> pdu, in_addr_t ip, u16 port) {
+
+    auto& pduFields = Application::getInstance().getPduFields();
+    std::vector<PlannedField> planned(pduFields.size());
+    std::string errorText;
+    SnmpPlanner planner(engine);
+
+    for(u32 i = 0; i < pduFields.size(); i++) {
+        planned[i] = {&pduFields[i], &errorText};
+        planner.get(pdu, ip, port, pduFields[i].oid->getOid(), storePlannedField, &planned[i]);
+    }
+    planner.wait();
+
+    if(!errorText.empty()) {
+        throw std::runtime_error(errorText);
+    }
+}
+
 /**
  * @brief Send a SNMP PDU to some destination
  * @param params    Request parameters
+ * @note A GetBulkRequest with max-repetitions 0 walks the whole subtree of each repeater field.
+ *       GetRequests are split or merged to fit the agent message size.
  */
 void Utils::sendSnmpPdu(SnmpThreadParams *params) {
 
@@ -218,18 +367,19 @@ void Utils::sendSnmpPdu(SnmpThreadParams *params) {
     auto session = params->session;
     auto& pduFields = Application::getInstance().getPduFields();
 
-    std::shared_ptr<UdpSocket> sock = std::make_shared<UdpSocket>(config.udpTimeout);
+    // The configured timeout is split between the tries
+    auto engine = std::make_shared<SnmpEngine>(config.udpTimeout * 1000 / (SNMPENGINE_DEFAULT_RETRIES + 1));
+    bool walkFields = session->pduType == SNMPV2_GETBULKREQUEST && session->maxRepetitions == 0;
+    SnmpEngineResponse response;
+    std::shared_ptr<BerNull> nullval = std::make_shared<BerNull>();
     
     if(params->usmEnabled) {
         std::shared_ptr<Snmpv3Pdu> pdu = std::make_shared<Snmpv3Pdu>(configStore.getEngineID(), configStore.getContextName(), params->username);
-        std::shared_ptr<BerNull> nullval = std::make_shared<BerNull>();
-        std::shared_ptr<BerOid> testOid = std::make_shared<BerOid>("1.3.6.1.2.1.1.7.0");
-        pdu->addVarBind(testOid, nullval);
-        pdu->sendRequest(SNMPV2_GETREQUEST, sock, session->agentIP, config.snmpPort);
-        try {
-            pdu->recvResponse(sock, session->agentIP, config.snmpPort);
-        } catch (const std::runtime_error &e) { }
-        pdu->clear();
+
+        if(session->pduType == SNMPV1_GETREQUEST) {
+            getSnmpFields(engine, pdu, session->agentIP, config.snmpPort);
+            return;
+        }
 
         if(session->pduType == SNMPV1_SETREQUEST) {
             for(u32 i = 0; i < pduFields.size(); i++) {
@@ -241,77 +391,95 @@ void Utils::sendSnmpPdu(SnmpThreadParams *params) {
             }
         }
 
-        if(session->pduType == SNMPV2_GETBULKREQUEST) {
-            pdu->sendBulkRequest(session->nonRepeaters, session->maxRepetitions, sock, session->agentIP, config.snmpPort);
-        } else {
-            pdu->sendRequest(session->pduType, sock, session->agentIP, config.snmpPort);
+        engine->wait(engine->sendRequest(pdu, session->pduType, session->agentIP, config.snmpPort, storeSnmpResponse, &response, session->nonRepeaters, session->maxRepetitions));
+        checkSnmpResponse(response);
+        showSnmpResponse(pdu->getVarBinds(), pdu->getNVarBinds(), session);
+
+        if(walkFields) {
+            SnmpWalk walk(engine, pdu, session->agentIP, config.snmpPort);
+            walkSnmpFields(walk, session);
         }
-        for(u32 i = 0; i < 60; i++) gspWaitForVBlank();
-        pdu->recvResponse(sock, session->agentIP, config.snmpPort);
+    } else {
+        std::shared_ptr<Snmpv1Pdu> pdu = makeCommunityPdu(params);
 
-        if(session->pduType == SNMPV2_GETBULKREQUEST) {
-            for(u32 i = 0; i < pdu->getNVarBinds(); i++) {
-                if(i < session->nonRepeaters) {
-                    pduFields[i].value = pdu->getVarBind(i)->print();
-                } else if(i == session->nonRepeaters) {
-                    pduFields[i].value = std::to_string(pdu->getNVarBinds() - session->nonRepeaters) + " fields";
-                } else {
-                    PduField field;
-                    field.oidText = pdu->getVarBindOid(session->nonRepeaters)->print();
-                    field.value = pdu->getVarBind(i)->print();
-                    pduFields.push_back(field);
-                }
+        if(session->pduType == SNMPV1_GETREQUEST) {
+            getSnmpFields(engine, pdu, session->agentIP, config.snmpPort);
+            return;
+        }
+
+        if(session->pduType == SNMPV1_SETREQUEST) {
+            for(u32 i = 0; i < pduFields.size(); i++) {
+                pdu->addVarBind(pduFields[i].oid, prepareSetField(i));
             }
         } else {
             for(u32 i = 0; i < pduFields.size(); i++) {
-                pduFields[i].value = pdu->getVarBind(i)->print();
+                pdu->addVarBind(pduFields[i].oid, nullval);
             }
         }
-    } else {
+
+        u32 id;
         if(session->pduType == SNMPV2_GETBULKREQUEST) {
-            std::unique_ptr<Snmpv2Pdu> pdu = std::unique_ptr<Snmpv2Pdu>(new Snmpv2Pdu(params->community));
-            std::shared_ptr<BerNull> nullval = std::make_shared<BerNull>();
+            id = engine->sendBulkRequest(std::static_pointer_cast<Snmpv2Pdu>(pdu), session->nonRepeaters, session->maxRepetitions, session->agentIP, config.snmpPort, storeSnmpResponse, &response);
+        } else {
+            id = engine->sendRequest(pdu, session->pduType, session->agentIP, config.snmpPort, storeSnmpResponse, &response);
+        }
+        engine->wait(id);
+        checkSnmpResponse(response);
+        showSnmpResponse(pdu->getVarBinds(), pdu->getNVarBinds(), session);
 
-            for(u32 i = 0; i < pduFields.size(); i++) {
-                pdu->addVarBind(pduFields[i].oid, nullval);
-            }
+        if(walkFields) {
+            SnmpWalk walk(engine, pdu, session->agentIP, config.snmpPort);
+            walkSnmpFields(walk, session);
+        }
+    }
+}
 
-            pdu->sendBulkRequest(session->nonRepeaters, session->maxRepetitions, sock, session->agentIP, config.snmpPort);
-            pdu->recvResponse(sock, session->agentIP, config.snmpPort);
-
-            for(u32 i = 0; i < pdu->getNVarBinds(); i++) {
-                if(i < session->nonRepeaters) {
-                    pduFields[i].value = pdu->getVarBind(i)->print();
-                } else if(i == session->nonRepeaters) {
-                    pduFields[i].value = std::to_string(pdu->getNVarBinds() - session->nonRepeaters) + " fields";
-                } else {
-                    PduField field;
-                    field.oidText = pdu->getVarBindOid(session->nonRepeaters)->print();
-                    field.value = pdu->getVarBind(i)->print();
-                    pduFields.push_back(field);
-                }
-            }
-        } else {
-            std::unique_ptr<Snmpv1Pdu> pdu = std::unique_ptr<Snmpv1Pdu>(new Snmpv1Pdu(params->community));
-            if(session->pduType == SNMPV1_SETREQUEST) {
-                for(u32 i = 0; i < pduFields.size(); i++) {
-                    pdu->addVarBind(pduFields[i].oid, prepareSetField(i));
-                }
-            } else {
-                std::shared_ptr<BerNull> nullval = std::make_shared<BerNull>();
-                for(u32 i = 0; i < pduFields.size(); i++) {
-                    pdu->addVarBind(pduFields[i].oid, nullval);
-                }
-            }
+/**
+ * @brief Fetch every row of a SNMP table
+ * @param params    Request parameters
+ * @param table     Table to fill
+ * @note Community sessions use the SNMP version of sendSnmpPdu(), so the table of a v1 session is walked with GetNextRequests
+ */
+void Utils::fetchSnmpTable(SnmpThreadParams *params, std::shared_ptr<SnmpTable> table) {
 
-            pdu->sendRequest(session->pduType, sock, session->agentIP, config.snmpPort);
-            pdu->recvResponse(sock, session->agentIP, config.snmpPort);
+    auto& configStore = Config::getInstance();
+    auto& config = configStore.getData();
+    auto session = params->session;
+    auto engine = std::make_shared<SnmpEngine>(config.udpTimeout * 1000 / (SNMPENGINE_DEFAULT_RETRIES + 1));
 
-            for(u32 i = 0; i < pduFields.size(); i++) {
-                pduFields[i].value = pdu->getVarBind(i)->print();
-            }
-        }
+    if(params->usmEnabled) {
+        std::shared_ptr<Snmpv3Pdu> pdu = std::make_shared<Snmpv3Pdu>(configStore.getEngineID(), configStore.getContextName(), params->username);
+        table->fetch(engine, pdu, session->agentIP, config.snmpPort);
+    } else {
+        table->fetch(engine, makeCommunityPdu(params), session->agentIP, config.snmpPort);
+    }
+}
+
+/**
+ * @brief Poll some OIDs of the session agent periodically, from a new thread
+ * @param params    Request parameters
+ * @param oids      OIDs to poll
+ * @param interval  Poll interval, in ms
+ * @param callback  Called from the poller thread for each polled OID
+ * @param args      Callback arguments
+ * @return The started poller, which stops when it is destroyed
+ */
+std::shared_ptr<SnmpPoller> Utils::pollSnmpOids(SnmpThreadParams *params, const std::vector<CompactOid> &oids, u32 interval, SnmpPollerCallback callback, void *args) {
+
+    auto& configStore = Config::getInstance();
+    auto& config = configStore.getData();
+    auto session = params->session;
+    auto engine = std::make_shared<SnmpEngine>(config.udpTimeout * 1000 / (SNMPENGINE_DEFAULT_RETRIES + 1));
+    auto poller = std::make_shared<SnmpPoller>(engine);
+
+    if(params->usmEnabled) {
+        std::shared_ptr<Snmpv3Pdu> pdu = std::make_shared<Snmpv3Pdu>(configStore.getEngineID(), configStore.getContextName(), params->username);
+        poller->addTarget(pdu, session->agentIP, config.snmpPort, oids, interval, callback, args);
+    } else {
+        poller->addTarget(makeCommunityPdu(params), session->agentIP, config.snmpPort, oids, interval, callback, args);
     }
+    poller->start();
+    return poller;
 }
 
 /**
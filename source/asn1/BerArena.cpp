@@ -0,0 +1,83 @@
+/**
+ * @file BerArena.cpp
+ * @brief Monotonic arena for BER field trees
+ */
+
+// Includes C/C++
+#include <stdexcept>
+
+// Own includes
+#include "asn1/BerArena.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a BerArena
+ * @note No memory is taken until the first allocation
+ */
+BerArena::BerArena() {
+	this->curChunk = 0;
+	this->offset = 0;
+	this->used = 0;
+	this->peak = 0;
+	this->capacity = 0;
+}
+
+/**
+ * @brief Destructor for a BerArena
+ */
+BerArena::~BerArena() {
+	for(u32 i = 0; i < chunks.size(); i++) {
+		delete [] chunks[i];
+	}
+}
+
+/**
+ * @brief Allocate memory from the arena
+ * @param size		Number of bytes
+ * @param alignment	Required alignment, power of two
+ * @return The allocated memory
+ */
+void *BerArena::allocate(size_t size, size_t alignment) {
+
+	// Look for a chunk with enough space, starting by the current one
+	while(curChunk < chunks.size()) {
+		u32 start = (offset + alignment - 1) &~(alignment - 1);
+		if(start + size <= chunkSizes[curChunk]) {
+			offset = start + size;
+			used += size;
+			if(used > peak) peak = used;
+			return chunks[curChunk] + start;
+		}
+		curChunk ++;
+		offset = 0;
+	}
+
+	// Create a new chunk, big enough for this allocation
+	try {
+		u32 chunkSize = BERARENA_CHUNK_SIZE;
+		if(size + alignment > chunkSize) chunkSize = size + alignment;
+		chunks.push_back(new u8[chunkSize]);
+		chunkSizes.push_back(chunkSize);
+		capacity += chunkSize;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+
+	// Now it fits
+	curChunk = chunks.size() - 1;
+	offset = 0;
+	return this->allocate(size, alignment);
+}
+
+/**
+ * @brief Release every allocation at once, keeping the chunks
+ * @note Objects living in the arena must have been destroyed before
+ */
+void BerArena::reset() {
+	curChunk = 0;
+	offset = 0;
+	used = 0;
+}
+
+}
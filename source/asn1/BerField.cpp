@@ -97,6 +97,24 @@ void BerField::parseLength(u8 **out) {
 	*out += this->lengthSize;
 }
 
+/**
+ * @brief Encode the whole field in front of the already written data
+ * @param writer Reverse BER encoder
+ * @return Field total size, including tag, length and payload size
+ */
+u32 BerField::encode(BerWriter &writer) {
+
+	u32 start = writer.getSize();
+
+	// Contents go first, so the length is known when it is written
+	this->encodeData(writer);
+	this->setLength(writer.getSize() - start);
+	writer.writeLength(this->length);
+	writer.writeTag(this->tagOptions, this->tag);
+
+	return writer.getSize() - start;
+}
+
 /**
  * @brief Retrieve field total size
  * @return Field total size, including tag, length and payload size
@@ -132,34 +150,35 @@ u32 BerField::decodeLength(u8 **data) {
 /**
  * @brief Decode a BER field
  * @param data Input buffer
+ * @param arena Arena used for the decoded field (optional)
  * @return A decoded BER field
  */
-std::shared_ptr<BerField> BerField::decode(u8 **data) {
+std::shared_ptr<BerField> BerField::decode(u8 **data, const std::shared_ptr<BerArena> &arena) {
 
 	try {
 		switch((*data)[0]) {
 			// SNMPv1+
 			case (BER_TAG_INTEGER | BER_TAGCLASS_INTEGER):
-				return BerInteger::decode(data, true);
+				return BerInteger::decode(data, true, arena);
 			case (SNMPV1_TAG_COUNTER | SNMPV1_TAGCLASS_COUNTER):
 			case (SNMPV1_TAG_GAUGE | SNMPV1_TAGCLASS_GAUGE):
 			case (SNMPV1_TAG_TIMETICKS | SNMPV1_TAGCLASS_TIMETICKS):
-				return BerInteger::decode(data, false);
+				return BerInteger::decode(data, false, arena);
 			case (BER_TAG_NULL | BER_TAGCLASS_NULL):
-				return BerNull::decode(data);
+				return BerNull::decode(data, arena);
 			case (BER_TAG_OCTETSTRING | BER_TAGCLASS_OCTETSTRING):
 			case (SNMPV1_TAG_NETWORKADDRESS | SNMPV1_TAGCLASS_NETWORKADDRESS):
 			case (SNMPV1_TAG_OPAQUE | SNMPV1_TAGCLASS_OPAQUE):
-				return BerOctetString::decode(data);
+				return BerOctetString::decode(data, arena);
 			case (BER_TAG_OID | BER_TAGCLASS_OID):
-				return BerOid::decode(data);
+				return BerOid::decode(data, arena);
 			// SNMPv2+
 			case (SNMPV2_TAG_NOSUCHOBJECT | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
 			case (SNMPV2_TAG_NOSUCHINSTANCE | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
 			case (SNMPV2_TAG_ENDOFMIBVIEW | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
-				return BerNull::decode(data);
+				return BerNull::decode(data, arena);
 			case (SNMPV2_TAG_COUNTER64 | SNMPV2_TAGCLASS_COUNTER64):
-				return BerInteger::decode(data, false);
+				return BerInteger::decode(data, false, arena);
 		}
 	} catch (const std::runtime_error &e) {
 		throw;
@@ -171,4 +190,42 @@ std::shared_ptr<BerField> BerField::decode(u8 **data) {
 	return nullptr;
 }
 
+/**
+ * @brief Check if a BER field can be decoded, without throwing
+ * @param view Field to check
+ * @return BER_OK if decode() would succeed, BER_ERROR_TAG for unknown types, or BER_ERROR_VALUE for malformed contents
+ */
+BerStatus BerField::validate(const BerView &view) {
+
+	u64 value;
+	switch(view.getTag()) {
+		// SNMPv1+
+		case (BER_TAG_INTEGER | BER_TAGCLASS_INTEGER):
+			return view.getInteger(true, &value);
+		case (SNMPV1_TAG_COUNTER | SNMPV1_TAGCLASS_COUNTER):
+		case (SNMPV1_TAG_GAUGE | SNMPV1_TAGCLASS_GAUGE):
+		case (SNMPV1_TAG_TIMETICKS | SNMPV1_TAGCLASS_TIMETICKS):
+		case (SNMPV2_TAG_COUNTER64 | SNMPV2_TAGCLASS_COUNTER64):
+			return view.getInteger(false, &value);
+		case (BER_TAG_NULL | BER_TAGCLASS_NULL):
+		case (SNMPV2_TAG_NOSUCHOBJECT | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+		case (SNMPV2_TAG_NOSUCHINSTANCE | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+		case (SNMPV2_TAG_ENDOFMIBVIEW | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+			// BerNull only takes the short form of a zero length
+			return (view.getTotalSize() == 2) ? BER_OK : BER_ERROR_VALUE;
+		case (BER_TAG_OCTETSTRING | BER_TAGCLASS_OCTETSTRING):
+		case (SNMPV1_TAG_NETWORKADDRESS | SNMPV1_TAGCLASS_NETWORKADDRESS):
+		case (SNMPV1_TAG_OPAQUE | SNMPV1_TAGCLASS_OPAQUE):
+			return BER_OK;
+		case (BER_TAG_OID | BER_TAGCLASS_OID):
+			// Not empty, and the last arc must be complete
+			if(view.getLength() == 0 || (view.getValue()[view.getLength() - 1] &(1 << 7))) {
+				return BER_ERROR_VALUE;
+			}
+			return BER_OK;
+	}
+
+	return BER_ERROR_TAG;
+}
+
 }
@@ -4,6 +4,7 @@
  */
 
 // Includes C/C++
+#include <stdint.h>
 #include <string.h>
 #include <stdexcept>
 
@@ -22,15 +23,61 @@ namespace NetMan {
  */
 BerInteger::BerInteger(void *value, u8 len, bool sign, u8 tagOptions, u32 tag) : BerField(tagOptions, tag){
 
-	if(len != 4 && len != 8) {
+	if(len == 4) {
+		this->setValue(sign ? (u64)(s64)*(s32*)value : (u64)*(u32*)value, sign);
+	} else if(len == 8) {
+		this->setValue(*(u64*)value, sign);
+	} else {
 		throw std::runtime_error("Invalid integer length (4 or 8): " + std::to_string(len));
 	}
-	this->value = std::unique_ptr<u8>(new u8[len]);
-	memcpy(this->value.get(), value, len);
+}
 
-	this->setLength(len);
+/**
+ * @brief Constructor for a Integer field
+ * @param value Value to be stored (s64 casted to u64 if signed)
+ * @param sign Signed integer?
+ * @param tagOptions Specific tag scope (optional)
+ * @param tag Tag value (optional)
+ */
+BerInteger::BerInteger(u64 value, bool sign, u8 tagOptions, u32 tag) : BerField(tagOptions, tag){
+	this->setValue(value, sign);
+}
 
+/**
+ * @brief Store a value and compute its encoded length
+ * @param value Value to be stored
+ * @param sign Signed integer?
+ */
+void BerInteger::setValue(u64 value, bool sign) {
+	this->value = value;
 	this->sign = sign;
+	this->setLength(BerInteger::getEncodedLength(value, sign));
+}
+
+/**
+ * @brief Get the minimal two's complement encoding length of an integer
+ * @param value Integer value
+ * @param sign Signed integer?
+ * @return Number of contents octets (1 to 9)
+ */
+u8 BerInteger::getEncodedLength(u64 value, bool sign) {
+
+	// Unsigned values with their top bit set need a leading zero octet
+	if(!sign && (value &(1ULL << 63))) {
+		return 9;
+	}
+
+	// Drop leading octets while they only repeat the sign of the next one
+	u8 len = 8;
+	u8 fill = (sign && (s64)value < 0) ? 0xFF : 0x00;
+	while(len > 1) {
+		u8 leading = (value >> ((len - 1) << 3)) &0xFF;
+		u8 nextSign = ((value >> ((len - 2) << 3)) &0x80) ? 0xFF : 0x00;
+		if(leading != fill || nextSign != fill) break;
+		len --;
+	}
+
+	return len;
 }
 
 /**
@@ -42,14 +89,87 @@ void BerInteger::parseData(u8 **out) {
 	u8 *data = *out;
 	u32 len = this->getLength();
 
+	// Most significant octet first, the ninth one is always the leading zero
 	for(u32 i = 0; i < len; i++) {
-		data[i] = this->value.get()[len - i - 1];
+		u32 shift = (len - i - 1) << 3;
+		data[i] = shift < 64 ? (this->value >> shift) &0xFF : 0;
 	}
 
 	// Advance write pointer
 	*out += len;
 }
 
+/**
+ * @brief Encode integer data
+ * @param writer Reverse BER encoder
+ */
+void BerInteger::encodeData(BerWriter &writer) {
+
+	u32 len = this->getLength();
+
+	// Least significant octet first, as the writer goes backwards
+	for(u32 i = 0; i < len; i++) {
+		u32 shift = i << 3;
+		writer.writeByte(shift < 64 ? (this->value >> shift) &0xFF : 0);
+	}
+}
+
+/**
+ * @brief Decode the contents of an integer, of any valid length
+ * @param in Integer contents
+ * @param len Contents length
+ * @param sign Interpret as signed integer?
+ * @return The decoded integer, sign extended if needed
+ */
+u64 BerInteger::decodeValue(const u8 *in, u32 len, bool sign) {
+
+	u64 value;
+	if(BerInteger::tryDecodeValue(in, len, sign, &value) != BER_OK) {
+		if(len == 0) {
+			throw std::runtime_error("Empty INTEGER");
+		}
+		throw std::runtime_error("Invalid length for INTEGER64: " + std::to_string(len));
+	}
+
+	return value;
+}
+
+/**
+ * @brief Decode the contents of an integer, without throwing
+ * @param in Integer contents
+ * @param len Contents length
+ * @param sign Interpret as signed integer?
+ * @param value Decoded value (output)
+ * @return BER_OK, or BER_ERROR_VALUE if the integer is empty or does not fit in 64 bits
+ */
+BerStatus BerInteger::tryDecodeValue(const u8 *in, u32 len, bool sign, u64 *value) {
+
+	if(len == 0) {
+		return BER_ERROR_VALUE;
+	}
+
+	// Sign extension
+	u8 fill = (sign && (in[0] &(1 << 7))) ? 0xFF : 0x00;
+	u64 result = fill ? ~(u64)0 : 0;
+
+	// Skip redundant leading octets (unsigned values may carry an extra zero)
+	while(len > sizeof(u64) && in[0] == fill) {
+		in++;
+		len--;
+	}
+	if(len > sizeof(u64)) {
+		return BER_ERROR_VALUE;
+	}
+
+	// Copy integer
+	for(u32 i = 0; i < len; i++) {
+		result = (result << 8) | in[i];
+	}
+
+	*value = result;
+	return BER_OK;
+}
+
 /**
  * @brief Decode an integer value
  * @param data Input buffer
@@ -60,31 +180,23 @@ void BerInteger::parseData(u8 **out) {
  */
 void BerInteger::decodeIntegerValue(u8 **data, u8 len, bool sign, u8 *dest, u8 maxlen) {
 
-	u8 *in = *data;
-
 	// Check max length (32 or 64 bits)
 	if(maxlen != 4 && maxlen != 8) {
 		throw std::runtime_error("Invalid maximum length (4 or 8): " + std::to_string(maxlen));
 	}
 
-	// Check length
-    if(len > maxlen) {
-        throw std::runtime_error("Invalid length for INTEGER" + std::to_string(maxlen << 3) + ": " + std::to_string(len));
-    }
-
-	// Copy integer
-	for(u8 i = 0; i < len; i++) {
-		dest[i] = in[len - i - 1];
+	// Check length, leading zeros aside
+	u64 value = BerInteger::decodeValue(*data, len, sign);
+	if(maxlen == 4 && (sign ? ((s64)value < INT32_MIN || (s64)value > INT32_MAX) : value > UINT32_MAX)) {
+		throw std::runtime_error("Invalid length for INTEGER32: " + std::to_string(len));
 	}
 
-	// Fill remaining bytes
-	if((in[0] &(1 << 7)) && sign) {
-		memset(&dest[len], 0xFF, maxlen - len);
-	} else {
-		memset(&dest[len], 0, maxlen - len);
+	// Copy integer (destination is little endian)
+	for(u8 i = 0; i < maxlen; i++) {
+		dest[i] = (value >> (i << 3)) &0xFF;
 	}
 
-	// Update write pointer
+	// Update read pointer
 	*data += len;
 }
 
@@ -92,11 +204,14 @@ void BerInteger::decodeIntegerValue(u8 **data, u8 len, bool sign, u8 *dest, u8 m
  * @brief Decode an Integer
  * @param data Data pointer
  * @param sign Interpret as signed integer?
+ * @param arena Arena used for the decoded field (optional)
  * @return A decoded BerInteger
  */
-std::shared_ptr<BerInteger> BerInteger::decode(u8 **data, bool sign) {
+std::shared_ptr<BerInteger> BerInteger::decode(u8 **data, bool sign, const std::shared_ptr<BerArena> &arena) {
 
 	// Skip tag
+	u8 tagOptions = (*data)[0] &0xE0;
+	u8 tag = (*data)[0] &0x1F;
 	*data += 1;
 	
 	try {
@@ -104,15 +219,11 @@ std::shared_ptr<BerInteger> BerInteger::decode(u8 **data, bool sign) {
 		u32 len = BerField::decodeLength(data);
 
 		// Return decoded integer
-		u8 maxlen = sizeof(s32);
-		if(len > 4) maxlen = sizeof(s64);
-		u8 *val = new u8[maxlen];
-		BerInteger::decodeIntegerValue(data, len, sign, val, maxlen);
-		std::shared_ptr<BerInteger> ptr = std::make_shared<BerInteger>(val, maxlen, sign);
-		delete [] val;
-		return ptr;
+		u64 value = BerInteger::decodeValue(*data, len, sign);
+		*data += len;
+		return makeBerField<BerInteger>(arena, value, sign, tagOptions, tag);
 	} catch (const std::runtime_error &e) {
-		throw e;
+		throw;
 	}
 }
 
@@ -122,19 +233,9 @@ std::shared_ptr<BerInteger> BerInteger::decode(u8 **data, bool sign) {
  */
 std::string BerInteger::print() {
 	if(sign) {
-		if(this->getLength() == sizeof(s64)) {
-            return std::to_string(*(s64*)this->value.get());
-		} else {
-            return std::to_string(*(s32*)this->value.get());
-		}
-	} else {
-		if(this->getLength() == sizeof(u64)) {
-            return std::to_string(*(u64*)this->value.get());
-		} else {
-            return std::to_string(*(u32*)this->value.get());
-		}
+		return std::to_string((s64)this->value);
 	}
-    return "";
+	return std::to_string(this->value);
 }
 
 /**
@@ -143,8 +244,7 @@ std::string BerInteger::print() {
  */
 u32 BerInteger::getValueU32() {
 	if(this->sign) throw std::runtime_error("Not unsigned");
-	if(this->getLength() == 4) return *(u32*)this->value.get();
-	return *(u64*)this->value.get();
+	return (u32)this->value;
 }
 
 /**
@@ -153,8 +253,7 @@ u32 BerInteger::getValueU32() {
  */
 s32 BerInteger::getValueS32() {
 	if(!this->sign) throw std::runtime_error("Not signed");
-	if(this->getLength() == 4) return *(s32*)this->value.get();
-	return *(s64*)this->value.get();
+	return (s32)this->value;
 }
 
 /**
@@ -163,8 +262,7 @@ s32 BerInteger::getValueS32() {
  */
 u64 BerInteger::getValueU64() {
 	if(this->sign) throw std::runtime_error("Not unsigned");
-	if(this->getLength() == 4) return *(u32*)this->value.get();
-	return *(u64*)this->value.get();
+	return this->value;
 }
 
 /**
@@ -173,8 +271,7 @@ u64 BerInteger::getValueU64() {
  */
 s64 BerInteger::getValueS64() {
 	if(!this->sign) throw std::runtime_error("Not signed");
-	if(this->getLength() == 4) return *(s32*)this->value.get();
-	return *(s64*)this->value.get();
+	return (s64)this->value;
 }
 
 }
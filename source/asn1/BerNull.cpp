@@ -24,12 +24,19 @@ BerNull::BerNull(u8 tagOptions, u32 tag) : BerField(tagOptions, tag) { }
  */
 void BerNull::parseData(u8 **out) { }
 
+/**
+ * @brief Encode data
+ * @param writer Reverse BER encoder
+ */
+void BerNull::encodeData(BerWriter &writer) { }
+
 /**
  * @brief Decode a NULL value
  * @param data Output buffer
+ * @param arena Arena used for the decoded field (optional)
  * @return A decoded NULL value
  */
-std::shared_ptr<BerNull> BerNull::decode(u8 **data) {
+std::shared_ptr<BerNull> BerNull::decode(u8 **data, const std::shared_ptr<BerArena> &arena) {
 
 	// Check a length of zero
 	u8 *in = *data;
@@ -41,7 +48,7 @@ std::shared_ptr<BerNull> BerNull::decode(u8 **data) {
 	*data += 2;
 
 	// Return decoded data
-	return std::make_shared<BerNull>(in[0] >> 5, in[0] &0x1F);
+	return makeBerField<BerNull>(arena, in[0] >> 5, in[0] &0x1F);
 }
 
 /**
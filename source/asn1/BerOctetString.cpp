@@ -39,6 +39,14 @@ void BerOctetString::parseData(u8 **out) {
 	*out += this->getLength();
 }
 
+/**
+ * @brief Encode octet string data
+ * @param writer Reverse BER encoder
+ */
+void BerOctetString::encodeData(BerWriter &writer) {
+	writer.writeBytes(this->text.data(), this->text.length());
+}
+
 /**
  * @brief Destructor for a BerOctetString
  */
@@ -47,9 +55,10 @@ BerOctetString::~BerOctetString() { }
 /**
  * @brief Decode an OCTET STRING from a buffer
  * @param data Input buffer
+ * @param arena Arena used for the decoded field (optional)
  * @return A decoded OCTET STRING
  */
-std::shared_ptr<BerOctetString> BerOctetString::decode(u8 **data) {
+std::shared_ptr<BerOctetString> BerOctetString::decode(u8 **data, const std::shared_ptr<BerArena> &arena) {
 
 	// Skip tag
 	*data += 1;
@@ -60,15 +69,13 @@ std::shared_ptr<BerOctetString> BerOctetString::decode(u8 **data) {
 
 		// Retrieve value
 		u8 *in = *data;
-		std::string str;
-		str.resize(len);
-		memcpy(&str[0], in, len);
+		std::string str((const char*)in, len);
 
 		// Update write pointer
 		*data += len;
 
 		// Return decoded string
-		return std::make_shared<BerOctetString>(str);
+		return makeBerField<BerOctetString>(arena, str);
 	} catch (const std::runtime_error &e) {
 		throw;
 	} catch (const std::bad_alloc &e) {
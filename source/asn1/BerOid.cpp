@@ -4,7 +4,6 @@
  */
 
 // Includes C/C++
-#include <stdlib.h>
 #include <string.h>
 #include <stdexcept>
 
@@ -26,35 +25,9 @@ BerOid::BerOid(u8 tagOptions, u32 tag) : BerField(tagOptions, tag){ }
  * @param tagOptions Tag options (optional)
  * @param tag Tag (optional)
  */
-BerOid::BerOid(const std::string &oidString, u8 tagOptions, u32 tag) : BerField(tagOptions, tag) {
-
-	std::vector<u32> oid = std::vector<u32>();
-
-	char oidTemp[256];
-	memcpy(oidTemp, &oidString[0], oidString.length());
-	oidTemp[oidString.length()] = '\0';
-
-	char *oidToken = strtok(oidTemp, ".");
-	u32 oidFirst = 0;
-	bool firstFlag = false;
-
-	while(oidToken) {
-
-		if(!firstFlag) {
-			oidFirst = atoi(oidToken) * 40;
-			firstFlag = true;
-		} else if(oid.size() == 0) {
-			oidFirst += atoi(oidToken);
-			oid.push_back(oidFirst);
-		} else {
-			oid.push_back(atoi(oidToken));
-		}
-
-		oidToken = strtok(NULL, ".");
-	}
-
+BerOid::BerOid(const std::string &oidString, u8 tagOptions, u32 tag) : BerField(tagOptions, tag), oid(oidString) {
 	try {
-		this->parseOid(oid);
+		this->parseOid();
 	} catch (const std::runtime_error &e) {
 		throw;
 	}
@@ -66,46 +39,39 @@ BerOid::BerOid(const std::string &oidString, u8 tagOptions, u32 tag) : BerField(
  * @param tagOptions Tag options (optional)
  * @param tag Tag (optional)
  */
-BerOid::BerOid(const std::vector<u32> &oid, u8 tagOptions, u32 tag) : BerField(tagOptions, tag) {
-
-    std::vector<u32> realOid = std::vector<u32>();
-    if(oid.size() < 2) {
-        throw std::runtime_error("OID length < 2");
-    }
-    realOid.push_back(oid[0] * 40 + oid[1]);
-    for(u32 i = 2; i < oid.size(); i++) {
-        realOid.push_back(oid[i]);
-    }
-
+BerOid::BerOid(const std::vector<u32> &oid, u8 tagOptions, u32 tag) : BerField(tagOptions, tag), oid(oid) {
 	try {
-		this->parseOid(realOid);
+		this->parseOid();
 	} catch (const std::runtime_error &e) {
 		throw;
 	}
 }
 
 /**
- * @brief Parse an OID vector
- * @param oid OID to parse
+ * @brief Constructor for a BerOid
+ * @param oid Compact OID
+ * @param tagOptions Tag options (optional)
+ * @param tag Tag (optional)
  */
-void BerOid::parseOid(std::vector<u32> &oid){
+BerOid::BerOid(const CompactOid &oid, u8 tagOptions, u32 tag) : BerField(tagOptions, tag), oid(oid) {
+	try {
+		this->parseOid();
+	} catch (const std::runtime_error &e) {
+		throw;
+	}
+}
 
-	this->oid = oid;
+/**
+ * @brief Update the field length after the OID has changed
+ */
+void BerOid::parseOid() {
 
-	if(this->oid.size() == 0) {
+	if(this->oid.isEmpty()) {
 		throw std::runtime_error("OID is empty");
 	}
 
-	u32 length = 0;
-	for(u32 i = 0; i < this->oid.size(); i++) {
-		length ++;
-		for(u8 j = 1; j <= 4; j++) {
-			if((this->oid[i] >> (7 * j)) &0x7F) length ++;
-			else j = 5;		// Exit the loop
-		}
-	}
-
-	this->setLength(length);
+	// The OID is already encoded
+	this->setLength(this->oid.getLength());
 }
 
 /**
@@ -113,8 +79,8 @@ void BerOid::parseOid(std::vector<u32> &oid){
  * @param n Element to be added
  */
 void BerOid::addElement(u32 n) {
-    this->oid.push_back(n);
-    this->parseOid(this->oid);
+    this->oid.append(n);
+    this->setLength(this->oid.getLength());
 }
 
 /**
@@ -122,8 +88,12 @@ void BerOid::addElement(u32 n) {
  * @param n New value for the last element
  */
 void BerOid::editLastElement(u32 n) {
-    this->oid[this->oid.size() - 1] = n;
-    this->parseOid(this->oid);
+
+    // The first two elements are encoded together
+    u32 nArcs = this->oid.getNArcs();
+    this->oid.truncate(nArcs > 2 ? nArcs - 1 : 0);
+    this->oid.append(n);
+    this->setLength(this->oid.getLength());
 }
 
 /**
@@ -131,29 +101,16 @@ void BerOid::editLastElement(u32 n) {
  * @param out Output buffer
  */
 void BerOid::parseData(u8 **out) {
+	memcpy(*out, this->oid.getData(), this->oid.getLength());
+	*out += this->oid.getLength();
+}
 
-	u8 *data = *out;
-
-	for(u32 i = 0; i < this->oid.size(); i++) {
-
-		// Get number length
-		u8 len = 1;
-		for(u8 j = 1; j <= 4; j++) {
-			if((this->oid[i] >> (7 * j)) &0x7F) len ++;
-			else j = 5;			// Exit the loop
-		}
-
-		// Parse the number
-		for(u8 j = 0; j < len; j++) {
-			data[len - j - 1] = ((j > 0) << 7) | 		// Bit 7 up except the last iteration
-								((this->oid[i] >> (7 * j)) &0x7F);
-		}
-
-		data += len;
-	}
-
-	// Update write pointer
-	*out = data;
+/**
+ * @brief Encode OID data
+ * @param writer Reverse BER encoder
+ */
+void BerOid::encodeData(BerWriter &writer) {
+	writer.writeBytes(this->oid.getData(), this->oid.getLength());
 }
 
 /**
@@ -164,9 +121,10 @@ BerOid::~BerOid() { }
 /**
  * @brief Decode an OBJECT IDENTIFIER
  * @param data Input buffer
+ * @param arena Arena used for the decoded field (optional)
  * @return A decoded BerOid
  */
-std::shared_ptr<BerOid> BerOid::decode(u8** data) {
+std::shared_ptr<BerOid> BerOid::decode(u8** data, const std::shared_ptr<BerArena> &arena) {
 
 	// Skip tag
 	*data += 1;
@@ -176,25 +134,9 @@ std::shared_ptr<BerOid> BerOid::decode(u8** data) {
 		u32 len = BerField::decodeLength(data);
 		u8 *in = *data;
 
-		// Fill a vector with oid data
-		std::vector<u32> oid;
-		u32 curOid = 0;
-		for(u32 i = 0; i < len; i++) {
-
-			curOid <<= 7;
-			curOid |= in[i] &0x7F;
-
-			if(!(in[i] &(1 << 7))) {
-				oid.push_back(curOid);
-				curOid = 0;
-			}
-		}
-
+		// The OID is kept encoded
+		std::shared_ptr<BerOid> berOid = makeBerField<BerOid>(arena, CompactOid(in, len));
 		*data += len;
-
-		// Return the decoded OID
-		std::shared_ptr<BerOid> berOid = std::make_shared<BerOid>();
-		berOid->parseOid(oid);
 		return berOid;
 	} catch (const std::runtime_error &e) {
 		throw;
@@ -206,15 +148,7 @@ std::shared_ptr<BerOid> BerOid::decode(u8** data) {
  * @return The OID representation
  */
 std::string BerOid::print() {
-	std::string text;
-	char tmp[64];
-	sprintf(tmp, "%ld.%ld", oid[0] / 40, oid[0] % 40);
-	text.append(tmp);
-	for(u32 i = 1; i < oid.size(); i++) {
-		sprintf(tmp, ".%ld", oid[i]);
-		text.append(tmp);
-	}
-	return text;
+	return this->oid.print();
 }
 
 }
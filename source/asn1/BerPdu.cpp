@@ -4,6 +4,7 @@
  */
 
 // Includes C/C++
+#include <string.h>
 #include <stdexcept>
 
 // Own includes
@@ -20,9 +21,36 @@ BerPdu::BerPdu() {
 
 /**
  * @brief Clear a BerPdu for further usage
+ * @note Derived classes must drop their own fields before calling it, so the arena can be reused
  */
 void BerPdu::clear() {
 	fields.clear();
+
+	// Release the whole arena at once if nothing points into it, or leave it to the remaining fields
+	if(this->arena != nullptr) {
+		if(this->arena.use_count() == 1) {
+			this->arena->reset();
+		} else {
+			this->arena.reset();
+		}
+	}
+}
+
+/**
+ * @brief Get the arena used to build and decode the fields of this PDU, creating it if needed
+ * @return The arena
+ */
+std::shared_ptr<BerArena> BerPdu::getArena() {
+
+	try {
+		if(this->arena == nullptr) {
+			this->arena = std::make_shared<BerArena>();
+		}
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+
+	return this->arena;
 }
 
 /**
@@ -80,6 +108,64 @@ std::unique_ptr<u8> BerPdu::serialize(u32 *size, u8 alignment) {
 	}
 }
 
+/**
+ * @brief Encode a BerPdu in a single pass, from the end of a buffer towards its beginning
+ * @param buffer		Output buffer
+ * @param bufferSize	Output buffer size
+ * @param pduSize		Encoded data size (input)
+ * @param alignment		Data alignment (in bytes), padding is filled with zeros
+ * @return The beginning of the encoded BerPdu, inside buffer
+ */
+u8 *BerPdu::encode(u8 *buffer, u32 bufferSize, u32 *pduSize, u8 alignment) {
+
+	try {
+		BerWriter writer(buffer, bufferSize);
+
+		// Encode the fields, the last one first
+		u32 size = 0;
+		for(u32 i = fields.size(); i > 0; i--) {
+			size += fields[i - 1]->encode(writer);
+		}
+
+		// Align the PDU size, padding goes at the end
+		u32 r = size % alignment;
+		if(r > 0) {
+			u32 padding = alignment - r;
+			if(padding > writer.getRemaining()) {
+				throw std::runtime_error("BER output buffer is full");
+			}
+			u8 *data = writer.getData();
+			memmove(data - padding, data, size);
+			memset(data - padding + size, 0, padding);
+			size += padding;
+			*pduSize = size;
+			return data - padding;
+		}
+
+		*pduSize = size;
+		return writer.getData();
+	} catch (const std::runtime_error &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Get the buffer used to encode PDUs before sending them, creating it if needed
+ * @return The send buffer (BERPDU_MAX_SIZE bytes)
+ */
+u8 *BerPdu::getSendBuffer() {
+
+	try {
+		if(this->sendBuffer == nullptr) {
+			this->sendBuffer = std::unique_ptr<u8[]>(new u8[BERPDU_MAX_SIZE]);
+		}
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+
+	return this->sendBuffer.get();
+}
+
 /**
  * @brief Send a BerPdu
  * @param sock Socket to be used for sending
@@ -88,13 +174,13 @@ std::unique_ptr<u8> BerPdu::serialize(u32 *size, u8 alignment) {
  */
 void BerPdu::send(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port) {
 
-	// Create the PDU buffer
+	// Encode the PDU
 	try {
 		u32 pdu_size = 0;
-		std::unique_ptr<u8> pdu_base = this->serialize(&pdu_size);
+		u8 *pdu_base = this->encode(this->getSendBuffer(), BERPDU_MAX_SIZE, &pdu_size);
 
 		// Send the PDU packet
-		sock->sendPacket(pdu_base.get(), pdu_size, ip, port);
+		sock->sendPacket(pdu_base, pdu_size, ip, port);
 	} catch (const std::runtime_error &e) {
 		throw;
 	}
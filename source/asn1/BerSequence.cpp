@@ -15,12 +15,11 @@ namespace NetMan {
  * @brief Constructor for a BER Sequence
  * @param tagOptions Tag options (optional)
  * @param tag Tag (optional)
+ * @param arena Arena used for the list of children (optional)
  * @note Also valid for a BER Sequence of
  */
-BerSequence::BerSequence(u8 tagOptions, u32 tag) : BerField(tagOptions, tag){
-
-	children = std::vector<std::shared_ptr<BerField>>();
-}
+BerSequence::BerSequence(u8 tagOptions, u32 tag, const std::shared_ptr<BerArena> &arena) : BerField(tagOptions, tag),
+	children(BerArenaAllocator<std::shared_ptr<BerField>>(arena)) { }
 
 /**
  * @brief Add a child to a BerSequence
@@ -60,6 +59,18 @@ void BerSequence::parseData(u8 **out) {
 	}
 }
 
+/**
+ * @brief Encode sequence data
+ * @param writer Reverse BER encoder
+ * @note Children are encoded from the last one to the first one
+ */
+void BerSequence::encodeData(BerWriter &writer) {
+
+	for(u32 i = children.size(); i > 0; i--) {
+		children[i - 1]->encode(writer);
+	}
+}
+
 /**
  * @brief Destructor for a BerSequence
  */
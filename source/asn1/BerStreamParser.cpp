@@ -0,0 +1,174 @@
+/**
+ * @file BerStreamParser.cpp
+ * @brief Resumable push parser for BER messages received in chunks
+ */
+
+// Includes C/C++
+#include <stdexcept>
+
+// Own includes
+#include "asn1/BerStreamParser.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a BerStreamParser
+ * @param maxMessageSize Maximum size of a whole TLV (tag, length and contents)
+ */
+BerStreamParser::BerStreamParser(u32 maxMessageSize) {
+	this->maxMessageSize = maxMessageSize;
+	this->reset();
+}
+
+/**
+ * @brief Drop any partial message and wait for a new one
+ * @note Also needed after an error, or after reading a complete message
+ */
+void BerStreamParser::reset() {
+	this->buffer.clear();
+	this->headerSize = 0;
+	this->lengthSize = 0;
+	this->contentLength = 0;
+	this->state = BERSTREAM_TAG;
+	this->message = BerView();
+}
+
+/**
+ * @brief Stop parsing because of a malformed or too long message
+ * @param error Error description
+ */
+void BerStreamParser::fail(const char *error) {
+	this->state = BERSTREAM_ERROR;
+	throw std::runtime_error(error);
+}
+
+/**
+ * @brief Start copying the contents, once the length is known
+ */
+void BerStreamParser::startContents() {
+
+	if((u64)this->headerSize + this->contentLength > this->maxMessageSize) {
+		this->fail("BER message too long");
+	}
+
+	// Contents are appended after the header, so the message is contiguous
+	u32 total = this->headerSize + this->contentLength;
+	this->buffer.reserve(total);
+	this->buffer.assign(this->header, this->header + this->headerSize);
+	this->state = BERSTREAM_CONTENTS;
+
+	if(this->contentLength == 0) {
+		this->message = BerView(this->buffer.data(), total);
+		this->state = BERSTREAM_DONE;
+	}
+}
+
+/**
+ * @brief Feed a chunk of received bytes
+ * @param data	Received bytes
+ * @param size	Number of received bytes
+ * @return Number of bytes used. Parsing stops when a message is complete, so call it again with the rest
+ * @note A complete message which is wholly inside one chunk is not copied: its view points to that chunk
+ */
+u32 BerStreamParser::push(const u8 *data, u32 size) {
+
+	if(this->state == BERSTREAM_ERROR) {
+		throw std::runtime_error("BER stream must be reset after an error");
+	}
+
+	u32 pos = 0;
+	while(pos < size && this->state != BERSTREAM_DONE) {
+
+		switch(this->state) {
+			case BERSTREAM_TAG:
+			{
+				// Whole message in this chunk, keep a view of it
+				const u8 *in = &data[pos];
+				u32 remaining = size - pos;
+				if(remaining >= 2 && (in[0] &0x1F) != 0x1F) {
+					u32 len = in[1];
+					u32 hdr = 2;
+					bool complete = true;
+					if(len &(1 << 7)) {
+						u32 lenSize = len &0x7F;
+						if(lenSize == 0 || lenSize > 4) {
+							this->fail("Invalid BER length");
+						}
+						if(remaining < 2 + lenSize) {
+							complete = false;
+						} else {
+							len = 0;
+							for(u32 i = 0; i < lenSize; i++) {
+								len = (len << 8) | in[2 + i];
+							}
+							hdr += lenSize;
+						}
+					}
+					if(complete && (u64)hdr + len > this->maxMessageSize) {
+						this->fail("BER message too long");
+					}
+					if(complete && len <= remaining - hdr) {
+						this->message = BerView(in, hdr + len);
+						this->state = BERSTREAM_DONE;
+						pos += hdr + len;
+						break;
+					}
+				}
+
+				// Otherwise, reassemble it
+				if((data[pos] &0x1F) == 0x1F) {
+					this->fail("Long BER tags are not supported");
+				}
+				this->header[this->headerSize++] = data[pos++];
+				this->state = BERSTREAM_LENGTH;
+				break;
+			}
+			case BERSTREAM_LENGTH:
+			{
+				u8 len = data[pos++];
+				this->header[this->headerSize++] = len;
+				if(len &(1 << 7)) {
+					this->lengthSize = len &0x7F;
+					if(this->lengthSize == 0 || this->lengthSize > 4) {
+						this->fail("Invalid BER length");
+					}
+					this->contentLength = 0;
+					this->state = BERSTREAM_LONG_LENGTH;
+				} else {
+					this->contentLength = len;
+					this->startContents();
+				}
+				break;
+			}
+			case BERSTREAM_LONG_LENGTH:
+			{
+				u8 len = data[pos++];
+				this->header[this->headerSize++] = len;
+				this->contentLength = (this->contentLength << 8) | len;
+				if(this->headerSize == 2 + this->lengthSize) {
+					this->startContents();
+				}
+				break;
+			}
+			case BERSTREAM_CONTENTS:
+			{
+				u32 total = this->headerSize + this->contentLength;
+				u32 n = total - this->buffer.size();
+				if(n > size - pos) n = size - pos;
+				this->buffer.insert(this->buffer.end(), &data[pos], &data[pos] + n);
+				pos += n;
+				if(this->buffer.size() == total) {
+					this->message = BerView(this->buffer.data(), total);
+					this->state = BERSTREAM_DONE;
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	return pos;
+}
+
+}
@@ -0,0 +1,280 @@
+/**
+ * @file BerView.cpp
+ * @brief Zero-copy BER field view
+ */
+
+// Includes C/C++
+#include <string.h>
+#include <stdexcept>
+
+// Own includes
+#include "asn1/BerView.h"
+#include "asn1/BerInteger.h"
+#include "asn1/BerNull.h"
+#include "asn1/BerOctetString.h"
+#include "asn1/BerOid.h"
+#include "snmp/Snmpv2Pdu.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for an empty BerView
+ */
+BerView::BerView() {
+	this->data = NULL;
+	this->value = NULL;
+	this->length = 0;
+	this->tag = 0;
+}
+
+/**
+ * @brief Constructor for a BerView
+ * @param data	Beginning of the BER field
+ * @param size	Maximum number of bytes the field can span
+ * @note Only single octet tags and definite lengths (up to 4 octets) are supported
+ */
+BerView::BerView(const u8 *data, u32 size) {
+	BerStatus status = BerView::parse(data, size, this);
+	if(status != BER_OK) {
+		throw std::runtime_error(BerView::getStatusString(status));
+	}
+}
+
+/**
+ * @brief Parse a BER field header, without throwing
+ * @param data	Beginning of the BER field
+ * @param size	Maximum number of bytes the field can span
+ * @param view	Parsed view (output, only set on success)
+ * @return BER_OK, or the reason why the field is not valid
+ */
+BerStatus BerView::parse(const u8 *data, u32 size, BerView *view) {
+
+	// Check tag
+	if(size < 2) {
+		return BER_ERROR_TRUNCATED;
+	}
+	if((data[0] &0x1F) == 0x1F) {
+		return BER_ERROR_LONG_TAG;
+	}
+
+	// Decode length
+	u32 len = data[1];
+	u32 headerSize = 2;
+	if(len &(1 << 7)) {
+		u8 lengthSize = len &0x7F;
+		if(lengthSize == 0 || lengthSize > sizeof(u32)) {
+			return BER_ERROR_LENGTH;
+		}
+		if(size < 2 + (u32)lengthSize) {
+			return BER_ERROR_TRUNCATED;
+		}
+		len = 0;
+		for(u8 i = 0; i < lengthSize; i++) {
+			len = (len << 8) | data[2 + i];
+		}
+		headerSize += lengthSize;
+	}
+
+	// Check the contents fit in the buffer
+	if(len > size - headerSize) {
+		return BER_ERROR_TRUNCATED;
+	}
+
+	view->data = data;
+	view->value = data + headerSize;
+	view->length = len;
+	view->tag = data[0];
+	return BER_OK;
+}
+
+/**
+ * @brief Get the description of a BER decoding status
+ * @param status Decoding status
+ * @return The status description, the same as the exception messages
+ */
+const char *BerView::getStatusString(BerStatus status) {
+	static const char *strings[BER_NSTATUS] = {
+		"OK",
+		"Truncated BER field",
+		"Long BER tags are not supported",
+		"Invalid BER length",
+		"Unexpected BER tag",
+		"Invalid BER value",
+	};
+	return (status < BER_NSTATUS) ? strings[status] : "Unknown BER error";
+}
+
+/**
+ * @brief Get an INTEGER view, without throwing
+ * @param sign	Sign extend the value?
+ * @param value	Decoded value (output)
+ * @return BER_OK, or BER_ERROR_VALUE if the integer is empty or too long
+ */
+BerStatus BerView::getInteger(bool sign, u64 *value) const {
+	return BerInteger::tryDecodeValue(this->value, this->length, sign, value);
+}
+
+/**
+ * @brief Get an INTEGER view as u32
+ * @return The integer as u32
+ */
+u32 BerView::getValueU32() const {
+	return (u32)BerInteger::decodeValue(this->value, this->length, false);
+}
+
+/**
+ * @brief Get an INTEGER view as s32
+ * @return The integer as s32
+ */
+s32 BerView::getValueS32() const {
+	return (s32)BerInteger::decodeValue(this->value, this->length, true);
+}
+
+/**
+ * @brief Get an INTEGER view as u64
+ * @return The integer as u64
+ */
+u64 BerView::getValueU64() const {
+	return BerInteger::decodeValue(this->value, this->length, false);
+}
+
+/**
+ * @brief Get an INTEGER view as s64
+ * @return The integer as s64
+ */
+s64 BerView::getValueS64() const {
+	return (s64)BerInteger::decodeValue(this->value, this->length, true);
+}
+
+/**
+ * @brief Get an OBJECT IDENTIFIER view as a CompactOid
+ * @return The OID, copied from the view contents
+ */
+CompactOid BerView::getOid() const {
+	return CompactOid(this->value, this->length);
+}
+
+/**
+ * @brief Compare the contents of an OCTET STRING view
+ * @param text	String to compare with
+ * @return If both contents are equal
+ */
+bool BerView::equals(const std::string &text) const {
+	return text.length() == this->length && memcmp(text.c_str(), this->value, this->length) == 0;
+}
+
+/**
+ * @brief Copy the contents of the view into a string
+ * @return The field contents
+ */
+std::string BerView::getString() const {
+	return std::string((const char*)this->value, this->length);
+}
+
+/**
+ * @brief Print a BerView
+ * @return The field representation, the same as the one given by its BerField
+ */
+std::string BerView::print() const {
+
+	switch(this->tag) {
+		case (BER_TAG_INTEGER | BER_TAGCLASS_INTEGER):
+			return std::to_string(this->getValueS64());
+		case (SNMPV1_TAG_COUNTER | SNMPV1_TAGCLASS_COUNTER):
+		case (SNMPV1_TAG_GAUGE | SNMPV1_TAGCLASS_GAUGE):
+		case (SNMPV1_TAG_TIMETICKS | SNMPV1_TAGCLASS_TIMETICKS):
+		case (SNMPV2_TAG_COUNTER64 | SNMPV2_TAGCLASS_COUNTER64):
+			return std::to_string(this->getValueU64());
+		case (BER_TAG_OCTETSTRING | BER_TAGCLASS_OCTETSTRING):
+		case (SNMPV1_TAG_NETWORKADDRESS | SNMPV1_TAGCLASS_NETWORKADDRESS):
+		case (SNMPV1_TAG_OPAQUE | SNMPV1_TAGCLASS_OPAQUE):
+			return this->getString();
+		case (BER_TAG_NULL | BER_TAGCLASS_NULL):
+		case (SNMPV2_TAG_NOSUCHOBJECT | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+		case (SNMPV2_TAG_NOSUCHINSTANCE | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+		case (SNMPV2_TAG_ENDOFMIBVIEW | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+			return "null";
+		case (BER_TAG_OID | BER_TAGCLASS_OID):
+			return CompactOid::print(this->value, this->length);
+	}
+
+	return "";
+}
+
+/**
+ * @brief Constructor for a BerReader
+ * @param data	Input buffer
+ * @param size	Input buffer size
+ */
+BerReader::BerReader(const u8 *data, u32 size) {
+	this->ptr = data;
+	this->end = data + size;
+}
+
+/**
+ * @brief Constructor for a BerReader which walks the children of a structured field
+ * @param view	Structured field (SEQUENCE, PDU, ...)
+ */
+BerReader::BerReader(const BerView &view) {
+	this->ptr = view.getValue();
+	this->end = view.getEnd();
+}
+
+/**
+ * @brief Read the next field, without throwing
+ * @param view	Next field (output, only set on success)
+ * @return BER_OK, or the reason why the next field is not valid
+ * @note The reader does not move on errors, so getPosition() gives the offending field
+ */
+BerStatus BerReader::tryNext(BerView *view) {
+	BerStatus status = BerView::parse(this->ptr, this->end - this->ptr, view);
+	if(status == BER_OK) {
+		this->ptr = view->getEnd();
+	}
+	return status;
+}
+
+/**
+ * @brief Read the next field checking its tag, without throwing
+ * @param tag	Expected identifier octet
+ * @param view	Next field (output, only set on success)
+ * @return BER_OK, or the reason why the next field is not valid
+ */
+BerStatus BerReader::tryNext(u8 tag, BerView *view) {
+	if(this->ptr >= this->end) {
+		return BER_ERROR_TRUNCATED;
+	}
+	if(this->ptr[0] != tag) {
+		return BER_ERROR_TAG;
+	}
+	return this->tryNext(view);
+}
+
+/**
+ * @brief Read the next field
+ * @return A view of the next field
+ */
+BerView BerReader::next() {
+	BerView view;
+	BerStatus status = this->tryNext(&view);
+	if(status != BER_OK) {
+		throw std::runtime_error(BerView::getStatusString(status));
+	}
+	return view;
+}
+
+/**
+ * @brief Read the next field, checking its tag
+ * @param tag	Expected identifier octet
+ * @return A view of the next field
+ */
+BerView BerReader::next(u8 tag) {
+	BerView view;
+	BerStatus status = this->tryNext(tag, &view);
+	if(status != BER_OK) {
+		throw std::runtime_error(BerView::getStatusString(status));
+	}
+	return view;
+}
+
+}
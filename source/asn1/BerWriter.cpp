@@ -0,0 +1,117 @@
+/**
+ * @file BerWriter.cpp
+ * @brief Reverse BER encoder
+ */
+
+// Includes C/C++
+#include <string.h>
+#include <stdexcept>
+
+// Own includes
+#include "asn1/BerWriter.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a BerWriter
+ * @param buffer	Output buffer
+ * @param size		Output buffer size
+ */
+BerWriter::BerWriter(u8 *buffer, u32 size) {
+	this->base = buffer;
+	this->end = buffer + size;
+	this->ptr = this->end;
+}
+
+/**
+ * @brief Write a byte in front of the already written data
+ * @param value Byte to write
+ */
+void BerWriter::writeByte(u8 value) {
+	if(this->ptr == this->base) {
+		throw std::runtime_error("BER output buffer is full");
+	}
+	*(--this->ptr) = value;
+}
+
+/**
+ * @brief Write a block of bytes in front of the already written data
+ * @param data		Data to write
+ * @param length	Data length
+ */
+void BerWriter::writeBytes(const void *data, u32 length) {
+	if(length > this->getRemaining()) {
+		throw std::runtime_error("BER output buffer is full");
+	}
+	this->ptr -= length;
+	memcpy(this->ptr, data, length);
+}
+
+/**
+ * @brief Write a block of zeros in front of the already written data
+ * @param length Number of zeros
+ */
+void BerWriter::writeZeros(u32 length) {
+	if(length > this->getRemaining()) {
+		throw std::runtime_error("BER output buffer is full");
+	}
+	this->ptr -= length;
+	memset(this->ptr, 0, length);
+}
+
+/**
+ * @brief Take as written the bytes in front of the already written data, leaving them as they are
+ * @param length Number of bytes
+ * @note Used to put a field header in front of contents produced in the buffer by other means
+ */
+void BerWriter::skip(u32 length) {
+	if(length > this->getRemaining()) {
+		throw std::runtime_error("BER output buffer is full");
+	}
+	this->ptr -= length;
+}
+
+/**
+ * @brief Write a field length
+ * @param length Field length
+ */
+void BerWriter::writeLength(u32 length) {
+
+	if(length <= 127) {				// Short size
+		this->writeByte(length);
+		return;
+	}
+
+	// Long size
+	u8 lengthSize = 0;
+	while(length > 0) {
+		this->writeByte(length &0xFF);
+		length >>= 8;
+		lengthSize ++;
+	}
+	this->writeByte((1 << 7) | lengthSize);		// Number of bytes which compound the length
+}
+
+/**
+ * @brief Write a field tag
+ * @param tagOptions	Tag class and if it is a structured field
+ * @param tag			Tag ID
+ */
+void BerWriter::writeTag(u8 tagOptions, u32 tag) {
+
+	if(tag < 31) {					// Short tag
+		this->writeByte(tagOptions | tag);
+		return;
+	}
+
+	// Long tag, bit 7 up except for the last octet
+	this->writeByte(tag &0x7F);
+	tag >>= 7;
+	while(tag > 0) {
+		this->writeByte((1 << 7) | (tag &0x7F));
+		tag >>= 7;
+	}
+	this->writeByte(tagOptions | 0b11111);
+}
+
+}
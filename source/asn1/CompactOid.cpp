@@ -0,0 +1,372 @@
+/**
+ * @file CompactOid.cpp
+ * @brief Compact OBJECT IDENTIFIER, stored in its BER encoded form
+ */
+
+// Includes C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+
+// Own includes
+#include "asn1/CompactOid.h"
+#include "asn1/OidCodec.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for an empty CompactOid
+ */
+CompactOid::CompactOid() {
+	this->data = this->inlineData;
+	this->length = 0;
+	this->capacity = COMPACTOID_INLINE_SIZE;
+}
+
+/**
+ * @brief Constructor for a CompactOid
+ * @param encoded	BER encoded arcs (OID contents, without tag and length)
+ * @param length	Encoded length
+ */
+CompactOid::CompactOid(const u8 *encoded, u32 length) : CompactOid() {
+
+	// The last octet must end an arc
+	if(length > 0 && (encoded[length - 1] &(1 << 7))) {
+		throw std::runtime_error("Truncated OID arc");
+	}
+
+	this->reserve(length);
+	memcpy(this->data, encoded, length);
+	this->length = length;
+}
+
+/**
+ * @brief Constructor for a CompactOid
+ * @param oidString OID in dotted notation
+ */
+CompactOid::CompactOid(const std::string &oidString) : CompactOid() {
+
+	const char *ptr = oidString.c_str();
+	u32 nArcs = 0;
+	u32 first = 0;
+
+	while(*ptr != '\0') {
+
+		// Skip empty arcs
+		if(*ptr == '.') {
+			ptr ++;
+			continue;
+		}
+
+		char *end;
+		u32 arc = strtoul(ptr, &end, 10);
+		if(end == ptr || (*end != '.' && *end != '\0')) {
+			throw std::runtime_error("Invalid OID: " + oidString);
+		}
+
+		// The first two arcs are encoded together
+		if(nArcs == 0) {
+			first = arc * 40;
+		} else if(nArcs == 1) {
+			this->append(first + arc);
+		} else {
+			this->append(arc);
+		}
+		nArcs ++;
+		ptr = end;
+	}
+
+	if(nArcs < 2) {
+		throw std::runtime_error("OID length < 2");
+	}
+}
+
+/**
+ * @brief Constructor for a CompactOid
+ * @param arcs OID arcs, as in the dotted notation
+ */
+CompactOid::CompactOid(const std::vector<u32> &arcs) : CompactOid() {
+
+	if(arcs.size() < 2) {
+		throw std::runtime_error("OID length < 2");
+	}
+
+	this->append(arcs[0] * 40 + arcs[1]);
+	this->reserve(this->length + (arcs.size() - 2) * OIDCODEC_MAX_ARC_SIZE);
+	this->length += OidCodec::encodeArcs(&arcs[2], arcs.size() - 2, &this->data[this->length]);
+}
+
+/**
+ * @brief Copy constructor for a CompactOid
+ * @param other OID to copy
+ */
+CompactOid::CompactOid(const CompactOid &other) : CompactOid() {
+	this->reserve(other.length);
+	memcpy(this->data, other.data, other.length);
+	this->length = other.length;
+}
+
+/**
+ * @brief Copy a CompactOid
+ * @param other OID to copy
+ * @return This OID
+ */
+CompactOid &CompactOid::operator=(const CompactOid &other) {
+	if(this != &other) {
+		this->reserve(other.length);
+		memcpy(this->data, other.data, other.length);
+		this->length = other.length;
+	}
+	return *this;
+}
+
+/**
+ * @brief Destructor for a CompactOid
+ */
+CompactOid::~CompactOid() {
+	if(this->data != this->inlineData) {
+		delete [] this->data;
+	}
+}
+
+/**
+ * @brief Make room for some encoded bytes
+ * @param size Total encoded size needed
+ */
+void CompactOid::reserve(u32 size) {
+
+	if(size <= this->capacity) return;
+	if(size > 0xFFFF) {
+		throw std::runtime_error("OID is too long");
+	}
+
+	// Grow geometrically, the OID is usually being built arc by arc
+	u32 newCapacity = this->capacity << 1;
+	if(newCapacity < size) newCapacity = size;
+	if(newCapacity > 0xFFFF) newCapacity = 0xFFFF;
+
+	u8 *newData = new u8[newCapacity];
+	memcpy(newData, this->data, this->length);
+	if(this->data != this->inlineData) {
+		delete [] this->data;
+	}
+	this->data = newData;
+	this->capacity = newCapacity;
+}
+
+/**
+ * @brief Find where an arc begins
+ * @param nArcs Number of encoded arcs to skip
+ * @return Offset of the arc, or the encoded length if there are less arcs
+ */
+u32 CompactOid::skipArcs(u32 nArcs) const {
+	u32 offset = 0;
+	u32 arc;
+	for(u32 i = 0; i < nArcs && offset < this->length; i++) {
+		u32 size = OidCodec::decodeArc(&this->data[offset], this->length - offset, &arc);
+		if(size == 0) return this->length;
+		offset += size;
+	}
+	return offset;
+}
+
+/**
+ * @brief Get the number of arcs, as in the dotted notation
+ * @return Number of arcs
+ */
+u32 CompactOid::getNArcs() const {
+
+	if(this->length == 0) return 0;
+
+	// The first encoded arc holds two arcs
+	return OidCodec::countArcs(this->data, this->length) + 1;
+}
+
+/**
+ * @brief Get an arc
+ * @param i Arc index, as in the dotted notation
+ * @return The arc value
+ */
+u32 CompactOid::getArc(u32 i) const {
+
+	u32 offset = this->skipArcs((i == 0) ? 0 : i - 1);
+	u32 arc;
+	if(offset >= this->length || OidCodec::decodeArc(&this->data[offset], this->length - offset, &arc) == 0) {
+		throw std::out_of_range("OID arc out of range");
+	}
+
+	// The first two arcs are encoded as 40 * X + Y
+	if(i <= 1) {
+		u32 x = (arc < 80) ? arc / 40 : 2;
+		return (i == 0) ? x : arc - x * 40;
+	}
+	return arc;
+}
+
+/**
+ * @brief Add an arc at the end
+ * @param arc Arc value (the first two arcs go together, as 40 * X + Y)
+ */
+void CompactOid::append(u32 arc) {
+	this->reserve(this->length + OIDCODEC_MAX_ARC_SIZE);
+	this->length += OidCodec::encodeArc(arc, &this->data[this->length]);
+}
+
+/**
+ * @brief Add the arcs of another OID at the end
+ * @param suffix	OID with the arcs to add
+ * @param firstArc	First arc of suffix to add, as in the dotted notation (2 or more)
+ */
+void CompactOid::append(const CompactOid &suffix, u32 firstArc) {
+
+	if(firstArc < 2) {
+		throw std::runtime_error("The first two arcs can't be appended");
+	}
+
+	// Skip the first arcs of the suffix
+	u32 offset = suffix.skipArcs(firstArc - 1);
+
+	u32 size = suffix.length - offset;
+	this->reserve(this->length + size);
+	memcpy(&this->data[this->length], &suffix.data[offset], size);
+	this->length += size;
+}
+
+/**
+ * @brief Keep only the first arcs
+ * @param nArcs Number of arcs to keep, as in the dotted notation
+ */
+void CompactOid::truncate(u32 nArcs) {
+
+	if(nArcs < 2) {
+		this->length = 0;
+		return;
+	}
+
+	this->length = this->skipArcs(nArcs - 1);
+}
+
+/**
+ * @brief Remove every arc
+ */
+void CompactOid::clear() {
+	this->length = 0;
+}
+
+/**
+ * @brief Compare two OIDs in lexicographic arc order, using the encoded form
+ * @param other OID to compare with
+ * @return Less than zero, zero or greater than zero if this OID goes before, equals or goes after other
+ * @note Minimal encodings are assumed: a longer arc is a bigger arc
+ */
+int CompactOid::compare(const CompactOid &other) const {
+
+	u32 i = 0;
+	u32 j = 0;
+	while(i < this->length && j < other.length) {
+
+		// Equal octets are equal arcs, so skip them before decoding
+		if(this->data[i] == other.data[j]) {
+			i ++;
+			j ++;
+			continue;
+		}
+
+		// Both positions are at the same point of an arc, decode the rest of it
+		u32 a, b;
+		u32 sizeA = OidCodec::decodeArc(&this->data[i], this->length - i, &a);
+		u32 sizeB = OidCodec::decodeArc(&other.data[j], other.length - j, &b);
+		if(sizeA != sizeB) {
+			return (sizeA < sizeB) ? -1 : 1;
+		}
+		return (a < b) ? -1 : 1;
+	}
+
+	// The shorter OID goes first
+	if(i < this->length) return 1;
+	if(j < other.length) return -1;
+	return 0;
+}
+
+/**
+ * @brief Check if this OID is a prefix of another one (or the same OID)
+ * @param other OID which could be under this one
+ * @return If every arc of this OID starts other
+ * @note As arcs end with an octet without bit 7, a byte prefix is always an arc prefix
+ */
+bool CompactOid::isPrefixOf(const CompactOid &other) const {
+	return this->length <= other.length && memcmp(this->data, other.data, this->length) == 0;
+}
+
+/**
+ * @brief Hash an OID (FNV-1a over the encoded bytes)
+ * @return The hash value
+ */
+u32 CompactOid::hash() const {
+	u32 h = 2166136261u;
+	for(u32 i = 0; i < this->length; i++) {
+		h ^= this->data[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/**
+ * @brief Append an arc to a dotted OID
+ * @param text	Dotted OID
+ * @param arc	Arc value
+ */
+static void compactoid_append_arc(std::string &text, u32 arc) {
+	char tmp[10];
+	char *ptr = tmp + sizeof(tmp);
+	do {
+		*--ptr = '0' + arc % 10;
+		arc /= 10;
+	} while(arc != 0);
+	text.append(ptr, tmp + sizeof(tmp) - ptr);
+}
+
+/**
+ * @brief Print BER encoded OID contents, without copying them
+ * @param encoded	BER encoded arcs
+ * @param length	Encoded length
+ * @return The OID in dotted notation
+ */
+std::string CompactOid::print(const u8 *encoded, u32 length) {
+
+	std::string text;
+	text.reserve(length * 3);
+	u32 arcs[32];
+	u32 offset = 0;
+	bool first = true;
+	while(offset < length) {
+		u32 consumed;
+		u32 n = OidCodec::decodeArcs(&encoded[offset], length - offset, arcs, 32, &consumed);
+		if(n == 0) break;
+		for(u32 i = 0; i < n; i++) {
+			if(first) {
+				u32 x = (arcs[i] < 80) ? arcs[i] / 40 : 2;
+				compactoid_append_arc(text, x);
+				text.push_back('.');
+				compactoid_append_arc(text, arcs[i] - x * 40);
+				first = false;
+			} else {
+				text.push_back('.');
+				compactoid_append_arc(text, arcs[i]);
+			}
+		}
+		offset += consumed;
+	}
+	return text;
+}
+
+/**
+ * @brief Print an OID
+ * @return The OID in dotted notation
+ */
+std::string CompactOid::print() const {
+	return CompactOid::print(this->data, this->length);
+}
+
+}
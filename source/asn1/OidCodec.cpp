@@ -0,0 +1,212 @@
+/**
+ * @file OidCodec.cpp
+ * @brief Word-at-a-time base 128 codec for OID arcs
+ */
+
+// Own includes
+#include "asn1/OidCodec.h"
+
+// SSE2 is only available on host builds, the ARM11 has no NEON either
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace NetMan {
+
+/**
+ * @brief Encoded size for each number of significant bits
+ */
+const u8 OidCodec::arcSizes[33] = {
+	1, 1, 1, 1, 1, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2,
+	3, 3, 3, 3, 3, 3, 3,
+	4, 4, 4, 4, 4, 4, 4,
+	5, 5, 5, 5
+};
+
+/**
+ * @brief Encode an arc in base 128
+ * @param arc	Arc value
+ * @param out	Output buffer (OIDCODEC_MAX_ARC_SIZE octets at least)
+ * @return Number of written octets
+ */
+u32 OidCodec::encodeArc(u32 arc, u8 *out) {
+
+	u32 size = OidCodec::getArcSize(arc);
+	if(size == 1) {
+		out[0] = arc;
+		return 1;
+	}
+
+	// Spread the 7 bit groups, one per octet, the last group in the lowest octet
+	u64 spread = (arc &0x7F) | ((arc &0x3F80) << 1) | ((arc &0x1FC000) << 2) |
+				((arc &0xFE00000) << 3) | ((u64)(arc &0xF0000000) << 4);
+
+	// Bit 7 up except for the last octet
+	spread |= 0x8080808000ULL &((1ULL << (size << 3)) - 1);
+
+	// Store in big endian order
+	spread = __builtin_bswap64(spread) >> ((8 - size) << 3);
+	memcpy(out, &spread, size);
+	return size;
+}
+
+/**
+ * @brief Encode some arcs in base 128
+ * @param arcs		Arc values
+ * @param nArcs		Number of arcs
+ * @param out		Output buffer (nArcs * OIDCODEC_MAX_ARC_SIZE octets at least)
+ * @return Number of written octets
+ */
+u32 OidCodec::encodeArcs(const u32 *arcs, u32 nArcs, u8 *out) {
+	u8 *ptr = out;
+	for(u32 i = 0; i < nArcs; i++) {
+		if(arcs[i] < 0x80) {
+			*ptr++ = arcs[i];
+		} else {
+			ptr += OidCodec::encodeArc(arcs[i], ptr);
+		}
+	}
+	return ptr - out;
+}
+
+/**
+ * @brief Decode an arc one octet at a time, for arcs longer than a word
+ * @param in		Input buffer
+ * @param length	Readable octets
+ * @param arc		Output arc value
+ * @return Number of read octets, 0 if the arc is truncated
+ */
+u32 OidCodec::decodeSlow(const u8 *in, u32 length, u32 *arc) {
+	u32 value = 0;
+	for(u32 i = 0; i < length; i++) {
+		value = (value << 7) | (in[i] &0x7F);
+		if(!(in[i] &(1 << 7))) {
+			*arc = value;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Decode an arc
+ * @param in		Input buffer
+ * @param length	Readable octets
+ * @param arc		Output arc value
+ * @return Number of read octets, 0 if the arc is truncated
+ */
+u32 OidCodec::decodeArc(const u8 *in, u32 length, u32 *arc) {
+
+	if(length == 0) return 0;
+
+	// Find the first terminator within the next word
+	u32 word = OidCodec::loadWord(in, length);
+	u32 terminators = OidCodec::getTerminators(word);
+	if(length < 4) {
+		terminators &= (1U << (length << 3)) - 1;
+	}
+	if(terminators == 0) {
+		return OidCodec::decodeSlow(in, length, arc);
+	}
+	u32 size = (__builtin_ctz(terminators) + 1) >> 3;
+
+	// Keep the arc octets in big endian order and join their 7 bit groups
+	u32 value = word &0x7F7F7F7F;
+	value = __builtin_bswap32(value) >> ((4 - size) << 3);
+	*arc = (value &0x7F) | ((value >> 1) &0x3F80) | ((value >> 2) &0x1FC000) | ((value >> 3) &0xFE00000);
+	return size;
+}
+
+/**
+ * @brief Decode some arcs
+ * @param in		Input buffer
+ * @param length	Readable octets
+ * @param arcs		Output arc values
+ * @param maxArcs	Maximum number of arcs to decode
+ * @param consumed	Number of read octets (optional)
+ * @return Number of decoded arcs
+ * @note Decoding stops at a truncated arc
+ */
+u32 OidCodec::decodeArcs(const u8 *in, u32 length, u32 *arcs, u32 maxArcs, u32 *consumed) {
+
+	u32 pos = 0;
+	u32 n = 0;
+	while(pos < length && n < maxArcs) {
+
+#ifdef __SSE2__
+		// 16 single octet arcs, widened to 32 bits
+		if(length - pos >= 16 && maxArcs - n >= 16) {
+			__m128i bytes = _mm_loadu_si128((const __m128i*)&in[pos]);
+			if(_mm_movemask_epi8(bytes) == 0) {
+				__m128i zero = _mm_setzero_si128();
+				__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+				__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+				_mm_storeu_si128((__m128i*)&arcs[n], _mm_unpacklo_epi16(lo, zero));
+				_mm_storeu_si128((__m128i*)&arcs[n + 4], _mm_unpackhi_epi16(lo, zero));
+				_mm_storeu_si128((__m128i*)&arcs[n + 8], _mm_unpacklo_epi16(hi, zero));
+				_mm_storeu_si128((__m128i*)&arcs[n + 12], _mm_unpackhi_epi16(hi, zero));
+				pos += 16;
+				n += 16;
+				continue;
+			}
+		}
+#endif
+
+		// 4 single octet arcs
+		if(length - pos >= 4 && maxArcs - n >= 4) {
+			u32 word = OidCodec::loadWord(&in[pos], 4);
+			if(OidCodec::getTerminators(word) == OIDCODEC_HIGH_BITS) {
+				arcs[n] = word &0xFF;
+				arcs[n + 1] = (word >> 8) &0xFF;
+				arcs[n + 2] = (word >> 16) &0xFF;
+				arcs[n + 3] = word >> 24;
+				pos += 4;
+				n += 4;
+				continue;
+			}
+		}
+
+		// Multi octet arc
+		u32 size = OidCodec::decodeArc(&in[pos], length - pos, &arcs[n]);
+		if(size == 0) break;
+		pos += size;
+		n ++;
+	}
+
+	if(consumed != NULL) {
+		*consumed = pos;
+	}
+	return n;
+}
+
+/**
+ * @brief Count the encoded arcs
+ * @param in		Input buffer
+ * @param length	Readable octets
+ * @return Number of complete arcs
+ */
+u32 OidCodec::countArcs(const u8 *in, u32 length) {
+
+	u32 n = 0;
+	u32 pos = 0;
+
+#ifdef __SSE2__
+	for(; pos + 16 <= length; pos += 16) {
+		u32 mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)&in[pos]));
+		n += 16 - __builtin_popcount(mask);
+	}
+#endif
+
+	// Each octet with bit 7 down ends an arc
+	for(; pos < length; pos += 4) {
+		u32 terminators = OidCodec::getTerminators(OidCodec::loadWord(&in[pos], length - pos));
+		if(length - pos < 4) {
+			terminators &= (1U << ((length - pos) << 3)) - 1;
+		}
+		n += __builtin_popcount(terminators);
+	}
+	return n;
+}
+
+}
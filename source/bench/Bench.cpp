@@ -0,0 +1,203 @@
+/**
+ * @file Bench.cpp
+ * @brief Micro benchmark helper
+ */
+
+// Includes C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+// Includes 3DS
+#include <3ds.h>
+
+// Own includes
+#include "bench/Bench.h"
+
+// Defines
+#define BENCH_ALLOC_HEADER  8       /**< Room to remember each allocation size, keeps 8 byte alignment */
+
+// Allocation counters
+static u32 allocCount = 0;
+static u32 allocBytes = 0;
+static u32 liveBytes = 0;
+static u32 peakBytes = 0;
+
+#ifdef BENCH_ALLOCS
+void *operator new(size_t size) {
+    u8 *ptr = (u8*)malloc(size + BENCH_ALLOC_HEADER);
+    if(ptr == NULL) throw std::bad_alloc();
+    *(u32*)ptr = size;
+    allocCount ++;
+    allocBytes += size;
+    liveBytes += size;
+    if(liveBytes > peakBytes) peakBytes = liveBytes;
+    return ptr + BENCH_ALLOC_HEADER;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    if(ptr == NULL) return;
+    u8 *base = (u8*)ptr - BENCH_ALLOC_HEADER;
+    liveBytes -= *(u32*)base;
+    free(base);
+}
+
+void operator delete[](void *ptr) noexcept {
+    operator delete(ptr);
+}
+#endif
+
+namespace NetMan {
+
+/**
+ * @brief Check if heap allocations are being counted
+ * @return If BENCH_ALLOCS is defined
+ */
+bool Bench::isCountingAllocs() {
+#ifdef BENCH_ALLOCS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Get the number of heap allocations done so far
+ * @return The number of allocations, always 0 if BENCH_ALLOCS is not defined
+ */
+u32 Bench::getAllocCount() {
+    return allocCount;
+}
+
+/**
+ * @brief Get the number of bytes allocated so far
+ * @return The allocated bytes, always 0 if BENCH_ALLOCS is not defined
+ */
+u32 Bench::getAllocBytes() {
+    return allocBytes;
+}
+
+/**
+ * @brief Get the number of heap bytes in use
+ * @return The bytes in use, always 0 if BENCH_ALLOCS is not defined
+ */
+u32 Bench::getLiveBytes() {
+    return liveBytes;
+}
+
+/**
+ * @brief Run a benchmark
+ * @param name          Benchmark name
+ * @param iterations    Number of times the function is called
+ * @param func          Function to be measured
+ * @param args          Function arguments
+ * @return The benchmark result
+ */
+BenchResult Bench::run(const std::string &name, u32 iterations, BenchFunc func, void *args) {
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+
+    // Warm up, so lazy buffers are not counted
+    func(args);
+
+    u32 allocs = allocCount;
+    u32 bytes = allocBytes;
+    u32 live = liveBytes;
+    peakBytes = liveBytes;
+    u64 start = svcGetSystemTick();
+    for(u32 i = 0; i < iterations; i++) {
+        func(args);
+    }
+    result.ticks = svcGetSystemTick() - start;
+    result.allocs = allocCount - allocs;
+    result.allocBytes = allocBytes - bytes;
+    result.peakBytes = peakBytes - live;
+
+    return result;
+}
+
+/**
+ * @brief Append a benchmark result to a log file
+ * @param result    Benchmark result
+ * @param path      Log file path
+ */
+void Bench::log(const BenchResult &result, const std::string &path) {
+
+    FILE *f = fopen(path.c_str(), "a+");
+    if(f == NULL) return;
+
+    u32 iterations = result.iterations == 0 ? 1 : result.iterations;
+    double ns = (double)result.ticks * 1000000000.0 / SYSCLOCK_ARM11 / iterations;
+    fprintf(f, "%s: %lu iterations, %.1f ns/op, %.2f ops/s, %.2f allocs/op, %.1f bytes/op, %lu peak heap bytes\n",
+        result.name.c_str(), (unsigned long)result.iterations, ns, ns > 0 ? 1000000000.0 / ns : 0.0,
+        (double)result.allocs / iterations, (double)result.allocBytes / iterations, (unsigned long)result.peakBytes);
+    fclose(f);
+}
+
+/**
+ * @brief Append a line of text to a log file
+ * @param text  Text, without the line break
+ * @param path  Log file path (optional)
+ */
+void Bench::logText(const std::string &text, const std::string &path) {
+
+    FILE *f = fopen(path.c_str(), "a+");
+    if(f == NULL) return;
+
+    fprintf(f, "%s\n", text.c_str());
+    fclose(f);
+}
+
+/**
+ * @brief Log the throughput of a benchmark, in items per second
+ * @param result Benchmark result
+ * @param itemsPerOp Items processed by each iteration
+ * @param unit Item name, in plural
+ * @param path Log file path (optional)
+ */
+void Bench::logRate(const BenchResult &result, u32 itemsPerOp, const std::string &unit, const std::string &path) {
+
+    FILE *f = fopen(path.c_str(), "a+");
+    if(f == NULL) return;
+
+    double seconds = (double)result.ticks / SYSCLOCK_ARM11;
+    double items = (double)result.iterations * itemsPerOp;
+    fprintf(f, "%s: %.0f %s/s\n", result.name.c_str(), seconds > 0 ? items / seconds : 0.0, unit.c_str());
+    fclose(f);
+}
+
+/**
+ * @brief Append a benchmark result to a JSON Lines file, to be compared between releases
+ * @param result        Benchmark result
+ * @param itemsPerOp    Items (fields, messages, ...) processed by each iteration
+ * @param bytesPerOp    Encoded bytes processed by each iteration
+ * @param path          Results file path (optional)
+ * @note Allocation figures are null if BENCH_ALLOCS is not defined
+ */
+void Bench::logJson(const BenchResult &result, u32 itemsPerOp, u32 bytesPerOp, const std::string &path) {
+
+    FILE *f = fopen(path.c_str(), "a+");
+    if(f == NULL) return;
+
+    u32 iterations = result.iterations == 0 ? 1 : result.iterations;
+    double seconds = (double)result.ticks / SYSCLOCK_ARM11;
+    double ns = seconds * 1000000000.0 / iterations;
+    fprintf(f, "{\"name\": \"%s\", \"iterations\": %lu, \"ns_per_op\": %.1f, \"items_per_op\": %lu, \"bytes_per_op\": %lu, \"items_per_s\": %.0f, \"bytes_per_s\": %.0f",
+        result.name.c_str(), (unsigned long)result.iterations, ns, (unsigned long)itemsPerOp, (unsigned long)bytesPerOp,
+        seconds > 0 ? (double)result.iterations * itemsPerOp / seconds : 0.0, seconds > 0 ? (double)result.iterations * bytesPerOp / seconds : 0.0);
+    if(Bench::isCountingAllocs()) {
+        fprintf(f, ", \"allocs_per_op\": %.2f, \"alloc_bytes_per_op\": %.1f, \"peak_heap_bytes\": %lu}\n",
+            (double)result.allocs / iterations, (double)result.allocBytes / iterations, (unsigned long)result.peakBytes);
+    } else {
+        fprintf(f, ", \"allocs_per_op\": null, \"alloc_bytes_per_op\": null, \"peak_heap_bytes\": null}\n");
+    }
+    fclose(f);
+}
+
+}
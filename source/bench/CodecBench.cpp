@@ -0,0 +1,1128 @@
+/**
+ * @file CodecBench.cpp
+ * @brief BER/SNMP codec benchmark suite, run over a corpus of SNMP messages
+ */
+
+// Includes C/C++
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+#include <stdexcept>
+
+// Own includes
+#include "bench/CodecBench.h"
+#include "asn1/BerArena.h"
+#include "asn1/BerInteger.h"
+#include "asn1/BerNull.h"
+#include "asn1/BerOctetString.h"
+#include "asn1/BerOid.h"
+#include "asn1/BerPdu.h"
+#include "asn1/BerSequence.h"
+#include "asn1/BerStreamParser.h"
+#include "asn1/BerView.h"
+#include "asn1/BerWriter.h"
+#include "asn1/OidCodec.h"
+#include "snmp/Snmpv2Pdu.h"
+#include "snmp/Snmpv3Pdu.h"
+#include "snmp/Snmpv3UserStore.h"
+
+// Defines
+#define CODECBENCH_FIELD_ITERATIONS     1000
+#define CODECBENCH_TREE_ITERATIONS      2000
+#define CODECBENCH_COLD_KEY_ITERATIONS  5       /**< SNMPv3 runs deriving the keys from the passwords each time */
+#define CODECBENCH_SEND_IP              "127.0.0.1"
+#define CODECBENCH_SEND_PORT            9       /**< Discard service, requests sent by the benchmark are not answered */
+#define CODECBENCH_AUTH_PASSWORD        "benchauthpass"
+#define CODECBENCH_PRIV_PASSWORD        "benchprivpass"
+
+// Field kinds
+#define CODECBENCH_INTEGER              0
+#define CODECBENCH_OID                  1
+#define CODECBENCH_OCTETSTRING          2
+#define CODECBENCH_VARBIND              3
+#define CODECBENCH_NKINDS               4
+
+namespace NetMan {
+
+/**
+ * @struct CodecBenchFile
+ */
+typedef struct {
+    const char *name;
+    u32 iterations;
+} CodecBenchFile;
+
+/**
+ * @struct CodecBenchUser
+ */
+typedef struct {
+    const char *name;
+    u32 authProto;
+    u32 privProto;
+} CodecBenchUser;
+
+/**
+ * @struct CodecBenchFieldArgs
+ */
+typedef struct {
+    std::vector<BerView> views;                         /**< Fields of a kind, inside the corpus messages */
+    std::vector<std::shared_ptr<BerField>> fields;      /**< The same fields, already decoded */
+    std::shared_ptr<BerField> (*decode)(u8 **data, const std::shared_ptr<BerArena> &arena);
+    std::shared_ptr<BerArena> arena;
+    u8 *buffer;
+} CodecBenchFieldArgs;
+
+/**
+ * @struct CodecBenchMessageArgs
+ */
+typedef struct {
+    const CodecBenchMessage *message;
+    u32 version;
+    u8 pduType;
+    u32 reqID;
+    u32 nonRepeaters;
+    u32 maxRepetitions;
+    std::shared_ptr<Snmpv1Pdu> pdu;                     /**< Used for SNMPv1 and SNMPv2c messages */
+    std::shared_ptr<Snmpv3Pdu> v3pdu;                   /**< Used for SNMPv3 messages */
+    std::vector<std::shared_ptr<BerOid>> oids;          /**< VarBind OIDs, to rebuild the message */
+    std::vector<std::shared_ptr<BerField>> values;      /**< VarBind values, to rebuild the message */
+    std::vector<u8> work;                               /**< SNMPv3 messages are modified while they are authenticated */
+    std::shared_ptr<UdpSocket> sock;                    /**< Used to send SNMPv3 requests */
+    std::shared_ptr<BerField> tree;
+    std::shared_ptr<BerArena> arena;
+    u8 *buffer;
+} CodecBenchMessageArgs;
+
+// Corpus messages, and how many times each one is processed
+static const CodecBenchFile corpusFiles[] = {
+    { "v1-get-request", 2000 },
+    { "v1-get-response", 2000 },
+    { "v1-trap", 2000 },
+    { "v2c-getbulk-request", 2000 },
+    { "v2c-getbulk-response", 2000 },
+    { "v2c-trap", 2000 },
+    { "v3-authpriv-get-request", 2000 },
+    { "v3-authpriv-get-response", 2000 },
+    { "v3-authnopriv-get-response", 2000 },
+};
+
+// Users of the SNMPv3 corpus messages
+static const CodecBenchUser corpusUsers[] = {
+    { "bench", SNMPV3_AUTHPROTO_MD5, SNMPV3_PRIVPROTO_DES },
+    { "benchsha", SNMPV3_AUTHPROTO_SHA1, SNMPV3_PRIVPROTO_NONE },
+};
+
+// Names of the field kinds
+static const char *kindNames[CODECBENCH_NKINDS] = {
+    "BerInteger", "BerOid", "BerOctetString", "BerSequence (VarBind)",
+};
+
+/**
+ * @brief Decode an INTEGER, or any of the SNMP unsigned types
+ * @param data  Input buffer
+ * @param arena Arena used for the field, or nullptr to use the heap
+ * @return The decoded field
+ */
+static std::shared_ptr<BerField> codecbench_decode_integer(u8 **data, const std::shared_ptr<BerArena> &arena) {
+    bool sign = (*data)[0] == (BER_TAGCLASS_INTEGER | BER_TAG_INTEGER);
+    return BerInteger::decode(data, sign, arena);
+}
+
+/**
+ * @brief Decode an OBJECT IDENTIFIER
+ * @param data  Input buffer
+ * @param arena Arena used for the field, or nullptr to use the heap
+ * @return The decoded field
+ */
+static std::shared_ptr<BerField> codecbench_decode_oid(u8 **data, const std::shared_ptr<BerArena> &arena) {
+    return BerOid::decode(data, arena);
+}
+
+/**
+ * @brief Decode an OCTET STRING, or any of the SNMP string types
+ * @param data  Input buffer
+ * @param arena Arena used for the field, or nullptr to use the heap
+ * @return The decoded field
+ */
+static std::shared_ptr<BerField> codecbench_decode_octetstring(u8 **data, const std::shared_ptr<BerArena> &arena) {
+    return BerOctetString::decode(data, arena);
+}
+
+/**
+ * @brief Decode a VarBind SEQUENCE
+ * @param data  Input buffer
+ * @param arena Arena used for the fields, or nullptr to use the heap
+ * @return The decoded VarBind
+ */
+static std::shared_ptr<BerField> codecbench_decode_varbind(u8 **data, const std::shared_ptr<BerArena> &arena) {
+    BerSequence::decode(data);
+    std::shared_ptr<BerSequence> varBind = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
+    varBind->addChild(BerOid::decode(data, arena));
+    varBind->addChild(BerField::decode(data, arena));
+    return varBind;
+}
+
+/**
+ * @brief Decode any field into a BerField tree, structured fields becoming BerSequences
+ * @param data  Input buffer
+ * @param arena Arena used for the fields, or nullptr to use the heap
+ * @return The decoded tree
+ */
+static std::shared_ptr<BerField> codecbench_decode_tree(u8 **data, const std::shared_ptr<BerArena> &arena) {
+
+    u8 tag = (*data)[0];
+    if(!(tag &BER_TAG_STRUCTURED)) {
+        return BerField::decode(data, arena);
+    }
+
+    u32 length = BerSequence::decode(data, tag &~0x1F, tag &0x1F);
+    u8 *end = *data + length;
+    std::shared_ptr<BerSequence> sequence = makeBerField<BerSequence>(arena, tag &~0x1F, tag &0x1F, arena);
+    while(*data < end) {
+        sequence->addChild(codecbench_decode_tree(data, arena));
+    }
+    return sequence;
+}
+
+/**
+ * @brief Gather the fields of each kind found in a message
+ * @param reader    Reader placed at the fields to walk
+ * @param kinds     Fields found, for each kind (output)
+ */
+static void codecbench_collect(BerReader &reader, CodecBenchFieldArgs *kinds) {
+
+    while(reader.hasNext()) {
+        BerView field = reader.next();
+        switch(field.getTag()) {
+            case (BER_TAG_INTEGER | BER_TAGCLASS_INTEGER):
+            case (SNMPV1_TAG_COUNTER | SNMPV1_TAGCLASS_COUNTER):
+            case (SNMPV1_TAG_GAUGE | SNMPV1_TAGCLASS_GAUGE):
+            case (SNMPV1_TAG_TIMETICKS | SNMPV1_TAGCLASS_TIMETICKS):
+            case (SNMPV2_TAG_COUNTER64 | SNMPV2_TAGCLASS_COUNTER64):
+                kinds[CODECBENCH_INTEGER].views.push_back(field);
+                break;
+            case (BER_TAG_OID | BER_TAGCLASS_OID):
+                kinds[CODECBENCH_OID].views.push_back(field);
+                break;
+            case (BER_TAG_OCTETSTRING | BER_TAGCLASS_OCTETSTRING):
+            case (SNMPV1_TAG_NETWORKADDRESS | SNMPV1_TAGCLASS_NETWORKADDRESS):
+            case (SNMPV1_TAG_OPAQUE | SNMPV1_TAGCLASS_OPAQUE):
+                kinds[CODECBENCH_OCTETSTRING].views.push_back(field);
+                break;
+            default:
+                if(field.getTag() &BER_TAG_STRUCTURED) {
+                    if(field.getTag() == (BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE) &&
+                       field.getLength() > 0 && field.getValue()[0] == (BER_TAGCLASS_OID | BER_TAG_OID)) {
+                        kinds[CODECBENCH_VARBIND].views.push_back(field);
+                    }
+                    BerReader children(field);
+                    codecbench_collect(children, kinds);
+                }
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Decode every field of a kind
+ * @param args Benchmark arguments
+ */
+static void codecbench_fields_decode(void *args) {
+    CodecBenchFieldArgs *bench = (CodecBenchFieldArgs*)args;
+    for(u32 i = 0; i < bench->views.size(); i++) {
+        u8 *ptr = (u8*)bench->views[i].getData();
+        bench->decode(&ptr, bench->arena);
+    }
+    bench->arena->reset();
+}
+
+/**
+ * @brief Encode every field of a kind
+ * @param args Benchmark arguments
+ */
+static void codecbench_fields_encode(void *args) {
+    CodecBenchFieldArgs *bench = (CodecBenchFieldArgs*)args;
+    BerWriter writer(bench->buffer, BERPDU_MAX_SIZE);
+    for(u32 i = 0; i < bench->fields.size(); i++) {
+        bench->fields[i]->encode(writer);
+    }
+}
+
+/**
+ * @brief Decode a SNMPv1 or SNMPv2c message, as received messages are decoded
+ * @param args Benchmark arguments
+ */
+static void codecbench_message_decode(void *args) {
+    CodecBenchMessageArgs *bench = (CodecBenchMessageArgs*)args;
+    const std::vector<u8> &data = bench->message->data;
+    if(bench->version == SNMPV1_VERSION && bench->pduType == SNMPV1_TRAP) {
+        bench->pdu->parseTrap(data.data(), data.size());
+    } else {
+        bench->pdu->parseResponse(data.data(), data.size(), false, SNMP_PDU_ANY);
+    }
+}
+
+/**
+ * @brief Build and encode a SNMPv1 or SNMPv2c message, as requests are sent
+ * @param args Benchmark arguments
+ */
+static void codecbench_message_encode(void *args) {
+    CodecBenchMessageArgs *bench = (CodecBenchMessageArgs*)args;
+    u32 size;
+    Snmpv1Pdu::setGlobalRequestID(bench->reqID - 1);
+    for(u32 i = 0; i < bench->oids.size(); i++) {
+        bench->pdu->addVarBind(bench->oids[i], bench->values[i]);
+    }
+    if(bench->pduType == SNMPV2_GETBULKREQUEST) {
+        std::static_pointer_cast<Snmpv2Pdu>(bench->pdu)->encodeBulkRequest(bench->nonRepeaters, bench->maxRepetitions, &size);
+    } else {
+        bench->pdu->encodeRequest(bench->pduType, &size);
+    }
+    bench->pdu->clear();
+}
+
+/**
+ * @brief Authenticate, decrypt and decode a SNMPv3 message, as received messages are decoded
+ * @param args Benchmark arguments
+ */
+static void codecbench_message_decode_v3(void *args) {
+    CodecBenchMessageArgs *bench = (CodecBenchMessageArgs*)args;
+    memcpy(bench->work.data(), bench->message->data.data(), bench->work.size());
+    bench->v3pdu->parseResponse(bench->work.data(), bench->work.size(), false, SNMP_PDU_ANY);
+}
+
+/**
+ * @brief Build, encrypt, authenticate and encode a SNMPv3 message, as requests are sent
+ * @param args Benchmark arguments
+ */
+static void codecbench_message_encode_v3(void *args) {
+    CodecBenchMessageArgs *bench = (CodecBenchMessageArgs*)args;
+    u32 size;
+    for(u32 i = 0; i < bench->oids.size(); i++) {
+        bench->v3pdu->addVarBind(bench->oids[i], bench->values[i]);
+    }
+    bench->v3pdu->encodeRequest(bench->pduType, &size, bench->nonRepeaters, bench->maxRepetitions);
+    bench->v3pdu->clear();
+}
+
+/**
+ * @brief Build, encrypt, authenticate and send a SNMPv3 request
+ * @param args Benchmark arguments
+ */
+static void codecbench_message_send_v3(void *args) {
+    CodecBenchMessageArgs *bench = (CodecBenchMessageArgs*)args;
+    for(u32 i = 0; i < bench->oids.size(); i++) {
+        bench->v3pdu->addVarBind(bench->oids[i], bench->values[i]);
+    }
+    bench->v3pdu->sendRequest(bench->pduType, bench->sock, inet_addr(CODECBENCH_SEND_IP), CODECBENCH_SEND_PORT, bench->nonRepeaters, bench->maxRepetitions);
+}
+
+/**
+ * @brief Decode a SNMPv3 message without cached keys, as every message was decoded before the key cache
+ * @param args Benchmark arguments
+ */
+static void codecbench_message_decode_v3_cold(void *args) {
+    Snmpv3UserStore::getInstance().clearKeyCache();
+    codecbench_message_decode_v3(args);
+}
+
+/**
+ * @brief Encode a SNMPv3 message without cached keys, as every message was encoded before the key cache
+ * @param args Benchmark arguments
+ */
+static void codecbench_message_encode_v3_cold(void *args) {
+    Snmpv3UserStore::getInstance().clearKeyCache();
+    codecbench_message_encode_v3(args);
+}
+
+/**
+ * @brief Decode a whole message into a BerField tree
+ * @param args Benchmark arguments
+ */
+static void codecbench_tree_decode(void *args) {
+    CodecBenchMessageArgs *bench = (CodecBenchMessageArgs*)args;
+    u8 *ptr = (u8*)bench->message->data.data();
+    codecbench_decode_tree(&ptr, bench->arena);
+    bench->arena->reset();
+}
+
+/**
+ * @brief Encode a whole message from its BerField tree
+ * @param args Benchmark arguments
+ */
+static void codecbench_tree_encode(void *args) {
+    CodecBenchMessageArgs *bench = (CodecBenchMessageArgs*)args;
+    BerWriter writer(bench->buffer, BERPDU_MAX_SIZE);
+    bench->tree->encode(writer);
+}
+
+/**
+ * @brief Remove the corpus users from the user store, bringing back the ones they replaced
+ * @param replaced Users which had the same name as a corpus user
+ */
+static void codecbench_restore_users(const std::unordered_map<std::string, Snmpv3UserStoreEntry> &replaced) {
+    Snmpv3UserStore &store = Snmpv3UserStore::getInstance();
+    for(u32 i = 0; i < sizeof(corpusUsers) / sizeof(CodecBenchUser); i++) {
+        store.removeUser(corpusUsers[i].name);
+    }
+    for(const std::pair<const std::string, Snmpv3UserStoreEntry> &user : replaced) {
+        store.addUser(user.first, user.second);
+    }
+}
+
+/**
+ * @brief Load the corpus messages
+ * @param path      Corpus directory, ending with a slash
+ * @param corpus    Loaded messages (output)
+ */
+void CodecBench::loadCorpus(const std::string &path, std::vector<CodecBenchMessage> &corpus) {
+
+    for(u32 i = 0; i < sizeof(corpusFiles) / sizeof(CodecBenchFile); i++) {
+
+        std::string fileName = path + corpusFiles[i].name + CODECBENCH_CORPUS_EXT;
+        FILE *f = fopen(fileName.c_str(), "rb");
+        if(f == NULL) {
+            throw std::runtime_error("Couldn't open " + fileName);
+        }
+
+        CodecBenchMessage message;
+        message.name = corpusFiles[i].name;
+        message.iterations = corpusFiles[i].iterations;
+        fseek(f, 0, SEEK_END);
+        message.data.resize(ftell(f));
+        fseek(f, 0, SEEK_SET);
+        size_t readBytes = fread(message.data.data(), 1, message.data.size(), f);
+        fclose(f);
+        if(message.data.empty() || readBytes != message.data.size()) {
+            throw std::runtime_error("Couldn't read " + fileName);
+        }
+
+        corpus.push_back(message);
+    }
+}
+
+/**
+ * @brief Benchmark each BER type, over all the fields of that type found in the corpus
+ * @param corpus        Corpus messages
+ * @param resultsPath   Results file path
+ */
+void CodecBench::runFields(const std::vector<CodecBenchMessage> &corpus, const std::string &resultsPath) {
+
+    std::unique_ptr<u8[]> buffer(new u8[BERPDU_MAX_SIZE]);
+    std::shared_ptr<BerArena> arena = std::make_shared<BerArena>();
+    CodecBenchFieldArgs kinds[CODECBENCH_NKINDS];
+    kinds[CODECBENCH_INTEGER].decode = codecbench_decode_integer;
+    kinds[CODECBENCH_OID].decode = codecbench_decode_oid;
+    kinds[CODECBENCH_OCTETSTRING].decode = codecbench_decode_octetstring;
+    kinds[CODECBENCH_VARBIND].decode = codecbench_decode_varbind;
+
+    // Gather the fields of the whole corpus
+    for(u32 i = 0; i < corpus.size(); i++) {
+        BerReader reader(corpus[i].data.data(), corpus[i].data.size());
+        codecbench_collect(reader, kinds);
+    }
+
+    for(u32 i = 0; i < CODECBENCH_NKINDS; i++) {
+
+        CodecBenchFieldArgs &args = kinds[i];
+        args.arena = arena;
+        args.buffer = buffer.get();
+        if(args.views.empty()) continue;
+
+        // Decode the fields once, on the heap, so they can be encoded
+        u32 bytes = 0;
+        for(u32 j = 0; j < args.views.size(); j++) {
+            u8 *ptr = (u8*)args.views[j].getData();
+            args.fields.push_back(args.decode(&ptr, nullptr));
+            bytes += args.views[j].getTotalSize();
+        }
+
+        std::string name = kindNames[i];
+        Bench::logJson(Bench::run(name + " decode", CODECBENCH_FIELD_ITERATIONS, codecbench_fields_decode, &args), args.views.size(), bytes, resultsPath);
+        Bench::logJson(Bench::run(name + " encode", CODECBENCH_FIELD_ITERATIONS, codecbench_fields_encode, &args), args.fields.size(), bytes, resultsPath);
+    }
+}
+
+/**
+ * @brief Benchmark a corpus message, using the SNMP PDU classes and a plain BerField tree
+ * @param message       Corpus message
+ * @param resultsPath   Results file path
+ * @note SNMPv1 and SNMPv2c messages are rebuilt byte for byte before being measured
+ */
+void CodecBench::runMessage(const CodecBenchMessage &message, const std::string &resultsPath) {
+
+    std::unique_ptr<u8[]> buffer(new u8[BERPDU_MAX_SIZE]);
+    CodecBenchMessageArgs args;
+    args.message = &message;
+    args.arena = std::make_shared<BerArena>();
+    args.buffer = buffer.get();
+    args.nonRepeaters = 0;
+    args.maxRepetitions = 0;
+    args.reqID = 0;
+
+    // Read the header fields needed to rebuild the message
+    BerReader reader(message.data.data(), message.data.size());
+    BerReader fields(reader.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE));
+    args.version = fields.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+
+    bool encodable = true;
+    if(args.version == SNMPV3_VERSION) {
+
+        // Engine ID and user name are in the security parameters
+        fields.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE);
+        BerReader securityParams(fields.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING));
+        BerReader paramsSeq(securityParams.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE));
+        std::string engineID = paramsSeq.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING).getString();
+        paramsSeq.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER);
+        paramsSeq.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER);
+        std::string userName = paramsSeq.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING).getString();
+
+        args.v3pdu = std::make_shared<Snmpv3Pdu>(engineID, "", userName);
+        args.work = message.data;
+        args.pduType = args.v3pdu->parseResponse(args.work.data(), args.work.size(), false, SNMP_PDU_ANY);
+        for(u32 i = 0; i < args.v3pdu->getNVarBinds(); i++) {
+            u8 *ptr = (u8*)args.v3pdu->getVarBind(i).oid.getData();
+            args.oids.push_back(BerOid::decode(&ptr));
+            args.values.push_back(args.v3pdu->getVarBind(i).value.toBerField());
+        }
+        args.v3pdu->clear();
+
+        Bench::logJson(Bench::run(message.name + " decode", message.iterations, codecbench_message_decode_v3, &args), 1, message.data.size(), resultsPath);
+        Bench::logJson(Bench::run(message.name + " encode", message.iterations, codecbench_message_encode_v3, &args), 1, message.data.size(), resultsPath);
+        Bench::logJson(Bench::run(message.name + " decode cold keys", CODECBENCH_COLD_KEY_ITERATIONS, codecbench_message_decode_v3_cold, &args), 1, message.data.size(), resultsPath);
+        Bench::logJson(Bench::run(message.name + " encode cold keys", CODECBENCH_COLD_KEY_ITERATIONS, codecbench_message_encode_v3_cold, &args), 1, message.data.size(), resultsPath);
+
+        // Requests are also sent, to get the messages per second the manager can put on the network
+        if(args.pduType != SNMPV2_GETRESPONSE) {
+            args.sock = std::make_shared<UdpSocket>(0);
+            BenchResult result = Bench::run(message.name + " send", message.iterations, codecbench_message_send_v3, &args);
+            Bench::logJson(result, 1, message.data.size(), resultsPath);
+            Bench::logRate(result, 1, "sends");
+        }
+    } else {
+
+        std::string community = fields.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING).getString();
+        BerView pduView = fields.next();
+        args.pduType = pduView.getTag() &0x1F;
+        if(args.version == SNMPV1_VERSION) {
+            args.pdu = std::make_shared<Snmpv1Pdu>(community);
+        } else {
+            args.pdu = std::make_shared<Snmpv2Pdu>(community);
+        }
+
+        // SNMPv1 traps can be received, but this manager never sends them
+        if(args.version == SNMPV1_VERSION && args.pduType == SNMPV1_TRAP) {
+            encodable = false;
+        } else {
+            BerReader pduFields(pduView);
+            args.reqID = pduFields.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+            args.nonRepeaters = pduFields.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+            args.maxRepetitions = pduFields.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+        }
+
+        codecbench_message_decode(&args);
+        for(u32 i = 0; i < args.pdu->getNVarBinds(); i++) {
+            u8 *ptr = (u8*)args.pdu->getVarBind(i).oid.getData();
+            args.oids.push_back(BerOid::decode(&ptr));
+            args.values.push_back(args.pdu->getVarBind(i).value.toBerField());
+        }
+        args.pdu->clear();
+
+        // The rebuilt message must be the same as the corpus one, or the encoder is not measuring the real work
+        if(encodable) {
+            u32 size;
+            Snmpv1Pdu::setGlobalRequestID(args.reqID - 1);
+            for(u32 i = 0; i < args.oids.size(); i++) {
+                args.pdu->addVarBind(args.oids[i], args.values[i]);
+            }
+            u8 *data = (args.pduType == SNMPV2_GETBULKREQUEST) ?
+                std::static_pointer_cast<Snmpv2Pdu>(args.pdu)->encodeBulkRequest(args.nonRepeaters, args.maxRepetitions, &size) :
+                args.pdu->encodeRequest(args.pduType, &size);
+            bool equal = size == message.data.size() && memcmp(data, message.data.data(), size) == 0;
+            args.pdu->clear();
+            if(!equal) {
+                throw std::runtime_error("Encoded " + message.name + " does not match the corpus");
+            }
+        }
+
+        Bench::logJson(Bench::run(message.name + " decode", message.iterations, codecbench_message_decode, &args), 1, message.data.size(), resultsPath);
+        if(encodable) {
+            Bench::logJson(Bench::run(message.name + " encode", message.iterations, codecbench_message_encode, &args), 1, message.data.size(), resultsPath);
+        }
+    }
+
+    // Whole message as a plain BerField tree, on the heap so it can be encoded
+    u8 *ptr = (u8*)message.data.data();
+    args.tree = codecbench_decode_tree(&ptr, nullptr);
+    Bench::logJson(Bench::run(message.name + " tree decode", CODECBENCH_TREE_ITERATIONS, codecbench_tree_decode, &args), 1, message.data.size(), resultsPath);
+    Bench::logJson(Bench::run(message.name + " tree encode", CODECBENCH_TREE_ITERATIONS, codecbench_tree_encode, &args), 1, message.data.size(), resultsPath);
+}
+
+/**
+ * @brief Run the whole suite
+ * @param corpusPath    Corpus directory, ending with a slash (optional)
+ * @param resultsPath   Results file path, truncated first (optional)
+ * @note Define BENCH_ALLOCS to get the allocations per message
+ */
+void CodecBench::run(const std::string &corpusPath, const std::string &resultsPath) {
+
+    FILE *f = fopen(resultsPath.c_str(), "wb");
+    if(f == NULL) {
+        throw std::runtime_error("Couldn't open " + resultsPath);
+    }
+    fclose(f);
+
+    // Register the corpus users, keeping the ones they replace
+    Snmpv3UserStore &store = Snmpv3UserStore::getInstance();
+    std::unordered_map<std::string, Snmpv3UserStoreEntry> users = store.getUserTable();
+    std::unordered_map<std::string, Snmpv3UserStoreEntry> replaced;
+    for(u32 i = 0; i < sizeof(corpusUsers) / sizeof(CodecBenchUser); i++) {
+        if(users.find(corpusUsers[i].name) != users.end()) {
+            replaced[corpusUsers[i].name] = users[corpusUsers[i].name];
+        }
+        Snmpv3UserStoreEntry entry;
+        entry.authPass = CODECBENCH_AUTH_PASSWORD;
+        entry.privPass = CODECBENCH_PRIV_PASSWORD;
+        entry.authProto = corpusUsers[i].authProto;
+        entry.privProto = corpusUsers[i].privProto;
+        store.addUser(corpusUsers[i].name, entry);
+    }
+
+    try {
+        std::vector<CodecBenchMessage> corpus;
+        CodecBench::loadCorpus(corpusPath, corpus);
+        CodecBench::runFields(corpus, resultsPath);
+        for(u32 i = 0; i < corpus.size(); i++) {
+            CodecBench::runMessage(corpus[i], resultsPath);
+        }
+    } catch (const std::runtime_error &e) {
+        codecbench_restore_users(replaced);
+        throw;
+    } catch (const std::bad_alloc &e) {
+        codecbench_restore_users(replaced);
+        throw;
+    }
+
+    codecbench_restore_users(replaced);
+}
+
+// Captured SNMPv2c GetResponse (sysDescr, sysObjectID, sysUpTime, sysName)
+static const u8 benchGetResponse[] = {
+    0x30, 0x7E, 0x02, 0x01, 0x01, 0x04, 0x06, 0x70, 0x75, 0x62, 0x6C, 0x69,
+    0x63, 0xA2, 0x71, 0x02, 0x01, 0x01, 0x02, 0x01, 0x00, 0x02, 0x01, 0x00,
+    0x30, 0x66, 0x30, 0x26, 0x06, 0x08, 0x2B, 0x06, 0x01, 0x02, 0x01, 0x01,
+    0x01, 0x00, 0x04, 0x1A, 0x4C, 0x69, 0x6E, 0x75, 0x78, 0x20, 0x6E, 0x65,
+    0x74, 0x6D, 0x61, 0x6E, 0x20, 0x34, 0x2E, 0x31, 0x39, 0x2E, 0x30, 0x20,
+    0x61, 0x72, 0x6D, 0x76, 0x36, 0x6C, 0x30, 0x16, 0x06, 0x08, 0x2B, 0x06,
+    0x01, 0x02, 0x01, 0x01, 0x02, 0x00, 0x06, 0x0A, 0x2B, 0x06, 0x01, 0x04,
+    0x01, 0xBF, 0x08, 0x03, 0x02, 0x0A, 0x30, 0x10, 0x06, 0x08, 0x2B, 0x06,
+    0x01, 0x02, 0x01, 0x01, 0x03, 0x00, 0x43, 0x04, 0x01, 0x2C, 0x4F, 0x1A,
+    0x30, 0x12, 0x06, 0x08, 0x2B, 0x06, 0x01, 0x02, 0x01, 0x01, 0x05, 0x00,
+    0x04, 0x06, 0x6E, 0x65, 0x74, 0x6D, 0x61, 0x6E,
+};
+
+/**
+ * @brief Decode the captured response building a BerField tree, as received PDUs used to be decoded
+ * @param args Unused
+ */
+static void codecbench_berview_tree(void *args) {
+
+    u8 *ptr = (u8*)benchGetResponse;
+    BerSequence::decode(&ptr);
+    BerInteger::decode(&ptr, false);
+    BerOctetString::decode(&ptr);
+    BerSequence::decode(&ptr, BER_TAG_CONTEXT | BER_TAG_STRUCTURED, SNMPV2_GETRESPONSE);
+    BerInteger::decode(&ptr, false);
+    BerInteger::decode(&ptr, false);
+    BerInteger::decode(&ptr, false);
+    u32 vbListSize = BerSequence::decode(&ptr);
+    u8 *end = ptr + vbListSize;
+    std::shared_ptr<BerSequence> vbList = std::make_shared<BerSequence>();
+    while(ptr < end) {
+        BerSequence::decode(&ptr);
+        std::shared_ptr<BerSequence> varBind = std::make_shared<BerSequence>();
+        varBind->addChild(BerOid::decode(&ptr));
+        varBind->addChild(BerField::decode(&ptr));
+        vbList->addChild(varBind);
+    }
+}
+
+/**
+ * @brief Decode the captured response with BerViews
+ * @param args SNMP PDU used for decoding
+ */
+static void codecbench_berview_view(void *args) {
+    Snmpv2Pdu *pdu = (Snmpv2Pdu*)args;
+    pdu->parseResponse(benchGetResponse, sizeof(benchGetResponse), false);
+}
+
+/**
+ * @brief Compare BerField tree decoding against BerView decoding
+ */
+void CodecBench::runBerView() {
+
+    std::shared_ptr<Snmpv2Pdu> pdu = std::make_shared<Snmpv2Pdu>("public");
+    Bench::log(Bench::run("GetResponse BerField tree", 10000, codecbench_berview_tree, NULL));
+    Bench::log(Bench::run("GetResponse BerView", 10000, codecbench_berview_view, pdu.get()));
+}
+
+/**
+ * @struct BerWriterBenchArgs
+ */
+typedef struct {
+    std::shared_ptr<BerSequence> message;
+    u8 *buffer;
+} BerWriterBenchArgs;
+
+/**
+ * @brief Build a SNMPv2c request as it is sent to an agent
+ * @param type                PDU type
+ * @param oids                OIDs to request
+ * @param n                    Number of OIDs
+ * @param nonRepeaters        Non-repeaters (GetBulkRequest) or error status
+ * @param maxRepetitions    Max-repetitions (GetBulkRequest) or error index
+ * @param arena                Arena used for the message, or nullptr to use the heap
+ * @return The whole message
+ */
+static std::shared_ptr<BerSequence> codecbench_berwriter_request(u32 type, const char **oids, u32 n, u32 nonRepeaters, u32 maxRepetitions, const std::shared_ptr<BerArena> &arena = nullptr) {
+
+    u32 version = SNMPV2_VERSION;
+    u32 reqID = 1234;
+    std::shared_ptr<BerSequence> message = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
+    std::shared_ptr<BerSequence> pdu = makeBerField<BerSequence>(arena, SNMPV1_TAGCLASS, type, arena);
+    std::shared_ptr<BerSequence> vbList = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
+    for(u32 i = 0; i < n; i++) {
+        std::shared_ptr<BerSequence> varBind = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
+        varBind->addChild(makeBerField<BerOid>(arena, oids[i]));
+        varBind->addChild(makeBerField<BerNull>(arena));
+        vbList->addChild(varBind);
+    }
+    pdu->addChild(makeBerField<BerInteger>(arena, &reqID, sizeof(u32), false));
+    pdu->addChild(makeBerField<BerInteger>(arena, &nonRepeaters, sizeof(u32), false));
+    pdu->addChild(makeBerField<BerInteger>(arena, &maxRepetitions, sizeof(u32), false));
+    pdu->addChild(vbList);
+    message->addChild(makeBerField<BerInteger>(arena, &version, sizeof(u32), false));
+    message->addChild(makeBerField<BerOctetString>(arena, "public"));
+    message->addChild(pdu);
+
+    return message;
+}
+
+/**
+ * @brief Encode a message computing sizes first, as BerPdu::serialize does
+ * @param args Benchmark arguments
+ */
+static void codecbench_berwriter_twopass(void *args) {
+    BerWriterBenchArgs *bench = (BerWriterBenchArgs*)args;
+    u8 *ptr = bench->buffer;
+    bench->message->getTotalSize();
+    bench->message->parseTag(&ptr);
+    bench->message->parseLength(&ptr);
+    bench->message->parseData(&ptr);
+}
+
+/**
+ * @brief Encode a message with the reverse encoder, as BerPdu::encode does
+ * @param args Benchmark arguments
+ */
+static void codecbench_berwriter_reverse(void *args) {
+    BerWriterBenchArgs *bench = (BerWriterBenchArgs*)args;
+    BerWriter writer(bench->buffer, BERPDU_MAX_SIZE);
+    bench->message->encode(writer);
+}
+
+/**
+ * @brief Compare two-pass encoding against single-pass reverse encoding
+ */
+void CodecBench::runBerWriter() {
+
+    const char *getOids[] = {
+        "1.3.6.1.2.1.1.1.0", "1.3.6.1.2.1.1.2.0", "1.3.6.1.2.1.1.3.0", "1.3.6.1.2.1.1.4.0",
+        "1.3.6.1.2.1.1.5.0", "1.3.6.1.2.1.1.6.0", "1.3.6.1.2.1.1.7.0",
+    };
+    const char *bulkOids[] = {
+        "1.3.6.1.2.1.1.3", "1.3.6.1.2.1.2.2.1.2", "1.3.6.1.2.1.2.2.1.10", "1.3.6.1.2.1.2.2.1.16",
+    };
+
+    std::unique_ptr<u8[]> buffer(new u8[BERPDU_MAX_SIZE]);
+    BerWriterBenchArgs args;
+    args.buffer = buffer.get();
+
+    args.message = codecbench_berwriter_request(SNMPV2_GETREQUEST, getOids, 7, 0, 0);
+    Bench::log(Bench::run("GetRequest two-pass", 10000, codecbench_berwriter_twopass, &args));
+    Bench::log(Bench::run("GetRequest reverse", 10000, codecbench_berwriter_reverse, &args));
+
+    args.message = codecbench_berwriter_request(SNMPV2_GETBULKREQUEST, bulkOids, 4, 1, 25);
+    Bench::log(Bench::run("GetBulkRequest two-pass", 10000, codecbench_berwriter_twopass, &args));
+    Bench::log(Bench::run("GetBulkRequest reverse", 10000, codecbench_berwriter_reverse, &args));
+}
+
+/**
+ * @struct BerArenaBenchArgs
+ */
+typedef struct {
+    std::shared_ptr<BerArena> arena;
+    u8 *buffer;
+} BerArenaBenchArgs;
+
+/**
+ * @brief One polling cycle: build and encode a GetRequest, decode its GetResponse and free both trees
+ * @param args Benchmark arguments
+ */
+static void codecbench_berarena_cycle(void *args) {
+
+    BerArenaBenchArgs *bench = (BerArenaBenchArgs*)args;
+    const char *oids[] = {
+        "1.3.6.1.2.1.1.1.0", "1.3.6.1.2.1.1.2.0", "1.3.6.1.2.1.1.3.0", "1.3.6.1.2.1.1.5.0",
+    };
+
+    {
+        // Request
+        BerWriter writer(bench->buffer, BERPDU_MAX_SIZE);
+        std::shared_ptr<BerSequence> request = codecbench_berwriter_request(SNMPV2_GETREQUEST, oids, 4, 0, 0, bench->arena);
+        request->encode(writer);
+
+        // Response
+        u8 *ptr = (u8*)benchGetResponse;
+        BerSequence::decode(&ptr);
+        BerInteger::decode(&ptr, false, bench->arena);
+        BerOctetString::decode(&ptr, bench->arena);
+        BerSequence::decode(&ptr, BER_TAG_CONTEXT | BER_TAG_STRUCTURED, SNMPV2_GETRESPONSE);
+        BerInteger::decode(&ptr, false, bench->arena);
+        BerInteger::decode(&ptr, false, bench->arena);
+        BerInteger::decode(&ptr, false, bench->arena);
+        u32 vbListSize = BerSequence::decode(&ptr);
+        u8 *end = ptr + vbListSize;
+        std::shared_ptr<BerSequence> vbList = makeBerField<BerSequence>(bench->arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, bench->arena);
+        while(ptr < end) {
+            BerSequence::decode(&ptr);
+            std::shared_ptr<BerSequence> varBind = makeBerField<BerSequence>(bench->arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, bench->arena);
+            varBind->addChild(BerOid::decode(&ptr, bench->arena));
+            varBind->addChild(BerField::decode(&ptr, bench->arena));
+            vbList->addChild(varBind);
+        }
+    }
+
+    // Both trees are gone, release them at once
+    if(bench->arena != nullptr) {
+        bench->arena->reset();
+    }
+}
+
+/**
+ * @brief Compare heap allocated field trees against arena allocated field trees
+ */
+void CodecBench::runBerArena() {
+
+    std::unique_ptr<u8[]> buffer(new u8[BERPDU_MAX_SIZE]);
+    BerArenaBenchArgs args;
+    args.buffer = buffer.get();
+
+    args.arena = nullptr;
+    Bench::log(Bench::run("Poll cycle heap", 10000, codecbench_berarena_cycle, &args));
+
+    args.arena = std::make_shared<BerArena>();
+    Bench::log(Bench::run("Poll cycle arena", 10000, codecbench_berarena_cycle, &args));
+
+    Bench::logText("Arena: " + std::to_string(args.arena->getPeak()) + " bytes peak, " + std::to_string(args.arena->getCapacity()) +
+        " bytes in " + std::to_string(args.arena->getNChunks()) + " chunks");
+}
+
+/**
+ * @struct CompactOidBenchArgs
+ */
+typedef struct {
+    std::shared_ptr<BerOid> subtree;
+    std::shared_ptr<BerOid> oids[8];
+    u32 matches;
+} CompactOidBenchArgs;
+
+/**
+ * @brief Check if some OIDs are in a subtree comparing their printed forms
+ * @param args Benchmark arguments
+ */
+static void codecbench_compactoid_string(void *args) {
+    CompactOidBenchArgs *bench = (CompactOidBenchArgs*)args;
+    std::string subtree = bench->subtree->print() + ".";
+    for(u32 i = 0; i < 8; i++) {
+        if(bench->oids[i]->print().compare(0, subtree.length(), subtree) == 0) bench->matches ++;
+    }
+}
+
+/**
+ * @brief Check if some OIDs are in a subtree with CompactOid::isPrefixOf
+ * @param args Benchmark arguments
+ */
+static void codecbench_compactoid_prefix(void *args) {
+    CompactOidBenchArgs *bench = (CompactOidBenchArgs*)args;
+    for(u32 i = 0; i < 8; i++) {
+        if(bench->subtree->getOid().isPrefixOf(bench->oids[i]->getOid())) bench->matches ++;
+    }
+}
+
+/**
+ * @brief Change the last arc of some OIDs
+ * @param args Benchmark arguments
+ */
+static void codecbench_compactoid_edit(void *args) {
+    CompactOidBenchArgs *bench = (CompactOidBenchArgs*)args;
+    for(u32 i = 0; i < 8; i++) {
+        bench->oids[i]->editLastElement(i + 1);
+    }
+}
+
+/**
+ * @brief Compare subtree checks on printed OIDs against CompactOid prefix checks
+ */
+void CodecBench::runCompactOid() {
+
+    const char *oids[] = {
+        "1.3.6.1.2.1.2.2.1.2.1", "1.3.6.1.2.1.2.2.1.2.2", "1.3.6.1.2.1.2.2.1.10.1", "1.3.6.1.2.1.2.2.1.10.2",
+        "1.3.6.1.2.1.2.2.1.16.1", "1.3.6.1.2.1.2.2.1.16.2", "1.3.6.1.2.1.3.1.1.2.1", "1.3.6.1.2.1.4.1.0"
+    };
+    CompactOidBenchArgs args;
+    args.subtree = std::make_shared<BerOid>("1.3.6.1.2.1.2.2");
+    for(u32 i = 0; i < 8; i++) {
+        args.oids[i] = std::make_shared<BerOid>(oids[i]);
+    }
+
+    args.matches = 0;
+    Bench::log(Bench::run("Subtree check print()", 10000, codecbench_compactoid_string, &args));
+    args.matches = 0;
+    Bench::log(Bench::run("Subtree check isPrefixOf", 10000, codecbench_compactoid_prefix, &args));
+    Bench::log(Bench::run("BerOid editLastElement", 10000, codecbench_compactoid_edit, &args));
+}
+
+/**
+ * @struct OidCodecBenchArgs
+ */
+typedef struct {
+    u32 arcs[256];
+    u32 nArcs;
+    u8 encoded[256 * OIDCODEC_MAX_ARC_SIZE];
+    u32 length;
+    u32 decoded[256];
+} OidCodecBenchArgs;
+
+/**
+ * @brief Encode the arcs one byte at a time
+ * @param args Benchmark arguments
+ */
+static void codecbench_oidcodec_encode_bytewise(void *args) {
+
+    // Previous BerOid::parseData loop
+    OidCodecBenchArgs *bench = (OidCodecBenchArgs*)args;
+    u8 *data = bench->encoded;
+    for(u32 i = 0; i < bench->nArcs; i++) {
+        u8 len = 1;
+        for(u8 j = 1; j <= 4; j++) {
+            if((bench->arcs[i] >> (7 * j)) &0x7F) len ++;
+            else j = 5;
+        }
+        for(u8 j = 0; j < len; j++) {
+            data[len - j - 1] = ((j > 0) << 7) | ((bench->arcs[i] >> (7 * j)) &0x7F);
+        }
+        data += len;
+    }
+}
+
+/**
+ * @brief Encode the arcs with OidCodec
+ * @param args Benchmark arguments
+ */
+static void codecbench_oidcodec_encode(void *args) {
+    OidCodecBenchArgs *bench = (OidCodecBenchArgs*)args;
+    OidCodec::encodeArcs(bench->arcs, bench->nArcs, bench->encoded);
+}
+
+/**
+ * @brief Decode the arcs one byte at a time
+ * @param args Benchmark arguments
+ */
+static void codecbench_oidcodec_decode_bytewise(void *args) {
+
+    // Previous BerOid::decode loop
+    OidCodecBenchArgs *bench = (OidCodecBenchArgs*)args;
+    u32 curOid = 0;
+    u32 n = 0;
+    for(u32 i = 0; i < bench->length; i++) {
+        curOid <<= 7;
+        curOid |= bench->encoded[i] &0x7F;
+        if(!(bench->encoded[i] &(1 << 7))) {
+            bench->decoded[n++] = curOid;
+            curOid = 0;
+        }
+    }
+}
+
+/**
+ * @brief Decode the arcs with OidCodec
+ * @param args Benchmark arguments
+ */
+static void codecbench_oidcodec_decode(void *args) {
+    OidCodecBenchArgs *bench = (OidCodecBenchArgs*)args;
+    OidCodec::decodeArcs(bench->encoded, bench->length, bench->decoded, 256);
+}
+
+/**
+ * @brief Compare bytewise OID arc encoding and decoding against OidCodec
+ */
+void CodecBench::runOidCodec() {
+
+    // ifTable columns 1..22 of 4 interfaces and dot1dTpFdbPort entries (MAC address indexes)
+    std::unique_ptr<OidCodecBenchArgs> args(new OidCodecBenchArgs);
+    const u32 ifEntry[] = {43, 6, 1, 2, 1, 2, 2, 1};
+    const u32 fdbPort[] = {43, 6, 1, 2, 1, 17, 4, 3, 1, 2};
+    const u32 macs[3][6] = {{0, 27, 33, 170, 187, 204}, {0, 80, 86, 192, 0, 8}, {240, 159, 194, 1, 2, 3}};
+    args->nArcs = 0;
+    for(u32 col = 1; col <= 22 && args->nArcs + 10 <= 256; col += 5) {
+        for(u32 idx = 1; idx <= 4; idx++) {
+            memcpy(&args->arcs[args->nArcs], ifEntry, sizeof(ifEntry));
+            args->nArcs += 8;
+            args->arcs[args->nArcs++] = col;
+            args->arcs[args->nArcs++] = idx * 1000;
+        }
+    }
+    for(u32 i = 0; i < 3; i++) {
+        memcpy(&args->arcs[args->nArcs], fdbPort, sizeof(fdbPort));
+        args->nArcs += 10;
+        memcpy(&args->arcs[args->nArcs], macs[i], sizeof(macs[i]));
+        args->nArcs += 6;
+    }
+    args->length = OidCodec::encodeArcs(args->arcs, args->nArcs, args->encoded);
+
+    BenchResult result;
+    result = Bench::run("Arc encode bytewise", 10000, codecbench_oidcodec_encode_bytewise, args.get());
+    Bench::logRate(result, args->nArcs, "arcs");
+    result = Bench::run("Arc encode OidCodec", 10000, codecbench_oidcodec_encode, args.get());
+    Bench::logRate(result, args->nArcs, "arcs");
+    result = Bench::run("Arc decode bytewise", 10000, codecbench_oidcodec_decode_bytewise, args.get());
+    Bench::logRate(result, args->nArcs, "arcs");
+    result = Bench::run("Arc decode OidCodec", 10000, codecbench_oidcodec_decode, args.get());
+    Bench::logRate(result, args->nArcs, "arcs");
+
+    if(memcmp(args->arcs, args->decoded, args->nArcs * sizeof(u32)) != 0) {
+        throw std::runtime_error("Decoded arcs differ");
+    }
+}
+
+/**
+ * @struct BerStreamBenchArgs
+ */
+typedef struct {
+    std::shared_ptr<Snmpv2Pdu> pdu;
+    BerStreamParser *parser;
+    u8 stream[4 * sizeof(benchGetResponse)];
+    u32 chunkSize;
+} BerStreamBenchArgs;
+
+/**
+ * @brief Feed a stream of GetResponses to the parser, decoding each message
+ * @param args Benchmark arguments
+ */
+static void codecbench_berstream_feed(void *args) {
+
+    // Four GetResponses back to back, received in segments of chunkSize bytes
+    BerStreamBenchArgs *bench = (BerStreamBenchArgs*)args;
+    for(u32 pos = 0; pos < sizeof(bench->stream); pos += bench->chunkSize) {
+        u32 size = sizeof(bench->stream) - pos;
+        if(size > bench->chunkSize) size = bench->chunkSize;
+        u32 used = 0;
+        while(used < size) {
+            used += bench->parser->push(&bench->stream[pos + used], size - used);
+            if(bench->parser->hasMessage()) {
+                const BerView &message = bench->parser->getMessage();
+                bench->pdu->parseResponse(message.getData(), message.getTotalSize(), false);
+                bench->parser->reset();
+            }
+        }
+    }
+}
+
+/**
+ * @brief Decode GetResponses received in segments of several sizes with a BerStreamParser
+ */
+void CodecBench::runBerStream() {
+
+    std::unique_ptr<BerStreamBenchArgs> args(new BerStreamBenchArgs);
+    BerStreamParser parser(SNMP_MAX_PDU_SIZE);
+    args->pdu = std::make_shared<Snmpv2Pdu>("public");
+    args->parser = &parser;
+    for(u32 i = 0; i < 4; i++) {
+        memcpy(&args->stream[i * sizeof(benchGetResponse)], benchGetResponse, sizeof(benchGetResponse));
+    }
+
+    args->chunkSize = sizeof(args->stream);
+    Bench::log(Bench::run("GetResponse stream, one chunk", 10000, codecbench_berstream_feed, args.get()));
+    args->chunkSize = 100;
+    Bench::log(Bench::run("GetResponse stream, 100 byte chunks", 10000, codecbench_berstream_feed, args.get()));
+    args->chunkSize = 7;
+    Bench::log(Bench::run("GetResponse stream, 7 byte chunks", 10000, codecbench_berstream_feed, args.get()));
+}
+
+/**
+ * @struct DecodeStatusBenchArgs
+ */
+typedef struct {
+    std::shared_ptr<Snmpv2Pdu> pdu;
+    u8 packets[8][sizeof(benchGetResponse)];
+    u32 sizes[8];
+    u32 dropped;
+} DecodeStatusBenchArgs;
+
+/**
+ * @brief Decode the packets, dropping the invalid ones when an exception is thrown
+ * @param args Benchmark arguments
+ */
+static void codecbench_decodestatus_throw(void *args) {
+    DecodeStatusBenchArgs *bench = (DecodeStatusBenchArgs*)args;
+    for(u32 i = 0; i < 8; i++) {
+        try {
+            bench->pdu->parseResponse(bench->packets[i], bench->sizes[i], false);
+        } catch (const std::runtime_error &e) {
+            bench->dropped ++;
+        }
+    }
+}
+
+/**
+ * @brief Decode the packets, dropping the invalid ones by their status code
+ * @param args Benchmark arguments
+ */
+static void codecbench_decodestatus_status(void *args) {
+    DecodeStatusBenchArgs *bench = (DecodeStatusBenchArgs*)args;
+    u8 pduType;
+    for(u32 i = 0; i < 8; i++) {
+        if(bench->pdu->tryParseResponse(bench->packets[i], bench->sizes[i], false, SNMPV2_GETRESPONSE, &pduType).status != SNMP_OK) {
+            bench->dropped ++;
+        }
+    }
+}
+
+/**
+ * @brief Compare dropping invalid responses with exceptions against status codes
+ */
+void CodecBench::runDecodeStatus() {
+
+    // Half of the packets are valid, the other half are foreign or malformed
+    std::unique_ptr<DecodeStatusBenchArgs> args(new DecodeStatusBenchArgs);
+    args->pdu = std::make_shared<Snmpv2Pdu>("public");
+    for(u32 i = 0; i < 8; i++) {
+        memcpy(args->packets[i], benchGetResponse, sizeof(benchGetResponse));
+        args->sizes[i] = sizeof(benchGetResponse);
+    }
+    args->packets[1][7] = 'P';                      // Wrong community
+    args->sizes[3] = sizeof(benchGetResponse) / 2;  // Truncated
+    args->packets[5][4] = 0x03;                     // Wrong version
+    args->packets[7][13] = 0xA7;                    // Not a response
+
+    args->dropped = 0;
+    Bench::log(Bench::run("50% invalid, exceptions", 10000, codecbench_decodestatus_throw, args.get()));
+    Bench::logText("Dropped: " + std::to_string(args->dropped));
+
+    args->dropped = 0;
+    Bench::log(Bench::run("50% invalid, status codes", 10000, codecbench_decodestatus_status, args.get()));
+    Bench::logText("Dropped: " + std::to_string(args->dropped));
+}
+
+}
@@ -0,0 +1,339 @@
+/**
+ * @file NotifyBench.cpp
+ * @brief Trap and syslog storage benchmarks
+ */
+
+// Includes C/C++
+#include <memory>
+#include <stdexcept>
+#include <arpa/inet.h>
+
+// Own includes
+#include "bench/NotifyBench.h"
+#include "asn1/BerInteger.h"
+#include "asn1/BerOid.h"
+#include "notify/EventLog.h"
+#include "notify/NotificationReceiver.h"
+#include "notify/TrapDeduplicator.h"
+#include "notify/TrapRules.h"
+#include "snmp/Snmpv2Pdu.h"
+#include "socket/UdpSocket.h"
+
+namespace NetMan {
+
+/**
+ * @struct EventLogBenchArgs
+ */
+typedef struct {
+    std::shared_ptr<EventLog> log;
+    EventLogRecord record;
+    EventLogFilter filter;
+    u32 nAppended;
+    u32 nRead;
+    u32 nMatched;
+} EventLogBenchArgs;
+
+/**
+ * @brief Append a batch of traps
+ * @param args Benchmark arguments
+ */
+static void notifybench_eventlog_append(void *args) {
+
+    // A batch of traps from 16 agents, flushed as the receiver does
+    EventLogBenchArgs *bench = (EventLogBenchArgs*)args;
+    for(u32 i = 0; i < NOTIFY_BATCH_SIZE; i++) {
+        bench->record.source = htonl(0xC0A80101 + (bench->nAppended++ % 16));
+        bench->log->append(bench->record);
+    }
+    bench->log->flush();
+}
+
+/**
+ * @brief Query the traps of an agent
+ * @param args Benchmark arguments
+ */
+static void notifybench_eventlog_query(void *args) {
+
+    // Every page of the linkDown traps of one agent, as the log list reads them
+    EventLogBenchArgs *bench = (EventLogBenchArgs*)args;
+    std::vector<u32> indexes;
+    u32 begin = bench->log->getBegin(), end = bench->log->getEnd();
+    for(u32 skip = 0; bench->log->query(bench->filter, begin, end, skip, 5, indexes) != 0; skip += 5) {
+        bench->nMatched += indexes.size();
+    }
+}
+
+/**
+ * @brief Reopen the log, rebuilding its index
+ * @param args Benchmark arguments
+ */
+static void notifybench_eventlog_open(void *args) {
+    EventLogBenchArgs *bench = (EventLogBenchArgs*)args;
+    bench->log->open();
+}
+
+/**
+ * @brief Read every record of the log
+ * @param args Benchmark arguments
+ */
+static void notifybench_eventlog_read(void *args) {
+    EventLogBenchArgs *bench = (EventLogBenchArgs*)args;
+    EventLogIterator it(bench->log, bench->log->getBegin());
+    EventLogRecord record;
+    while(it.next(record)) {
+        bench->nRead ++;
+    }
+}
+
+/**
+ * @brief Measure EventLog appends, reads, queries and reopening
+ */
+void NotifyBench::runEventLog() {
+
+    std::unique_ptr<EventLogBenchArgs> args(new EventLogBenchArgs);
+    args->log = std::make_shared<EventLog>(NOTIFYBENCH_LOG_NAME, 100000);
+    args->nAppended = 0;
+    args->nRead = 0;
+    args->nMatched = 0;
+
+    // A linkDown trap, as serialized by Snmpv2Pdu
+    args->record.type = NOTIFY_TRAPV2;
+    args->record.time = osGetTime();
+    args->record.source = inet_addr("192.168.1.1");
+    args->record.name = "[00:00:00] Trap V2";
+    const char *fields[] = {"OID: 1.3.6.1.2.1.1.3.0", "Value: 123456", "OID: 1.3.6.1.6.3.1.1.4.1.0", "Value: 1.3.6.1.6.3.1.1.5.3",
+        "OID: 1.3.6.1.2.1.2.2.1.1.2", "Value: 2", "OID: 1.3.6.1.2.1.2.2.1.7.2", "Value: 1", "OID: 1.3.6.1.2.1.2.2.1.8.2", "Value: 2"};
+    for(u32 i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        args->record.fields.push_back(fields[i]);
+    }
+    CompactOid linkDown("1.3.6.1.6.3.1.1.5.3"), snmpTraps(SNMP_TRAPS_OID);
+    EventLogKey trapOid = {EVENTLOG_KEY_TRAPOID, std::string((const char*)linkDown.getData(), linkDown.getLength())};
+    EventLogKey enterprise = {EVENTLOG_KEY_ENTERPRISE, std::string((const char*)snmpTraps.getData(), snmpTraps.getLength())};
+    args->record.keys.push_back(trapOid);
+    args->record.keys.push_back(enterprise);
+    args->filter.fromTime = 0;
+    args->filter.toTime = 0;
+    args->filter.source = htonl(0xC0A80105);
+    args->filter.keys.push_back(trapOid);
+    std::vector<u8> encoded;
+    u32 recordSize = EventLog::encode(args->record, encoded);
+
+    BenchResult result = Bench::run("EventLog append", 200, notifybench_eventlog_append, args.get());
+    Bench::logRate(result, NOTIFY_BATCH_SIZE, "events");
+    Bench::logJson(result, NOTIFY_BATCH_SIZE, NOTIFY_BATCH_SIZE * recordSize);
+
+    u32 nRecords = args->log->getEnd() - args->log->getBegin();
+    result = Bench::run("EventLog read", 1, notifybench_eventlog_read, args.get());
+    Bench::logRate(result, nRecords, "events");
+
+    result = Bench::run("EventLog query", 1, notifybench_eventlog_query, args.get());
+    Bench::logRate(result, args->nMatched, "matches");
+
+    result = Bench::run("EventLog open", 1, notifybench_eventlog_open, args.get());
+    Bench::logRate(result, nRecords, "events");
+
+    Bench::logText("Records: " + std::to_string(args->nRead) + " read, " + std::to_string(nRecords) + " kept, " +
+        std::to_string(args->nMatched) + " matched, " + std::to_string(args->log->getNBytes()) + " bytes");
+}
+
+/**
+ * @struct TrapDedupBenchArgs
+ */
+typedef struct {
+    TrapDeduplicator dedup;
+    CompactOid linkDown;
+    u8 buffer[4][16];
+    SnmpVarBind varBinds[4][2];         /**< sysUpTime.0 and ifIndex of 4 flapping interfaces */
+    u32 nChecked;
+    u32 nAccepted;
+} TrapDedupBenchArgs;
+
+/**
+ * @brief Check a second of a trap storm
+ * @param args Benchmark arguments
+ */
+static void notifybench_trapdedup_storm(void *args) {
+
+    // linkDown traps from 16 agents, 1000 per second, swept as the receiver does
+    TrapDedupBenchArgs *bench = (TrapDedupBenchArgs*)args;
+    for(u32 i = 0; i < 1000; i++) {
+        u32 n = bench->nChecked++;
+        u64 now = 1000000 + n;
+        if(bench->dedup.check(htonl(0xC0A80101 + (n % 16)), bench->linkDown, bench->varBinds[(n / 16) % 4], 2, now) == TRAP_ACCEPT) {
+            bench->nAccepted++;
+        }
+        if(n % NOTIFY_SWEEP_MS == 0) {
+            bench->dedup.sweep(now);
+            TrapSummary summary;
+            while(bench->dedup.popSummary(summary));
+        }
+    }
+}
+
+/**
+ * @brief Measure the trap deduplicator during a trap storm
+ */
+void NotifyBench::runTrapDedup() {
+
+    std::unique_ptr<TrapDedupBenchArgs> args(new TrapDedupBenchArgs);
+    args->linkDown = CompactOid(SNMP_TRAPS_OID ".3");
+    args->nChecked = 0;
+    args->nAccepted = 0;
+
+    static const u8 sysUpTime[] = {0x06, 0x08, 0x2B, 0x06, 0x01, 0x02, 0x01, 0x01, 0x03, 0x00};
+    static const u8 ifIndex[] = {0x06, 0x0A, 0x2B, 0x06, 0x01, 0x02, 0x01, 0x02, 0x02, 0x01, 0x01, 0x02};
+    for(u32 i = 0; i < 4; i++) {
+        u8 *buffer = args->buffer[i];
+        buffer[0] = 0x43; buffer[1] = 0x02; buffer[2] = 0x30; buffer[3] = i;  // TimeTicks
+        buffer[4] = 0x02; buffer[5] = 0x01; buffer[6] = i + 1;              // INTEGER
+        BerView value;
+        BerView::parse(sysUpTime, sizeof(sysUpTime), &args->varBinds[i][0].oid);
+        BerView::parse(buffer, 4, &value);
+        VarBindValue::decode(value, &args->varBinds[i][0].value);
+        BerView::parse(ifIndex, sizeof(ifIndex), &args->varBinds[i][1].oid);
+        BerView::parse(buffer + 4, 3, &value);
+        VarBindValue::decode(value, &args->varBinds[i][1].value);
+    }
+
+    BenchResult result = Bench::run("Trap storm dedup", 1000, notifybench_trapdedup_storm, args.get());
+    Bench::logRate(result, 1000, "traps");
+
+    Bench::logText("Traps: " + std::to_string(args->nChecked) + " checked, " + std::to_string(args->nAccepted) + " accepted, " +
+        std::to_string(args->dedup.getNDuplicates()) + " duplicates, " + std::to_string(args->dedup.getNRateLimited()) + " rate limited");
+}
+
+/**
+ * @struct TrapRulesBenchArgs
+ */
+typedef struct {
+    std::shared_ptr<TrapRuleSet> rules;
+    TrapRuleMatch match;
+    CompactOid trapOid;
+    CompactOid enterprise;
+    u8 buffer[16];
+    SnmpVarBind varBind;                /**< ifIndex.2 = 2 */
+    u32 nMatched;
+} TrapRulesBenchArgs;
+
+/**
+ * @brief Match a batch of traps against the rules
+ * @param args Benchmark arguments
+ */
+static void notifybench_traprules_match(void *args) {
+
+    // linkDown traps from 256 agents
+    TrapRulesBenchArgs *bench = (TrapRulesBenchArgs*)args;
+    for(u32 i = 0; i < 1000; i++) {
+        bench->rules->match(htonl(0x0A000001 + ((i % 256) << 8)), bench->trapOid, bench->enterprise, &bench->varBind, 1, bench->match);
+        bench->nMatched += bench->match.tags.size() + bench->match.alerts.size() + (bench->match.drop ? 1 : 0) + (bench->match.route ? 1 : 0);
+    }
+}
+
+/**
+ * @brief Measure trap rule matching with 10, 100 and 1000 rules
+ */
+void NotifyBench::runTrapRules() {
+
+    std::unique_ptr<TrapRulesBenchArgs> args(new TrapRulesBenchArgs);
+    args->trapOid = CompactOid(SNMP_TRAPS_OID ".3");
+    args->enterprise = CompactOid(SNMP_TRAPS_OID);
+
+    static const u8 ifIndex[] = {0x06, 0x0A, 0x2B, 0x06, 0x01, 0x02, 0x01, 0x02, 0x02, 0x01, 0x01, 0x02};
+    args->buffer[0] = 0x02; args->buffer[1] = 0x01; args->buffer[2] = 0x02;
+    BerView value;
+    BerView::parse(ifIndex, sizeof(ifIndex), &args->varBind.oid);
+    BerView::parse(args->buffer, 3, &value);
+    VarBindValue::decode(value, &args->varBind.value);
+
+    // A subnet, an enterprise and an ifIndex rule per agent, so most of them are not matched
+    u32 sizes[] = {10, 100, 1000};
+    for(u32 i = 0; i < 3; i++) {
+        std::vector<TrapRule> ruleList(sizes[i]);
+        for(u32 j = 0; j < sizes[i]; j++) {
+            TrapRule &rule = ruleList[j];
+            rule.name = std::to_string(j);
+            rule.action = (j % 3 == 0) ? TRAPRULE_ALERT : TRAPRULE_TAG;
+            rule.argument = "rule" + std::to_string(j);
+            if(j % 3 == 0) rule.source = "10.0." + std::to_string(j % 256) + ".0/24";
+            if(j % 3 == 1) rule.enterprise = "1.3.6.1.4.1." + std::to_string(j);
+            if(j % 3 == 2) {
+                TrapRuleVarBind varBind = {"1.3.6.1.2.1.2.2.1.1." + std::to_string(j), "2"};
+                rule.trapOid = SNMP_TRAPS_OID;
+                rule.varBinds.push_back(varBind);
+            }
+        }
+        args->rules = std::make_shared<TrapRuleSet>(ruleList);
+        args->nMatched = 0;
+        BenchResult result = Bench::run("Trap rules match, " + std::to_string(sizes[i]) + " rules", 1000, notifybench_traprules_match, args.get());
+        Bench::logRate(result, 1000, "traps");
+    }
+}
+
+/**
+ * @struct InformBenchArgs
+ */
+typedef struct {
+    std::shared_ptr<Snmpv2Pdu> sender;
+    std::shared_ptr<Snmpv2Pdu> receiver;
+    std::shared_ptr<UdpSocket> senderSock;
+    std::shared_ptr<UdpSocket> receiverSock;
+    CompactOid linkDown;
+    u32 nReceived;
+} InformBenchArgs;
+
+/**
+ * @brief Send a linkDown inform, receive and acknowledge it as the receiver does, and receive the acknowledgement
+ * @param args Benchmark arguments
+ * @note Throws if the inform lost its VarBinds or its trap OID while being acknowledged
+ */
+static void notifybench_inform_roundtrip(void *args) {
+
+    InformBenchArgs *bench = (InformBenchArgs*)args;
+    bench->sender->addVarBind(std::make_shared<BerOid>(TRAPDEDUP_SYSUPTIME_OID),
+        std::make_shared<BerInteger>((u64)123456, false, SNMPV1_TAGCLASS_TIMETICKS, SNMPV1_TAG_TIMETICKS));
+    bench->sender->addVarBind(std::make_shared<BerOid>(SNMP_TRAPOID_OID), std::make_shared<BerOid>(bench->linkDown));
+    bench->sender->addVarBind(std::make_shared<BerOid>("1.3.6.1.2.1.2.2.1.1.2"), std::make_shared<BerInteger>((u64)2, false));
+    bench->sender->sendRequest(SNMPV2_INFORMREQUEST, bench->senderSock, inet_addr("127.0.0.1"), NOTIFYBENCH_INFORM_PORT);
+
+    bench->receiver->clear();
+    SnmpResult result = bench->receiver->tryRecvTrap(bench->receiverSock);
+    if(result.status != SNMP_OK) {
+        throw std::runtime_error("Inform not received: " + Snmpv1Pdu::getErrorString(result));
+    }
+    CompactOid trapOid, enterprise;
+    std::shared_ptr<json_t> trap = bench->receiver->serializeTrap();
+    if(bench->receiver->getNVarBinds() != 3 || json_array_size(json_object_get(trap.get(), "data")) != 6 ||
+        !bench->receiver->getTrapOid(trapOid, enterprise) || !(trapOid == bench->linkDown)) {
+        throw std::runtime_error("Acknowledged inform lost its VarBinds");
+    }
+    bench->nReceived++;
+
+    // The acknowledgement must carry the inform request ID
+    u8 pduType;
+    result = bench->sender->tryRecvResponse(bench->senderSock, inet_addr("127.0.0.1"), NOTIFYBENCH_INFORM_PORT, SNMPV2_GETRESPONSE, &pduType);
+    bench->sender->clear();
+    if(result.status != SNMP_OK) {
+        throw std::runtime_error("Inform not acknowledged: " + Snmpv1Pdu::getErrorString(result));
+    }
+}
+
+/**
+ * @brief Measure the reception and acknowledgement of SNMPv2c informs, over the loopback interface
+ */
+void NotifyBench::runInform() {
+
+    std::unique_ptr<InformBenchArgs> args(new InformBenchArgs);
+    args->sender = std::make_shared<Snmpv2Pdu>("public");
+    args->receiver = std::make_shared<Snmpv2Pdu>("public");
+    args->senderSock = std::make_shared<UdpSocket>(1);
+    args->receiverSock = std::make_shared<UdpSocket>(1);
+    args->receiverSock->bindTo(NOTIFYBENCH_INFORM_PORT);
+    args->linkDown = CompactOid(SNMP_TRAPS_OID ".3");
+    args->nReceived = 0;
+
+    BenchResult result = Bench::run("Inform receive and acknowledge", 1000, notifybench_inform_roundtrip, args.get());
+    Bench::logRate(result, 1, "informs");
+    Bench::logText("Informs: " + std::to_string(args->nReceived) + " received and acknowledged");
+}
+
+}
@@ -0,0 +1,80 @@
+/**
+ * @file Host3ds.cpp
+ * @brief libctru functions used by the benchmarked code, on top of POSIX
+ */
+
+// Includes C/C++
+#include <sched.h>
+#include <sys/time.h>
+#include <time.h>
+
+// Includes 3DS
+#include <3ds.h>
+
+// Includes jansson
+#include <jansson.h>
+
+// Own includes
+#include "Utils.h"
+
+// Defines
+#define HOST3DS_EPOCH_OFFSET    2208988800000ULL    /**< ms from 1900, the osGetTime() epoch, to 1970 */
+
+/**
+ * @brief Get the system tick count
+ * @return Ticks of a SYSCLOCK_ARM11 clock, from the host monotonic clock
+ */
+u64 svcGetSystemTick(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * SYSCLOCK_ARM11 + (u64)ts.tv_nsec * SYSCLOCK_ARM11 / 1000000000ULL;
+}
+
+/**
+ * @brief Get the current time
+ * @return ms since January 1st 1900, as on the console
+ */
+u64 osGetTime(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (u64)tv.tv_sec * 1000 + tv.tv_usec / 1000 + HOST3DS_EPOCH_OFFSET;
+}
+
+/**
+ * @brief Initialize a lock
+ * @param lock Lock
+ */
+void LightLock_Init(LightLock *lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Take a lock, yielding while it is held
+ * @param lock Lock
+ */
+void LightLock_Lock(LightLock *lock) {
+    while(__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0) {
+        sched_yield();
+    }
+}
+
+/**
+ * @brief Release a lock
+ * @param lock Lock
+ */
+void LightLock_Unlock(LightLock *lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+namespace NetMan {
+
+/**
+ * @brief Add a text field to a JSON array, as Utils.cpp does (the rest of Utils needs the GUI)
+ * @param array JSON array
+ * @param field Text
+ */
+void Utils::addJsonField(json_t *array, const std::string &field) {
+    json_array_append_new(array, json_string(field.c_str()));
+}
+
+}
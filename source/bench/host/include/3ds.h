@@ -0,0 +1,48 @@
+/**
+ * @file 3ds.h
+ * @brief Subset of libctru used by the benchmarked code, implemented on top of POSIX in Host3ds.cpp
+ */
+
+#ifndef _HOST_3DS_H_
+#define _HOST_3DS_H_
+
+// Includes C/C++
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// Includes 3DS
+#include <3ds/types.h>
+
+// Defines
+#define SYSCLOCK_ARM11      268111856       /**< svcGetSystemTick() ticks per second */
+
+typedef s32 LightLock;
+typedef struct Thread_tag *Thread;
+
+u64 svcGetSystemTick(void);
+u64 osGetTime(void);
+void LightLock_Init(LightLock *lock);
+void LightLock_Lock(LightLock *lock);
+void LightLock_Unlock(LightLock *lock);
+
+/**
+ * @struct touchPosition
+ */
+typedef struct {
+    u16 px;
+    u16 py;
+} touchPosition;
+
+/**
+ * @enum HTTPC_RequestMethod
+ */
+typedef enum {
+    HTTPC_METHOD_GET = 1,
+    HTTPC_METHOD_POST,
+    HTTPC_METHOD_HEAD,
+    HTTPC_METHOD_PUT,
+    HTTPC_METHOD_DELETE
+} HTTPC_RequestMethod;
+
+#endif
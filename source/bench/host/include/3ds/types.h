@@ -0,0 +1,36 @@
+/**
+ * @file types.h
+ * @brief libctru types, for the host benchmark build
+ */
+
+#ifndef _HOST_3DS_TYPES_H_
+#define _HOST_3DS_TYPES_H_
+
+// Includes C/C++
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#ifdef __cplusplus
+#include <stdexcept>                        // Brought in by the devkitARM headers, the sources rely on it
+#include <string>
+#endif
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+typedef volatile u8 vu8;
+typedef volatile u16 vu16;
+typedef volatile u32 vu32;
+typedef volatile u64 vu64;
+
+typedef s32 Result;
+typedef u32 Handle;
+
+#endif
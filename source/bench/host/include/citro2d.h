@@ -0,0 +1,42 @@
+/**
+ * @file citro2d.h
+ * @brief citro2d types named by the GUI headers, for the host benchmark build
+ * @note Only the types are declared, the benchmarked code does not draw
+ */
+
+#ifndef _HOST_CITRO2D_H_
+#define _HOST_CITRO2D_H_
+
+// Includes 3DS
+#include <3ds.h>
+
+typedef struct C2D_SpriteSheet_s *C2D_SpriteSheet;
+typedef struct C2D_TextBuf_s *C2D_TextBuf;
+
+/**
+ * @struct C2D_Sprite
+ */
+typedef struct {
+    struct {
+        struct {
+            float x, y;
+        } pos;
+        float angle;
+    } params;
+} C2D_Sprite;
+
+/**
+ * @struct C2D_ImageTint
+ */
+typedef struct {
+    u32 color;
+} C2D_ImageTint;
+
+/**
+ * @struct C2D_Text
+ */
+typedef struct {
+    float width;
+} C2D_Text;
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file tinyxml2.h
+ * @brief tinyxml2 classes named by the RESTCONF headers, for the host benchmark build
+ * @note Only the classes are declared, the benchmarked code does not parse XML
+ */
+
+#ifndef _HOST_TINYXML2_H_
+#define _HOST_TINYXML2_H_
+
+namespace tinyxml2 {
+
+class XMLElement;
+
+/**
+ * @class XMLDocument
+ */
+class XMLDocument {
+};
+
+}
+
+#endif
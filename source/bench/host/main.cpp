@@ -0,0 +1,57 @@
+/**
+ * @file main.cpp
+ * @brief Runs the benchmarks on the host, as bench_test() does on the console
+ */
+
+// Includes C/C++
+#include <stdio.h>
+#include <stdexcept>
+#include <string>
+
+// Own includes
+#include "bench/Bench.h"
+#include "bench/CodecBench.h"
+#include "bench/NotifyBench.h"
+
+using namespace NetMan;
+
+/**
+ * @brief Main function
+ * @param argc Number of arguments
+ * @param argv Program arguments: corpus directory, ending with a slash (optional)
+ * @return 0 if every benchmark was run
+ * @note Results go to log.txt and bench.jsonl, in the working directory
+ */
+int main(int argc, char **argv) {
+
+    std::string corpusPath = (argc > 1) ? argv[1] : "romfs/bench/";
+
+    FILE *f = fopen(BENCH_LOG_PATH, "wb");
+    if(f == NULL) {
+        fprintf(stderr, "Couldn't open %s\n", BENCH_LOG_PATH);
+        return 1;
+    }
+    fclose(f);
+
+    try {
+        CodecBench::runBerView();
+        CodecBench::runBerWriter();
+        CodecBench::runBerArena();
+        CodecBench::runCompactOid();
+        CodecBench::runOidCodec();
+        CodecBench::runBerStream();
+        CodecBench::runDecodeStatus();
+        CodecBench::run(corpusPath);
+        NotifyBench::runEventLog();     // Writes to benchlog/
+        NotifyBench::runTrapDedup();
+        NotifyBench::runTrapRules();
+        NotifyBench::runInform();
+    } catch (const std::runtime_error &e) {
+        Bench::logText(std::string("Error: ") + e.what());
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    printf("Results written to %s and %s\n", BENCH_LOG_PATH, BENCH_RESULTS_PATH);
+    return 0;
+}
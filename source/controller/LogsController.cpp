@@ -2,10 +2,18 @@
  * @file LogsController.cpp
  */
 
+// Includes C/C++
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <arpa/inet.h>
+
 // Own includes
 #include "controller/LogsController.h"
 #include "Application.h"
+#include "asn1/CompactOid.h"
 #include "gui/BinaryButtonView.h"
+#include "gui/EditTextView.h"
 #include "gui/ListView.h"
 #include "gui/TextView.h"
 #include "Utils.h"
@@ -14,6 +22,7 @@
 #define ICON_SIZE           81.0f
 #define TEXT_OFFX           10.0f
 #define TEXT_SCALE          0.8f
+#define FILTER_NONE         "*"
 
 namespace NetMan {
 
@@ -34,35 +43,51 @@ static void fillLogs(void *args) {
     controller->setFillParams(params);
     params->layouts.clear();
 
-    auto list = controller->getJson();
-    if(list.get() == NULL) {
+    auto log = controller->getLog();
+    if(log == nullptr) {
         Application::getInstance().requestLayoutChange("menu");
         return;
     }
-    u32 listSize = json_array_size(list.get());
 
-    if(params->endElement >= listSize) {
+    // Only the records of the page matching the filter are read
+    if(!controller->loadPage(params->startElement, params->endElement - params->startElement)) {
         params->remaining = false;
     }
+    const std::vector<u32> &page = controller->getPage();
 
-    for(u32 i = params->startElement; i < params->endElement; i++) {
-        if(i < listSize) {
-            float y = params->startY + (i % params->maxElements) * params->elementHeight;
-            json_t *obj = json_array_get(list.get(), listSize - i - 1);
-            json_t *name = json_object_get(obj, "name");
-            std::shared_ptr<GuiLayout> layout = std::make_shared<GuiLayout>();
-            std::shared_ptr<ImageView> bg = std::make_shared<ImageView>("menuButton", params->startX + params->elementWidth / 2, y + params->elementHeight / 2, params->elementWidth / ICON_SIZE, params->elementHeight / ICON_SIZE);
-            layout->addView(bg);
-            if(name) {
-                std::shared_ptr<TextView> tv = std::make_shared<TextView>(json_string_value(name), params->startX + TEXT_OFFX, y, TEXT_SCALE, C2D_Color32(0, 0, 0, 0xFF));
-                layout->addView(tv);
-            }
-            params->layouts.push_back(layout);
-        } else {
-            i = params->endElement;
-            params->remaining = false;
+    // The list goes from the newest record, so the page is read backwards
+    std::vector<EventLogRecord> records(page.size());
+    EventLogIterator it(log, page.empty() ? 0 : page.back());
+    for(u32 i = page.size(); i > 0; i--) {
+        it.seek(page[i - 1]);
+        if(!it.next(records[i - 1])) {
+            records[i - 1].name = "Deleted";
         }
     }
+
+    for(u32 i = 0; i < records.size(); i++) {
+        float y = params->startY + ((params->startElement + i) % params->maxElements) * params->elementHeight;
+        std::shared_ptr<GuiLayout> layout = std::make_shared<GuiLayout>();
+        std::shared_ptr<ImageView> bg = std::make_shared<ImageView>("menuButton", params->startX + params->elementWidth / 2, y + params->elementHeight / 2, params->elementWidth / ICON_SIZE, params->elementHeight / ICON_SIZE);
+        layout->addView(bg);
+        std::shared_ptr<TextView> tv = std::make_shared<TextView>(records[i].name, params->startX + TEXT_OFFX, y, TEXT_SCALE, C2D_Color32(0, 0, 0, 0xFF));
+        layout->addView(tv);
+        params->layouts.push_back(layout);
+    }
+}
+
+/**
+ * @brief Go back to the first page, with the records stored now
+ * @param controller Logs controller
+ */
+static void reloadLogs(std::shared_ptr<LogsController> controller) {
+    ListViewFillParams *listParams = controller->getFillParams();
+    controller->loadLog();
+    if(listParams == NULL) return;
+    listParams->endElement -= listParams->startElement;
+    listParams->startElement = 0;
+    listParams->remaining = true;
+    fillLogs(listParams);
 }
 
 /**
@@ -74,16 +99,38 @@ static void editLogMode(void *args) {
     auto controller = std::static_pointer_cast<LogsController>(params->controller);
     
     // Load the proper log list
-    ListViewFillParams *listParams = controller->getFillParams();
-    listParams->endElement -= listParams->startElement;
-    listParams->startElement = 0;
-    listParams->remaining = true;
-    if(params->selected) {
-        controller->loadJsonList("syslog.json");
-    } else {
-        controller->loadJsonList("snmpTrap.json");
+    controller->setSyslogMode(params->selected);
+    reloadLogs(controller);
+}
+
+/**
+ * @brief Edit the log filter
+ */
+static void editFilter(void *args) {
+    EditTextParams *params = (EditTextParams*)args;
+    auto controller = std::static_pointer_cast<LogsController>(params->controller);
+    if(!params->init) {
+        sprintf(params->text, "%s", controller->getFilterText().c_str());
+        params->init = true;
+        return;
     }
-    fillLogs(listParams);
+
+    if(!controller->setFilter(params->text)) {
+        params->init = false;
+
+        // Show the route logs, as they are only known by the rule file
+        std::string message = "Invalid filter";
+        auto receiver = Application::getInstance().getReceiver();
+        if(receiver != nullptr) {
+            std::vector<std::string> names = receiver->getRouteLogNames();
+            for(u32 i = 0; i < names.size(); i++) {
+                message += ((i == 0) ? ". Route logs: " : ", ") + names[i];
+            }
+        }
+        Application::getInstance().messageBox(message);
+        return;
+    }
+    reloadLogs(controller);
 }
 
 /**
@@ -93,11 +140,22 @@ static void clickLog(void *args) {
     ListViewClickParams *params = (ListViewClickParams*)args;
     auto controller = std::static_pointer_cast<LogsController>(params->controller);
     
-    auto list = controller->getJson();
-    u32 listSize = json_array_size(list.get());
-    json_t *obj = json_array_get(list.get(), listSize - params->element - 1);
-    json_t *data = json_object_get(obj, "data");
-    data = json_incref(data);
+    auto log = controller->getLog();
+    u32 index;
+    if(log == nullptr || !controller->getRecordIndex(params->element, &index)) return;
+
+    EventLogRecord record;
+    EventLogIterator it(log, index);
+    if(!it.next(record)) {
+        Application::getInstance().messageBox("This log was deleted");
+        return;
+    }
+
+    // The log viewer takes the fields as a JSON list
+    json_t *data = json_array();
+    for(u32 i = 0; i < record.fields.size(); i++) {
+        Utils::addJsonField(data, record.fields[i]);
+    }
 
     auto context = std::shared_ptr<json_t>(data, [=](json_t* data) { json_decref(data); });
     Application::getInstance().requestLayoutChange("viewlog", context);
@@ -112,18 +170,150 @@ LogsController::LogsController() {
         {"editLogMode", editLogMode},
         {"fillLogs", fillLogs},
         {"clickLog", clickLog},
+        {"editFilter", editFilter},
     };
+    this->fillParams = NULL;
+    this->pageStart = 0;
+    this->filter.fromTime = 0;
+    this->filter.toTime = 0;
+    this->filter.source = 0;
+    this->filterText = FILTER_NONE;
+    this->syslogMode = false;
 
     // Load trap list by default
-    loadJsonList("snmpTrap.json");
+    loadLog();
+}
+
+/**
+ * @brief Load the list of the selected log: the syslog log, the route log set by the filter, or the trap log
+ * @note The list keeps the records stored at this moment
+ */
+void LogsController::loadLog() {
+    auto receiver = Application::getInstance().getReceiver();
+    std::shared_ptr<EventLog> log = nullptr;
+    if(receiver != nullptr) {
+        if(this->syslogMode) {
+            log = receiver->getSyslogLog();
+        } else if(!this->routeLog.empty()) {
+            log = receiver->findRouteLog(this->routeLog);
+        } else {
+            log = receiver->getTrapLog();
+        }
+    }
+    this->log = log;
+    this->begin = (log != nullptr) ? log->getBegin() : 0;
+    this->end = (log != nullptr) ? log->getEnd() : 0;
+    this->page.clear();
+}
+
+/**
+ * @brief Set the filter of the list
+ * @param text  Space separated conditions, all of them must match: src=IP, oid=OID (trap OID), ent=OID (trap enterprise),
+ *              fac=N (syslog facility), sev=N (syslog severity), app=NAME, msgid=ID, tag=NAME (trap rule tag),
+ *              last=N (received in the last N minutes),
+ *              log=NAME (list the traps routed to a log by a trap rule), or FILTER_NONE to list every record
+ * @return false if the filter is not valid, then it is not changed
+ */
+bool LogsController::setFilter(const std::string &text) {
+
+    EventLogFilter newFilter;
+    newFilter.fromTime = 0;
+    newFilter.toTime = 0;
+    newFilter.source = 0;
+    std::string newRouteLog;
+
+    u32 pos = 0;
+    while(pos < text.size()) {
+        size_t tokenEnd = text.find(' ', pos);
+        if(tokenEnd == std::string::npos) tokenEnd = text.size();
+        std::string token = text.substr(pos, tokenEnd - pos);
+        pos = tokenEnd + 1;
+        if(token.empty() || token == FILTER_NONE) continue;
+
+        size_t equals = token.find('=');
+        if(equals == std::string::npos || equals + 1 == token.size()) return false;
+        std::string name = token.substr(0, equals);
+        std::string value = token.substr(equals + 1);
+
+        EventLogKey key;
+        if(name == "src") {
+            newFilter.source = inet_addr(value.c_str());
+            if(newFilter.source == INADDR_NONE || newFilter.source == 0) return false;
+            continue;
+        } else if(name == "last") {
+            char *numberEnd;
+            u32 minutes = strtoul(value.c_str(), &numberEnd, 10);
+            if(*numberEnd != '\0' || minutes == 0) return false;
+            newFilter.fromTime = osGetTime() - (u64)minutes * 60000ULL;
+            continue;
+        } else if(name == "log") {
+            auto receiver = Application::getInstance().getReceiver();
+            if(receiver == nullptr || receiver->findRouteLog(value) == nullptr) return false;
+            newRouteLog = value;
+            continue;
+        } else if(name == "oid" || name == "ent") {
+            try {
+                CompactOid oid(value);
+                if(oid.isEmpty()) return false;
+                key.value.assign((const char*)oid.getData(), oid.getLength());
+            } catch (const std::runtime_error &e) {
+                return false;
+            }
+            key.kind = (name == "oid") ? EVENTLOG_KEY_TRAPOID : EVENTLOG_KEY_ENTERPRISE;
+        } else if(name == "fac" || name == "sev") {
+            char *numberEnd;
+            u32 number = strtoul(value.c_str(), &numberEnd, 10);
+            if(*numberEnd != '\0' || number > ((name == "fac") ? 23 : 7)) return false;
+            key.kind = (name == "fac") ? EVENTLOG_KEY_FACILITY : EVENTLOG_KEY_SEVERITY;
+            key.value = std::to_string(number);
+        } else if(name == "app") {
+            key.kind = EVENTLOG_KEY_APPNAME;
+            key.value = value;
+        } else if(name == "msgid") {
+            key.kind = EVENTLOG_KEY_MSGID;
+            key.value = value;
+        } else if(name == "tag") {
+            key.kind = EVENTLOG_KEY_TAG;
+            key.value = value;
+        } else {
+            return false;
+        }
+        newFilter.keys.push_back(key);
+    }
+
+    this->filter = newFilter;
+    this->routeLog = newRouteLog;
+    this->filterText = (newFilter.source == 0 && newFilter.fromTime == 0 && newFilter.keys.empty() && newRouteLog.empty()) ? FILTER_NONE : text;
+    return true;
+}
+
+/**
+ * @brief Find the records of a page of the list
+ * @param startElement  First element of the page
+ * @param count         Elements in the page
+ * @return If there are more records after the page
+ * @note The page is taken from the log index, see getPage()
+ */
+bool LogsController::loadPage(u32 startElement, u32 count) {
+    this->pageStart = startElement;
+    this->page.clear();
+    if(this->log == nullptr) return false;
+    this->log->query(this->filter, this->begin, this->end, startElement, count + 1, this->page);
+    if(this->page.size() <= count) return false;
+    this->page.resize(count);
+    return true;
 }
 
 /**
- * @brief Load a JSON list
- * @param path  JSON file path
+ * @brief Get the record shown in an element of the list
+ * @param element   Element of the shown page
+ * @param index     Record index (output)
+ * @return false if the element is not shown
  */
-void LogsController::loadJsonList(const std::string &path) {
-    root = Utils::loadJsonList(path);
+bool LogsController::getRecordIndex(u32 element, u32 *index) {
+    if(element < this->pageStart || element - this->pageStart >= this->page.size()) return false;
+    *index = this->page[element - this->pageStart];
+    return true;
 }
 
 /**
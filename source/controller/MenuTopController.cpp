@@ -14,143 +14,43 @@
 #include "Application.h"
 #include "gui/TextView.h"
 #include "gui/UpdateView.h"
-#include "Config.h"
-#include "Utils.h"
 
 // Defines
 #define MENUTEXT_X          160
 
 namespace NetMan {
 
-// Log file paths
-static const char *trapFile = "snmpTrap.json";
-static const char *logFile = "syslog.json";
-
-/**
- * @brief Save a log to the proper file in JSON format
- * @param path  Log file path
- * @param json  JSON object containing log data
- * @param name  Canonical log name
- * @param limit How many logs to store in this file?
- */
-static void saveLogEntry(const std::string &path, std::shared_ptr<json_t> json, const std::string &name, u32 limit) {
-    
-    json_object_set_new(json.get(), "name", json_string(name.c_str()));
-
-    FILE *f = fopen(path.c_str(), "rb");
-    if(f == NULL) {
-        // Create a new file
-        f = fopen(path.c_str(), "wb");
-        if(f) {
-            json_t *root = json_array();
-            json_array_append(root, json.get());
-            fprintf(f, json_dumps(root, 0));
-            fclose(f);
-            json_decref(root);
-        }
-    } else {
-        
-        // File already exists
-        json_t *root = json_loadf(f, 0, NULL);
-        fclose(f);
-        if(root) {
-            u32 size = json_array_size(root);
-            if(size >= limit) {
-                for(u32 i = 0; i < (size - limit + 1); i++) {
-                    json_array_remove(root, i);
-                }
-            }
-            json_array_append(root, json.get());
-
-            f = fopen(path.c_str(), "wb");
-            if(f) {
-                fprintf(f, json_dumps(root, 0));
-                fclose(f);
-            }
-            
-            json_decref(root);
-        }
-    }
-}
-
 /**
- * @brief Process the log daemon
+ * @brief Show the traps and logs received since the last frame
+ * @note They are received and stored by the NotificationReceiver
  */
 static void onUpdateLogs(void *args) {
 
-    auto trapv1Sock = Application::getInstance().getTrapv1Sock();
-    auto trapv2Sock = Application::getInstance().getTrapv2Sock();
-    auto trapv3Sock = Application::getInstance().getTrapv3Sock();
-    auto syslogUdpSock = Application::getInstance().getSyslogUdpSock();
-    auto syslogTcpSock = Application::getInstance().getSyslogTcpSock();
+    auto receiver = Application::getInstance().getReceiver();
     auto params = (UpdateParams*)args;
     auto controller = std::static_pointer_cast<MenuTopController>(params->controller);
-    auto& configData = Config::getInstance().getData();
-
-    // Handle SNMPv1 traps
-    if(trapv1Sock != nullptr) {
-        try {
-            auto pdu = controller->getSnmpv1Pdu();
-            pdu->clear();
-            pdu->recvTrap(trapv1Sock);
-            auto curTime = Utils::getCurrentTime();
-            saveLogEntry(trapFile, pdu->serializeTrap(), curTime + " Trap V1", configData.trapLimit);
-            controller->getTrapText()->setText(curTime + ": SNMPv1 trap received!");
-            controller->beep();
-        } catch (const std::runtime_error &e) { }
-    }
+    if(receiver == nullptr) return;
 
-    // Handle SNMPv2 traps
-    if(trapv2Sock != nullptr) {
-        try {
-            auto pdu = controller->getSnmpv2Pdu();
-            pdu->clear();
-            pdu->recvTrap(trapv2Sock);
-            auto curTime = Utils::getCurrentTime();
-            saveLogEntry(trapFile, pdu->serializeTrap(), curTime + " Trap V2", configData.trapLimit);
-            controller->getTrapText()->setText(curTime + ": SNMPv2 trap received!");
-            controller->beep();
-        } catch (const std::runtime_error &e) { }
+    // Only the last event is shown
+    NotificationEvent event;
+    u32 nEvents = 0;
+    while(receiver->popEvent(event)) {
+        nEvents++;
     }
+    if(nEvents == 0) return;
 
-    // Handle SNMPv3 traps
-    if(trapv3Sock != nullptr) {
-        try {
-            auto pdu = controller->getSnmpv3Pdu();
-            pdu->clear();
-            auto curTime = Utils::getCurrentTime();
-            if(pdu->recvTrap(trapv3Sock)) {
-                controller->getTrapText()->setText(curTime + ": SNMPv3 inform received!");
-            } else {
-                controller->getTrapText()->setText(curTime + ": SNMPv3 trap received!");
-            }
-            saveLogEntry(trapFile, pdu->serializeTrap(), curTime + " Trap V3", configData.trapLimit);
-            controller->beep();
-        } catch (const std::runtime_error &e) { }
+    // Events are only dropped while the ring is full, so there is always a newer one to show them with
+    std::string text(event.summary);
+    if(nEvents > 1) {
+        text += " (+" + std::to_string(nEvents - 1) + ")";
     }
-
-    // Handle syslogs
-    auto syslogPdu = controller->getSyslogPdu();
-    if(syslogUdpSock != nullptr) {
-        try {
-            syslogPdu->recvLog(syslogUdpSock);
-            auto curTime = Utils::getCurrentTime();
-            saveLogEntry(logFile, syslogPdu->serialize(), curTime + " Syslog UDP", configData.syslogLimit);
-            controller->getTrapText()->setText(curTime + ": UDP Syslog received!");
-            controller->beep();
-        } catch (const std::runtime_error &e) { }
-    } else if(syslogTcpSock != nullptr) {
-        try {
-            std::shared_ptr<TcpSocket> conn = syslogTcpSock->acceptConnection(configData.tcpTimeout);
-			if(conn != nullptr) {
-				syslogPdu->recvLog(conn);
-                auto curTime = Utils::getCurrentTime();
-                saveLogEntry(logFile, syslogPdu->serialize(), curTime + " Syslog TCP", configData.syslogLimit);
-                controller->getTrapText()->setText(curTime + ": TCP Syslog received!");
-                controller->beep();
-			}
-        } catch (const std::runtime_error &e) { }
+    u32 nDropped = receiver->getNDropped();
+    if(nDropped != controller->getNDropped()) {
+        text += " " + std::to_string(nDropped - controller->getNDropped()) + " dropped";
+        controller->setNDropped(nDropped);
     }
+    controller->getTrapText()->setText(text);
+    controller->beep();
 }
 
 /**
@@ -170,12 +70,9 @@ MenuTopController::MenuTopController() {
         throw;
     }
 
-    // Create the trap and log PDUs
-    auto& config = Config::getInstance();
-    snmpv1Pdu = std::make_shared<Snmpv1Pdu>(config.getCommunity());
-    snmpv2Pdu = std::make_shared<Snmpv2Pdu>(config.getCommunity());
-    snmpv3Pdu = std::make_shared<Snmpv3Pdu>(config.getEngineID(), config.getContextName(), config.getTrapUser());
-    syslogPdu = std::make_shared<SyslogPdu>();
+    // The events dropped before entering this menu are not shown
+    auto receiver = Application::getInstance().getReceiver();
+    nDropped = (receiver != nullptr) ? receiver->getNDropped() : 0;
 }
 
 /**
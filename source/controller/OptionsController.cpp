@@ -37,6 +37,19 @@ static void nextBootMessage() {
 static void gotoMenu(void *args) {
     Application::getInstance().requestLayoutChange("menu");
     Config::getInstance().save();
+
+    // The trap PDUs take the community and the trap user when started
+    auto receiver = Application::getInstance().getReceiver();
+    if(receiver != nullptr) {
+        try {
+            receiver->stop();
+            receiver->start();
+        } catch (const std::bad_alloc &e) {
+            Application::getInstance().messageBox(e.what());
+        } catch (const std::runtime_error &e) {
+            Application::getInstance().messageBox(e.what());
+        }
+    }
 }
 
 /**
@@ -57,7 +70,7 @@ static void fillUsers(void *args) {
     controller->clearCrosses();
     controller->clearTexts();
 
-    auto& users = Snmpv3UserStore::getInstance().getUserTable();
+    auto users = Snmpv3UserStore::getInstance().getUserTable();
 
     if(params->endElement >= users.size()) {
         params->remaining = false;
@@ -187,7 +200,7 @@ static void editTrapv2Bool(void *args) {
  * @brief Edit the trap limit to be stored
  */
 static void editTrapLimit(void *args) {
-    Utils::handleFormInteger((EditTextParams*)args, &Config::getInstance().getData().trapLimit, 999);
+    Utils::handleFormInteger((EditTextParams*)args, &Config::getInstance().getData().trapLimit, MAX_LOG_LIMIT);
 }
 
 /**
@@ -269,7 +282,7 @@ static void editSyslogTransport(void *args) {
  * @brief Edit the syslog limit to be stored
  */
 static void editLogLimit(void *args) {
-    Utils::handleFormInteger((EditTextParams*)args, &Config::getInstance().getData().syslogLimit, 999);
+    Utils::handleFormInteger((EditTextParams*)args, &Config::getInstance().getData().syslogLimit, MAX_LOG_LIMIT);
 }
 
 /**
@@ -6,8 +6,10 @@
 #include "controller/SnmpTableController.h"
 #include "controller/SnmpTypeController.h"
 #include "gui/ButtonView.h"
+#include "gui/UpdateView.h"
 #include "Application.h"
 #include "snmp/Snmpv1Pdu.h"
+#include "asn1/BerOid.h"
 #include "Utils.h"
 
 // Defines
@@ -25,11 +27,17 @@
 #define EDITTEXT_WIDTH      50.0f
 #define EDITTEXT_HEIGHT     20.0f
 #define EDITTEXT_LENGTH     4
+#define MAX_TABLE_ROWS      99999
+#define WATCH_INTERVAL      5000        /**< Poll interval of a watched row, in ms */
 
 namespace NetMan {
 
 // Static data
 std::shared_ptr<SnmpThreadParams> SnmpTableController::snmpParams = nullptr;
+std::shared_ptr<SnmpTable> SnmpTableController::table = nullptr;
+std::shared_ptr<SnmpPoller> SnmpTableController::poller = nullptr;
+SnmpTableWatch SnmpTableController::watch;
+u32 SnmpTableController::tableIndex = 1;
 
 /**
  * @brief Go to the SNMP menu, clearing PDU contents
@@ -146,38 +154,135 @@ static void onEditColumn(void *args) {
 }
 
 /**
- * @brief Edit the table index
+ * @brief Describe a row of the fetched table
+ * @param table Fetched table
+ * @param row   Row position
+ * @return The row number and its INDEX values
+ */
+static std::string printRow(std::shared_ptr<SnmpTable> table, u32 row) {
+    return "Row " + std::to_string(row + 1) + "/" + std::to_string(table->getNRows()) + ": " + table->printIndex(row);
+}
+
+/**
+ * @brief Show a row of the fetched table in the PDU fields
+ * @param controller    Table controller
+ */
+static void showRow(SnmpTableController *controller) {
+
+    auto table = controller->getTable();
+    auto& pduFields = Application::getInstance().getPduFields();
+    u32 row = *controller->getTableIndex() - 1;
+
+    if(table->getNRows() == 0) {
+        controller->getRowText()->setText("No rows fetched");
+        return;
+    }
+    if(row >= table->getNRows()) {
+        Application::getInstance().messageBox("The table has " + std::to_string(table->getNRows()) + " rows");
+        return;
+    }
+
+    for(u32 i = 0; i < pduFields.size() && i < table->getNColumns(); i++) {
+        pduFields[i].oid = std::make_shared<BerOid>(table->getInstanceOid(i, row));
+        pduFields[i].value = table->getValue(i, row);
+        if(pduFields[i].type == '\0') {
+            pduFields[i].type = table->getColumn(i).type;
+        }
+    }
+    controller->getRowText()->setText(printRow(table, row));
+}
+
+/**
+ * @brief Edit the table row, showing it from the fetched table
  */
 static void editTableIndex(void *args) {
     EditTextParams *params = (EditTextParams*)args;
     auto controller = std::static_pointer_cast<SnmpTableController>(params->controller);
-    Utils::handleFormInteger(params, controller->getTableIndex(), 999);
+    bool init = params->init;
+    Utils::handleFormInteger(params, controller->getTableIndex(), MAX_TABLE_ROWS);
+    if(init && params->init) {
+        controller->stopWatch();
+        showRow(controller.get());
+        fillTable(controller->getFillParams());
+    }
 }
 
 /**
- * @brief Obtain a row from the SNMP table
+ * @brief Fetch the whole SNMP table
  */
-static void getRow(void *args) {
+static void fetchTable(void *args) {
     ButtonParams *params = (ButtonParams*)args;
     auto controller = std::static_pointer_cast<SnmpTableController>(params->controller);
-    auto& pduFields = Application::getInstance().getPduFields();
 
-    // Update the row to be used
-    for(auto &field : pduFields) {
-        field.oid->editLastElement(*controller->getTableIndex());
+    try {
+        controller->stopWatch();
+        Utils::fetchSnmpTable(controller->getSnmpParams().get(), controller->getTable());
+        *controller->getTableIndex() = 1;
+        showRow(controller.get());
+        fillTable(controller->getFillParams());
+    } catch (const std::runtime_error &e) {
+        Application::getInstance().messageBox(e.what());
     }
+}
 
-    // Send the GET request
-    auto snmpParams = controller->getSnmpParams();
-    snmpParams->session->pduType = SNMPV1_GETREQUEST;
-    try {
-        Utils::sendSnmpPdu(snmpParams.get());
+/**
+ * @brief Watch the shown row, polling it periodically, or stop watching it
+ */
+static void watchRow(void *args) {
+    ButtonParams *params = (ButtonParams*)args;
+    auto controller = std::static_pointer_cast<SnmpTableController>(params->controller);
+
+    if(controller->isWatching()) {
+        controller->stopWatch();
+        showRow(controller.get());
         fillTable(controller->getFillParams());
+        return;
+    }
+
+    try {
+        controller->startWatch();
     } catch (const std::runtime_error &e) {
         Application::getInstance().messageBox(e.what());
     }
 }
 
+/**
+ * @brief Show the last polled values of the watched row
+ */
+static void onUpdateWatch(void *args) {
+    UpdateParams *params = (UpdateParams*)args;
+    auto controller = std::static_pointer_cast<SnmpTableController>(params->controller);
+    if(controller->updateWatch() && controller->getFillParams() != NULL) {
+        fillTable(controller->getFillParams());
+    }
+}
+
+/**
+ * @brief Keep a polled value of the watched row
+ * @param sample    Polled value
+ * @param args      Watched row values
+ * @note Called from the poller thread. Counters are shown as their rate.
+ */
+static void storeWatchSample(const SnmpPollSample *sample, void *args) {
+
+    SnmpTableWatch *watch = (SnmpTableWatch*)args;
+    std::string value;
+    if(sample->varBind == NULL) {
+        value = "Error";
+    } else if(sample->hasRate) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.1f/s", sample->rate);
+        value = text;
+    } else {
+        value = sample->varBind->value.print();
+    }
+
+    LightLock_Lock(&watch->lock);
+    watch->values[sample->index] = value;
+    watch->changed = true;
+    LightLock_Unlock(&watch->lock);
+}
+
 /**
  * @brief Constructor for a SnmpTableController
  */
@@ -187,8 +292,10 @@ SnmpTableController::SnmpTableController() {
         {"fillTable", fillTable},
         {"clickColumn", clickColumn},
         {"editTableIndex", editTableIndex},
-        {"getRow", getRow},
+        {"fetchTable", fetchTable},
         {"onEditColumn", onEditColumn},
+        {"watchRow", watchRow},
+        {"onUpdateWatch", onUpdateWatch},
     };
 
     // Initialize the table, if needed
@@ -199,24 +306,21 @@ SnmpTableController::SnmpTableController() {
             throw std::runtime_error("No context specified");
         }
 
-        auto oidTree = snmpParams->session->mib->getOidTree();
+        table = std::make_shared<SnmpTable>(snmpParams->session->mib, snmpParams->session->tableName);
         auto& pduFields = Application::getInstance().getPduFields();
         pduFields.clear();
-        auto it = oidTree->find(snmpParams->session->tableName);
-        auto columns = it->second->children.begin()->second->children;
-        for(auto& column : columns) {
+        for(u32 i = 0; i < table->getNColumns(); i++) {
             PduField field;
-            field.oid = snmpParams->session->mib->resolve(column.first);
+            field.oid = std::make_shared<BerOid>(table->getColumn(i).oid);
             field.oid->addElement(0);   // Add index indicator
-            field.oidText = column.first;
+            field.oidText = table->getColumn(i).name;
             field.type = '\0';
             field.value = "";
             pduFields.push_back(field);
         }
+        tableIndex = 1;
+        LightLock_Init(&watch.lock);
     }
-
-    // Initialize data
-    this->tableIndex = 1;
 }
 
 /**
@@ -235,6 +339,59 @@ void SnmpTableController::addIcons(std::shared_ptr<TextView> columnText, std::sh
     this->tableIcons.push_back(icons);
 }
 
+/**
+ * @brief Get the row text view, and show the current row if the table was already fetched
+ * @param views Layout views
+ */
+void SnmpTableController::initialize(std::vector<std::shared_ptr<GuiView>> &views) {
+    this->rowText = std::static_pointer_cast<TextView>(views[8]);
+    if(table->getNRows() != 0) {
+        this->rowText->setText((poller != nullptr ? "Watching " : "") + printRow(table, tableIndex - 1));
+    }
+}
+
+/**
+ * @brief Start polling every column of the shown row
+ */
+void SnmpTableController::startWatch() {
+
+    u32 row = tableIndex - 1;
+    if(row >= table->getNRows()) {
+        throw std::runtime_error("Fetch the table to watch a row");
+    }
+
+    std::vector<CompactOid> oids;
+    for(u32 i = 0; i < table->getNColumns(); i++) {
+        oids.push_back(table->getInstanceOid(i, row));
+    }
+
+    watch.values.assign(oids.size(), "");
+    watch.changed = false;
+    poller = Utils::pollSnmpOids(snmpParams.get(), oids, WATCH_INTERVAL, storeWatchSample, &watch);
+    this->rowText->setText("Watching " + printRow(table, row));
+}
+
+/**
+ * @brief Show the last polled values of the watched row in the PDU fields
+ * @return If some value changed
+ */
+bool SnmpTableController::updateWatch() {
+
+    if(poller == nullptr) return false;
+
+    auto& pduFields = Application::getInstance().getPduFields();
+    LightLock_Lock(&watch.lock);
+    bool changed = watch.changed;
+    for(u32 i = 0; changed && i < pduFields.size() && i < watch.values.size(); i++) {
+        if(!watch.values[i].empty()) {
+            pduFields[i].value = watch.values[i];
+        }
+    }
+    watch.changed = false;
+    LightLock_Unlock(&watch.lock);
+    return changed;
+}
+
 /**
  * @brief Destructor for a SnmpTableController
  */
@@ -21,6 +21,8 @@
 #include "restconf/RestConfClient.h"
 #include "restconf/YinHelper.h"
 #include "Config.h"
+#include "bench/CodecBench.h"
+#include "bench/NotifyBench.h"
 
 using namespace NetMan;
 
@@ -33,6 +35,7 @@ void snmpv3_test();
 void snmpagent_test();
 void mibloader_test();
 void restconf_test();
+void bench_test();
 
 /**
  * @brief Main function
@@ -53,12 +56,41 @@ int main(int argc, char **argv) {
     //snmpagent_test();
     //mibloader_test();
     //restconf_test();
+    //bench_test();	// Results go to log.txt and bench.jsonl, define BENCH_ALLOCS to count allocations
 
 	app.run();
 
 	return 0;
 }
 
+/**
+ * @brief Run the benchmarks
+ */
+void bench_test() {
+
+	FILE *f = fopen(BENCH_LOG_PATH, "wb");
+	fclose(f);
+
+	try {
+		CodecBench::runBerView();
+		CodecBench::runBerWriter();
+		CodecBench::runBerArena();
+		CodecBench::runCompactOid();
+		CodecBench::runOidCodec();
+		CodecBench::runBerStream();
+		CodecBench::runDecodeStatus();
+		CodecBench::run();
+		NotifyBench::runEventLog();		// Writes to the SD card, in benchlog/
+		NotifyBench::runTrapDedup();
+		NotifyBench::runTrapRules();
+		NotifyBench::runInform();		// Uses the loopback interface
+	} catch (const std::runtime_error &e) {
+		f = fopen(BENCH_LOG_PATH, "a+");
+		fprintf(f, "Error: %s\n", e.what());
+		fclose(f);
+	}
+}
+
 /**
  * @brief Test the restconf stuff
  */
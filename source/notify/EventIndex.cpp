@@ -0,0 +1,200 @@
+/**
+ * @file EventIndex.cpp
+ * @brief In-memory secondary index of an EventLog
+ */
+
+// Includes C/C++
+#include <algorithm>
+
+// Own includes
+#include "notify/EventIndex.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for an EventIndex
+ */
+EventIndex::EventIndex() {
+	this->clear();
+}
+
+/**
+ * @brief Remove every record
+ */
+void EventIndex::clear() {
+	this->lists.clear();
+	this->buckets.clear();
+	this->begin = 0;
+	this->end = 0;
+	this->nEntries = 0;
+}
+
+/**
+ * @brief Add a record
+ * @param index	Record index, after the ones already added
+ * @param time	Reception time, in ms
+ * @param keys	Record keys
+ * @param nKeys	Number of keys
+ * @note A record already added is ignored
+ */
+void EventIndex::add(u32 index, u64 time, const u64 *keys, u32 nKeys) {
+
+	if(index < this->end) return;
+	if(this->begin == this->end) this->begin = index;
+	this->end = index + 1;
+
+	// The clock may go back, then the record is counted in the last bucket
+	u64 bucket = time / EVENTINDEX_BUCKET_MS;
+	if(this->buckets.empty() || bucket > this->buckets.back().bucket) {
+		EventIndexBucket entry = {bucket, index};
+		this->buckets.push_back(entry);
+	}
+
+	for(u32 i = 0; i < nKeys; i++) {
+		EventIndexList &list = this->lists[keys[i]];
+		if(list.indexes.empty()) list.start = 0;
+		else if(list.indexes.back() == index) continue;		// Repeated key
+		list.indexes.push_back(index);
+		this->nEntries++;
+	}
+}
+
+/**
+ * @brief Forget the records deleted from the log
+ * @param begin Index of the oldest stored record
+ * @note Lists are compacted once half of them is pruned, so each entry is moved a bounded number of times
+ */
+void EventIndex::prune(u32 begin) {
+
+	if(begin <= this->begin) return;
+	this->begin = (begin < this->end) ? begin : this->end;
+
+	for(auto it = this->lists.begin(); it != this->lists.end(); ) {
+		EventIndexList &list = it->second;
+		list.start = std::lower_bound(list.indexes.begin() + list.start, list.indexes.end(), this->begin) - list.indexes.begin();
+		if(list.start == list.indexes.size()) {
+			this->nEntries -= list.indexes.size();
+			it = this->lists.erase(it);
+			continue;
+		}
+		if(list.start > list.indexes.size() / 2) {
+			this->nEntries -= list.start;
+			list.indexes.erase(list.indexes.begin(), list.indexes.begin() + list.start);
+			list.indexes.shrink_to_fit();
+			list.start = 0;
+		}
+		++it;
+	}
+
+	while(this->buckets.size() > 1 && this->buckets[1].firstIndex <= this->begin) {
+		this->buckets.pop_front();
+	}
+	if(!this->buckets.empty() && this->buckets.front().firstIndex < this->begin) {
+		this->buckets.front().firstIndex = this->begin;
+	}
+}
+
+/**
+ * @brief Find the first record received at or after some time
+ * @param time Time, in ms, rounded down to its bucket
+ * @return The record index, or the index after the newest record
+ */
+u32 EventIndex::findTime(u64 time) {
+
+	u64 bucket = time / EVENTINDEX_BUCKET_MS;
+	u32 lo = 0, hi = this->buckets.size();
+	while(lo < hi) {
+		u32 mid = (lo + hi) / 2;
+		if(this->buckets[mid].bucket < bucket) lo = mid + 1;
+		else hi = mid;
+	}
+	return (lo < this->buckets.size()) ? this->buckets[lo].firstIndex : this->end;
+}
+
+/**
+ * @brief Find the records having every key, newest first
+ * @param keys		Keys to match, or NULL
+ * @param nKeys		Number of keys, 0 to match every record
+ * @param begin		Oldest record to look at
+ * @param end		Index after the newest record to look at
+ * @param skip		Newest matching records to skip
+ * @param count		Matching records to return, at most
+ * @param indexes	Indexes of the matching records (output)
+ * @return The number of records returned
+ * @note Only the shortest list is walked, the others are binary searched
+ */
+u32 EventIndex::query(const u64 *keys, u32 nKeys, u32 begin, u32 end, u32 skip, u32 count, std::vector<u32> &indexes) {
+
+	indexes.clear();
+	if(begin >= end || count == 0) return 0;
+
+	if(nKeys == 0) {
+		if(end - begin <= skip) return 0;
+		for(u32 i = end - skip; i > begin && indexes.size() < count; i--) {
+			indexes.push_back(i - 1);
+		}
+		return indexes.size();
+	}
+
+	std::vector<const EventIndexList*> keyLists(nKeys);
+	u32 driver = 0;
+	for(u32 i = 0; i < nKeys; i++) {
+		auto it = this->lists.find(keys[i]);
+		if(it == this->lists.end()) return 0;
+		keyLists[i] = &it->second;
+		if(keyLists[i]->indexes.size() - keyLists[i]->start < keyLists[driver]->indexes.size() - keyLists[driver]->start) {
+			driver = i;
+		}
+	}
+
+	const EventIndexList *list = keyLists[driver];
+	auto first = list->indexes.begin() + list->start;
+	auto pos = std::lower_bound(first, list->indexes.end(), end);
+	while(pos != first && indexes.size() < count) {
+		u32 index = *--pos;
+		if(index < begin) break;
+
+		bool match = true;
+		for(u32 i = 0; i < nKeys && match; i++) {
+			if(i == driver) continue;
+			match = std::binary_search(keyLists[i]->indexes.begin() + keyLists[i]->start, keyLists[i]->indexes.end(), index);
+		}
+		if(!match) continue;
+
+		if(skip != 0) {
+			skip--;
+		} else {
+			indexes.push_back(index);
+		}
+	}
+	return indexes.size();
+}
+
+/**
+ * @brief Get the key of a value (64-bit FNV-1a)
+ * @param kind	Value kind, so that equal values of different kinds do not share a key
+ * @param data	Value
+ * @param size	Value size
+ * @return The key
+ */
+u64 EventIndex::hash(u8 kind, const void *data, u32 size) {
+	u64 hash = EventIndex::hashBytes(EVENTINDEX_HASH_BASIS, &kind, 1);
+	return EventIndex::hashBytes(hash, data, size);
+}
+
+/**
+ * @brief Add some bytes to a 64-bit FNV-1a hash
+ * @param hash	Current hash, EVENTINDEX_HASH_BASIS for the first bytes
+ * @param data	Bytes
+ * @param size	Number of bytes
+ * @return The new hash
+ */
+u64 EventIndex::hashBytes(u64 hash, const void *data, u32 size) {
+	const u8 *bytes = (const u8*)data;
+	for(u32 i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+}
@@ -0,0 +1,849 @@
+/**
+ * @file EventLog.cpp
+ * @brief Append-only log of received events
+ */
+
+// Includes C/C++
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <stdexcept>
+
+// Own includes
+#include "notify/EventLog.h"
+
+// Defines
+#define EVENTLOG_MIN_PAYLOAD_SIZE		15				/**< Type, time, source and string count */
+#define EVENTLOG_MAX_STRING_LENGTH		0xFFFF
+
+namespace NetMan {
+
+/**
+ * @brief Append a little endian integer to a buffer
+ * @param data	Buffer
+ * @param value	Integer
+ * @param size	Integer size, in bytes
+ */
+static void eventlog_put_uint(std::vector<u8> &data, u64 value, u32 size) {
+	for(u32 i = 0; i < size; i++) {
+		data.push_back((value >> (i * 8)) & 0xFF);
+	}
+}
+
+/**
+ * @brief Read a little endian integer
+ * @param data	Integer bytes
+ * @param size	Integer size, in bytes
+ * @return The integer
+ */
+static u64 eventlog_get_uint(const u8 *data, u32 size) {
+	u64 value = 0;
+	for(u32 i = 0; i < size; i++) {
+		value |= (u64)data[i] << (i * 8);
+	}
+	return value;
+}
+
+/**
+ * @brief Append a length-prefixed string to a buffer
+ * @param data	Buffer
+ * @param text	String, cut at EVENTLOG_MAX_STRING_LENGTH bytes
+ */
+static void eventlog_put_string(std::vector<u8> &data, const std::string &text) {
+	u32 length = (text.size() > EVENTLOG_MAX_STRING_LENGTH) ? EVENTLOG_MAX_STRING_LENGTH : text.size();
+	eventlog_put_uint(data, length, 2);
+	data.insert(data.end(), text.begin(), text.begin() + length);
+}
+
+/**
+ * @brief Append the keys of a record to a buffer, as stored in the index files
+ * @param data		Buffer
+ * @param record	Record
+ */
+static void eventlog_put_keys(std::vector<u8> &data, const EventLogRecord &record) {
+	u64 hashes[EVENTLOG_MAX_KEYS + 1];
+	u32 nHashes = EventLog::hashKeys(record.source, record.keys, hashes);
+	eventlog_put_uint(data, record.time, 8);
+	eventlog_put_uint(data, nHashes, 1);
+	for(u32 i = 0; i < nHashes; i++) {
+		eventlog_put_uint(data, hashes[i], 8);
+	}
+}
+
+/**
+ * @brief Count the records in a buffer of keys
+ * @param keys Buffer, see eventlog_put_keys()
+ * @return The number of records, or 0xFFFFFFFF if the buffer is malformed
+ */
+static u32 eventlog_count_keys(const std::vector<u8> &keys) {
+	u32 pos = 0, count = 0;
+	while(pos < keys.size()) {
+		if(pos + 9 > keys.size()) return 0xFFFFFFFF;
+		pos += 9 + keys[pos + 8] * 8;
+		count++;
+	}
+	return (pos == keys.size()) ? count : 0xFFFFFFFF;
+}
+
+/**
+ * @brief Constructor for an EventLog
+ * @param path			Directory of the segment files
+ * @param maxRecords	Records kept, at least
+ * @param maxBytes		Size of the log over which the oldest segments are deleted
+ * @param segmentBytes	Size over which a new segment is started
+ */
+EventLog::EventLog(const std::string &path, u32 maxRecords, u32 maxBytes, u32 segmentBytes) {
+	this->path = path;
+	this->maxRecords = (maxRecords != 0) ? maxRecords : 1;
+	this->maxBytes = maxBytes;
+	this->segmentBytes = segmentBytes;
+	this->tail = NULL;
+	this->end = 0;
+	this->flushedEnd = 0;
+	this->nBytes = 0;
+	this->resumeTail = false;
+	LightLock_Init(&this->lock);
+	try {
+		this->open();
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Destructor for an EventLog
+ */
+EventLog::~EventLog() {
+	this->close();
+}
+
+/**
+ * @brief Get the path of a segment file
+ * @param id	Segment file number
+ * @param ext	EVENTLOG_SEGMENT_EXT, or EVENTLOG_INDEX_EXT for its index file
+ * @return The path
+ */
+std::string EventLog::getSegmentPath(u32 id, const char *ext) {
+	char name[16];
+	sprintf(name, "/%08lX", id);
+	return this->path + name + ext;
+}
+
+/**
+ * @brief Read the index file of a segment
+ * @param id	Segment file number
+ * @param keys	Keys of the segment records (output)
+ * @return false if it is missing or malformed
+ */
+bool EventLog::readKeys(u32 id, std::vector<u8> &keys) {
+
+	FILE *f = fopen(this->getSegmentPath(id, EVENTLOG_INDEX_EXT).c_str(), "rb");
+	if(f == NULL) return false;
+
+	u8 header[8];
+	fseek(f, 0, SEEK_END);
+	long fileSize = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if(fileSize < 8 || fread(header, 1, 8, f) != 8 || eventlog_get_uint(header, 4) != EVENTLOG_INDEX_MAGIC) {
+		fclose(f);
+		return false;
+	}
+
+	keys.resize(fileSize - 8);
+	bool ok = fread(keys.data(), 1, keys.size(), f) == keys.size();
+	fclose(f);
+	return ok && eventlog_count_keys(keys) == eventlog_get_uint(header + 4, 4);
+}
+
+/**
+ * @brief Save the keys of the newest segment in its index file
+ * @param segment Newest segment
+ * @note Called with the log locked. A failure only makes the next opening slower.
+ */
+void EventLog::writeKeys(const EventLogSegment &segment) {
+
+	if(eventlog_count_keys(this->tailKeys) != segment.nRecords) return;
+
+	std::string keysPath = this->getSegmentPath(segment.id, EVENTLOG_INDEX_EXT);
+	FILE *f = fopen(keysPath.c_str(), "wb");
+	if(f == NULL) return;
+
+	std::vector<u8> header;
+	eventlog_put_uint(header, EVENTLOG_INDEX_MAGIC, 4);
+	eventlog_put_uint(header, segment.nRecords, 4);
+	bool ok = fwrite(header.data(), 1, header.size(), f) == header.size() &&
+		fwrite(this->tailKeys.data(), 1, this->tailKeys.size(), f) == this->tailKeys.size();
+	if(fclose(f) != 0 || !ok) {
+		remove(keysPath.c_str());
+	}
+}
+
+/**
+ * @brief Read the records of a segment file
+ * @param id		Segment file number
+ * @param isTail	If it is the newest segment, whose records are checked and whose broken end is cut
+ * @param useKeys	If the keys can be taken from the index file, instead of decoding the records
+ * @param segment	Read segment (output)
+ * @param keys		Keys of the records (output)
+ * @return false if the file is not a segment
+ */
+bool EventLog::scanSegment(u32 id, bool isTail, bool useKeys, EventLogSegment &segment, std::vector<u8> &keys) {
+
+	std::string segmentPath = this->getSegmentPath(id);
+	FILE *f = fopen(segmentPath.c_str(), "rb");
+	if(f == NULL) return false;
+
+	u8 header[EVENTLOG_HEADER_SIZE];
+	if(fread(header, 1, EVENTLOG_HEADER_SIZE, f) != EVENTLOG_HEADER_SIZE || eventlog_get_uint(header, 4) != EVENTLOG_MAGIC) {
+		fclose(f);
+		return false;
+	}
+
+	fseek(f, 0, SEEK_END);
+	u32 fileSize = ftell(f);
+	fseek(f, EVENTLOG_HEADER_SIZE, SEEK_SET);
+
+	segment.id = id;
+	segment.firstIndex = eventlog_get_uint(header + 4, 4);
+	segment.nRecords = 0;
+	segment.size = EVENTLOG_HEADER_SIZE;
+	segment.checkpoints.clear();
+
+	// The newest segment has no index file yet
+	keys.clear();
+	bool decode = isTail || !useKeys || !this->readKeys(id, keys);
+	if(decode) keys.clear();
+
+	// Walk the records, stopping at the first one that does not fit
+	EventLogRecord record;
+	u8 recordHeader[EVENTLOG_RECORD_HEADER_SIZE];
+	while(segment.size + EVENTLOG_RECORD_HEADER_SIZE <= fileSize) {
+		if(fread(recordHeader, 1, EVENTLOG_RECORD_HEADER_SIZE, f) != EVENTLOG_RECORD_HEADER_SIZE) break;
+		u32 length = eventlog_get_uint(recordHeader, 4);
+		if(length < EVENTLOG_MIN_PAYLOAD_SIZE || length > EVENTLOG_MAX_RECORD_SIZE ||
+			segment.size + EVENTLOG_RECORD_HEADER_SIZE + length > fileSize) break;
+
+		if(decode) {
+			this->buffer.resize(length);
+			if(fread(this->buffer.data(), 1, length, f) != length) break;
+			if(isTail && EventLog::checksum(this->buffer.data(), length) != eventlog_get_uint(recordHeader + 4, 4)) break;
+			if(!EventLog::decode(this->buffer.data(), length, record)) {
+				record.time = 0;				// Still counted, without keys
+				record.source = 0;
+				record.keys.clear();
+			}
+			eventlog_put_keys(keys, record);
+		} else if(fseek(f, length, SEEK_CUR) != 0) {
+			break;
+		}
+
+		if(segment.nRecords % EVENTLOG_CHECKPOINT_STRIDE == 0) {
+			segment.checkpoints.push_back(segment.size);
+		}
+		segment.size += EVENTLOG_RECORD_HEADER_SIZE + length;
+		segment.nRecords++;
+	}
+	fclose(f);
+
+	// An index file not matching its segment is rebuilt
+	if(!decode && eventlog_count_keys(keys) != segment.nRecords) {
+		remove(this->getSegmentPath(id, EVENTLOG_INDEX_EXT).c_str());
+		return this->scanSegment(id, isTail, false, segment, keys);
+	}
+
+	// Drop what a crash left after the last complete record
+	if(isTail && segment.size < fileSize) {
+		f = fopen(segmentPath.c_str(), "r+b");
+		if(f == NULL || ftruncate(fileno(f), segment.size) != 0) {
+			if(f) fclose(f);
+			throw std::runtime_error("Couldn't recover " + segmentPath);
+		}
+		fclose(f);
+	}
+
+	return true;
+}
+
+/**
+ * @brief Add the records of a segment to the index
+ * @param segment	Segment
+ * @param keys		Keys of its records, see eventlog_put_keys()
+ */
+void EventLog::indexSegment(const EventLogSegment &segment, const std::vector<u8> &keys) {
+
+	u64 hashes[256];
+	u32 pos = 0;
+	for(u32 i = 0; i < segment.nRecords && pos + 9 <= keys.size(); i++) {
+		u64 time = eventlog_get_uint(keys.data() + pos, 8);
+		u32 nHashes = keys[pos + 8];
+		pos += 9;
+		for(u32 j = 0; j < nHashes; j++, pos += 8) {
+			hashes[j] = eventlog_get_uint(keys.data() + pos, 8);
+		}
+		this->index.add(segment.firstIndex + i, time, hashes, nHashes);
+	}
+}
+
+/**
+ * @brief Open the segments in the log directory, creating it if needed
+ * @note The index is rebuilt from the index files of the segments, and the newest segment is decoded
+ */
+void EventLog::open() {
+
+	this->close();
+	mkdir(this->path.c_str(), 0777);
+	DIR *dir = opendir(this->path.c_str());
+	if(dir == NULL) {
+		throw std::runtime_error("Couldn't open " + this->path);
+	}
+
+	// Find the segment files
+	std::vector<u32> ids;
+	struct dirent *entry;
+	u32 extLength = strlen(EVENTLOG_SEGMENT_EXT);
+	while((entry = readdir(dir)) != NULL) {
+		const char *name = entry->d_name;
+		if(strlen(name) != 8 + extLength || strcmp(name + 8, EVENTLOG_SEGMENT_EXT) != 0) continue;
+		char *numberEnd;
+		u32 id = strtoul(name, &numberEnd, 16);
+		if(numberEnd == name + 8) ids.push_back(id);
+	}
+	closedir(dir);
+	std::sort(ids.begin(), ids.end());
+
+	LightLock_Lock(&this->lock);
+	try {
+		this->segments.clear();
+		this->index.clear();
+		this->tailKeys.clear();
+		this->nBytes = 0;
+		for(u32 i = 0; i < ids.size(); i++) {
+			EventLogSegment segment;
+			std::vector<u8> keys;
+			if(!this->scanSegment(ids[i], i == ids.size() - 1, true, segment, keys)) {
+				remove(this->getSegmentPath(ids[i]).c_str());		// Created by a rotation that did not finish
+				remove(this->getSegmentPath(ids[i], EVENTLOG_INDEX_EXT).c_str());
+				continue;
+			}
+			this->nBytes += segment.size;
+			this->segments.push_back(segment);
+			this->indexSegment(segment, keys);
+			this->tailKeys.swap(keys);
+		}
+		this->end = this->segments.empty() ? 0 : this->segments.back().firstIndex + this->segments.back().nRecords;
+		this->flushedEnd = this->end;
+		this->resumeTail = true;
+	} catch (const std::runtime_error &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	} catch (const std::bad_alloc &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	}
+	LightLock_Unlock(&this->lock);
+}
+
+/**
+ * @brief Flush and close the newest segment
+ */
+void EventLog::close() {
+	if(this->tail == NULL) return;
+	this->flush();
+	fclose(this->tail);
+	this->tail = NULL;
+}
+
+/**
+ * @brief Open the newest segment for appending, starting a new one if it is full
+ * @note Called with the log locked
+ */
+void EventLog::openSegment() {
+
+	u32 segmentRecords = (this->maxRecords + EVENTLOG_MIN_SEGMENTS - 1) / EVENTLOG_MIN_SEGMENTS;
+	if(!this->segments.empty()) {
+		EventLogSegment &last = this->segments.back();
+		if(this->tail == NULL && this->resumeTail && last.size < this->segmentBytes && last.nRecords < segmentRecords) {
+			this->resumeTail = false;
+			this->tail = fopen(this->getSegmentPath(last.id).c_str(), "ab");
+			if(this->tail != NULL) return;
+		}
+	}
+	this->resumeTail = false;
+
+	if(this->tail != NULL) {
+		fflush(this->tail);
+		fclose(this->tail);
+		this->tail = NULL;
+	}
+	if(!this->segments.empty()) {
+		this->writeKeys(this->segments.back());
+	}
+	this->tailKeys.clear();
+
+	// Start a new segment, after the last one
+	EventLogSegment segment;
+	segment.id = this->segments.empty() ? 0 : this->segments.back().id + 1;
+	segment.firstIndex = this->end;
+	segment.nRecords = 0;
+	segment.size = EVENTLOG_HEADER_SIZE;
+
+	std::string segmentPath = this->getSegmentPath(segment.id);
+	this->tail = fopen(segmentPath.c_str(), "wb");
+	if(this->tail == NULL) {
+		throw std::runtime_error("Couldn't create " + segmentPath);
+	}
+
+	std::vector<u8> header;
+	eventlog_put_uint(header, EVENTLOG_MAGIC, 4);
+	eventlog_put_uint(header, segment.firstIndex, 4);
+	if(fwrite(header.data(), 1, EVENTLOG_HEADER_SIZE, this->tail) != EVENTLOG_HEADER_SIZE) {
+		fclose(this->tail);
+		this->tail = NULL;
+		remove(segmentPath.c_str());
+		throw std::runtime_error("Couldn't write " + segmentPath);
+	}
+
+	this->nBytes += segment.size;
+	this->segments.push_back(segment);
+}
+
+/**
+ * @brief Delete the oldest segments that are not needed to keep the retention
+ * @note Called with the log locked. A segment still open by a reader is deleted on a later append.
+ */
+void EventLog::trim() {
+	bool trimmed = false;
+	while(this->segments.size() > 1) {
+		EventLogSegment &oldest = this->segments.front();
+		bool tooMany = (this->end - oldest.firstIndex) - oldest.nRecords >= this->maxRecords;
+		bool tooBig = this->nBytes > this->maxBytes;
+		if(!tooMany && !tooBig) break;
+		if(remove(this->getSegmentPath(oldest.id).c_str()) != 0 && errno != ENOENT) break;
+		remove(this->getSegmentPath(oldest.id, EVENTLOG_INDEX_EXT).c_str());
+		this->nBytes -= oldest.size;
+		this->segments.pop_front();
+		trimmed = true;
+	}
+	if(trimmed) {
+		this->index.prune(this->segments.front().firstIndex);
+	}
+}
+
+/**
+ * @brief Append a record
+ * @param record Record to append
+ * @return Index of the record
+ * @note It can not be read until the next flush()
+ */
+u32 EventLog::append(const EventLogRecord &record) {
+
+	u32 size = EventLog::encode(record, this->buffer);
+	if(size > EVENTLOG_RECORD_HEADER_SIZE + EVENTLOG_MAX_RECORD_SIZE) {
+		throw std::runtime_error("Log record too long");
+	}
+	u64 hashes[EVENTLOG_MAX_KEYS + 1];
+	u32 nHashes = EventLog::hashKeys(record.source, record.keys, hashes);
+
+	LightLock_Lock(&this->lock);
+	try {
+		u32 segmentRecords = (this->maxRecords + EVENTLOG_MIN_SEGMENTS - 1) / EVENTLOG_MIN_SEGMENTS;
+		if(this->tail == NULL || this->segments.empty() || (this->segments.back().nRecords != 0 &&
+			(this->segments.back().size + size > this->segmentBytes || this->segments.back().nRecords >= segmentRecords))) {
+			this->openSegment();
+		}
+
+		EventLogSegment &segment = this->segments.back();
+		if(fwrite(this->buffer.data(), 1, size, this->tail) != size) {
+
+			// The rest of this segment would be cut when opened, so continue on a new one
+			fclose(this->tail);
+			this->tail = NULL;
+			throw std::runtime_error("Couldn't append to " + this->path);
+		}
+
+		if(segment.nRecords % EVENTLOG_CHECKPOINT_STRIDE == 0) {
+			segment.checkpoints.push_back(segment.size);
+		}
+		segment.size += size;
+		segment.nRecords++;
+		this->nBytes += size;
+		this->end++;
+		eventlog_put_keys(this->tailKeys, record);
+		this->index.add(this->end - 1, record.time, hashes, nHashes);
+		this->trim();
+	} catch (const std::runtime_error &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	} catch (const std::bad_alloc &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	}
+	u32 index = this->end - 1;
+	LightLock_Unlock(&this->lock);
+	return index;
+}
+
+/**
+ * @brief Write the appended records to the file, and let them be read
+ */
+void EventLog::flush() {
+	if(this->tail != NULL) {
+		fflush(this->tail);
+	}
+	LightLock_Lock(&this->lock);
+	this->flushedEnd = this->end;
+	LightLock_Unlock(&this->lock);
+}
+
+/**
+ * @brief Change how many records are kept
+ * @param maxRecords Records kept, at least
+ * @note Old segments are deleted on the next append
+ */
+void EventLog::setMaxRecords(u32 maxRecords) {
+	LightLock_Lock(&this->lock);
+	this->maxRecords = (maxRecords != 0) ? maxRecords : 1;
+	LightLock_Unlock(&this->lock);
+}
+
+/**
+ * @brief Get the index of the oldest readable record
+ * @return The index, equal to getEnd() if the log is empty
+ * @note Segments are deleted as a whole, so older records may still be stored past maxRecords
+ */
+u32 EventLog::getBegin() {
+	LightLock_Lock(&this->lock);
+	u32 begin = this->getFirstIndex();
+	LightLock_Unlock(&this->lock);
+	return begin;
+}
+
+/**
+ * @brief Get the index of the oldest readable record
+ * @return The index
+ * @note Called with the log locked
+ */
+u32 EventLog::getFirstIndex() {
+	u32 begin = this->segments.empty() ? this->flushedEnd : this->segments.front().firstIndex;
+	if(this->flushedEnd - begin > this->maxRecords) {
+		begin = this->flushedEnd - this->maxRecords;
+	}
+	return begin;
+}
+
+/**
+ * @brief Get the index after the newest readable record
+ * @return The index
+ */
+u32 EventLog::getEnd() {
+	LightLock_Lock(&this->lock);
+	u32 end = this->flushedEnd;
+	LightLock_Unlock(&this->lock);
+	return end;
+}
+
+/**
+ * @brief Find where a record is stored
+ * @param index			Record index
+ * @param segmentPath	Segment file (output)
+ * @param offset		Offset of the closest previous checkpoint (output)
+ * @param skip			Records between the checkpoint and the record (output)
+ * @param segmentEnd	Index after the last readable record of the segment (output)
+ * @return false if the record is not stored or not flushed
+ */
+bool EventLog::locate(u32 index, std::string &segmentPath, u32 *offset, u32 *skip, u32 *segmentEnd) {
+
+	LightLock_Lock(&this->lock);
+	if(this->segments.empty() || index >= this->flushedEnd || index < this->segments.front().firstIndex) {
+		LightLock_Unlock(&this->lock);
+		return false;
+	}
+
+	// Last segment starting at or before the index
+	u32 lo = 0, hi = this->segments.size();
+	while(hi - lo > 1) {
+		u32 mid = (lo + hi) / 2;
+		if(this->segments[mid].firstIndex <= index) lo = mid;
+		else hi = mid;
+	}
+
+	const EventLogSegment &segment = this->segments[lo];
+	u32 position = index - segment.firstIndex;
+	if(position >= segment.nRecords) {
+		LightLock_Unlock(&this->lock);
+		return false;
+	}
+
+	segmentPath = this->getSegmentPath(segment.id);
+	*offset = segment.checkpoints[position / EVENTLOG_CHECKPOINT_STRIDE];
+	*skip = position % EVENTLOG_CHECKPOINT_STRIDE;
+	*segmentEnd = std::min(segment.firstIndex + segment.nRecords, this->flushedEnd);
+	LightLock_Unlock(&this->lock);
+	return true;
+}
+
+/**
+ * @brief Find the readable records matching a filter, newest first
+ * @param filter	Filter
+ * @param begin		Oldest record to look at
+ * @param end		Index after the newest record to look at
+ * @param skip		Newest matching records to skip, for paging
+ * @param count		Matching records to return, at most
+ * @param indexes	Indexes of the matching records (output)
+ * @return The number of records returned
+ * @note Only the index is read, so the cost depends on the number of records having the filter keys,
+ *       and not on the log size. Reading the returned records is left to an EventLogIterator.
+ */
+u32 EventLog::query(const EventLogFilter &filter, u32 begin, u32 end, u32 skip, u32 count, std::vector<u32> &indexes) {
+
+	if(filter.keys.size() > EVENTLOG_MAX_KEYS) {
+		indexes.clear();
+		return 0;		// No record has that many keys
+	}
+	u64 hashes[EVENTLOG_MAX_KEYS + 1];
+	u32 nHashes = EventLog::hashKeys(filter.source, filter.keys, hashes);
+
+	LightLock_Lock(&this->lock);
+	u32 n = 0;
+	try {
+		begin = std::max(begin, this->getFirstIndex());
+		end = std::min(end, this->flushedEnd);
+		if(filter.fromTime != 0) begin = std::max(begin, this->index.findTime(filter.fromTime));
+		if(filter.toTime != 0) end = std::min(end, this->index.findTime(filter.toTime + EVENTINDEX_BUCKET_MS));
+		n = this->index.query(hashes, nHashes, begin, end, skip, count, indexes);
+	} catch (const std::bad_alloc &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	}
+	LightLock_Unlock(&this->lock);
+	return n;
+}
+
+/**
+ * @brief Encode a record, header included
+ * @param record	Record to encode
+ * @param data		Encoded record (output)
+ * @return The encoded size
+ */
+u32 EventLog::encode(const EventLogRecord &record, std::vector<u8> &data) {
+
+	data.clear();
+	data.resize(EVENTLOG_RECORD_HEADER_SIZE);
+	eventlog_put_uint(data, record.type, 1);
+	eventlog_put_uint(data, record.time, 8);
+	eventlog_put_uint(data, record.source, 4);
+	eventlog_put_uint(data, record.fields.size() + 1, 2);
+	eventlog_put_string(data, record.name);
+	for(u32 i = 0; i < record.fields.size(); i++) {
+		eventlog_put_string(data, record.fields[i]);
+	}
+	u32 nKeys = std::min<u32>(record.keys.size(), EVENTLOG_MAX_KEYS);
+	eventlog_put_uint(data, nKeys, 1);
+	for(u32 i = 0; i < nKeys; i++) {
+		eventlog_put_uint(data, record.keys[i].kind, 1);
+		eventlog_put_string(data, record.keys[i].value);
+	}
+
+	// Fill the header
+	u32 length = data.size() - EVENTLOG_RECORD_HEADER_SIZE;
+	u32 sum = EventLog::checksum(data.data() + EVENTLOG_RECORD_HEADER_SIZE, length);
+	for(u32 i = 0; i < 4; i++) {
+		data[i] = (length >> (i * 8)) & 0xFF;
+		data[4 + i] = (sum >> (i * 8)) & 0xFF;
+	}
+	return data.size();
+}
+
+/**
+ * @brief Decode the payload of a record
+ * @param data		Payload
+ * @param size		Payload size
+ * @param record	Decoded record (output)
+ * @return false if the payload is malformed
+ */
+bool EventLog::decode(const u8 *data, u32 size, EventLogRecord &record) {
+
+	if(size < EVENTLOG_MIN_PAYLOAD_SIZE) return false;
+	record.type = data[0];
+	record.time = eventlog_get_uint(data + 1, 8);
+	record.source = eventlog_get_uint(data + 9, 4);
+	u32 nStrings = eventlog_get_uint(data + 13, 2);
+	record.fields.clear();
+	record.keys.clear();
+
+	u32 pos = EVENTLOG_MIN_PAYLOAD_SIZE;
+	for(u32 i = 0; i < nStrings; i++) {
+		if(pos + 2 > size) return false;
+		u32 length = eventlog_get_uint(data + pos, 2);
+		pos += 2;
+		if(pos + length > size) return false;
+		if(i == 0) {
+			record.name.assign((const char*)data + pos, length);
+		} else {
+			record.fields.push_back(std::string((const char*)data + pos, length));
+		}
+		pos += length;
+	}
+
+	// Keys, missing in the records of older versions
+	if(pos < size) {
+		u32 nKeys = data[pos++];
+		for(u32 i = 0; i < nKeys; i++) {
+			if(pos + 3 > size) return false;
+			EventLogKey key;
+			key.kind = data[pos];
+			u32 length = eventlog_get_uint(data + pos + 1, 2);
+			pos += 3;
+			if(pos + length > size) return false;
+			key.value.assign((const char*)data + pos, length);
+			record.keys.push_back(key);
+			pos += length;
+		}
+	}
+	return nStrings != 0;
+}
+
+/**
+ * @brief Checksum of a record payload (64-bit FNV-1a, folded)
+ * @param data Payload
+ * @param size Payload size
+ * @return The checksum
+ */
+u32 EventLog::checksum(const u8 *data, u32 size) {
+	u64 hash = EventIndex::hashBytes(EVENTINDEX_HASH_BASIS, data, size);
+	return (u32)(hash ^ (hash >> 32));
+}
+
+/**
+ * @brief Get the index keys of a record
+ * @param source	Sender IP, or 0
+ * @param keys		Record keys, only the first EVENTLOG_MAX_KEYS are used
+ * @param hashes	Keys for the EventIndex, EVENTLOG_MAX_KEYS + 1 at most (output)
+ * @return The number of keys
+ */
+u32 EventLog::hashKeys(in_addr_t source, const std::vector<EventLogKey> &keys, u64 *hashes) {
+	u32 n = 0;
+	if(source != 0) {
+		hashes[n++] = EventIndex::hash(EVENTLOG_KEY_SOURCE, &source, sizeof(source));
+	}
+	for(u32 i = 0; i < keys.size() && i < EVENTLOG_MAX_KEYS; i++) {
+		hashes[n++] = EventIndex::hash(keys[i].kind, keys[i].value.data(), keys[i].value.size());
+	}
+	return n;
+}
+
+/**
+ * @brief Constructor for an EventLogIterator
+ * @param log	Log to read
+ * @param index	Index of the first record to read
+ */
+EventLogIterator::EventLogIterator(std::shared_ptr<EventLog> log, u32 index) {
+	this->log = log;
+	this->file = NULL;
+	this->index = index;
+	this->segmentEnd = index;
+}
+
+/**
+ * @brief Destructor for an EventLogIterator
+ */
+EventLogIterator::~EventLogIterator() {
+	this->closeFile();
+}
+
+/**
+ * @brief Close the segment being read
+ */
+void EventLogIterator::closeFile() {
+	if(this->file == NULL) return;
+	fclose(this->file);
+	this->file = NULL;
+}
+
+/**
+ * @brief Skip records of the open segment
+ * @param nRecords Records to skip
+ * @return false if the file could not be read
+ */
+bool EventLogIterator::skip(u32 nRecords) {
+	u8 header[EVENTLOG_RECORD_HEADER_SIZE];
+	for(u32 i = 0; i < nRecords; i++) {
+		if(fread(header, 1, EVENTLOG_RECORD_HEADER_SIZE, this->file) != EVENTLOG_RECORD_HEADER_SIZE ||
+			fseek(this->file, eventlog_get_uint(header, 4), SEEK_CUR) != 0) {
+			this->closeFile();
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Move to another record
+ * @param index Index of the next record to read
+ * @note A record a few ahead in the open segment is reached without reopening it, as when reading query results
+ */
+void EventLogIterator::seek(u32 index) {
+	if(index == this->index) return;
+	if(this->file != NULL && index > this->index && index < this->segmentEnd && index - this->index < EVENTLOG_CHECKPOINT_STRIDE) {
+		if(this->skip(index - this->index)) {
+			this->index = index;
+			return;
+		}
+	}
+	this->closeFile();
+	this->index = index;
+}
+
+/**
+ * @brief Read the next record
+ * @param record Read record (output)
+ * @return false at the end of the log, or if the record is no longer stored
+ */
+bool EventLogIterator::next(EventLogRecord &record) {
+
+	u8 header[EVENTLOG_RECORD_HEADER_SIZE];
+
+	// Open the segment of the record, going to its closest checkpoint
+	if(this->file == NULL || this->index >= this->segmentEnd) {
+		this->closeFile();
+		std::string segmentPath;
+		u32 offset, skip;
+		if(!this->log->locate(this->index, segmentPath, &offset, &skip, &this->segmentEnd)) return false;
+		this->file = fopen(segmentPath.c_str(), "rb");
+		if(this->file == NULL) return false;
+		if(fseek(this->file, offset, SEEK_SET) != 0) {
+			this->closeFile();
+			return false;
+		}
+		if(!this->skip(skip)) return false;
+	}
+
+	// Read it
+	if(fread(header, 1, EVENTLOG_RECORD_HEADER_SIZE, this->file) != EVENTLOG_RECORD_HEADER_SIZE) {
+		this->closeFile();
+		return false;
+	}
+	u32 length = eventlog_get_uint(header, 4);
+	if(length > EVENTLOG_MAX_RECORD_SIZE) {
+		this->closeFile();
+		return false;
+	}
+	this->buffer.resize(length);
+	if(fread(this->buffer.data(), 1, length, this->file) != length ||
+		EventLog::checksum(this->buffer.data(), length) != eventlog_get_uint(header + 4, 4) ||
+		!EventLog::decode(this->buffer.data(), length, record)) {
+		this->closeFile();
+		return false;
+	}
+
+	this->index++;
+	return true;
+}
+
+}
@@ -0,0 +1,591 @@
+/**
+ * @file NotificationReceiver.cpp
+ * @brief Reception of traps and syslogs
+ */
+
+// Includes C/C++
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <stdexcept>
+#include <sys/select.h>
+
+// Own includes
+#include "notify/NotificationReceiver.h"
+#include "Config.h"
+#include "Utils.h"
+
+namespace NetMan {
+
+/**
+ * @brief Print an osGetTime() time as getCurrentTime() does
+ * @param time Time, in ms since 1900
+ * @return The time of the day, in UTC
+ */
+static std::string notify_print_time(u64 time) {
+	unsigned int seconds = (time / 1000) % 86400;
+	char text[16];
+	snprintf(text, sizeof(text), "[%02u:%02u:%02u]", seconds / 3600, (seconds / 60) % 60, seconds % 60);
+	return std::string(text);
+}
+
+/**
+ * @brief Constructor for a NotificationReceiver
+ * @param trapv1Sock	SNMPv1 trap socket, or nullptr
+ * @param trapv2Sock	SNMPv2 trap socket, or nullptr
+ * @param trapv3Sock	SNMPv3 trap socket, or nullptr
+ * @param syslogUdpSock	Syslog UDP socket, or nullptr
+ * @param syslogTcpSock	Syslog TCP listening socket, or nullptr
+ * @note The sockets must not wait on reception, see UdpSocket(0). The logs are opened here.
+ */
+NotificationReceiver::NotificationReceiver(std::shared_ptr<UdpSocket> trapv1Sock, std::shared_ptr<UdpSocket> trapv2Sock, std::shared_ptr<UdpSocket> trapv3Sock,
+	std::shared_ptr<UdpSocket> syslogUdpSock, std::shared_ptr<TcpSocket> syslogTcpSock) {
+	this->trapv1Sock = trapv1Sock;
+	this->trapv2Sock = trapv2Sock;
+	this->trapv3Sock = trapv3Sock;
+	this->syslogUdpSock = syslogUdpSock;
+	this->syslogTcpSock = syslogTcpSock;
+	this->thread = NULL;
+
+	auto& configData = Config::getInstance().getData();
+	try {
+		this->trapLog = std::make_shared<EventLog>(NOTIFY_TRAPLOG_PATH, configData.trapLimit);
+		this->syslogLog = std::make_shared<EventLog>(NOTIFY_SYSLOG_PATH, configData.syslogLimit);
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+	this->rules = std::make_shared<TrapRuleSet>();
+	this->running = false;
+	this->nReceived = 0;
+	this->lastSweep = 0;
+}
+
+/**
+ * @brief Destructor for a NotificationReceiver
+ */
+NotificationReceiver::~NotificationReceiver() {
+	this->stop();
+}
+
+/**
+ * @brief Hand the summary of an event to the UI
+ * @param type		Event type
+ * @param source	Sender IP
+ * @param text		Summary, after the reception time
+ */
+void NotificationReceiver::publish(u8 type, in_addr_t source, const char *text) {
+	NotificationEvent event;
+	event.type = type;
+	event.time = osGetTime();
+	event.source = source;
+	snprintf(event.summary, NOTIFY_SUMMARY_SIZE, "%s: %s", Utils::getCurrentTime().c_str(), text);
+	this->events.push(event);
+	this->nReceived++;
+}
+
+/**
+ * @brief Add a key to the next stored event
+ * @param kind	EVENTLOG_KEY_*
+ * @param value	Key value
+ */
+void NotificationReceiver::addKey(u8 kind, const std::string &value) {
+	EventLogKey key;
+	key.kind = kind;
+	key.value = value;
+	this->record.keys.push_back(key);
+}
+
+/**
+ * @brief Set the keys of the next stored event to a trap OID and enterprise
+ * @param trapOid		snmpTrapOID.0 value
+ * @param enterprise	Trap enterprise
+ */
+void NotificationReceiver::setTrapKeys(const CompactOid &trapOid, const CompactOid &enterprise) {
+	this->record.keys.clear();
+	this->addKey(EVENTLOG_KEY_TRAPOID, std::string((const char*)trapOid.getData(), trapOid.getLength()));
+	this->addKey(EVENTLOG_KEY_ENTERPRISE, std::string((const char*)enterprise.getData(), enterprise.getLength()));
+}
+
+/**
+ * @brief Set the keys of the next stored event to the ones of the received syslog
+ * @note Missing APP-NAME and MSGID are not indexed
+ */
+void NotificationReceiver::setSyslogKeys() {
+	this->record.keys.clear();
+	this->addKey(EVENTLOG_KEY_FACILITY, std::to_string(this->syslogPdu->getFacility()));
+	this->addKey(EVENTLOG_KEY_SEVERITY, std::to_string(this->syslogPdu->getSeverity()));
+	if(this->syslogPdu->getAppName() != "-") {
+		this->addKey(EVENTLOG_KEY_APPNAME, this->syslogPdu->getAppName());
+	}
+	if(this->syslogPdu->getMsgId() != "-") {
+		this->addKey(EVENTLOG_KEY_MSGID, this->syslogPdu->getMsgId());
+	}
+}
+
+/**
+ * @brief Append the next stored event to a log
+ * @param log		Trap or syslog log
+ * @param type		Event type
+ * @param source	Sender IP
+ * @param name		Log name, after the reception time
+ * @note The fields and keys added since the last call are stored with it, and indexed.
+ *       A failed write only loses the event, it is still shown.
+ */
+void NotificationReceiver::appendRecord(std::shared_ptr<EventLog> log, u8 type, in_addr_t source, const char *name) {
+
+	this->record.type = type;
+	this->record.time = osGetTime();
+	this->record.source = source;
+	this->record.name = Utils::getCurrentTime() + " " + name;
+
+	try {
+		log->append(this->record);
+	} catch (const std::runtime_error &e) { }
+	this->record.fields.clear();
+	this->record.keys.clear();
+}
+
+/**
+ * @brief Append an event to a log
+ * @param log		Trap or syslog log
+ * @param json		Serialized PDU, whose "data" strings are stored
+ * @param type		Event type
+ * @param source	Sender IP
+ * @param name		Log name, after the reception time
+ * @note The fields are added after the ones already set, like the tags
+ */
+void NotificationReceiver::store(std::shared_ptr<EventLog> log, std::shared_ptr<json_t> json, u8 type, in_addr_t source, const char *name) {
+
+	json_t *data = json_object_get(json.get(), "data");
+	for(u32 i = 0; i < json_array_size(data); i++) {
+		const char *field = json_string_value(json_array_get(data, i));
+		if(field) this->record.fields.push_back(field);
+	}
+	this->appendRecord(log, type, source, name);
+}
+
+/**
+ * @brief Decide if a received trap is stored and shown
+ * @param source	Sender IP
+ * @param trapOid	snmpTrapOID.0 value, or empty
+ * @param varBinds	Trap VarBinds
+ * @param nVarBinds	Number of VarBinds
+ * @return false if it is a repeat or its source is over its rate
+ * @note It is called before serializing the trap, so suppressed traps are only decoded.
+ *       The first trap dropped from a source is shown as a storm warning.
+ */
+bool NotificationReceiver::admitTrap(in_addr_t source, const CompactOid &trapOid, const SnmpVarBind *varBinds, u32 nVarBinds) {
+
+	TrapVerdict verdict = this->dedup.check(source, trapOid, varBinds, nVarBinds, osGetTime());
+	if(verdict == TRAP_LIMIT_TRIPPED) {
+		struct in_addr addr;
+		addr.s_addr = source;
+		char text[NOTIFY_SUMMARY_SIZE];
+		snprintf(text, NOTIFY_SUMMARY_SIZE, "Trap storm from %s!", inet_ntoa(addr));
+		this->publish(NOTIFY_TRAP_SUMMARY, source, text);
+	}
+	return verdict == TRAP_ACCEPT;
+}
+
+/**
+ * @brief Get the log of a route rule, opening it if needed
+ * @param name Log name
+ * @return The log, or the trap log if it can't be opened
+ * @note loadRules() opens the logs of every route rule, so the map is not changed while the thread runs
+ */
+std::shared_ptr<EventLog> NotificationReceiver::getRouteLog(const std::string &name) {
+
+	auto it = this->routeLogs.find(name);
+	if(it != this->routeLogs.end()) return it->second;
+
+	std::shared_ptr<EventLog> log;
+	try {
+		log = std::make_shared<EventLog>(NOTIFY_ROUTELOG_PREFIX + name, Config::getInstance().getData().trapLimit);
+	} catch (const std::runtime_error &e) {
+		log = this->trapLog;		// Not retried on every trap
+	}
+	this->routeLogs[name] = log;
+	return log;
+}
+
+/**
+ * @brief Find the log of a route rule
+ * @param name Log name
+ * @return The log, or nullptr if no rule routes traps to it
+ * @note It can be called from the UI, as the route logs are opened by start() before the thread
+ */
+std::shared_ptr<EventLog> NotificationReceiver::findRouteLog(const std::string &name) {
+	auto it = this->routeLogs.find(name);
+	return (it != this->routeLogs.end()) ? it->second : nullptr;
+}
+
+/**
+ * @brief Get the names of the route logs
+ * @return Log names, sorted
+ */
+std::vector<std::string> NotificationReceiver::getRouteLogNames() {
+	std::vector<std::string> names;
+	for(auto it = this->routeLogs.begin(); it != this->routeLogs.end(); ++it) {
+		names.push_back(it->first);
+	}
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+/**
+ * @brief Apply the rules and the deduplicator to a received trap
+ * @param source		Sender IP
+ * @param hasTrapOid	If the trap OID and enterprise were found
+ * @param trapOid		snmpTrapOID.0 value
+ * @param enterprise	Trap enterprise
+ * @param varBinds		Trap VarBinds
+ * @param nVarBinds		Number of VarBinds
+ * @return The log to store the trap in, or nullptr to drop it
+ * @note The keys and tags of the trap are set for store(), and the matched alerts kept for publishTrap()
+ */
+std::shared_ptr<EventLog> NotificationReceiver::routeTrap(in_addr_t source, bool hasTrapOid, const CompactOid &trapOid, const CompactOid &enterprise,
+	const SnmpVarBind *varBinds, u32 nVarBinds) {
+
+	this->rules->match(source, trapOid, enterprise, varBinds, nVarBinds, this->ruleMatch);
+	if(this->ruleMatch.drop) return nullptr;
+	if(!this->admitTrap(source, trapOid, varBinds, nVarBinds)) return nullptr;
+
+	if(hasTrapOid) {
+		this->setTrapKeys(trapOid, enterprise);
+	}
+	if(!this->ruleMatch.tags.empty()) {
+		std::string tags = "Tags:";
+		for(u32 i = 0; i < this->ruleMatch.tags.size(); i++) {
+			this->addKey(EVENTLOG_KEY_TAG, this->ruleMatch.tags[i]->argument);
+			tags += " " + this->ruleMatch.tags[i]->argument;
+		}
+		this->record.fields.push_back(tags);
+	}
+	return (this->ruleMatch.route != NULL) ? this->getRouteLog(this->ruleMatch.route->argument) : this->trapLog;
+}
+
+/**
+ * @brief Hand the summary of a stored trap to the UI
+ * @param type		Event type
+ * @param source	Sender IP
+ * @param text		Summary, when no alert rule was matched
+ */
+void NotificationReceiver::publishTrap(u8 type, in_addr_t source, const char *text) {
+	if(this->ruleMatch.alerts.empty()) {
+		this->publish(type, source, text);
+	} else {
+		this->publish(NOTIFY_TRAP_ALERT, source, ("Alert: " + this->ruleMatch.alerts[0]->argument).c_str());
+	}
+}
+
+/**
+ * @brief Flush the trap log and the route logs
+ */
+void NotificationReceiver::flushTrapLogs() {
+	u32 trapLimit = Config::getInstance().getData().trapLimit;
+	for(auto it = this->routeLogs.begin(); it != this->routeLogs.end(); ++it) {
+		it->second->setMaxRecords(trapLimit);
+		it->second->flush();
+	}
+	this->trapLog->flush();
+}
+
+/**
+ * @brief Load and compile the trap rules, and open their route logs
+ * @note Without a rule file every trap is stored in the trap log
+ */
+void NotificationReceiver::loadRules() {
+
+	this->rules = std::make_shared<TrapRuleSet>();
+
+	FILE *f = fopen(NOTIFY_RULES_PATH, "rb");
+	if(f == NULL) return;
+	fclose(f);
+
+	json_error_t error;
+	auto root = std::shared_ptr<json_t>(json_load_file(NOTIFY_RULES_PATH, 0, &error), [=](json_t* data) { json_decref(data); });
+	if(root.get() == NULL) {
+		throw std::runtime_error(std::string("Bad trap rules: ") + error.text);
+	}
+
+	std::vector<TrapRule> ruleList;
+	try {
+		TrapRuleSet::parse(root.get(), ruleList);
+		this->rules = std::make_shared<TrapRuleSet>(ruleList);
+		for(u32 i = 0; i < ruleList.size(); i++) {
+			if(ruleList[i].action == TRAPRULE_ROUTE) {
+				this->getRouteLog(ruleList[i].argument);
+			}
+		}
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Store the pending summaries of suppressed traps
+ * @note They are not shown, the storm warning already was
+ */
+void NotificationReceiver::storeSummaries() {
+
+	TrapSummary summary;
+	bool stored = false;
+	while(this->dedup.popSummary(summary)) {
+		struct in_addr addr;
+		addr.s_addr = summary.source;
+		this->record.keys.clear();
+		this->record.fields.clear();
+		this->record.fields.push_back(std::string("Source: ") + inet_ntoa(addr));
+		if(summary.type == TRAPDEDUP_REPEATED) {
+			if(!summary.trapOid.isEmpty()) {
+				this->record.fields.push_back("Trap OID: " + summary.trapOid.print());
+				this->addKey(EVENTLOG_KEY_TRAPOID, std::string((const char*)summary.trapOid.getData(), summary.trapOid.getLength()));
+			}
+			this->record.fields.push_back("Repeats: " + std::to_string(summary.count));
+		} else {
+			this->record.fields.push_back("Rate limited: " + std::to_string(summary.count));
+		}
+		this->record.fields.push_back("First seen: " + notify_print_time(summary.firstSeen));
+		this->record.fields.push_back("Last seen: " + notify_print_time(summary.lastSeen));
+		this->appendRecord(this->trapLog, NOTIFY_TRAP_SUMMARY, summary.source, "Trap summary");
+		stored = true;
+	}
+	if(stored) this->trapLog->flush();
+}
+
+/**
+ * @brief Receive the pending SNMPv1 or SNMPv2 traps of a socket
+ * @param pdu	PDU used for decoding
+ * @param sock	Trap socket
+ * @param type	NOTIFY_TRAPV1 or NOTIFY_TRAPV2
+ * @note Informs whose acknowledgement could not be sent are dropped, the agent sends them again
+ */
+void NotificationReceiver::drainTraps(std::shared_ptr<Snmpv1Pdu> pdu, std::shared_ptr<UdpSocket> sock, u8 type) {
+
+	this->trapLog->setMaxRecords(Config::getInstance().getData().trapLimit);
+	for(u32 i = 0; i < NOTIFY_BATCH_SIZE; i++) {
+		try {
+			pdu->clear();
+			SnmpResult result = pdu->tryRecvTrap(sock);
+			if(result.status == SNMP_ERROR_TIMEOUT || result.status == SNMP_ERROR_RECV) break;
+			if(result.status != SNMP_OK) continue;		// Junk is dropped
+
+			CompactOid trapOid, enterprise;
+			bool hasTrapOid = pdu->getTrapOid(trapOid, enterprise);
+			std::shared_ptr<EventLog> log = this->routeTrap(sock->getLastOrigin(), hasTrapOid, trapOid, enterprise, pdu->getVarBinds(), pdu->getNVarBinds());
+			if(log == nullptr) continue;
+			if(type == NOTIFY_TRAPV1) {
+				this->store(log, pdu->serializeTrap(), type, sock->getLastOrigin(), "Trap V1");
+				this->publishTrap(type, sock->getLastOrigin(), "SNMPv1 trap received!");
+			} else {
+				this->store(log, pdu->serializeTrap(), type, sock->getLastOrigin(), "Trap V2");
+				this->publishTrap(type, sock->getLastOrigin(), "SNMPv2 trap received!");
+			}
+		} catch (const std::runtime_error &e) {
+			break;
+		}
+	}
+	this->flushTrapLogs();
+}
+
+/**
+ * @brief Receive the pending SNMPv3 traps and informs
+ * @note A malformed packet ends the batch, the rest are read on the next step
+ */
+void NotificationReceiver::drainTrapsv3() {
+
+	this->trapLog->setMaxRecords(Config::getInstance().getData().trapLimit);
+	for(u32 i = 0; i < NOTIFY_BATCH_SIZE; i++) {
+		try {
+			this->snmpv3Pdu->clear();
+			bool inform = this->snmpv3Pdu->recvTrap(this->trapv3Sock);
+			CompactOid trapOid, enterprise;
+			bool hasTrapOid = this->snmpv3Pdu->getTrapOid(trapOid, enterprise);
+			std::shared_ptr<EventLog> log = this->routeTrap(this->trapv3Sock->getLastOrigin(), hasTrapOid, trapOid, enterprise,
+				this->snmpv3Pdu->getVarBinds(), this->snmpv3Pdu->getNVarBinds());
+			if(log == nullptr) continue;
+			this->store(log, this->snmpv3Pdu->serializeTrap(), inform ? NOTIFY_INFORMV3 : NOTIFY_TRAPV3, this->trapv3Sock->getLastOrigin(), "Trap V3");
+			if(inform) {
+				this->publishTrap(NOTIFY_INFORMV3, this->trapv3Sock->getLastOrigin(), "SNMPv3 inform received!");
+			} else {
+				this->publishTrap(NOTIFY_TRAPV3, this->trapv3Sock->getLastOrigin(), "SNMPv3 trap received!");
+			}
+		} catch (const std::runtime_error &e) {
+			break;
+		}
+	}
+	this->flushTrapLogs();
+}
+
+/**
+ * @brief Receive the pending UDP syslogs
+ * @note A malformed packet ends the batch, the rest are read on the next step
+ */
+void NotificationReceiver::drainSyslogUdp() {
+
+	this->syslogLog->setMaxRecords(Config::getInstance().getData().syslogLimit);
+	for(u32 i = 0; i < NOTIFY_BATCH_SIZE; i++) {
+		try {
+			this->syslogPdu->recvLog(this->syslogUdpSock);
+			this->setSyslogKeys();
+			this->store(this->syslogLog, this->syslogPdu->serialize(), NOTIFY_SYSLOG_UDP, this->syslogUdpSock->getLastOrigin(), "Syslog UDP");
+			this->publish(NOTIFY_SYSLOG_UDP, this->syslogUdpSock->getLastOrigin(), "UDP Syslog received!");
+		} catch (const std::runtime_error &e) {
+			break;
+		}
+	}
+	this->syslogLog->flush();
+}
+
+/**
+ * @brief Receive a syslog from each pending TCP connection
+ */
+void NotificationReceiver::drainSyslogTcp() {
+
+	auto& configData = Config::getInstance().getData();
+	this->syslogLog->setMaxRecords(configData.syslogLimit);
+	for(u32 i = 0; i < NOTIFY_BATCH_SIZE; i++) {
+		try {
+			std::shared_ptr<TcpSocket> conn = this->syslogTcpSock->acceptConnection(configData.tcpTimeout);
+			if(conn == nullptr) break;
+			this->syslogPdu->recvLog(conn);
+			this->setSyslogKeys();
+			this->store(this->syslogLog, this->syslogPdu->serialize(), NOTIFY_SYSLOG_TCP, 0, "Syslog TCP");
+			this->publish(NOTIFY_SYSLOG_TCP, 0, "TCP Syslog received!");
+		} catch (const std::runtime_error &e) { }
+	}
+	this->syslogLog->flush();
+}
+
+/**
+ * @brief Wait for packets on every socket, and handle them
+ * @param waitMs Time to wait for packets, in ms
+ * @return If any socket had something to read
+ * @note start() calls it from the receiver thread. It can be called from another loop instead.
+ *       The trap deduplicator is swept first, so the summaries are stored even when nothing is received.
+ */
+bool NotificationReceiver::step(u32 waitMs) {
+
+	u64 now = osGetTime();
+	if(now - this->lastSweep >= NOTIFY_SWEEP_MS) {
+		this->dedup.sweep(now);
+		this->lastSweep = now;
+		this->storeSummaries();
+	}
+
+	fd_set set;
+	FD_ZERO(&set);
+	int maxfd = -1;
+	std::shared_ptr<UdpSocket> udpSocks[] = {this->trapv1Sock, this->trapv2Sock, this->trapv3Sock, this->syslogUdpSock};
+	for(u32 i = 0; i < 4; i++) {
+		if(udpSocks[i] == nullptr) continue;
+		FD_SET(udpSocks[i]->getDescriptor(), &set);
+		if(udpSocks[i]->getDescriptor() > maxfd) maxfd = udpSocks[i]->getDescriptor();
+	}
+	if(this->syslogTcpSock != nullptr) {
+		FD_SET(this->syslogTcpSock->getDescriptor(), &set);
+		if(this->syslogTcpSock->getDescriptor() > maxfd) maxfd = this->syslogTcpSock->getDescriptor();
+	}
+
+	if(maxfd < 0) {
+		svcSleepThread((s64)waitMs * 1000000LL);
+		return false;
+	}
+
+	struct timeval timeout;
+	timeout.tv_sec = waitMs / 1000;
+	timeout.tv_usec = (waitMs % 1000) * 1000;
+	if(select(maxfd + 1, &set, NULL, NULL, &timeout) <= 0) return false;
+
+	try {
+		if(this->trapv1Sock != nullptr && FD_ISSET(this->trapv1Sock->getDescriptor(), &set)) {
+			this->drainTraps(this->snmpv1Pdu, this->trapv1Sock, NOTIFY_TRAPV1);
+		}
+		if(this->trapv2Sock != nullptr && FD_ISSET(this->trapv2Sock->getDescriptor(), &set)) {
+			this->drainTraps(this->snmpv2Pdu, this->trapv2Sock, NOTIFY_TRAPV2);
+		}
+		if(this->trapv3Sock != nullptr && FD_ISSET(this->trapv3Sock->getDescriptor(), &set)) {
+			this->drainTrapsv3();
+		}
+		if(this->syslogUdpSock != nullptr && FD_ISSET(this->syslogUdpSock->getDescriptor(), &set)) {
+			this->drainSyslogUdp();
+		}
+		if(this->syslogTcpSock != nullptr && FD_ISSET(this->syslogTcpSock->getDescriptor(), &set)) {
+			this->drainSyslogTcp();
+		}
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Receiver thread
+ * @param args Receiver
+ */
+void NotificationReceiver::threadMain(void *args) {
+	NotificationReceiver *receiver = (NotificationReceiver*)args;
+	while(receiver->running) {
+		try {
+			receiver->step(NOTIFY_WAIT_MS);
+		} catch (const std::bad_alloc &e) {
+			svcSleepThread((s64)NOTIFY_WAIT_MS * 1000000LL);		// Some memory may be freed
+		}
+	}
+}
+
+/**
+ * @brief Start receiving, from a new thread
+ * @note The PDUs are created with the current configuration, so restart it when the configuration changes
+ */
+void NotificationReceiver::start() {
+
+	if(this->running) return;
+
+	try {
+		auto& config = Config::getInstance();
+		this->snmpv1Pdu = std::make_shared<Snmpv1Pdu>(config.getCommunity());
+		this->snmpv2Pdu = std::make_shared<Snmpv2Pdu>(config.getCommunity());
+		this->snmpv3Pdu = std::make_shared<Snmpv3Pdu>(config.getEngineID(), config.getContextName(), config.getTrapUser());
+		this->syslogPdu = std::make_shared<SyslogPdu>();
+	} catch (const std::bad_alloc &e) {
+		throw;
+	} catch (const std::runtime_error &e) {
+		throw;
+	}
+
+	// Traps are still received after a bad rule file, which is reported before the thread takes the event ring
+	try {
+		this->loadRules();
+	} catch (const std::runtime_error &e) {
+		this->publish(NOTIFY_TRAP_ALERT, 0, e.what());
+	}
+
+	// Below the UI, so that a storm does not stall the frames. The kernel buffers the packets meanwhile.
+	this->running = true;
+	s32 prio = 0;
+	svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+	this->thread = threadCreate(NotificationReceiver::threadMain, this, NOTIFY_STACKSIZE, prio+1, -2, false);
+	if(this->thread == NULL) {
+		this->running = false;
+		throw std::runtime_error("Can't create receiver thread");
+	}
+}
+
+/**
+ * @brief Stop receiving, waiting for the receiver thread to end
+ */
+void NotificationReceiver::stop() {
+	if(!this->running) return;
+	this->running = false;
+	threadJoin(this->thread, U64_MAX);
+	threadFree(this->thread);
+	this->thread = NULL;
+}
+
+}
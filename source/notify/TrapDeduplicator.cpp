@@ -0,0 +1,285 @@
+/**
+ * @file TrapDeduplicator.cpp
+ * @brief Suppression of repeated traps and trap storms
+ */
+
+// Includes C/C++
+#include <string.h>
+
+// Own includes
+#include "notify/TrapDeduplicator.h"
+#include "notify/EventIndex.h"
+#include "snmp/Snmpv1Pdu.h"
+#include "snmp/Snmpv2Pdu.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a TrapDeduplicator
+ * @param windowMs	Time a trap is remembered after its last reception, and time between summaries, in ms
+ * @param rate		New traps per second accepted from each source, 0 for no limit
+ * @param burst		New traps accepted at once from each source
+ */
+TrapDeduplicator::TrapDeduplicator(u32 windowMs, u32 rate, u32 burst) {
+	this->windowMs = windowMs;
+	this->rate = rate;
+	this->burst = burst;
+	this->clear();
+}
+
+/**
+ * @brief Forget every trap, source and pending summary
+ */
+void TrapDeduplicator::clear() {
+	for(u32 i = 0; i < TRAPDEDUP_SETS * TRAPDEDUP_WAYS; i++) {
+		this->entries[i].key = 0;
+		this->entries[i].trapOid.clear();
+	}
+	memset(this->sources, 0, sizeof(this->sources));
+	this->summaries.clear();
+	this->nDuplicates = 0;
+	this->nRateLimited = 0;
+	this->nLostSummaries = 0;
+}
+
+/**
+ * @brief Get the identity of a trap
+ * @param source	Sender IP
+ * @param trapOid	snmpTrapOID.0 value, or empty
+ * @param varBinds	Trap VarBinds
+ * @param nVarBinds	Number of VarBinds
+ * @return A non-zero key
+ * @note sysUpTime.0, snmpTrapOID.0 and the values that change on every send (TimeTicks and counters) are left out
+ */
+u64 TrapDeduplicator::getKey(in_addr_t source, const CompactOid &trapOid, const SnmpVarBind *varBinds, u32 nVarBinds) {
+
+	static const CompactOid sysUpTime(TRAPDEDUP_SYSUPTIME_OID);
+	static const CompactOid snmpTrapOid(SNMP_TRAPOID_OID);
+
+	u64 hash = EVENTINDEX_HASH_BASIS;
+	hash = EventIndex::hashBytes(hash, &source, sizeof(source));
+	hash = EventIndex::hashBytes(hash, trapOid.getData(), trapOid.getLength());
+
+	for(u32 i = 0; i < nVarBinds; i++) {
+		const BerView &oid = varBinds[i].oid;
+		const VarBindValue &value = varBinds[i].value;
+		u8 tag = value.getTag();
+		if(tag == (SNMPV1_TAG_TIMETICKS | SNMPV1_TAGCLASS_TIMETICKS) ||
+			tag == (SNMPV1_TAG_COUNTER | SNMPV1_TAGCLASS_COUNTER) ||
+			tag == (SNMPV2_TAG_COUNTER64 | SNMPV2_TAGCLASS_COUNTER64)) continue;
+		if(oid.getLength() == sysUpTime.getLength() && memcmp(oid.getValue(), sysUpTime.getData(), oid.getLength()) == 0) continue;
+		if(oid.getLength() == snmpTrapOid.getLength() && memcmp(oid.getValue(), snmpTrapOid.getData(), oid.getLength()) == 0) continue;
+
+		hash = EventIndex::hashBytes(hash, oid.getValue(), oid.getLength());
+		hash = EventIndex::hashBytes(hash, &tag, 1);
+		switch(value.getType()) {
+			case VARBIND_OCTETS:
+			case VARBIND_OID:
+				hash = EventIndex::hashBytes(hash, value.getOctets(), value.getLength());
+				break;
+			case VARBIND_INTEGER:
+			case VARBIND_UNSIGNED: {
+				u64 integer = value.getUnsigned();
+				hash = EventIndex::hashBytes(hash, &integer, sizeof(integer));
+				break;
+			}
+			default:
+				break;
+		}
+	}
+	return (hash != 0) ? hash : 1;
+}
+
+/**
+ * @brief Queue a summary
+ * @param type		TRAPDEDUP_REPEATED or TRAPDEDUP_RATE_LIMITED
+ * @param source	Sender IP
+ * @param trapOid	Repeated trap OID
+ * @param firstSeen	First suppressed trap
+ * @param lastSeen	Last suppressed trap
+ * @param count		Suppressed traps
+ * @note Summaries are dropped and counted once TRAPDEDUP_MAX_SUMMARIES are waiting
+ */
+void TrapDeduplicator::addSummary(u8 type, in_addr_t source, const CompactOid &trapOid, u64 firstSeen, u64 lastSeen, u32 count) {
+
+	if(this->summaries.size() >= TRAPDEDUP_MAX_SUMMARIES) {
+		this->nLostSummaries++;
+		return;
+	}
+
+	TrapSummary summary;
+	summary.type = type;
+	summary.source = source;
+	summary.trapOid = trapOid;
+	summary.firstSeen = firstSeen;
+	summary.lastSeen = lastSeen;
+	summary.count = count;
+	this->summaries.push_back(summary);
+}
+
+/**
+ * @brief Report the repeats of a trap, and forget it
+ * @param entry Trap entry
+ */
+void TrapDeduplicator::closeEntry(TrapDedupEntry &entry) {
+	if(entry.key != 0 && entry.nRepeats != 0) {
+		this->addSummary(TRAPDEDUP_REPEATED, entry.source, entry.trapOid, entry.firstSeen, entry.lastSeen, entry.nRepeats);
+	}
+	entry.key = 0;
+	entry.nRepeats = 0;
+}
+
+/**
+ * @brief Report the traps dropped from a source
+ * @param source Source entry
+ */
+void TrapDeduplicator::closeSource(TrapRateEntry &source) {
+	if(source.nDropped != 0) {
+		this->addSummary(TRAPDEDUP_RATE_LIMITED, source.source, CompactOid(), source.firstDrop, source.lastDrop, source.nDropped);
+	}
+	source.nDropped = 0;
+}
+
+/**
+ * @brief Take a token from the bucket of a source
+ * @param source	Sender IP
+ * @param now		Current time, in ms
+ * @param tripped	Set if it is the first trap dropped from the source in the current window (output)
+ * @return false if the trap must be dropped
+ */
+bool TrapDeduplicator::takeToken(in_addr_t source, u64 now, bool *tripped) {
+
+	*tripped = false;
+	if(this->rate == 0 || source == 0) return true;
+
+	u32 set = ((source * 2654435761U) >> 16) & (TRAPDEDUP_SOURCE_SETS - 1);
+	TrapRateEntry *ways = &this->sources[set * TRAPDEDUP_SOURCE_WAYS];
+	TrapRateEntry *entry = NULL;
+	for(u32 i = 0; i < TRAPDEDUP_SOURCE_WAYS && entry == NULL; i++) {
+		if(ways[i].source == source) entry = &ways[i];
+	}
+
+	// A new source replaces a free or the least recently seen one, with a full bucket
+	if(entry == NULL) {
+		entry = &ways[0];
+		for(u32 i = 1; i < TRAPDEDUP_SOURCE_WAYS; i++) {
+			if(entry->source == 0) break;
+			if(ways[i].source == 0 || ways[i].lastRefill < entry->lastRefill) entry = &ways[i];
+		}
+		this->closeSource(*entry);
+		entry->source = source;
+		entry->tokens = this->burst * 1000;
+		entry->lastRefill = now;
+	}
+
+	// rate traps per second are rate milli-tokens per ms
+	if(now > entry->lastRefill) {
+		u64 tokens = entry->tokens + (now - entry->lastRefill) * this->rate;
+		entry->tokens = (tokens < this->burst * 1000ULL) ? tokens : this->burst * 1000;
+	}
+	entry->lastRefill = now;
+
+	if(entry->tokens >= 1000) {
+		entry->tokens -= 1000;
+		return true;
+	}
+
+	if(entry->nDropped == 0) {
+		entry->firstDrop = now;
+		*tripped = true;
+	}
+	entry->lastDrop = now;
+	entry->nDropped++;
+	this->nRateLimited++;
+	return false;
+}
+
+/**
+ * @brief Decide what to do with a received trap
+ * @param source	Sender IP
+ * @param trapOid	snmpTrapOID.0 value, or empty
+ * @param varBinds	Trap VarBinds
+ * @param nVarBinds	Number of VarBinds
+ * @param now		Reception time, in ms
+ * @return TRAP_ACCEPT if the trap must be stored
+ * @note Repeats do not take tokens, so a flapping link does not hide the other traps of its source
+ */
+TrapVerdict TrapDeduplicator::check(in_addr_t source, const CompactOid &trapOid, const SnmpVarBind *varBinds, u32 nVarBinds, u64 now) {
+
+	u64 key = TrapDeduplicator::getKey(source, trapOid, varBinds, nVarBinds);
+	u32 set = (u32)(key ^ (key >> 32)) & (TRAPDEDUP_SETS - 1);
+	TrapDedupEntry *ways = &this->entries[set * TRAPDEDUP_WAYS];
+
+	TrapDedupEntry *entry = NULL;
+	for(u32 i = 0; i < TRAPDEDUP_WAYS && entry == NULL; i++) {
+		if(ways[i].key == key) entry = &ways[i];
+	}
+	if(entry != NULL && now - entry->lastSeen < this->windowMs) {
+		entry->lastSeen = now;
+		entry->nRepeats++;
+		this->nDuplicates++;
+		return TRAP_DUPLICATE;
+	}
+
+	bool tripped;
+	if(!this->takeToken(source, now, &tripped)) {
+		return tripped ? TRAP_LIMIT_TRIPPED : TRAP_RATE_LIMITED;
+	}
+
+	// A new trap replaces its expired entry, a free one or the least recently seen one
+	if(entry == NULL) {
+		entry = &ways[0];
+		for(u32 i = 1; i < TRAPDEDUP_WAYS; i++) {
+			if(entry->key == 0) break;
+			if(ways[i].key == 0 || ways[i].lastSeen < entry->lastSeen) entry = &ways[i];
+		}
+	}
+	this->closeEntry(*entry);
+	entry->key = key;
+	entry->source = source;
+	entry->firstSeen = now;
+	entry->lastSeen = now;
+	entry->trapOid = trapOid;
+	return TRAP_ACCEPT;
+}
+
+/**
+ * @brief Report the traps suppressed for a whole window, and forget the expired traps
+ * @param now Current time, in ms
+ * @note Call it about once per second, so that the summaries of a long storm are not delayed
+ */
+void TrapDeduplicator::sweep(u64 now) {
+
+	for(u32 i = 0; i < TRAPDEDUP_SETS * TRAPDEDUP_WAYS; i++) {
+		TrapDedupEntry &entry = this->entries[i];
+		if(entry.key == 0) continue;
+		if(now - entry.lastSeen >= this->windowMs) {
+			this->closeEntry(entry);
+		} else if(entry.nRepeats != 0 && now - entry.firstSeen >= this->windowMs) {
+			this->addSummary(TRAPDEDUP_REPEATED, entry.source, entry.trapOid, entry.firstSeen, entry.lastSeen, entry.nRepeats);
+			entry.firstSeen = now;
+			entry.nRepeats = 0;
+		}
+	}
+
+	for(u32 i = 0; i < TRAPDEDUP_SOURCE_SETS * TRAPDEDUP_SOURCE_WAYS; i++) {
+		TrapRateEntry &source = this->sources[i];
+		if(source.nDropped != 0 && now - source.firstDrop >= this->windowMs) {
+			this->closeSource(source);
+		}
+	}
+}
+
+/**
+ * @brief Take the oldest pending summary
+ * @param summary Summary (output)
+ * @return false if there is none
+ */
+bool TrapDeduplicator::popSummary(TrapSummary &summary) {
+	if(this->summaries.empty()) return false;
+	summary = this->summaries.front();
+	this->summaries.pop_front();
+	return true;
+}
+
+}
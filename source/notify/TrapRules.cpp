@@ -0,0 +1,470 @@
+/**
+ * @file TrapRules.cpp
+ * @brief User defined trap filtering and routing rules
+ */
+
+// Includes C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+// Own includes
+#include "notify/TrapRules.h"
+#include "snmp/Snmpv1Pdu.h"
+
+namespace NetMan {
+
+/**
+ * @brief Order trie edges by byte
+ */
+static bool traprules_edge_less(const TrapTrieEdge &a, const TrapTrieEdge &b) {
+	return a.byte < b.byte;
+}
+
+/**
+ * @brief Get a string member of a JSON object
+ * @param object	JSON object
+ * @param key		Member name
+ * @return The string, or an empty one if missing
+ */
+static std::string traprules_get_string(json_t *object, const char *key) {
+	const char *value = json_string_value(json_object_get(object, key));
+	return (value != NULL) ? std::string(value) : std::string();
+}
+
+/**
+ * @brief Check a tag or log name
+ * @param name Name
+ * @return If it is not empty and only has letters, digits, '-' and '_'
+ */
+static bool traprules_check_name(const std::string &name) {
+	if(name.empty() || name.size() > TRAPRULES_MAX_NAME) return false;
+	for(u32 i = 0; i < name.size(); i++) {
+		char c = name[i];
+		if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_')) return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Parse an OID prefix of a rule
+ * @param rule	Rule, for the error message
+ * @param text	Dotted OID
+ * @return The prefix, with 2 arcs at least
+ */
+static CompactOid traprules_parse_oid(const TrapRule &rule, const std::string &text) {
+	try {
+		CompactOid oid(text);
+		if(!oid.isEmpty()) return oid;
+	} catch (const std::runtime_error &e) { }
+	throw std::runtime_error("Trap rule " + rule.name + ": bad OID " + text);
+}
+
+/**
+ * @brief Constructor for a TrapRuleTrie
+ */
+TrapRuleTrie::TrapRuleTrie() {
+	this->newEdges.resize(1);
+	this->newRefs.resize(1);
+}
+
+/**
+ * @brief Add a prefix
+ * @param prefix	Non-empty OID prefix
+ * @param ref		Rule condition met by the OIDs under the prefix
+ */
+void TrapRuleTrie::insert(const CompactOid &prefix, TrapRuleRef ref) {
+
+	u32 node = 0;
+	for(u32 i = 0; i < prefix.getLength(); i++) {
+		u8 byte = prefix.getData()[i];
+		u32 next = 0;
+		for(u32 j = 0; j < this->newEdges[node].size() && next == 0; j++) {
+			if(this->newEdges[node][j].byte == byte) next = this->newEdges[node][j].node;
+		}
+		if(next == 0) {
+			next = this->newEdges.size();
+			TrapTrieEdge edge = {byte, next};
+			this->newEdges[node].push_back(edge);
+			this->newEdges.resize(next + 1);
+			this->newRefs.resize(next + 1);
+		}
+		node = next;
+	}
+	this->newRefs[node].push_back(ref);
+}
+
+/**
+ * @brief Pack the inserted prefixes, so that they can be matched
+ */
+void TrapRuleTrie::compile() {
+
+	this->nodes.resize(this->newEdges.size());
+	this->edges.clear();
+	this->refs.clear();
+	for(u32 i = 0; i < this->nodes.size(); i++) {
+		std::vector<TrapTrieEdge> &nodeEdges = this->newEdges[i];
+		std::sort(nodeEdges.begin(), nodeEdges.end(), traprules_edge_less);
+		this->nodes[i].firstEdge = this->edges.size();
+		this->nodes[i].nEdges = nodeEdges.size();
+		this->edges.insert(this->edges.end(), nodeEdges.begin(), nodeEdges.end());
+		this->nodes[i].firstRef = this->refs.size();
+		this->nodes[i].nRefs = this->newRefs[i].size();
+		this->refs.insert(this->refs.end(), this->newRefs[i].begin(), this->newRefs[i].end());
+	}
+	std::vector<std::vector<TrapTrieEdge>>().swap(this->newEdges);
+	std::vector<std::vector<TrapRuleRef>>().swap(this->newRefs);
+}
+
+/**
+ * @brief Find the prefixes of an OID
+ * @param data		Encoded OID
+ * @param length	Encoded length
+ * @param matched	Conditions of every prefix found, appended
+ */
+void TrapRuleTrie::match(const u8 *data, u32 length, std::vector<TrapRuleRef> &matched) const {
+
+	if(this->nodes.empty()) return;
+
+	const TrapTrieNode *node = &this->nodes[0];
+	for(u32 i = 0; i < length && node->nEdges != 0; i++) {
+		TrapTrieEdge key = {data[i], 0};
+		const TrapTrieEdge *first = &this->edges[node->firstEdge];
+		const TrapTrieEdge *last = first + node->nEdges;
+		const TrapTrieEdge *edge = std::lower_bound(first, last, key, traprules_edge_less);
+		if(edge == last || edge->byte != data[i]) return;
+		node = &this->nodes[edge->node];
+		if(node->nRefs != 0) {
+			matched.insert(matched.end(), &this->refs[node->firstRef], &this->refs[node->firstRef] + node->nRefs);
+		}
+	}
+}
+
+/**
+ * @brief Constructor for an empty TrapRuleSet
+ */
+TrapRuleSet::TrapRuleSet() {
+	this->generation = 0;
+	this->trapOids.compile();
+	this->enterprises.compile();
+	this->varBindOids.compile();
+}
+
+/**
+ * @brief Constructor for a TrapRuleSet
+ * @param rules Rules, in the order they are applied
+ */
+TrapRuleSet::TrapRuleSet(const std::vector<TrapRule> &rules) {
+
+	if(rules.size() > TRAPRULES_MAX_RULES) {
+		throw std::runtime_error("Too many trap rules");
+	}
+
+	this->rules = rules;
+	this->masks.resize(rules.size());
+	this->values.resize(rules.size());
+	this->generation = 0;
+
+	u64 usedLengths = 0;
+	for(u32 i = 0; i < rules.size(); i++) {
+		const TrapRule &rule = rules[i];
+		u32 mask = 0;
+
+		if(rule.action > TRAPRULE_ALERT) {
+			throw std::runtime_error("Trap rule " + rule.name + ": bad action");
+		}
+		if((rule.action == TRAPRULE_TAG || rule.action == TRAPRULE_ROUTE) && !traprules_check_name(rule.argument)) {
+			throw std::runtime_error("Trap rule " + rule.name + ": bad name " + rule.argument);
+		}
+		if(rule.varBinds.size() > TRAPRULES_MAX_VARBINDS) {
+			throw std::runtime_error("Trap rule " + rule.name + ": too many VarBinds");
+		}
+
+		if(!rule.trapOid.empty()) {
+			TrapRuleRef ref = {(u16)i, TRAPRULE_COND_TRAPOID};
+			this->trapOids.insert(traprules_parse_oid(rule, rule.trapOid), ref);
+			mask |= 1 << TRAPRULE_COND_TRAPOID;
+		}
+		if(!rule.enterprise.empty()) {
+			TrapRuleRef ref = {(u16)i, TRAPRULE_COND_ENTERPRISE};
+			this->enterprises.insert(traprules_parse_oid(rule, rule.enterprise), ref);
+			mask |= 1 << TRAPRULE_COND_ENTERPRISE;
+		}
+		if(!rule.source.empty()) {
+			u32 network;
+			u8 length;
+			if(!TrapRuleSet::parseSubnet(rule.source, &network, &length)) {
+				throw std::runtime_error("Trap rule " + rule.name + ": bad subnet " + rule.source);
+			}
+			TrapRuleRef ref = {(u16)i, TRAPRULE_COND_SOURCE};
+			this->subnets[((u64)length << 32) | network].push_back(ref);
+			usedLengths |= 1ULL << length;
+			mask |= 1 << TRAPRULE_COND_SOURCE;
+		}
+
+		for(u32 j = 0; j < rule.varBinds.size(); j++) {
+			TrapRuleRef ref = {(u16)i, (u8)(TRAPRULE_COND_VARBIND + j)};
+			this->varBindOids.insert(traprules_parse_oid(rule, rule.varBinds[j].oid), ref);
+			mask |= 1 << (TRAPRULE_COND_VARBIND + j);
+
+			// The value is kept in every form it can be received in
+			const std::string &text = rule.varBinds[j].value;
+			TrapRuleValue value;
+			value.isAny = text.empty();
+			value.text = text;
+			char *numberEnd;
+			value.number = strtoll(text.c_str(), &numberEnd, 10);
+			value.isNumber = !text.empty() && *numberEnd == '\0';
+			u32 address = 0;
+			u8 length;
+			value.isAddress = text.find('/') == std::string::npos && TrapRuleSet::parseSubnet(text, &address, &length);
+			value.address = htonl(address);
+			try {
+				value.oid = CompactOid(text);
+			} catch (const std::runtime_error &e) { }
+			this->values[i].push_back(value);
+		}
+
+		this->masks[i] = mask;
+		if(mask == 0) this->always.push_back(i);
+	}
+
+	for(s32 length = 32; length >= 0; length--) {
+		if(usedLengths & (1ULL << length)) this->prefixLengths.push_back(length);
+	}
+	this->trapOids.compile();
+	this->enterprises.compile();
+	this->varBindOids.compile();
+
+	TrapRuleState state = {0, 0};
+	this->states.resize(rules.size(), state);
+}
+
+/**
+ * @brief Mark some conditions of a rule as met by the current trap
+ * @param rule	Rule index
+ * @param mask	Conditions met
+ */
+void TrapRuleSet::hit(u16 rule, u32 mask) {
+	TrapRuleState &state = this->states[rule];
+	if(state.generation != this->generation) {
+		state.generation = this->generation;
+		state.mask = 0;
+		this->touched.push_back(rule);
+	}
+	state.mask |= mask;
+}
+
+/**
+ * @brief Compare a received value with the one of a condition
+ * @param expected	Condition value
+ * @param value		Received value
+ * @return If they are equal
+ */
+bool TrapRuleSet::matchValue(const TrapRuleValue &expected, const VarBindValue &value) {
+
+	if(expected.isAny) return true;
+	switch(value.getType()) {
+		case VARBIND_INTEGER:
+			return expected.isNumber && value.getInteger() == expected.number;
+		case VARBIND_UNSIGNED:
+		case VARBIND_COUNTER64:
+			return expected.isNumber && expected.number >= 0 && value.getUnsigned() == (u64)expected.number;
+		case VARBIND_OID:
+			return value.getLength() == expected.oid.getLength() && memcmp(value.getOctets(), expected.oid.getData(), value.getLength()) == 0;
+		case VARBIND_OCTETS:
+			if(value.getTag() == (SNMPV1_TAG_NETWORKADDRESS | SNMPV1_TAGCLASS_NETWORKADDRESS) && value.getLength() == 4) {
+				return expected.isAddress && memcmp(value.getOctets(), &expected.address, 4) == 0;
+			}
+			return value.equals(expected.text);
+		default:
+			return false;
+	}
+}
+
+/**
+ * @brief Find the rules matched by a trap
+ * @param source		Sender IP
+ * @param trapOid		snmpTrapOID.0 value, or empty
+ * @param enterprise	Trap enterprise, or empty
+ * @param varBinds		Trap VarBinds
+ * @param nVarBinds		Number of VarBinds
+ * @param result		Actions to apply (output)
+ */
+void TrapRuleSet::match(in_addr_t source, const CompactOid &trapOid, const CompactOid &enterprise,
+	const SnmpVarBind *varBinds, u32 nVarBinds, TrapRuleMatch &result) {
+
+	result.drop = false;
+	result.route = NULL;
+	result.tags.clear();
+	result.alerts.clear();
+	if(this->rules.empty()) return;
+
+	// A new generation forgets the conditions met by the previous trap
+	if(++this->generation == 0) {
+		for(u32 i = 0; i < this->states.size(); i++) {
+			this->states[i].generation = 0;
+		}
+		this->generation = 1;
+	}
+	this->touched.clear();
+
+	this->matched.clear();
+	this->trapOids.match(trapOid.getData(), trapOid.getLength(), this->matched);
+	this->enterprises.match(enterprise.getData(), enterprise.getLength(), this->matched);
+	for(u32 i = 0; i < this->matched.size(); i++) {
+		this->hit(this->matched[i].rule, 1 << this->matched[i].condition);
+	}
+
+	u32 address = ntohl(source);
+	for(u32 i = 0; i < this->prefixLengths.size(); i++) {
+		u8 length = this->prefixLengths[i];
+		u32 network = (length == 0) ? 0 : address & (0xFFFFFFFF << (32 - length));
+		auto it = this->subnets.find(((u64)length << 32) | network);
+		if(it == this->subnets.end()) continue;
+		for(u32 j = 0; j < it->second.size(); j++) {
+			this->hit(it->second[j].rule, 1 << TRAPRULE_COND_SOURCE);
+		}
+	}
+
+	for(u32 i = 0; i < nVarBinds; i++) {
+		this->matched.clear();
+		this->varBindOids.match(varBinds[i].oid.getValue(), varBinds[i].oid.getLength(), this->matched);
+		for(u32 j = 0; j < this->matched.size(); j++) {
+			const TrapRuleRef &ref = this->matched[j];
+			if(TrapRuleSet::matchValue(this->values[ref.rule][ref.condition - TRAPRULE_COND_VARBIND], varBinds[i].value)) {
+				this->hit(ref.rule, 1 << ref.condition);
+			}
+		}
+	}
+
+	for(u32 i = 0; i < this->always.size(); i++) {
+		this->hit(this->always[i], 0);
+	}
+
+	// Rules are applied in order, and only the touched ones can be matched
+	std::sort(this->touched.begin(), this->touched.end());
+	bool decided = false;
+	for(u32 i = 0; i < this->touched.size(); i++) {
+		u16 index = this->touched[i];
+		if(this->states[index].mask != this->masks[index]) continue;
+		const TrapRule &rule = this->rules[index];
+		switch(rule.action) {
+			case TRAPRULE_DROP:
+				if(!decided) result.drop = true;
+				decided = true;
+				break;
+			case TRAPRULE_ROUTE:
+				if(!decided) result.route = &rule;
+				decided = true;
+				break;
+			case TRAPRULE_TAG:
+				if(result.tags.size() < TRAPRULES_MAX_TAGS) result.tags.push_back(&rule);
+				break;
+			case TRAPRULE_ALERT:
+				result.alerts.push_back(&rule);
+				break;
+		}
+	}
+}
+
+/**
+ * @brief Read the rules of a JSON list
+ * @param root	List of rule objects
+ * @param rules	Rules (output)
+ * @note Each object has a "name", an "action" (drop, tag, route or alert), and optionally "oid", "enterprise", "source"
+ *       and "varbinds", a list of objects with an "oid" and a "value". Tag rules have a "tag", route rules a "log",
+ *       and alert rules may have a "text".
+ */
+void TrapRuleSet::parse(json_t *root, std::vector<TrapRule> &rules) {
+
+	if(!json_is_array(root)) {
+		throw std::runtime_error("Trap rules must be a list");
+	}
+
+	rules.clear();
+	for(u32 i = 0; i < json_array_size(root); i++) {
+		json_t *object = json_array_get(root, i);
+		if(!json_is_object(object)) {
+			throw std::runtime_error("Trap rule " + std::to_string(i + 1) + " is not an object");
+		}
+
+		TrapRule rule;
+		rule.name = traprules_get_string(object, "name");
+		if(rule.name.empty()) rule.name = std::to_string(i + 1);
+		rule.trapOid = traprules_get_string(object, "oid");
+		rule.enterprise = traprules_get_string(object, "enterprise");
+		rule.source = traprules_get_string(object, "source");
+
+		std::string action = traprules_get_string(object, "action");
+		if(action == "drop") {
+			rule.action = TRAPRULE_DROP;
+		} else if(action == "tag") {
+			rule.action = TRAPRULE_TAG;
+			rule.argument = traprules_get_string(object, "tag");
+		} else if(action == "route") {
+			rule.action = TRAPRULE_ROUTE;
+			rule.argument = traprules_get_string(object, "log");
+		} else if(action == "alert") {
+			rule.action = TRAPRULE_ALERT;
+			rule.argument = traprules_get_string(object, "text");
+			if(rule.argument.empty()) rule.argument = rule.name;
+		} else {
+			throw std::runtime_error("Trap rule " + rule.name + ": bad action " + action);
+		}
+
+		json_t *varBinds = json_object_get(object, "varbinds");
+		for(u32 j = 0; j < json_array_size(varBinds); j++) {
+			json_t *varBind = json_array_get(varBinds, j);
+			TrapRuleVarBind condition;
+			condition.oid = traprules_get_string(varBind, "oid");
+			condition.value = traprules_get_string(varBind, "value");
+			if(condition.oid.empty()) {
+				throw std::runtime_error("Trap rule " + rule.name + ": VarBind without OID");
+			}
+			rule.varBinds.push_back(condition);
+		}
+		rules.push_back(rule);
+	}
+}
+
+/**
+ * @brief Parse a subnet
+ * @param text		Subnet, as a.b.c.d/len, or an address as a.b.c.d
+ * @param network	Network address, in host order (output)
+ * @param length	Prefix length, 32 for an address (output)
+ * @return false if it is malformed
+ */
+bool TrapRuleSet::parseSubnet(const std::string &text, u32 *network, u8 *length) {
+
+	const char *ptr = text.c_str();
+	u32 address = 0;
+	for(u32 i = 0; i < 4; i++) {
+		if(i != 0 && *ptr++ != '.') return false;
+		if(*ptr < '0' || *ptr > '9') return false;
+		char *end;
+		unsigned long byte = strtoul(ptr, &end, 10);
+		if(byte > 255) return false;
+		address = (address << 8) | byte;
+		ptr = end;
+	}
+
+	unsigned long bits = 32;
+	if(*ptr == '/') {
+		ptr++;
+		if(*ptr < '0' || *ptr > '9') return false;
+		char *end;
+		bits = strtoul(ptr, &end, 10);
+		if(bits > 32) return false;
+		ptr = end;
+	}
+	if(*ptr != '\0') return false;
+
+	*network = (bits == 0) ? 0 : address & (0xFFFFFFFF << (32 - bits));
+	*length = bits;
+	return true;
+}
+
+}
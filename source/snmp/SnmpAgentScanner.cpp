@@ -5,7 +5,6 @@
 
 // Includes C/C++
 #include <arpa/inet.h>
-#include <typeinfo>
 
 // Includes 3DS
 #include <3ds.h>
@@ -106,11 +105,11 @@ void SnmpAgentScanner::scanAgents(in_addr_t baseIP, u16 nhosts, u16 port, u8 ver
                 SnmpAgentEntry agent;
                 agent.sysDescr = this->getStringFromVarBind(pdu, 0);
                 agent.sysObjectID = this->getOidFromVarBind(pdu, 1);
-                agent.sysUpTime = this->getIntegerFromVarBind(pdu, 2)->getValueU32();
+                agent.sysUpTime = this->getIntegerFromVarBind(pdu, 2);
                 agent.sysContact = this->getStringFromVarBind(pdu, 3);
                 agent.sysName = this->getStringFromVarBind(pdu, 4);
                 agent.sysLocation = this->getStringFromVarBind(pdu, 5);
-                agent.sysServices = this->getIntegerFromVarBind(pdu, 6)->getValueS32();
+                agent.sysServices = this->getIntegerFromVarBind(pdu, 6);
                 this->agents[sock->getLastOrigin()] = agent;
             } catch (const std::bad_alloc &e) {
                 throw;
@@ -128,18 +127,31 @@ void SnmpAgentScanner::scanAgents(in_addr_t baseIP, u16 nhosts, u16 port, u8 ver
 }
 
 /**
- * @brief Get a string from a varbind
+ * @brief Get the value of a varbind, checking its type
  * @param pdu   SNMP pdu to use
  * @param i     Index of the varbind
- * @return The retrieved string
+ * @param type  Expected value type
+ * @return The varbind value
  */
-std::string &SnmpAgentScanner::getStringFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i) {
-    std::shared_ptr<BerField> varBind = pdu->getVarBind(i);
-    if(typeid(*varBind.get()) == typeid(BerOctetString)) {
-        return std::static_pointer_cast<BerOctetString>(varBind)->getValue();
+const VarBindValue &SnmpAgentScanner::getVarBindValue(std::shared_ptr<Snmpv1Pdu> pdu, u8 i, VarBindType type) {
+    if(i < pdu->getNVarBinds()) {
+        const VarBindValue &value = pdu->getVarBind(i).value;
+        if(value.getType() == type || (type == VARBIND_INTEGER && value.getType() == VARBIND_UNSIGNED)) {
+            return value;
+        }
     }
 
-    throw std::runtime_error("Error retrieving OCTET STRING");
+    throw std::runtime_error("Error retrieving VarBind value");
+}
+
+/**
+ * @brief Get a string from a varbind
+ * @param pdu   SNMP pdu to use
+ * @param i     Index of the varbind
+ * @return The retrieved string
+ */
+std::string SnmpAgentScanner::getStringFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i) {
+    return this->getVarBindValue(pdu, i, VARBIND_OCTETS).getString();
 }
 
 /**
@@ -149,27 +161,17 @@ std::string &SnmpAgentScanner::getStringFromVarBind(std::shared_ptr<Snmpv1Pdu> p
  * @return The retrieved OID (ready to be printed)
  */
 std::string SnmpAgentScanner::getOidFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i) {
-    std::shared_ptr<BerField> varBind = pdu->getVarBind(i);
-    if(typeid(*varBind.get()) == typeid(BerOid)) {
-        return std::static_pointer_cast<BerOid>(varBind)->print();
-    }
-
-    throw std::runtime_error("Error retrieving OID");
+    return this->getVarBindValue(pdu, i, VARBIND_OID).print();
 }
 
 /**
  * @brief Get an integer from a varbind
  * @param pdu   SNMP pdu to use
  * @param i     Index of the varbind
- * @return The retrieved integer
+ * @return The retrieved integer (INTEGER, Counter32, Gauge32 or TimeTicks)
  */
-std::shared_ptr<BerInteger> SnmpAgentScanner::getIntegerFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i) {
-    std::shared_ptr<BerField> varBind = pdu->getVarBind(i);
-    if(typeid(*varBind.get()) == typeid(BerInteger)) {
-        return std::static_pointer_cast<BerInteger>(varBind);
-    }
-
-    throw std::runtime_error("Error retrieving INTEGER");
+u32 SnmpAgentScanner::getIntegerFromVarBind(std::shared_ptr<Snmpv1Pdu> pdu, u8 i) {
+    return (u32)this->getVarBindValue(pdu, i, VARBIND_INTEGER).getUnsigned();
 }
 
 /**
@@ -0,0 +1,423 @@
+/**
+ * @file SnmpEngine.cpp
+ * @brief Asynchronous SNMP request multiplexer
+ */
+
+// Includes C/C++
+#include <stdexcept>
+
+// Includes 3DS
+#include <3ds.h>
+
+// Own includes
+#include "snmp/SnmpEngine.h"
+#include "snmp/Snmpv3EngineCache.h"
+#include "asn1/BerInteger.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a SNMP engine
+ * @param timeout	Time to wait for each try, in ms
+ * @param retries	Retransmissions of a request before reporting a timeout
+ */
+SnmpEngine::SnmpEngine(u32 timeout, u8 retries) {
+
+	try {
+		this->sock = std::make_shared<UdpSocket>(0);
+		this->recvBuffer = std::unique_ptr<u8[]>(new u8[SNMP_MAX_PDU_SIZE]);
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+
+	this->requestID = 0;
+	this->timeout = timeout;
+	this->retries = retries;
+}
+
+/**
+ * @brief Get the request ID for a new request
+ * @return An ID not used by any outstanding request
+ */
+u32 SnmpEngine::generateRequestID() {
+	do {
+		this->requestID = (this->requestID >= SNMPENGINE_MAX_REQUEST_ID) ? 1 : this->requestID + 1;
+	} while(this->requests.count(this->requestID) != 0);
+	return this->requestID;
+}
+
+/**
+ * @brief Send an encoded request and keep it until it completes
+ * @param id		Request ID
+ * @param data		Encoded message
+ * @param size		Encoded message size
+ * @param ip		Agent IP
+ * @param port		Agent port
+ * @param callback	Completion callback
+ * @param args		Callback arguments
+ * @param pdu		SNMPv1/v2c PDU used to decode the response
+ * @param v3pdu		SNMPv3 PDU used to decode the response
+ */
+void SnmpEngine::addRequest(u32 id, u8 *data, u32 size, in_addr_t ip, u16 port, SnmpEngineCallback callback, void *args, std::shared_ptr<Snmpv1Pdu> pdu, std::shared_ptr<Snmpv3Pdu> v3pdu) {
+
+	try {
+		this->sock->sendPacket(data, size, ip, port);
+
+		SnmpEngineRequest &request = this->requests[id];
+		request.message.assign(data, data + size);
+		request.ip = ip;
+		request.port = port;
+		request.timeout = this->timeout;
+		request.deadline = osGetTime() + this->timeout;
+		request.retries = this->retries;
+		request.pdu = pdu;
+		request.v3pdu = v3pdu;
+		request.requestPdu.clear();
+		request.resent = false;
+		request.callback = callback;
+		request.args = args;
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		this->requests.erase(id);
+		throw;
+	}
+}
+
+/**
+ * @brief Send a SNMPv1/v2c request, without waiting for the response
+ * @param pdu		PDU holding the VarBinds to ask for. It is cleared, and later holds the response.
+ * @param type		Type of SNMP PDU
+ * @param ip		Agent IP
+ * @param port		Agent port
+ * @param callback	Completion callback (optional)
+ * @param args		Callback arguments
+ * @return The request ID
+ */
+u32 SnmpEngine::sendRequest(std::shared_ptr<Snmpv1Pdu> pdu, u32 type, in_addr_t ip, u16 port, SnmpEngineCallback callback, void *args) {
+
+	try {
+		u32 id = this->generateRequestID();
+		pdu->setRequestID(id);
+		u32 size;
+		u8 *data = pdu->encodeRequest(type, &size);
+		this->addRequest(id, data, size, ip, port, callback, args, pdu, nullptr);
+		pdu->clear();
+		return id;
+	} catch (const std::runtime_error &e) {
+		pdu->clear();
+		throw;
+	} catch (const std::bad_alloc &e) {
+		pdu->clear();
+		throw;
+	}
+}
+
+/**
+ * @brief Send a SNMPv2c GetBulk request, without waiting for the response
+ * @param pdu				PDU holding the VarBinds to ask for. It is cleared, and later holds the response.
+ * @param nonRepeaters		Number of scalar objects to fetch
+ * @param maxRepetitions	Number of rows to get for the remaining objects
+ * @param ip				Agent IP
+ * @param port				Agent port
+ * @param callback			Completion callback (optional)
+ * @param args				Callback arguments
+ * @return The request ID
+ */
+u32 SnmpEngine::sendBulkRequest(std::shared_ptr<Snmpv2Pdu> pdu, u32 nonRepeaters, u32 maxRepetitions, in_addr_t ip, u16 port, SnmpEngineCallback callback, void *args) {
+
+	try {
+		u32 id = this->generateRequestID();
+		pdu->setRequestID(id);
+		u32 size;
+		u8 *data = pdu->encodeBulkRequest(nonRepeaters, maxRepetitions, &size);
+		this->addRequest(id, data, size, ip, port, callback, args, pdu, nullptr);
+		pdu->clear();
+		return id;
+	} catch (const std::runtime_error &e) {
+		pdu->clear();
+		throw;
+	} catch (const std::bad_alloc &e) {
+		pdu->clear();
+		throw;
+	}
+}
+
+/**
+ * @brief Send a SNMPv3 request, without waiting for the response
+ * @param pdu				PDU holding the VarBinds to ask for. It is cleared, and later holds the response.
+ * @param type				Type of SNMP PDU
+ * @param ip				Agent IP
+ * @param port				Agent port
+ * @param callback			Completion callback (optional)
+ * @param args				Callback arguments
+ * @param nonRepeaters		Non-repeaters field for GetBulkRequest
+ * @param maxRepetitions	Max-repetitions field for GetBulkRequest
+ * @return The request ID (msgID)
+ */
+u32 SnmpEngine::sendRequest(std::shared_ptr<Snmpv3Pdu> pdu, u32 type, in_addr_t ip, u16 port, SnmpEngineCallback callback, void *args, u32 nonRepeaters, u32 maxRepetitions) {
+
+	try {
+		// Skip the discovery if the agent engine is known
+		std::string engineID;
+		u32 engineBoots, engineTime;
+		if(Snmpv3EngineCache::getInstance().get(ip, port, engineID, &engineBoots, &engineTime)) {
+			pdu->setEngine(engineID, engineBoots, engineTime);
+		}
+
+		u32 id = this->generateRequestID();
+		pdu->setRequestID(id);
+		u32 size;
+		u8 *data = pdu->encodeRequest(type, &size, nonRepeaters, maxRepetitions);
+		this->addRequest(id, data, size, ip, port, callback, args, nullptr, pdu);
+		this->requests[id].requestPdu = pdu->getRequestPdu();
+		pdu->clear();
+		return id;
+	} catch (const std::runtime_error &e) {
+		pdu->clear();
+		throw;
+	} catch (const std::bad_alloc &e) {
+		pdu->clear();
+		throw;
+	}
+}
+
+/**
+ * @brief Drop an outstanding request, without calling its callback
+ * @param id Request ID
+ * @return If the request was outstanding
+ */
+bool SnmpEngine::cancel(u32 id) {
+	return this->requests.erase(id) != 0;
+}
+
+/**
+ * @brief Get the ID used to route a message, without decoding it
+ * @param data	Message data
+ * @param size	Message size
+ * @param id	request-id for SNMPv1/v2c, or msgID for SNMPv3 (output)
+ * @return If the ID could be read
+ */
+bool SnmpEngine::peekRequestID(const u8 *data, u32 size, u32 *id) {
+
+	BerReader reader(data, size);
+	BerView messageSeq, version, field;
+	if(reader.tryNext(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE, &messageSeq) != BER_OK) return false;
+	BerReader message(messageSeq);
+	if(message.tryNext(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER, &version) != BER_OK) return false;
+
+	u64 value;
+	if(version.getInteger(false, &value) != BER_OK) return false;
+	if(value == SNMPV3_VERSION) {
+		// msgID is the first field of msgGlobalData
+		if(message.tryNext(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE, &field) != BER_OK) return false;
+	} else {
+		// request-id is the first field of the PDU, after the community
+		if(message.tryNext(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING, &field) != BER_OK) return false;
+		if(message.tryNext(&field) != BER_OK) return false;
+	}
+	BerReader fields(field);
+	if(fields.tryNext(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER, &field) != BER_OK) return false;
+	if(field.getInteger(false, &value) != BER_OK) return false;
+
+	*id = value;
+	return true;
+}
+
+/**
+ * @brief Route a received message to its request, and complete it
+ * @param size Message size, inside the reception buffer
+ * @return Number of completed requests
+ */
+u32 SnmpEngine::dispatch(u32 size) {
+
+	u8 *data = this->recvBuffer.get();
+	u32 id;
+	if(!SnmpEngine::peekRequestID(data, size, &id)) return 0;
+
+	// Drop late, duplicated and foreign messages
+	auto it = this->requests.find(id);
+	if(it == this->requests.end()) return 0;
+	SnmpEngineRequest &request = it->second;
+	if(this->sock->getLastOrigin() != request.ip || this->sock->getLastPort() != htons(request.port)) return 0;
+
+	// Decode the response with the PDU that sent the request
+	u8 pduType = 0;
+	std::string errorText;
+	SnmpResult result = {SNMP_OK, 0, SNMPV1_ERROR_NOERROR, 0};
+	if(request.pdu != nullptr) {
+		request.pdu->setRequestID(id);
+		result = request.pdu->tryParseResponse(data, size, true, SNMPV1_GETRESPONSE, &pduType);
+		if(result.status != SNMP_OK) {
+			errorText = Snmpv1Pdu::getErrorString(result);
+		}
+	} else {
+		request.v3pdu->setRequestID(id);
+		try {
+			pduType = request.v3pdu->parseResponse(data, size, true, SNMPV1_GETRESPONSE);
+		} catch (const std::runtime_error &e) {
+			// Keep error-status responses apart from the security errors
+			result = request.v3pdu->getPduResult();
+			if(result.status == SNMP_OK) {
+				result.status = SNMP_ERROR_SECURITY;
+			}
+			errorText = e.what();
+		}
+
+		// Keep the agent engine, and send the request again if it reported other engine parameters
+		if(request.v3pdu->isEngineSynced()) {
+			std::shared_ptr<Snmpv3Pdu> v3pdu = request.v3pdu;
+			Snmpv3EngineCache::getInstance().update(request.ip, request.port, v3pdu->getEngineID(), v3pdu->getEngineBoots(), v3pdu->getEngineTime());
+			if(result.status != SNMP_OK && !request.resent && this->resend(request)) return 0;
+		}
+	}
+
+	this->complete(id, result, pduType, size, errorText);
+	return 1;
+}
+
+/**
+ * @brief Encode a SNMPv3 request again with the engine parameters of its PDU, and send it
+ * @param request Outstanding request
+ * @return If it was sent
+ */
+bool SnmpEngine::resend(SnmpEngineRequest &request) {
+
+	std::shared_ptr<Snmpv3Pdu> pdu = request.v3pdu;
+	try {
+		u32 size;
+		u8 *data = pdu->encodeRequest(request.requestPdu, &size);
+		this->sock->sendPacket(data, size, request.ip, request.port);
+		request.message.assign(data, data + size);
+	} catch (const std::runtime_error &e) {
+		pdu->clear();
+		return false;
+	} catch (const std::bad_alloc &e) {
+		pdu->clear();
+		return false;
+	}
+
+	pdu->clear();
+	request.resent = true;
+	request.deadline = osGetTime() + request.timeout;
+	return true;
+}
+
+/**
+ * @brief Retransmit the requests whose try timed out, and complete the ones without retries left
+ * @param now Current time, in osGetTime() ms
+ * @return Number of completed requests
+ */
+u32 SnmpEngine::checkTimeouts(u64 now) {
+
+	std::vector<u32> expired;
+	for(auto &it : this->requests) {
+		SnmpEngineRequest &request = it.second;
+		if(request.deadline > now) continue;
+		if(request.retries == 0) {
+			expired.push_back(it.first);
+			continue;
+		}
+
+		// Same request ID, so a late response to any try completes it
+		request.retries--;
+		request.deadline = now + request.timeout;
+		try {
+			this->sock->sendPacket(request.message.data(), request.message.size(), request.ip, request.port);
+		} catch (const std::runtime_error &e) { }
+	}
+
+	// Callbacks may add requests, so complete them out of the loop
+	SnmpResult result = {SNMP_ERROR_TIMEOUT, 0, SNMPV1_ERROR_NOERROR, 0};
+	for(u32 i = 0; i < expired.size(); i++) {
+		this->complete(expired[i], result, 0, 0, Snmpv1Pdu::getErrorString(result));
+	}
+
+	return expired.size();
+}
+
+/**
+ * @brief Remove a request and call its callback
+ * @param id			Request ID
+ * @param result		Request result
+ * @param pduType		Received PDU type
+ * @param size			Received message size
+ * @param errorText		Error description
+ */
+void SnmpEngine::complete(u32 id, const SnmpResult &result, u8 pduType, u32 size, const std::string &errorText) {
+
+	auto it = this->requests.find(id);
+	if(it == this->requests.end()) return;
+
+	SnmpEngineResponse response;
+	response.requestID = id;
+	response.result = result;
+	response.errorText = errorText;
+	response.pduType = pduType;
+	response.size = size;
+	response.pdu = it->second.pdu;
+	response.v3pdu = it->second.v3pdu;
+	response.args = it->second.args;
+	SnmpEngineCallback callback = it->second.callback;
+	this->requests.erase(it);
+
+	if(callback != NULL) {
+		callback(&response);
+	}
+}
+
+/**
+ * @brief Receive the responses and handle the timeouts of the outstanding requests
+ * @param waitMs Maximum time to wait for some request to complete, in ms (0 to not block)
+ * @return Number of completed requests
+ * @note It returns as soon as some request completes, after handling every message already received
+ */
+u32 SnmpEngine::poll(u32 waitMs) {
+
+	u32 completed = 0;
+	u64 now = osGetTime();
+	u64 end = now + waitMs;
+
+	while(!this->requests.empty()) {
+
+		// Sleep until a message arrives, the next try times out or the poll ends
+		u64 until = (completed != 0) ? now : end;
+		for(auto &it : this->requests) {
+			if(it.second.deadline < until) until = it.second.deadline;
+		}
+		this->sock->setTimeoutMs(until > now ? until - now : 0);
+		s32 size = this->sock->tryRecvPacket(this->recvBuffer.get(), SNMP_MAX_PDU_SIZE);
+		if(size > 0) {
+			completed += this->dispatch(size);
+		}
+
+		now = osGetTime();
+		completed += this->checkTimeouts(now);
+		if(size <= 0 && (completed != 0 || now >= end)) break;
+	}
+
+	return completed;
+}
+
+/**
+ * @brief Block until a request completes
+ * @param id Request ID
+ */
+void SnmpEngine::wait(u32 id) {
+	while(this->isPending(id)) {
+		this->poll(this->timeout);
+	}
+}
+
+/**
+ * @brief Block until every outstanding request completes
+ */
+void SnmpEngine::waitAll() {
+	while(!this->requests.empty()) {
+		this->poll(this->timeout);
+	}
+}
+
+}
@@ -0,0 +1,333 @@
+/**
+ * @file SnmpPlanner.cpp
+ * @brief Coalescing of SNMP GET requests
+ */
+
+// Includes C/C++
+#include <stdexcept>
+
+// Own includes
+#include "snmp/SnmpPlanner.h"
+#include "asn1/BerNull.h"
+#include "asn1/BerOid.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a SnmpPlanner
+ * @param engine Engine used to send the requests
+ */
+SnmpPlanner::SnmpPlanner(std::shared_ptr<SnmpEngine> engine) {
+	this->engine = engine;
+}
+
+/**
+ * @brief Find the target of a request, adding it if needed
+ * @param pdu	SNMPv1/v2c PDU, or nullptr
+ * @param v3pdu	SNMPv3 PDU, or nullptr
+ * @param ip	Agent IP
+ * @param port	Agent port
+ * @return The target position
+ * @note The PDU holds the security context, so GETs are only merged if they use the same PDU
+ */
+u32 SnmpPlanner::findTarget(std::shared_ptr<Snmpv1Pdu> pdu, std::shared_ptr<Snmpv3Pdu> v3pdu, in_addr_t ip, u16 port) {
+
+	for(u32 i = 0; i < this->targets.size(); i++) {
+		SnmpPlannerTarget &target = this->targets[i];
+		if(target.pdu == pdu && target.v3pdu == v3pdu && target.ip == ip && target.port == port) {
+			return i;
+		}
+	}
+
+	SnmpPlannerTarget target;
+	target.pdu = pdu;
+	target.v3pdu = v3pdu;
+	target.ip = ip;
+	target.port = port;
+	target.valueSize = SNMPPLANNER_VALUE_SIZE;
+	target.tooBig = false;
+	if(v3pdu != nullptr) {
+		target.maxSize = (v3pdu->getAgentMaxSize() != 0) ? v3pdu->getAgentMaxSize() : SNMPPLANNER_DEFAULT_MAX_SIZE;
+		target.headerSize = SNMPPLANNER_V3_HEADER_SIZE;
+	} else {
+		target.maxSize = SNMPPLANNER_DEFAULT_MAX_SIZE;
+		target.headerSize = SNMPPLANNER_HEADER_SIZE + pdu->getCommunity().length();
+	}
+	this->targets.push_back(target);
+	return this->targets.size() - 1;
+}
+
+/**
+ * @brief Queue a GET, merging it with a pending GET for the same OID
+ * @param target	Target position
+ * @param oid		OID to get
+ * @param callback	Called with the result
+ * @param args		Callback arguments
+ */
+void SnmpPlanner::addGet(u32 target, const CompactOid &oid, SnmpPlannerCallback callback, void *args) {
+
+	SnmpPlannerTarget &plannerTarget = this->targets[target];
+	SnmpPlannerWaiter waiter = {callback, args};
+
+	auto it = plannerTarget.pendingMap.find(oid);
+	if(it != plannerTarget.pendingMap.end()) {
+		plannerTarget.pending[it->second].waiters.push_back(waiter);
+		return;
+	}
+
+	SnmpPlannedOid planned;
+	planned.oid = oid;
+	planned.waiters.push_back(waiter);
+	plannerTarget.pendingMap[oid] = plannerTarget.pending.size();
+	plannerTarget.pending.push_back(planned);
+}
+
+/**
+ * @brief Queue a GET to a SNMPv1/v2c agent, to be sent by flush()
+ * @param pdu		PDU used for the request, holding the community
+ * @param ip		Agent IP
+ * @param port		Agent port
+ * @param oid		OID to get
+ * @param callback	Called with the result
+ * @param args		Callback arguments
+ */
+void SnmpPlanner::get(std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port, const CompactOid &oid, SnmpPlannerCallback callback, void *args) {
+	this->addGet(this->findTarget(pdu, nullptr, ip, port), oid, callback, args);
+}
+
+/**
+ * @brief Queue a GET to a SNMPv3 agent, to be sent by flush()
+ * @param pdu		PDU used for the request, holding the user and context
+ * @param ip		Agent IP
+ * @param port		Agent port
+ * @param oid		OID to get
+ * @param callback	Called with the result
+ * @param args		Callback arguments
+ */
+void SnmpPlanner::get(std::shared_ptr<Snmpv3Pdu> pdu, in_addr_t ip, u16 port, const CompactOid &oid, SnmpPlannerCallback callback, void *args) {
+	this->addGet(this->findTarget(nullptr, pdu, ip, port), oid, callback, args);
+}
+
+/**
+ * @brief Set the largest message a SNMPv1/v2c agent can send
+ * @param pdu		PDU used for the requests
+ * @param ip		Agent IP
+ * @param port		Agent port
+ * @param maxSize	Message size, in bytes
+ * @note SNMPv3 agents tell it in their messages
+ */
+void SnmpPlanner::setMaxSize(std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port, u32 maxSize) {
+	this->targets[this->findTarget(pdu, nullptr, ip, port)].maxSize = maxSize;
+}
+
+/**
+ * @brief Estimate the size of a VarBind in the response
+ * @param target	Target of the request
+ * @param oid		Requested OID
+ * @return Estimated size, in bytes
+ */
+u32 SnmpPlanner::getVarBindSize(const SnmpPlannerTarget &target, const CompactOid &oid) {
+	return oid.getLength() + 4 + target.valueSize;		// OID and VarBind headers
+}
+
+/**
+ * @brief Send a batch of GETs, and keep it until its response
+ * @param batch Batch to send, moved into the outstanding batches
+ */
+void SnmpPlanner::sendBatch(SnmpPlannerBatch &batch) {
+
+	try {
+		SnmpPlannerTarget &target = this->targets[batch.target];
+		std::shared_ptr<BerNull> nullval = std::make_shared<BerNull>();
+
+		u32 id;
+		if(target.v3pdu != nullptr) {
+			for(u32 i = 0; i < batch.oids.size(); i++) {
+				target.v3pdu->addVarBind(std::make_shared<BerOid>(batch.oids[i].oid), nullval);
+			}
+			id = this->engine->sendRequest(target.v3pdu, SNMPV2_GETREQUEST, target.ip, target.port, SnmpPlanner::onResponse, this);
+		} else {
+			for(u32 i = 0; i < batch.oids.size(); i++) {
+				target.pdu->addVarBind(std::make_shared<BerOid>(batch.oids[i].oid), nullval);
+			}
+			id = this->engine->sendRequest(target.pdu, SNMPV1_GETREQUEST, target.ip, target.port, SnmpPlanner::onResponse, this);
+		}
+		this->batches[id] = std::move(batch);
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Send a batch again as two requests
+ * @param batch Batch to split, with at least two OIDs
+ */
+void SnmpPlanner::splitBatch(SnmpPlannerBatch &batch) {
+
+	u32 half = batch.oids.size() / 2;
+	SnmpPlannerBatch second;
+	second.target = batch.target;
+	second.size = batch.size / 2;
+	second.oids.assign(batch.oids.begin() + half, batch.oids.end());
+	batch.oids.resize(half);
+	batch.size /= 2;
+
+	this->sendBatch(batch);
+	this->sendBatch(second);
+}
+
+/**
+ * @brief Send every queued GET, merged into as few requests as possible
+ * @return Number of sent requests
+ */
+u32 SnmpPlanner::flush() {
+
+	u32 sent = 0;
+	for(u32 i = 0; i < this->targets.size(); i++) {
+		SnmpPlannerTarget &target = this->targets[i];
+		if(target.pending.empty()) continue;
+
+		// Fill each request up to the agent message size
+		SnmpPlannerBatch batch;
+		batch.target = i;
+		batch.size = target.headerSize;
+		for(u32 j = 0; j < target.pending.size(); j++) {
+			u32 size = this->getVarBindSize(target, target.pending[j].oid);
+			if(!batch.oids.empty() && batch.size + size > target.maxSize) {
+				this->sendBatch(batch);
+				sent++;
+				batch.target = i;
+				batch.size = target.headerSize;
+				batch.oids.clear();
+			}
+			batch.oids.push_back(std::move(target.pending[j]));
+			batch.size += size;
+		}
+		this->sendBatch(batch);
+		sent++;
+
+		target.pending.clear();
+		target.pendingMap.clear();
+	}
+
+	return sent;
+}
+
+/**
+ * @brief Send every queued GET, and block until all of them complete
+ */
+void SnmpPlanner::wait() {
+	this->flush();
+	while(!this->batches.empty()) {
+		this->engine->poll(this->engine->getTimeout());
+		this->flush();		// Callbacks may queue more GETs
+	}
+}
+
+/**
+ * @brief Report an error to the callers of some OIDs
+ * @param oids		Planned OIDs
+ * @param start		First OID to report
+ * @param end		End of the OIDs to report
+ * @param result	Request result
+ * @param errorText	Error description
+ */
+void SnmpPlanner::failOids(const std::vector<SnmpPlannedOid> &oids, u32 start, u32 end, const SnmpResult &result, const std::string &errorText) {
+	for(u32 i = start; i < end; i++) {
+		for(auto& waiter : oids[i].waiters) {
+			waiter.callback(NULL, result, errorText, waiter.args);
+		}
+	}
+}
+
+/**
+ * @brief Handle the response to a batch
+ * @param response Request outcome
+ */
+void SnmpPlanner::onResponse(SnmpEngineResponse *response) {
+
+	SnmpPlanner *planner = (SnmpPlanner*)response->args;
+	auto it = planner->batches.find(response->requestID);
+	if(it == planner->batches.end()) return;
+
+	SnmpPlannerBatch batch = std::move(it->second);
+	planner->batches.erase(it);
+	planner->handleResponse(response, batch);
+}
+
+/**
+ * @brief Give the response of a batch to its callers, or send it again in smaller requests
+ * @param response	Request outcome
+ * @param batch		Batch of the request
+ */
+void SnmpPlanner::handleResponse(SnmpEngineResponse *response, SnmpPlannerBatch &batch) {
+
+	SnmpPlannerTarget &target = this->targets[batch.target];
+	const SnmpResult &result = response->result;
+
+	if(result.status == SNMP_ERROR_RESPONSE) {
+
+		// The response does not fit the agent message size, so ask for less
+		if(result.errorStatus == SNMPV1_ERROR_TOOBIG && batch.oids.size() > 1) {
+			u32 maxSize = batch.size * 3 / 4;
+			if(maxSize < SNMPV3_MIN_MSG_SIZE) maxSize = SNMPV3_MIN_MSG_SIZE;
+			if(maxSize < target.maxSize) target.maxSize = maxSize;
+			target.tooBig = true;
+			this->splitBatch(batch);
+			return;
+		}
+
+		// SNMPv1 fails the whole request because of one VarBind, so only that one is reported
+		u32 index = result.errorIndex;
+		if(result.errorStatus != SNMPV1_ERROR_TOOBIG && index >= 1 && index <= batch.oids.size() && batch.oids.size() > 1) {
+			batch.size -= this->getVarBindSize(target, batch.oids[index - 1].oid);
+			this->failOids(batch.oids, index - 1, index, result, response->errorText);
+			batch.oids.erase(batch.oids.begin() + index - 1);
+			this->sendBatch(batch);
+			return;
+		}
+	}
+
+	if(result.status != SNMP_OK) {
+		this->failOids(batch.oids, 0, batch.oids.size(), result, response->errorText);
+		return;
+	}
+
+	u32 n;
+	const SnmpVarBind *varBinds;
+	if(response->v3pdu != nullptr) {
+		n = response->v3pdu->getNVarBinds();
+		varBinds = response->v3pdu->getVarBinds();
+		if(!target.tooBig && response->v3pdu->getAgentMaxSize() != 0) {
+			target.maxSize = response->v3pdu->getAgentMaxSize();
+		}
+	} else {
+		n = response->pdu->getNVarBinds();
+		varBinds = response->pdu->getVarBinds();
+	}
+
+	if(n != batch.oids.size()) {
+		SnmpResult mismatch = {SNMP_ERROR_VALUE, 0, SNMPV1_ERROR_NOERROR, 0};
+		this->failOids(batch.oids, 0, batch.oids.size(), mismatch, "Response VarBinds do not match the request");
+		return;
+	}
+
+	// Learn the value sizes of this agent, to plan the next requests
+	u32 requested = target.headerSize;
+	for(u32 i = 0; i < n; i++) {
+		requested += batch.oids[i].oid.getLength() + 4;
+	}
+	u32 valueSize = (response->size > requested) ? (response->size - requested) / n : 2;
+	target.valueSize = (target.valueSize + valueSize + 1) / 2;
+
+	// Callbacks may add targets, so the target is not used anymore
+	for(u32 i = 0; i < n; i++) {
+		for(auto& waiter : batch.oids[i].waiters) {
+			waiter.callback(&varBinds[i], result, response->errorText, waiter.args);
+		}
+	}
+}
+
+}
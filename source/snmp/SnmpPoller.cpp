@@ -0,0 +1,425 @@
+/**
+ * @file SnmpPoller.cpp
+ * @brief Periodic SNMP polling
+ */
+
+// Includes C/C++
+#include <stdlib.h>
+#include <stdexcept>
+
+// Own includes
+#include "snmp/SnmpPoller.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a SnmpPoller
+ * @param engine		Engine used for the requests
+ * @param tickMs		Scheduling resolution, in ms
+ * @param maxAgentPolls	Polls in flight to the same agent
+ */
+SnmpPoller::SnmpPoller(std::shared_ptr<SnmpEngine> engine, u32 tickMs, u32 maxAgentPolls) : planner(engine), wheel(tickMs, osGetTime()) {
+	this->engine = engine;
+	this->maxAgentPolls = (maxAgentPolls != 0) ? maxAgentPolls : 1;
+	this->thread = NULL;
+	this->running = false;
+	this->nPolls = 0;
+	LightLock_Init(&this->lock);
+}
+
+/**
+ * @brief Destructor for a SnmpPoller
+ */
+SnmpPoller::~SnmpPoller() {
+	this->stop();
+}
+
+/**
+ * @brief Find the agent of a poll target, adding it if needed
+ * @param pdu	SNMPv1/v2c PDU, or nullptr
+ * @param v3pdu	SNMPv3 PDU, or nullptr
+ * @param ip	Agent IP
+ * @param port	Agent port
+ * @return The agent position
+ */
+u32 SnmpPoller::findAgent(std::shared_ptr<Snmpv1Pdu> pdu, std::shared_ptr<Snmpv3Pdu> v3pdu, in_addr_t ip, u16 port) {
+
+	for(u32 i = 0; i < this->agents.size(); i++) {
+		SnmpPollAgent &agent = this->agents[i];
+		if(agent.pdu == pdu && agent.v3pdu == v3pdu && agent.ip == ip && agent.port == port) {
+			return i;
+		}
+	}
+
+	SnmpPollAgent agent;
+	agent.pdu = pdu;
+	agent.v3pdu = v3pdu;
+	agent.ip = ip;
+	agent.port = port;
+	agent.nPolling = 0;
+	this->agents.push_back(agent);
+	return this->agents.size() - 1;
+}
+
+/**
+ * @brief Add a poll target, scheduling its first poll at a random point of its interval
+ * @param agent		Agent position
+ * @param oids		OIDs to poll
+ * @param interval	Poll interval, in ms
+ * @param callback	Called for each polled OID
+ * @param args		Callback arguments
+ * @return The poll target ID
+ */
+u32 SnmpPoller::createTarget(u32 agent, const std::vector<CompactOid> &oids, u32 interval, SnmpPollerCallback callback, void *args) {
+
+	if(interval == 0) {
+		throw std::runtime_error("The poll interval can't be 0");
+	}
+	if(oids.empty()) {
+		throw std::runtime_error("There are no OIDs to poll");
+	}
+
+	std::shared_ptr<SnmpPollTarget> target = std::make_shared<SnmpPollTarget>();
+	target->poller = this;
+	target->id = this->targets.size();
+	target->agent = agent;
+	target->interval = interval;
+	target->nWaiting = 0;
+	target->polling = false;
+	target->queued = false;
+	target->active = true;
+	target->nOverruns = 0;
+	target->callback = callback;
+	target->args = args;
+
+	target->oids.resize(oids.size());
+	for(u32 i = 0; i < oids.size(); i++) {
+		SnmpPolledOid &oid = target->oids[i];
+		oid.oid = oids[i];
+		oid.poller = this;
+		oid.target = target->id;
+		oid.index = i;
+		oid.lastValue = 0;
+		oid.lastTime = 0;
+		oid.hasLast = false;
+	}
+
+	// Targets added together would otherwise poll in bursts forever
+	u32 delay = rand() % interval;
+	target->nextTime = osGetTime() + delay;
+	TimingWheel::initTimer(&target->timer, SnmpPoller::onTimer, target.get());
+	this->wheel.schedule(&target->timer, delay);
+
+	this->targets.push_back(target);
+	return target->id;
+}
+
+/**
+ * @brief Poll some OIDs of a SNMPv1/v2c agent periodically
+ * @param pdu		PDU used for the requests, holding the community
+ * @param ip		Agent IP
+ * @param port		Agent port
+ * @param oids		OIDs to poll
+ * @param interval	Poll interval, in ms
+ * @param callback	Called for each polled OID
+ * @param args		Callback arguments
+ * @return The poll target ID
+ */
+u32 SnmpPoller::addTarget(std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port, const std::vector<CompactOid> &oids, u32 interval, SnmpPollerCallback callback, void *args) {
+
+	LightLock_Lock(&this->lock);
+	try {
+		u32 id = this->createTarget(this->findAgent(pdu, nullptr, ip, port), oids, interval, callback, args);
+		LightLock_Unlock(&this->lock);
+		return id;
+	} catch (const std::runtime_error &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	} catch (const std::bad_alloc &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	}
+}
+
+/**
+ * @brief Poll some OIDs of a SNMPv3 agent periodically
+ * @param pdu		PDU used for the requests, holding the user and context
+ * @param ip		Agent IP
+ * @param port		Agent port
+ * @param oids		OIDs to poll
+ * @param interval	Poll interval, in ms
+ * @param callback	Called for each polled OID
+ * @param args		Callback arguments
+ * @return The poll target ID
+ */
+u32 SnmpPoller::addTarget(std::shared_ptr<Snmpv3Pdu> pdu, in_addr_t ip, u16 port, const std::vector<CompactOid> &oids, u32 interval, SnmpPollerCallback callback, void *args) {
+
+	LightLock_Lock(&this->lock);
+	try {
+		u32 id = this->createTarget(this->findAgent(nullptr, pdu, ip, port), oids, interval, callback, args);
+		LightLock_Unlock(&this->lock);
+		return id;
+	} catch (const std::runtime_error &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	} catch (const std::bad_alloc &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	}
+}
+
+/**
+ * @brief Stop polling a target
+ * @param id Poll target ID
+ * @note A poll in flight is completed, but its samples are not reported
+ */
+void SnmpPoller::removeTarget(u32 id) {
+
+	LightLock_Lock(&this->lock);
+	if(id < this->targets.size() && this->targets[id] != nullptr) {
+		SnmpPollTarget *target = this->targets[id].get();
+		target->active = false;
+		this->wheel.cancel(&target->timer);
+		if(!target->polling) {
+			this->targets[id] = nullptr;		// Queued targets are skipped when their turn comes
+		}
+	}
+	LightLock_Unlock(&this->lock);
+}
+
+/**
+ * @brief Get the number of polls skipped because the previous one was still running
+ * @param id Poll target ID
+ * @return Number of skipped polls
+ */
+u32 SnmpPoller::getNOverruns(u32 id) {
+	u32 nOverruns = 0;
+	LightLock_Lock(&this->lock);
+	if(id < this->targets.size() && this->targets[id] != nullptr) {
+		nOverruns = this->targets[id]->nOverruns;
+	}
+	LightLock_Unlock(&this->lock);
+	return nOverruns;
+}
+
+/**
+ * @brief Queue the GETs of a poll
+ * @param target Poll target
+ */
+void SnmpPoller::startPoll(SnmpPollTarget *target) {
+
+	SnmpPollAgent &agent = this->agents[target->agent];
+	target->polling = true;
+	target->nWaiting = target->oids.size();
+	agent.nPolling++;
+	this->nPolls++;
+
+	for(auto& oid : target->oids) {
+		if(agent.v3pdu != nullptr) {
+			this->planner.get(agent.v3pdu, agent.ip, agent.port, oid.oid, SnmpPoller::onValue, &oid);
+		} else {
+			this->planner.get(agent.pdu, agent.ip, agent.port, oid.oid, SnmpPoller::onValue, &oid);
+		}
+	}
+}
+
+/**
+ * @brief End a poll, giving its slot to the next waiting target of the agent
+ * @param target Poll target
+ */
+void SnmpPoller::finishPoll(SnmpPollTarget *target) {
+
+	SnmpPollAgent &agent = this->agents[target->agent];
+	target->polling = false;
+	agent.nPolling--;
+	if(!target->active) {
+		this->targets[target->id] = nullptr;
+	}
+
+	while(agent.nPolling < this->maxAgentPolls && !agent.waiting.empty()) {
+		SnmpPollTarget *next = this->targets[agent.waiting.front()].get();
+		agent.waiting.pop_front();
+		if(next == nullptr) continue;
+		next->queued = false;
+		if(next->active) {
+			this->startPoll(next);
+		} else {
+			this->targets[next->id] = nullptr;
+		}
+	}
+}
+
+/**
+ * @brief Compute the rate of a counter
+ * @param oid	Polled OID, holding the previous value
+ * @param value	Received value
+ * @param time	Reception time, in ms
+ * @param rate	Increase per second
+ * @return If the rate could be computed
+ * @note A decrease is taken as a single wraparound, so counters must be polled faster than they can wrap twice
+ */
+bool SnmpPoller::computeRate(SnmpPolledOid &oid, const VarBindValue &value, u64 time, double *rate) {
+
+	u64 current = value.getUnsigned();
+	u64 delta;
+	if(value.getType() == VARBIND_COUNTER64) {
+		delta = current - oid.lastValue;						// Modulo 2^64
+	} else if(value.getType() == VARBIND_UNSIGNED && value.getTag() == (SNMPV1_TAGCLASS_COUNTER | SNMPV1_TAG_COUNTER)) {
+		delta = (u32)(current - oid.lastValue);					// Modulo 2^32
+	} else {
+		oid.hasLast = false;
+		return false;
+	}
+
+	bool valid = oid.hasLast && time > oid.lastTime;
+	if(valid) {
+		*rate = (double)delta * 1000.0 / (double)(time - oid.lastTime);
+	}
+
+	oid.lastValue = current;
+	oid.lastTime = time;
+	oid.hasLast = true;
+	return valid;
+}
+
+/**
+ * @brief Start the poll of a target, or queue it if its agent is busy
+ * @param args Poll target
+ */
+void SnmpPoller::onTimer(void *args) {
+
+	SnmpPollTarget *target = (SnmpPollTarget*)args;
+	SnmpPoller *poller = target->poller;
+
+	// Keep the phase, skipping the polls missed while the thread was not running
+	u64 now = osGetTime();
+	target->nextTime += target->interval;
+	if(target->nextTime <= now) {
+		target->nextTime += ((now - target->nextTime) / target->interval + 1) * target->interval;
+	}
+	poller->wheel.schedule(&target->timer, target->nextTime - now);
+
+	if(target->polling || target->queued) {
+		target->nOverruns++;
+		return;
+	}
+
+	SnmpPollAgent &agent = poller->agents[target->agent];
+	if(agent.nPolling < poller->maxAgentPolls) {
+		poller->startPoll(target);
+	} else {
+		target->queued = true;
+		agent.waiting.push_back(target->id);
+	}
+}
+
+/**
+ * @brief Report the value of a polled OID
+ * @param varBind	Received VarBind, or NULL if the GET failed
+ * @param result	Request result
+ * @param errorText	Error description
+ * @param args		Polled OID
+ */
+void SnmpPoller::onValue(const SnmpVarBind *varBind, const SnmpResult &result, const std::string &errorText, void *args) {
+
+	SnmpPolledOid *oid = (SnmpPolledOid*)args;
+	SnmpPoller *poller = oid->poller;
+
+	LightLock_Lock(&poller->lock);
+	SnmpPollTarget *target = poller->targets[oid->target].get();
+
+	SnmpPollSample sample;
+	sample.target = oid->target;
+	sample.index = oid->index;
+	sample.varBind = varBind;
+	sample.result = result;
+	sample.time = osGetTime();
+	sample.hasRate = false;
+	sample.rate = 0;
+	if(varBind != NULL) {
+		sample.hasRate = SnmpPoller::computeRate(*oid, varBind->value, sample.time, &sample.rate);
+	} else {
+		oid->hasLast = false;
+	}
+
+	if(target->active && target->callback != NULL) {
+		target->callback(&sample, target->args);
+	}
+
+	target->nWaiting--;
+	if(target->nWaiting == 0) {
+		poller->finishPoll(target);
+	}
+	LightLock_Unlock(&poller->lock);
+}
+
+/**
+ * @brief Run the polls due, and handle the responses
+ * @param waitMs Time to wait for responses, in ms
+ * @note start() calls it from the poller thread. It can be called from another loop instead.
+ */
+void SnmpPoller::step(u32 waitMs) {
+
+	try {
+		if(this->engine->getNPending() != 0) {
+			this->engine->poll(waitMs);
+		} else {
+			svcSleepThread((s64)waitMs * 1000000LL);
+		}
+
+		LightLock_Lock(&this->lock);
+		this->wheel.advance(osGetTime());
+		LightLock_Unlock(&this->lock);
+
+		this->planner.flush();
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Poller thread
+ * @param args Poller
+ */
+void SnmpPoller::threadMain(void *args) {
+	SnmpPoller *poller = (SnmpPoller*)args;
+	while(poller->running) {
+		try {
+			poller->step(poller->wheel.getTickMs());
+		} catch (const std::runtime_error &e) {
+			svcSleepThread((s64)poller->wheel.getTickMs() * 1000000LL);	// The network may come back
+		}
+	}
+}
+
+/**
+ * @brief Start polling, from a new thread
+ */
+void SnmpPoller::start() {
+
+	if(this->running) return;
+	this->running = true;
+
+	s32 prio = 0;
+	svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+	this->thread = threadCreate(SnmpPoller::threadMain, this, SNMPPOLLER_STACKSIZE, prio-1, -2, false);
+	if(this->thread == NULL) {
+		this->running = false;
+		throw std::runtime_error("Can't create poller thread");
+	}
+}
+
+/**
+ * @brief Stop polling, waiting for the poller thread to end
+ */
+void SnmpPoller::stop() {
+	if(!this->running) return;
+	this->running = false;
+	threadJoin(this->thread, U64_MAX);
+	threadFree(this->thread);
+	this->thread = NULL;
+}
+
+}
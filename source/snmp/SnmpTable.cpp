@@ -0,0 +1,504 @@
+/**
+ * @file SnmpTable.cpp
+ * @brief Whole SNMP table retrieval, stored by columns
+ */
+
+// Includes C/C++
+#include <algorithm>
+#include <stdexcept>
+#include <stdlib.h>
+
+// Own includes
+#include "snmp/SnmpTable.h"
+#include "asn1/BerInteger.h"
+#include "asn1/BerNull.h"
+#include "asn1/BerOctetString.h"
+#include "asn1/OidCodec.h"
+
+namespace NetMan {
+
+/**
+ * @struct SnmpTableWalkArgs
+ * @brief Callback arguments of a column walk
+ */
+typedef struct {
+	SnmpTable *table;
+	u32 column;
+} SnmpTableWalkArgs;
+
+/**
+ * @brief Split an INDEX or AUGMENTS clause into object names
+ * @param clause	Clause contents
+ * @param names		Object names and IMPLIED keywords (output)
+ */
+static void snmptable_split_index(const std::string &clause, std::vector<std::string> &names) {
+	names.clear();
+	std::string name;
+	for(u32 i = 0; i <= clause.length(); i++) {
+		char c = (i < clause.length()) ? clause[i] : ' ';
+		if(c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '{' || c == '}') {
+			if(!name.empty()) names.push_back(name);
+			name.clear();
+		} else {
+			name.push_back(c);
+		}
+	}
+}
+
+/**
+ * @brief Find how an INDEX object is encoded, from its SYNTAX clause
+ * @param syntax	SYNTAX clause of the object
+ * @param index		Index object to fill
+ * @note Textual conventions are not resolved, so only the common string ones are known
+ */
+static void snmptable_parse_syntax(const std::string &syntax, SnmpTableIndex *index) {
+
+	static const char *stringTypes[] = {
+		"OCTET", "DisplayString", "SnmpAdminString", "PhysAddress", "MacAddress", "OwnerString",
+		"SnmpEngineID", "SnmpTagValue", "TAddress", "InetAddress",
+	};
+
+	index->type = SNMPINDEX_INTEGER;
+	index->size = 0;
+
+	// First word of the syntax
+	size_t start = syntax.find_first_not_of(" \t\r\n");
+	if(start == std::string::npos) return;
+	size_t end = syntax.find_first_of(" \t\r\n(", start);
+	std::string type = syntax.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+	if(type == "IpAddress" || type == "NetworkAddress") {
+		index->type = SNMPINDEX_IPADDRESS;
+		return;
+	}
+	if(type == "OBJECT" || type == "AutonomousType" || type == "RowPointer") {
+		index->type = SNMPINDEX_OID;
+		return;
+	}
+	for(u32 i = 0; i < sizeof(stringTypes) / sizeof(char*); i++) {
+		if(type == stringTypes[i]) {
+			index->type = SNMPINDEX_STRING;
+			break;
+		}
+	}
+	if(index->type != SNMPINDEX_STRING) return;
+	if(type == "MacAddress") {
+		index->size = 6;
+		return;
+	}
+
+	// A single SIZE value means a fixed size string, which has no length arc
+	size_t size = syntax.find("SIZE");
+	if(size == std::string::npos) return;
+	size_t digits = syntax.find_first_of("0123456789", size);
+	if(digits == std::string::npos) return;
+	char *ptr;
+	u32 value = strtoul(syntax.c_str() + digits, &ptr, 10);
+	while(*ptr == ' ') ptr++;
+	if(*ptr == ')') index->size = value;
+}
+
+/**
+ * @brief Get the type character of a received value, as used by PduField
+ * @param tag Identifier octet of the value
+ * @return The type character, or '\0' for exceptions and unknown types
+ */
+static char snmptable_type_char(u8 tag) {
+	switch(tag) {
+		case (BER_TAGCLASS_INTEGER | BER_TAG_INTEGER):							return 'i';
+		case (BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING):					return 's';
+		case (BER_TAGCLASS_NULL | BER_TAG_NULL):								return 'n';
+		case (BER_TAGCLASS_OID | BER_TAG_OID):									return 'O';
+		case (SNMPV1_TAGCLASS_NETWORKADDRESS | SNMPV1_TAG_NETWORKADDRESS):		return 'a';
+		case (SNMPV1_TAGCLASS_COUNTER | SNMPV1_TAG_COUNTER):					return 'c';
+		case (SNMPV2_TAGCLASS_COUNTER64 | SNMPV2_TAG_COUNTER64):				return 'C';
+		case (SNMPV1_TAGCLASS_GAUGE | SNMPV1_TAG_GAUGE):						return 'g';
+		case (SNMPV1_TAGCLASS_TIMETICKS | SNMPV1_TAG_TIMETICKS):				return 't';
+		case (SNMPV1_TAGCLASS_OPAQUE | SNMPV1_TAG_OPAQUE):						return 'o';
+		default:																return '\0';
+	}
+}
+
+/**
+ * @brief Decode the arcs of an instance suffix
+ * @param instance	Instance suffix
+ * @param arcs		Arc values (output)
+ */
+static void snmptable_decode_arcs(const CompactOid &instance, std::vector<u32> &arcs) {
+	arcs.resize(OidCodec::countArcs(instance.getData(), instance.getLength()));
+	OidCodec::decodeArcs(instance.getData(), instance.getLength(), arcs.data(), arcs.size());
+}
+
+/**
+ * @brief Append some arcs in dotted notation
+ * @param text	Destination string
+ * @param arcs	Arc values
+ * @param start	First arc to append
+ * @param end	End of the arcs to append
+ */
+static void snmptable_append_arcs(std::string &text, const std::vector<u32> &arcs, u32 start, u32 end) {
+	for(u32 i = start; i < end; i++) {
+		if(i != start) text.push_back('.');
+		text.append(std::to_string(arcs[i]));
+	}
+}
+
+/**
+ * @brief Append a string index, quoted if printable or in hexadecimal if not
+ * @param text	Destination string
+ * @param arcs	Arc values, one per octet
+ * @param start	First octet
+ * @param end	End of the octets
+ */
+static void snmptable_append_string(std::string &text, const std::vector<u32> &arcs, u32 start, u32 end) {
+
+	static const char hex[] = "0123456789abcdef";
+
+	bool printable = true;
+	for(u32 i = start; i < end; i++) {
+		if(arcs[i] < ' ' || arcs[i] > '~') printable = false;
+	}
+
+	if(printable) {
+		text.push_back('"');
+		for(u32 i = start; i < end; i++) text.push_back(arcs[i]);
+		text.push_back('"');
+	} else {
+		for(u32 i = start; i < end; i++) {
+			if(i != start) text.push_back(':');
+			text.push_back(hex[(arcs[i] >> 4) &0xF]);
+			text.push_back(hex[arcs[i] &0xF]);
+		}
+	}
+}
+
+/**
+ * @brief Constructor for a SnmpTable
+ * @param mib		MIB defining the table
+ * @param tableName	Name of the table object
+ */
+SnmpTable::SnmpTable(std::shared_ptr<Mib> mib, const std::string &tableName) {
+
+	try {
+		auto oidTree = mib->getOidTree();
+		auto it = oidTree->find(tableName);
+		if(it == oidTree->end() || it->second->children.empty()) {
+			throw std::runtime_error("Unknown table " + tableName);
+		}
+
+		// The only child of a table is its entry, whose children are the columns
+		auto entry = it->second->children.begin();
+		for(auto& column : entry->second->children) {
+			SnmpTableColumn tableColumn;
+			tableColumn.name = column.first;
+			tableColumn.oid = mib->resolve(column.first)->getOid();
+			tableColumn.type = '\0';
+			this->columns.push_back(tableColumn);
+		}
+		std::sort(this->columns.begin(), this->columns.end(), [](const SnmpTableColumn &a, const SnmpTableColumn &b) {
+			return a.oid < b.oid;
+		});
+
+		this->parseIndexes(mib, entry->first);
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Read the INDEX objects of the table entry
+ * @param mib		MIB defining the table
+ * @param entryName	Name of the table entry
+ */
+void SnmpTable::parseIndexes(std::shared_ptr<Mib> mib, const std::string &entryName) {
+
+	auto oidTree = mib->getOidTree();
+	std::vector<std::string> names;
+
+	auto it = oidTree->find(entryName);
+	if(it == oidTree->end() || it->second->macroType != MACRO_OBJECT_TYPE) return;
+	snmptable_split_index(((MibObjectType*)it->second->macroData.get())->indexPart, names);
+
+	// AUGMENTS names another entry, which holds the INDEX clause
+	if(names.size() == 1) {
+		it = oidTree->find(names[0]);
+		if(it != oidTree->end() && it->second->macroType == MACRO_OBJECT_TYPE) {
+			MibObjectType *augmented = (MibObjectType*)it->second->macroData.get();
+			if(!augmented->indexPart.empty()) {
+				snmptable_split_index(augmented->indexPart, names);
+			}
+		}
+	}
+
+	bool implied = false;
+	for(u32 i = 0; i < names.size(); i++) {
+		if(names[i] == "IMPLIED") {
+			implied = true;
+			continue;
+		}
+
+		SnmpTableIndex index;
+		index.name = names[i];
+		index.implied = implied;
+		index.type = SNMPINDEX_INTEGER;
+		index.size = 0;
+		it = oidTree->find(names[i]);
+		if(it != oidTree->end() && it->second->macroType == MACRO_OBJECT_TYPE) {
+			snmptable_parse_syntax(((MibObjectType*)it->second->macroData.get())->syntax, &index);
+		}
+		this->indexes.push_back(index);
+		implied = false;
+	}
+}
+
+/**
+ * @brief Get the position of a row, adding it if needed
+ * @param instance Row instance, as an OID suffix
+ * @return The row position
+ */
+u32 SnmpTable::getRow(const CompactOid &instance) {
+
+	auto it = this->rowMap.find(instance);
+	if(it != this->rowMap.end()) return it->second;
+
+	u32 row = this->rows.size();
+	this->rows.push_back(instance);
+	this->rowMap[instance] = row;
+	for(auto& column : this->columns) {
+		column.values.push_back(std::string());
+	}
+	return row;
+}
+
+/**
+ * @brief Store a received value
+ * @param column	Column position
+ * @param varBind	Received VarBind, inside the column subtree
+ */
+void SnmpTable::addValue(u32 column, const SnmpVarBind *varBind) {
+
+	SnmpTableColumn &tableColumn = this->columns[column];
+	u32 prefix = tableColumn.oid.getLength();
+	CompactOid instance(varBind->oid.getValue() + prefix, varBind->oid.getLength() - prefix);
+
+	u32 row = this->getRow(instance);
+	tableColumn.values[row] = varBind->value.print();
+	if(tableColumn.type == '\0') {
+		tableColumn.type = snmptable_type_char(varBind->value.getTag());
+	}
+}
+
+/**
+ * @brief Put the rows in instance order
+ * @note Columns are walked separately, so sparse columns can add rows out of order
+ */
+void SnmpTable::sortRows() {
+
+	std::vector<u32> order(this->rows.size());
+	for(u32 i = 0; i < order.size(); i++) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [this](u32 a, u32 b) {
+		return this->rows[a] < this->rows[b];
+	});
+
+	bool sorted = true;
+	for(u32 i = 0; i < order.size() && sorted; i++) {
+		sorted = order[i] == i;
+	}
+	if(sorted) return;
+
+	std::vector<CompactOid> sortedRows(order.size());
+	for(u32 i = 0; i < order.size(); i++) {
+		sortedRows[i] = this->rows[order[i]];
+		this->rowMap[sortedRows[i]] = i;
+	}
+	this->rows.swap(sortedRows);
+
+	std::vector<std::string> sortedValues(order.size());
+	for(auto& column : this->columns) {
+		for(u32 i = 0; i < order.size(); i++) {
+			sortedValues[i].swap(column.values[order[i]]);
+		}
+		column.values.swap(sortedValues);
+	}
+}
+
+/**
+ * @brief Store a VarBind received by a column walk
+ * @param varBind	Received VarBind
+ * @param args		SnmpTableWalkArgs of the column
+ * @return true, to walk the whole column
+ */
+bool SnmpTable::addVarBind(const SnmpVarBind *varBind, void *args) {
+	SnmpTableWalkArgs *walkArgs = (SnmpTableWalkArgs*)args;
+	walkArgs->table->addValue(walkArgs->column, varBind);
+	return true;
+}
+
+/**
+ * @brief Walk every column, keeping a few of them in flight
+ * @param engine	Engine used to send the requests
+ * @param pdu		PDU shared by the column walks
+ * @param ip		Agent IP
+ * @param port		Agent port
+ */
+template<class T>
+void SnmpTable::fetchColumns(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<T> pdu, in_addr_t ip, u16 port) {
+
+	this->clear();
+
+	std::vector<SnmpTableWalkArgs> args(this->columns.size());
+	std::vector<std::unique_ptr<SnmpWalk>> walks(this->columns.size());
+	u32 next = 0;
+	u32 running = 0;
+
+	try {
+		while(next < this->columns.size() || running > 0) {
+
+			// Start walking the next columns
+			while(running < SNMPTABLE_MAX_WALKS && next < this->columns.size()) {
+				args[next].table = this;
+				args[next].column = next;
+				walks[next] = std::unique_ptr<SnmpWalk>(new SnmpWalk(engine, pdu, ip, port));
+				walks[next]->start(this->columns[next].oid, SnmpTable::addVarBind, &args[next]);
+				next++;
+				running++;
+			}
+
+			engine->poll(engine->getTimeout());
+
+			// Check the finished columns
+			running = 0;
+			for(u32 i = 0; i < next; i++) {
+				if(walks[i] == nullptr) continue;
+				if(walks[i]->isRunning()) {
+					running++;
+					continue;
+				}
+				if(walks[i]->getResult().status != SNMP_OK) {
+					throw std::runtime_error(this->columns[i].name + ": " + walks[i]->getErrorText());
+				}
+				walks[i] = nullptr;
+			}
+		}
+
+		this->sortRows();
+	} catch (const std::runtime_error &e) {
+		this->clear();
+		throw;
+	} catch (const std::bad_alloc &e) {
+		this->clear();
+		throw;
+	}
+}
+
+/**
+ * @brief Fetch the whole table from a SNMPv1/v2c agent
+ * @param engine	Engine used to send the requests
+ * @param pdu		PDU used for the requests. A Snmpv2Pdu uses GetBulkRequests, a Snmpv1Pdu GetNextRequests.
+ * @param ip		Agent IP
+ * @param port		Agent port
+ */
+void SnmpTable::fetch(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port) {
+	this->fetchColumns(engine, pdu, ip, port);
+}
+
+/**
+ * @brief Fetch the whole table from a SNMPv3 agent
+ * @param engine	Engine used to send the requests
+ * @param pdu		PDU used for the requests
+ * @param ip		Agent IP
+ * @param port		Agent port
+ */
+void SnmpTable::fetch(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<Snmpv3Pdu> pdu, in_addr_t ip, u16 port) {
+	this->fetchColumns(engine, pdu, ip, port);
+}
+
+/**
+ * @brief Remove every row
+ */
+void SnmpTable::clear() {
+	this->rows.clear();
+	this->rowMap.clear();
+	for(auto& column : this->columns) {
+		column.values.clear();
+	}
+}
+
+/**
+ * @brief Get the OID of a table cell
+ * @param column	Column position
+ * @param row		Row position
+ * @return The column OID followed by the row instance
+ */
+CompactOid SnmpTable::getInstanceOid(u32 column, u32 row) {
+	std::vector<u32> arcs;
+	snmptable_decode_arcs(this->rows[row], arcs);
+	CompactOid oid = this->columns[column].oid;
+	for(u32 i = 0; i < arcs.size(); i++) {
+		oid.append(arcs[i]);
+	}
+	return oid;
+}
+
+/**
+ * @brief Print the INDEX values of a row
+ * @param row Row position
+ * @return The INDEX values, separated by commas
+ * @note Arcs not matching the INDEX clause are printed in dotted notation
+ */
+std::string SnmpTable::printIndex(u32 row) {
+
+	std::vector<u32> arcs;
+	snmptable_decode_arcs(this->rows[row], arcs);
+
+	std::string text;
+	u32 pos = 0;
+	for(u32 i = 0; i < this->indexes.size() && pos < arcs.size(); i++) {
+		const SnmpTableIndex &index = this->indexes[i];
+		bool last = (i == this->indexes.size() - 1);
+
+		// Find where this object ends
+		u32 start = pos;
+		u32 end;
+		switch(index.type) {
+			case SNMPINDEX_IPADDRESS:
+				end = pos + 4;
+				break;
+			case SNMPINDEX_STRING:
+			case SNMPINDEX_OID:
+				if(index.size != 0) {
+					end = pos + index.size;
+				} else if(index.implied && last) {
+					end = arcs.size();
+				} else {
+					start = pos + 1;
+					end = start + arcs[pos];
+				}
+				break;
+			default:
+				end = pos + 1;
+				break;
+		}
+		if(end > arcs.size() || end < start) break;
+
+		if(!text.empty()) text.append(", ");
+		if(index.type == SNMPINDEX_STRING) {
+			snmptable_append_string(text, arcs, start, end);
+		} else {
+			snmptable_append_arcs(text, arcs, start, end);
+		}
+		pos = end;
+	}
+
+	// Arcs without a known INDEX object
+	if(pos < arcs.size()) {
+		if(!text.empty()) text.append(", ");
+		snmptable_append_arcs(text, arcs, pos, arcs.size());
+	}
+
+	return text;
+}
+
+}
@@ -0,0 +1,199 @@
+/**
+ * @file SnmpVarBind.cpp
+ * @brief Typed SNMP VarBind values
+ */
+
+// Includes C/C++
+#include <string.h>
+
+// Own includes
+#include "snmp/SnmpVarBind.h"
+#include "snmp/Snmpv2Pdu.h"
+#include "asn1/BerInteger.h"
+#include "asn1/BerNull.h"
+#include "asn1/BerOctetString.h"
+#include "asn1/BerOid.h"
+
+namespace NetMan {
+
+/**
+ * @brief Append an unsigned number to a string
+ * @param text	Destination string
+ * @param value	Number to append
+ */
+static void varbind_append_decimal(std::string &text, u64 value) {
+	char tmp[20];
+	char *ptr = tmp + sizeof(tmp);
+	do {
+		*--ptr = '0' + value % 10;
+		value /= 10;
+	} while(value != 0);
+	text.append(ptr, tmp + sizeof(tmp) - ptr);
+}
+
+/**
+ * @brief Constructor for a NULL VarBindValue
+ */
+VarBindValue::VarBindValue() {
+	this->uinteger = 0;
+	this->length = 0;
+	this->type = VARBIND_NULL;
+	this->tag = BER_TAGCLASS_NULL | BER_TAG_NULL;
+}
+
+/**
+ * @brief Decode a VarBind value, without throwing
+ * @param view	Value field
+ * @param value	Decoded value (output, only set on success)
+ * @return BER_OK, BER_ERROR_TAG for unknown types, or BER_ERROR_VALUE for malformed contents
+ */
+BerStatus VarBindValue::decode(const BerView &view, VarBindValue *value) {
+
+	BerStatus status = BerField::validate(view);
+	if(status != BER_OK) return status;
+
+	value->tag = view.getTag();
+	value->length = 0;
+	switch(view.getTag()) {
+		case (BER_TAG_INTEGER | BER_TAGCLASS_INTEGER):
+			value->type = VARBIND_INTEGER;
+			return view.getInteger(true, &value->uinteger);
+		case (SNMPV1_TAG_COUNTER | SNMPV1_TAGCLASS_COUNTER):
+		case (SNMPV1_TAG_GAUGE | SNMPV1_TAGCLASS_GAUGE):
+		case (SNMPV1_TAG_TIMETICKS | SNMPV1_TAGCLASS_TIMETICKS):
+			value->type = VARBIND_UNSIGNED;
+			return view.getInteger(false, &value->uinteger);
+		case (SNMPV2_TAG_COUNTER64 | SNMPV2_TAGCLASS_COUNTER64):
+			value->type = VARBIND_COUNTER64;
+			return view.getInteger(false, &value->uinteger);
+		case (BER_TAG_OCTETSTRING | BER_TAGCLASS_OCTETSTRING):
+		case (SNMPV1_TAG_NETWORKADDRESS | SNMPV1_TAGCLASS_NETWORKADDRESS):
+		case (SNMPV1_TAG_OPAQUE | SNMPV1_TAGCLASS_OPAQUE):
+			value->type = VARBIND_OCTETS;
+			break;
+		case (BER_TAG_OID | BER_TAGCLASS_OID):
+			value->type = VARBIND_OID;
+			break;
+		case (SNMPV2_TAG_NOSUCHOBJECT | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+			value->type = VARBIND_NOSUCHOBJECT;
+			value->uinteger = 0;
+			return BER_OK;
+		case (SNMPV2_TAG_NOSUCHINSTANCE | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+			value->type = VARBIND_NOSUCHINSTANCE;
+			value->uinteger = 0;
+			return BER_OK;
+		case (SNMPV2_TAG_ENDOFMIBVIEW | SNMPV2_TAGCLASS_VALUE_EXCEPTION):
+			value->type = VARBIND_ENDOFMIBVIEW;
+			value->uinteger = 0;
+			return BER_OK;
+		default:
+			value->type = VARBIND_NULL;
+			value->uinteger = 0;
+			return BER_OK;
+	}
+
+	// Octet strings and OIDs keep pointing into the message
+	value->data = view.getValue();
+	value->length = view.getLength();
+	return BER_OK;
+}
+
+/**
+ * @brief Copy an octet string value into a string
+ * @return The value contents, or an empty string for other types
+ */
+std::string VarBindValue::getString() const {
+	if(this->type != VARBIND_OCTETS) return std::string();
+	return std::string((const char*)this->data, this->length);
+}
+
+/**
+ * @brief Copy an OID value into a CompactOid
+ * @return The OID, or an empty OID for other types
+ */
+CompactOid VarBindValue::getOid() const {
+	if(this->type != VARBIND_OID) return CompactOid();
+	return CompactOid(this->data, this->length);
+}
+
+/**
+ * @brief Compare an octet string value
+ * @param text	String to compare with
+ * @return If both contents are equal
+ */
+bool VarBindValue::equals(const std::string &text) const {
+	return this->type == VARBIND_OCTETS && text.length() == this->length && memcmp(text.c_str(), this->data, this->length) == 0;
+}
+
+/**
+ * @brief Print a VarBindValue
+ * @return The value representation
+ */
+std::string VarBindValue::print() const {
+
+	std::string text;
+	switch(this->type) {
+		case VARBIND_INTEGER:
+			if(this->integer < 0) {
+				text.push_back('-');
+				varbind_append_decimal(text, -(u64)this->integer);
+			} else {
+				varbind_append_decimal(text, this->uinteger);
+			}
+			return text;
+		case VARBIND_UNSIGNED:
+		case VARBIND_COUNTER64:
+			varbind_append_decimal(text, this->uinteger);
+			return text;
+		case VARBIND_OCTETS:
+			if(this->tag == (SNMPV1_TAG_NETWORKADDRESS | SNMPV1_TAGCLASS_NETWORKADDRESS) && this->length == 4) {
+				for(u8 i = 0; i < 4; i++) {
+					if(i != 0) text.push_back('.');
+					varbind_append_decimal(text, this->data[i]);
+				}
+				return text;
+			}
+			return this->getString();
+		case VARBIND_OID:
+			return CompactOid::print(this->data, this->length);
+		case VARBIND_NOSUCHOBJECT:
+			return "noSuchObject";
+		case VARBIND_NOSUCHINSTANCE:
+			return "noSuchInstance";
+		case VARBIND_ENDOFMIBVIEW:
+			return "endOfMibView";
+		default:
+			return "null";
+	}
+}
+
+/**
+ * @brief Copy the value into a BerField, with the same type and tag
+ * @param arena	Arena used for the field (optional)
+ * @return The created field
+ */
+std::shared_ptr<BerField> VarBindValue::toBerField(const std::shared_ptr<BerArena> &arena) const {
+
+	u8 tagOptions = this->tag &~0x1F;
+	u32 tagNumber = this->tag &0x1F;
+
+	try {
+		switch(this->type) {
+			case VARBIND_INTEGER:
+				return makeBerField<BerInteger>(arena, this->uinteger, true, tagOptions, tagNumber);
+			case VARBIND_UNSIGNED:
+			case VARBIND_COUNTER64:
+				return makeBerField<BerInteger>(arena, this->uinteger, false, tagOptions, tagNumber);
+			case VARBIND_OCTETS:
+				return makeBerField<BerOctetString>(arena, this->getString(), tagOptions, tagNumber);
+			case VARBIND_OID:
+				return makeBerField<BerOid>(arena, this->getOid(), tagOptions, tagNumber);
+			default:
+				return makeBerField<BerNull>(arena, tagOptions, tagNumber);
+		}
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+}
@@ -0,0 +1,330 @@
+/**
+ * @file SnmpWalk.cpp
+ * @brief Adaptive SNMP subtree walk
+ */
+
+// Includes C/C++
+#include <stdexcept>
+
+// Includes 3DS
+#include <3ds.h>
+
+// Own includes
+#include "snmp/SnmpWalk.h"
+#include "asn1/BerNull.h"
+#include "asn1/BerOid.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a SNMPv1/v2c walk
+ * @param engine	Engine used to send the requests
+ * @param pdu		PDU used for the requests. A Snmpv2Pdu walks with GetBulkRequests, a Snmpv1Pdu with GetNextRequests.
+ * @param ip		Agent IP
+ * @param port		Agent port
+ */
+SnmpWalk::SnmpWalk(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<Snmpv1Pdu> pdu, in_addr_t ip, u16 port) {
+	this->initialize(engine, ip, port);
+	this->pdu = pdu;
+	this->v3pdu = nullptr;
+	this->bulk = std::dynamic_pointer_cast<Snmpv2Pdu>(pdu) != nullptr;
+}
+
+/**
+ * @brief Constructor for a SNMPv3 walk
+ * @param engine	Engine used to send the requests
+ * @param pdu		PDU used for the requests
+ * @param ip		Agent IP
+ * @param port		Agent port
+ */
+SnmpWalk::SnmpWalk(std::shared_ptr<SnmpEngine> engine, std::shared_ptr<Snmpv3Pdu> pdu, in_addr_t ip, u16 port) {
+	this->initialize(engine, ip, port);
+	this->pdu = nullptr;
+	this->v3pdu = pdu;
+	this->bulk = true;
+}
+
+/**
+ * @brief Destructor for a SnmpWalk
+ */
+SnmpWalk::~SnmpWalk() {
+	this->stop();
+}
+
+/**
+ * @brief Initialize the common fields of a walk
+ * @param engine	Engine used to send the requests
+ * @param ip		Agent IP
+ * @param port		Agent port
+ */
+void SnmpWalk::initialize(std::shared_ptr<SnmpEngine> engine, in_addr_t ip, u16 port) {
+	this->engine = engine;
+	this->ip = ip;
+	this->port = port;
+	this->callback = NULL;
+	this->args = NULL;
+	this->requestID = 0;
+	this->sendTime = 0;
+	this->repetitions = SNMPWALK_INITIAL_REPETITIONS;
+	this->repetitionsLimit = SNMPWALK_MAX_REPETITIONS;
+	this->nRequests = 0;
+	this->nVarBinds = 0;
+	this->running = false;
+	this->result = {SNMP_OK, 0, SNMPV1_ERROR_NOERROR, 0};
+}
+
+/**
+ * @brief Start walking a subtree, without waiting for it to finish
+ * @param root		Subtree to walk
+ * @param callback	Called for each VarBind inside the subtree
+ * @param args		Callback arguments
+ * @note The walk advances while the engine is polled. max-repetitions keeps the value learnt from previous walks.
+ */
+void SnmpWalk::start(const CompactOid &root, SnmpWalkCallback callback, void *args) {
+
+	if(this->running) {
+		throw std::runtime_error("The walk is already running");
+	}
+
+	this->root = root;
+	this->lastOid = root;
+	this->callback = callback;
+	this->args = args;
+	this->nRequests = 0;
+	this->nVarBinds = 0;
+	this->result = {SNMP_OK, 0, SNMPV1_ERROR_NOERROR, 0};
+	this->errorText.clear();
+	this->running = true;
+
+	try {
+		this->sendNext();
+	} catch (const std::runtime_error &e) {
+		this->running = false;
+		throw;
+	} catch (const std::bad_alloc &e) {
+		this->running = false;
+		throw;
+	}
+}
+
+/**
+ * @brief Walk a subtree, blocking until it finishes
+ * @param root		Subtree to walk
+ * @param callback	Called for each VarBind inside the subtree
+ * @param args		Callback arguments
+ */
+void SnmpWalk::run(const CompactOid &root, SnmpWalkCallback callback, void *args) {
+
+	try {
+		this->start(root, callback, args);
+		while(this->running) {
+			this->engine->poll(this->engine->getTimeout());
+		}
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Stop the walk, dropping its outstanding request
+ */
+void SnmpWalk::stop() {
+	if(this->requestID != 0) {
+		this->engine->cancel(this->requestID);
+		this->requestID = 0;
+	}
+	this->running = false;
+}
+
+/**
+ * @brief Ask for the objects following the last received OID
+ */
+void SnmpWalk::sendNext() {
+
+	try {
+		std::shared_ptr<BerOid> oid = std::make_shared<BerOid>(this->lastOid);
+		std::shared_ptr<BerNull> nullval = std::make_shared<BerNull>();
+
+		this->sendTime = osGetTime();
+		this->nRequests++;
+		if(this->v3pdu != nullptr) {
+			this->v3pdu->addVarBind(oid, nullval);
+			this->requestID = this->engine->sendRequest(this->v3pdu, SNMPV2_GETBULKREQUEST, this->ip, this->port, SnmpWalk::onResponse, this, 0, this->repetitions);
+		} else if(this->bulk) {
+			this->pdu->addVarBind(oid, nullval);
+			this->requestID = this->engine->sendBulkRequest(std::static_pointer_cast<Snmpv2Pdu>(this->pdu), 0, this->repetitions, this->ip, this->port, SnmpWalk::onResponse, this);
+		} else {
+			this->pdu->addVarBind(oid, nullval);
+			this->requestID = this->engine->sendRequest(this->pdu, SNMPV1_GETNEXTREQUEST, this->ip, this->port, SnmpWalk::onResponse, this);
+		}
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Halve max-repetitions after a failed GetBulkRequest
+ * @return If there is a smaller request to try
+ */
+bool SnmpWalk::shrink() {
+	if(!this->bulk || this->repetitions <= 1) return false;
+	this->repetitions /= 2;
+	this->repetitionsLimit = this->repetitions;
+	return true;
+}
+
+/**
+ * @brief Tune max-repetitions from a successful response
+ * @param nReceived	Number of received VarBinds
+ * @param size		Received message size
+ * @param rtt		Round trip time, in ms
+ */
+void SnmpWalk::adapt(u32 nReceived, u32 size, u32 rtt) {
+
+	if(!this->bulk) return;
+
+	// Agents return less VarBinds than asked when they hit their own message size limit
+	if(nReceived < this->repetitions) {
+		this->repetitionsLimit = (nReceived != 0) ? nReceived : 1;
+	}
+
+	// Grow while the agent answers quickly, back off when it gets close to the timeout
+	u32 timeout = this->engine->getTimeout();
+	if(rtt < timeout / 4) {
+		this->repetitions *= 2;
+	} else if(rtt > timeout / 2) {
+		this->repetitions /= 2;
+	}
+
+	// Keep the responses under the target size
+	u32 limit = this->repetitionsLimit;
+	if(nReceived != 0 && size != 0) {
+		u32 sizeLimit = SNMPWALK_TARGET_SIZE / (size / nReceived + 1);
+		if(sizeLimit < limit) limit = sizeLimit;
+	}
+	if(this->repetitions > limit) this->repetitions = limit;
+	if(this->repetitions == 0) this->repetitions = 1;
+}
+
+/**
+ * @brief Hand the received VarBinds inside the subtree to the callback
+ * @param varBinds	Received VarBinds
+ * @param n			Number of received VarBinds
+ * @return If the walk has to continue
+ */
+bool SnmpWalk::handleVarBinds(const SnmpVarBind *varBinds, u32 n) {
+
+	// An empty response would make us ask for the same OID forever
+	if(n == 0) return false;
+
+	for(u32 i = 0; i < n; i++) {
+		if(varBinds[i].value.getType() == VARBIND_ENDOFMIBVIEW) return false;
+
+		CompactOid oid(varBinds[i].oid.getValue(), varBinds[i].oid.getLength());
+		if(!this->root.isPrefixOf(oid)) return false;
+
+		// Broken agents may loop, so the OIDs have to increase
+		if(oid.compare(this->lastOid) <= 0) {
+			SnmpResult result = {SNMP_ERROR_VALUE, 0, SNMPV1_ERROR_NOERROR, 0};
+			this->finish(result, "OID not increasing: " + oid.print());
+			return false;
+		}
+
+		this->lastOid = oid;
+		this->nVarBinds++;
+		if(this->callback != NULL && !this->callback(&varBinds[i], this->args)) return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief End the walk
+ * @param result	Walk result
+ * @param errorText	Error description, if result is not SNMP_OK
+ */
+void SnmpWalk::finish(const SnmpResult &result, const std::string &errorText) {
+	if(!this->running) return;
+	this->result = result;
+	this->errorText = errorText;
+	this->running = false;
+}
+
+/**
+ * @brief Handle the response to a walk request
+ * @param response Request outcome
+ */
+void SnmpWalk::onResponse(SnmpEngineResponse *response) {
+
+	SnmpWalk *walk = (SnmpWalk*)response->args;
+	walk->requestID = 0;
+	if(!walk->running) return;
+
+	try {
+		const SnmpResult &result = response->result;
+		switch(result.status) {
+			case SNMP_OK:
+				break;
+			case SNMP_ERROR_TIMEOUT:
+				// Big responses take longer to build, and get more fragments lost
+				if(walk->shrink()) {
+					walk->sendNext();
+					return;
+				}
+				walk->finish(result, response->errorText);
+				return;
+			case SNMP_ERROR_RESPONSE:
+				if(result.errorStatus == SNMPV1_ERROR_TOOBIG && walk->shrink()) {
+					walk->sendNext();
+					return;
+				}
+				if(result.errorStatus == SNMPV1_ERROR_NOSUCHNAME && !walk->bulk) {
+					walk->finish({SNMP_OK, 0, SNMPV1_ERROR_NOERROR, 0}, "");	// SNMPv1 end of MIB view
+					return;
+				}
+				walk->finish(result, response->errorText);
+				return;
+			case SNMP_ERROR_SECURITY:
+				// The first REPORT tells the engine ID, boots and time
+				if(walk->nRequests == 1) {
+					walk->sendNext();
+					return;
+				}
+				walk->finish(result, response->errorText);
+				return;
+			default:
+				walk->finish(result, response->errorText);
+				return;
+		}
+
+		u32 n;
+		const SnmpVarBind *varBinds;
+		if(response->v3pdu != nullptr) {
+			n = response->v3pdu->getNVarBinds();
+			varBinds = response->v3pdu->getVarBinds();
+		} else {
+			n = response->pdu->getNVarBinds();
+			varBinds = response->pdu->getVarBinds();
+		}
+
+		if(!walk->handleVarBinds(varBinds, n)) {
+			walk->finish({SNMP_OK, 0, SNMPV1_ERROR_NOERROR, 0}, "");
+			return;
+		}
+
+		walk->adapt(n, response->size, osGetTime() - walk->sendTime);
+		walk->sendNext();
+	} catch (const std::runtime_error &e) {
+		walk->running = false;
+		throw;
+	} catch (const std::bad_alloc &e) {
+		walk->running = false;
+		throw;
+	}
+}
+
+}
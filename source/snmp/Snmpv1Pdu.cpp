@@ -27,6 +27,7 @@ Snmpv1Pdu::Snmpv1Pdu(const std::string &community) {
 
 	this->varBindList = nullptr;
 	this->reqID = 0;
+	this->fixedReqID = 0;
 	this->community = community;
 	this->snmpVersion = SNMPV1_VERSION;
 }
@@ -35,15 +36,26 @@ Snmpv1Pdu::Snmpv1Pdu(const std::string &community) {
  * @brief Clear the PDU for further usage
  */
 void Snmpv1Pdu::clear() {
-	BerPdu::clear();		// Varbindlist can't be here
 	this->varBindList.reset();
+	this->varBinds.clear();
+	this->clearTrapFields();
+	BerPdu::clear();		// Varbindlist can't be here, drop it first so the arena can be reused
+}
+
+/**
+ * @brief Empty the received trap fields, so that none points into an old message
+ */
+void Snmpv1Pdu::clearTrapFields() {
+	for(u8 i = 0; i < SNMPV1_TRAP_NFIELDS; i++) {
+		this->trapFields[i] = BerView();
+	}
 }
 
 /**
  * @brief Set the VarBindList to empty state
  */
 void Snmpv1Pdu::emptyVarBindList() {
-	this->varBindList = std::make_shared<BerSequence>();
+	this->varBindList = makeBerField<BerSequence>(this->getArena(), BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, this->getArena());
 }
 
 /**
@@ -51,12 +63,13 @@ void Snmpv1Pdu::emptyVarBindList() {
  * @param vbList VarBindList to use
  * @param oid Object identifier of the field
  * @param value Value for that field (optional if requesting)
+ * @param arena Arena used for the VarBind (optional)
  */
-void Snmpv1Pdu::addVarBind(std::shared_ptr<BerSequence> vbList, std::shared_ptr<BerOid> oid, std::shared_ptr<BerField> value) {
+void Snmpv1Pdu::addVarBind(std::shared_ptr<BerSequence> vbList, std::shared_ptr<BerOid> oid, std::shared_ptr<BerField> value, const std::shared_ptr<BerArena> &arena) {
 	
 	std::shared_ptr<BerSequence> varBind = nullptr;
 	try {
-		varBind = std::make_shared<BerSequence>();
+		varBind = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
 	} catch (const std::bad_alloc &e) {
 		throw;
 	}
@@ -74,8 +87,8 @@ void Snmpv1Pdu::addVarBind(std::shared_ptr<BerSequence> vbList, std::shared_ptr<
 void Snmpv1Pdu::addVarBind(std::shared_ptr<BerOid> oid, std::shared_ptr<BerField> value) {
 
 	try {
-		if(this->varBindList == nullptr) this->varBindList = std::make_shared<BerSequence>();
-		Snmpv1Pdu::addVarBind(this->varBindList, oid, value);
+		if(this->varBindList == nullptr) this->emptyVarBindList();
+		Snmpv1Pdu::addVarBind(this->varBindList, oid, value, this->getArena());
 	} catch (const std::bad_alloc &e) {
 		throw;
 	}
@@ -89,11 +102,12 @@ void Snmpv1Pdu::addVarBind(std::shared_ptr<BerOid> oid, std::shared_ptr<BerField
 std::shared_ptr<BerSequence> Snmpv1Pdu::generateHeader(u32 ver) {
 
 	try {
-		std::shared_ptr<BerSequence> message = std::make_shared<BerSequence>();
+		std::shared_ptr<BerArena> arena = this->getArena();
+		std::shared_ptr<BerSequence> message = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
 
 		// Header (common to all SNMP PDUs)
-		std::shared_ptr<BerInteger> version = std::make_shared<BerInteger>(&ver, sizeof(u32), false);
-		std::shared_ptr<BerOctetString> community = std::make_shared<BerOctetString>(this->community);
+		std::shared_ptr<BerInteger> version = makeBerField<BerInteger>(arena, &ver, sizeof(u32), false);
+		std::shared_ptr<BerOctetString> community = makeBerField<BerOctetString>(arena, this->community);
 		message->addChild(version);
 		message->addChild(community);
 		// From here it can be PDUs or authentication data
@@ -111,14 +125,15 @@ std::shared_ptr<BerSequence> Snmpv1Pdu::generateHeader(u32 ver) {
  */
 std::shared_ptr<BerSequence> Snmpv1Pdu::generateRequest(u32 type) {
 
-	std::shared_ptr<BerSequence> getRequest = std::make_shared<BerSequence>(SNMPV1_TAGCLASS, type);
+	std::shared_ptr<BerArena> arena = this->getArena();
+	std::shared_ptr<BerSequence> getRequest = makeBerField<BerSequence>(arena, SNMPV1_TAGCLASS, type, arena);
 
-	this->reqID = ++Snmpv1Pdu::requestID;
+	this->reqID = this->generateRequestID();
 	u32 errorInteger = SNMPV1_ERROR_NOERROR;
 	u32 errorDetailsInteger = 0;
-	std::shared_ptr<BerInteger> reqid = std::make_shared<BerInteger>(&this->reqID, sizeof(u32), false);
-	std::shared_ptr<BerInteger> error = std::make_shared<BerInteger>(&errorInteger, sizeof(u32), false);
-	std::shared_ptr<BerInteger> errorDetails = std::make_shared<BerInteger>(&errorDetailsInteger, sizeof(u32), false);
+	std::shared_ptr<BerInteger> reqid = makeBerField<BerInteger>(arena, &this->reqID, sizeof(u32), false);
+	std::shared_ptr<BerInteger> error = makeBerField<BerInteger>(arena, &errorInteger, sizeof(u32), false);
+	std::shared_ptr<BerInteger> errorDetails = makeBerField<BerInteger>(arena, &errorDetailsInteger, sizeof(u32), false);
 	getRequest->addChild(reqid);				// RequestID
 	getRequest->addChild(error);				// Error status
 	getRequest->addChild(errorDetails);			// Error details
@@ -128,13 +143,21 @@ std::shared_ptr<BerSequence> Snmpv1Pdu::generateRequest(u32 type) {
 }
 
 /**
- * @brief Send a GET REQUEST
+ * @brief Get the request ID for a new request
+ * @return The fixed request ID, if set by setRequestID(), or the next one of the global counter
+ */
+u32 Snmpv1Pdu::generateRequestID() {
+	return (this->fixedReqID != 0) ? this->fixedReqID : ++Snmpv1Pdu::requestID;
+}
+
+/**
+ * @brief Encode a request without sending it
  * @param type Type of SNMP PDU
- * @param socket Socket used when sending the PDU
- * @param ip Destination IP. If zero, last socket's remote host IP-port will be used
- * @param port  Destination port
+ * @param size Encoded message size (output)
+ * @return The encoded message, inside the send buffer
+ * @note The message fields are kept until clear() is called
  */
-void Snmpv1Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port) {
+u8 *Snmpv1Pdu::encodeRequest(u32 type, u32 *size) {
 
 	try {
 
@@ -149,7 +172,7 @@ void Snmpv1Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t
 		message->addChild(getRequest);
 
 		this->fields.push_back(message);
-		BerPdu::send(sock, ip, port);
+		return this->encode(this->getSendBuffer(), BERPDU_MAX_SIZE, size);
 
 	} catch (const std::bad_alloc &e) {
 		this->fields.clear();
@@ -158,123 +181,295 @@ void Snmpv1Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t
 		this->fields.clear();
 		throw;
 	}
-
-	// Clear data
-	this->fields.clear();
-	this->varBindList.reset();
 }
 
 /**
- * @brief Check a response header
- * @param ptr Header data
+ * @brief Send a GET REQUEST
+ * @param type Type of SNMP PDU
+ * @param socket Socket used when sending the PDU
+ * @param ip Destination IP. If zero, last socket's remote host IP-port will be used
+ * @param port  Destination port
  */
-void Snmpv1Pdu::checkHeader(u8 **ptr) {
+void Snmpv1Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port) {
+
 	try {
+		u32 size;
+		u8 *data = this->encodeRequest(type, &size);
+		sock->sendPacket(data, size, ip, port);
+	} catch (const std::bad_alloc &e) {
+		this->fields.clear();
+		throw;
+	} catch (const std::runtime_error &e) {
+		this->fields.clear();
+		throw;
+	}
 
-		// Read response header
-		BerSequence::decode(ptr);
+	// Clear data
+	this->clear();
+}
 
-		// Check version
-		std::shared_ptr<BerInteger> version = BerInteger::decode(ptr, false);
-		if(version->getValueU32() != this->snmpVersion) {
-			throw std::runtime_error("Not a SNMPv1 PDU");
-		}
+/**
+ * @brief Get the reception buffer, creating it if needed
+ * @return The reception buffer (SNMP_MAX_PDU_SIZE bytes)
+ */
+u8 *Snmpv1Pdu::getRecvBuffer() {
 
-		// Check community
-		std::shared_ptr<BerOctetString> community = BerOctetString::decode(ptr);
-		if(community->getValue().compare(this->community) != 0) {
-			throw std::runtime_error("Community does not match");
+	try {
+		if(this->recvBuffer == nullptr) {
+			this->recvBuffer = std::unique_ptr<u8[]>(new u8[SNMP_MAX_PDU_SIZE]);
 		}
-
-#ifdef SNMP_DEBUG
-		version->print();
-		community->print();
-#endif
-	} catch (const std::runtime_error &e) {
-		throw;
 	} catch (const std::bad_alloc &e) {
 		throw;
 	}
+
+	return this->recvBuffer.get();
 }
 
 /**
- * @brief Receive a response from a buffer
- * @param ptr Buffer data
- * @param checkResponseID Check response ID?
- * @param reqID Expected request ID
- * @param pduType Type of response PDU obtained (=expectedPduType, or obtained PDU if SNMP_PDU_ANY)
- * @param expectedPduType Expected PDU type
+ * @brief Build a decoding result
+ * @param status Decoding status
+ * @param base Beginning of the message
+ * @param at Offending field
+ * @return The decoding result
  */
-std::shared_ptr<BerSequence> Snmpv1Pdu::recvResponse(u8 **ptr, bool checkResponseID, u32 reqID, u8 *pduType, u32 expectedPduType) {
+SnmpResult Snmpv1Pdu::makeResult(SnmpStatus status, const u8 *base, const u8 *at) {
+	SnmpResult result;
+	result.status = status;
+	result.offset = (base != NULL && at != NULL) ? at - base : 0;
+	result.errorStatus = SNMPV1_ERROR_NOERROR;
+	result.errorIndex = 0;
+	return result;
+}
 
-	try {
+/**
+ * @brief Read the next field, checking its tag
+ * @param reader Reader placed at the field
+ * @param base Beginning of the message
+ * @param tag Expected identifier octet
+ * @param view Read field (output)
+ * @return The decoding result
+ */
+SnmpResult Snmpv1Pdu::readField(BerReader &reader, const u8 *base, u8 tag, BerView *view) {
+	BerStatus status = reader.tryNext(tag, view);
+	return Snmpv1Pdu::makeResult((SnmpStatus)status, base, reader.getPosition());
+}
 
-		// Skip get-response sequence
-		BerSequence::decode(ptr, SNMPV1_TAGCLASS, expectedPduType, pduType);
+/**
+ * @brief Read the next field as an unsigned INTEGER
+ * @param reader Reader placed at the field
+ * @param base Beginning of the message
+ * @param value Read value (output)
+ * @return The decoding result
+ */
+SnmpResult Snmpv1Pdu::readInteger(BerReader &reader, const u8 *base, u32 *value) {
 
-		// Check responseID
-		std::shared_ptr<BerInteger> responseID = BerInteger::decode(ptr, false);
-		if(checkResponseID && responseID->getValueU32() != reqID && responseID->getValueU32() != 0) {
-			throw std::runtime_error("RequestID does not match");
-		}
-		if(!checkResponseID) {		// Save the request ID for the possible ACK
-			Snmpv1Pdu::requestID = responseID->getValueU32() - 1;
+	BerView view;
+	SnmpResult result = Snmpv1Pdu::readField(reader, base, BER_TAGCLASS_INTEGER | BER_TAG_INTEGER, &view);
+	if(result.status != SNMP_OK) return result;
+
+	u64 integer;
+	if(view.getInteger(false, &integer) != BER_OK) {
+		return Snmpv1Pdu::makeResult(SNMP_ERROR_VALUE, base, view.getData());
+	}
+	*value = integer;
+	return result;
+}
+
+/**
+ * @brief Check a response header
+ * @param reader Reader placed at the beginning of the message contents
+ * @param base Beginning of the message
+ * @return The decoding result
+ */
+SnmpResult Snmpv1Pdu::checkHeader(BerReader &reader, const u8 *base) {
+
+	// Check version
+	u32 version;
+	const u8 *at = reader.getPosition();
+	SnmpResult result = Snmpv1Pdu::readInteger(reader, base, &version);
+	if(result.status != SNMP_OK) return result;
+	if(version != this->snmpVersion) {
+		return Snmpv1Pdu::makeResult(SNMP_ERROR_VERSION, base, at);
+	}
+
+	// Check community
+	BerView community;
+	result = Snmpv1Pdu::readField(reader, base, BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING, &community);
+	if(result.status != SNMP_OK) return result;
+	if(!community.equals(this->community)) {
+		return Snmpv1Pdu::makeResult(SNMP_ERROR_COMMUNITY, base, community.getData());
+	}
+
+	return result;
+}
+
+/**
+ * @brief Decode a VarBindList
+ * @param reader	Reader placed at the beginning of the VarBindList contents
+ * @param base		Beginning of the message
+ * @param varBinds	Decoded VarBinds (output)
+ * @return The decoding result
+ */
+SnmpResult Snmpv1Pdu::decodeVarBindList(BerReader &reader, const u8 *base, std::vector<SnmpVarBind> &varBinds) {
+
+	varBinds.clear();
+
+	// Loop each varbind
+	while(reader.hasNext()) {
+		BerView varBindSeq;
+		SnmpResult result = Snmpv1Pdu::readField(reader, base, BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE, &varBindSeq);
+		if(result.status != SNMP_OK) return result;
+
+		BerReader varBindReader(varBindSeq);
+		SnmpVarBind varBind;
+		result = Snmpv1Pdu::readField(varBindReader, base, BER_TAGCLASS_OID | BER_TAG_OID, &varBind.oid);
+		if(result.status != SNMP_OK) return result;
+		BerStatus status = BerField::validate(varBind.oid);
+		if(status != BER_OK) {
+			return Snmpv1Pdu::makeResult((SnmpStatus)status, base, varBind.oid.getData());
 		}
-#ifdef SNMP_DEBUG
-		responseID->print();
-#endif
 
-		// Check errors
-		std::shared_ptr<BerInteger> errorStatus = BerInteger::decode(ptr, false);
-#ifdef SNMP_DEBUG
-		errorStatus->print();
-#endif
-		std::shared_ptr<BerInteger> errorDetails = BerInteger::decode(ptr, false);
-#ifdef SNMP_DEBUG
-		errorDetails->print();
-#endif
-		if(errorStatus->getValueU32() != SNMPV1_ERROR_NOERROR) {
-			throw std::runtime_error(std::string("Error in SNMP response: ") + 
-									 std::to_string(errorStatus->getValueU32()) +
-									 std::string("; Details: ") +
-									 std::to_string(errorDetails->getValueU32()));
+		// Decode the value into its typed form
+		BerView value;
+		status = varBindReader.tryNext(&value);
+		if(status == BER_OK) {
+			status = VarBindValue::decode(value, &varBind.value);
+		}
+		if(status != BER_OK) {
+			return Snmpv1Pdu::makeResult((SnmpStatus)status, base, varBindReader.getPosition());
 		}
+		varBinds.push_back(varBind);
+	}
+
+	return Snmpv1Pdu::makeResult(SNMP_OK, base, reader.getPosition());
+}
 
-		// Skip varbindlist sequence
-		u32 varbindLength = BerSequence::decode(ptr);
+/**
+ * @brief Decode a response PDU
+ * @param reader Reader placed at the beginning of the PDU
+ * @param base Beginning of the message
+ * @param checkResponseID Check response ID?
+ * @param reqID Expected request ID, or the received one if not checked (in/out)
+ * @param pduType Type of response PDU obtained (=expectedPduType, or obtained PDU if SNMP_PDU_ANY)
+ * @param expectedPduType Expected PDU type
+ * @param varBinds Decoded VarBinds (output)
+ * @return The decoding result
+ */
+SnmpResult Snmpv1Pdu::decodeResponse(BerReader &reader, const u8 *base, bool checkResponseID, u32 *reqID, u8 *pduType, u32 expectedPduType, std::vector<SnmpVarBind> &varBinds) {
 
-		// Create a VarBindList
-		std::shared_ptr<BerSequence> vbList = std::make_shared<BerSequence>();
+	// Check PDU type
+	BerView pdu;
+	BerStatus status = reader.tryNext(&pdu);
+	if(status != BER_OK) {
+		return Snmpv1Pdu::makeResult((SnmpStatus)status, base, reader.getPosition());
+	}
+	if((pdu.getTag() &~0x1F) != SNMPV1_TAGCLASS ||
+	   (expectedPduType != SNMP_PDU_ANY && (pdu.getTag() &0x1F) != expectedPduType)) {
+		return Snmpv1Pdu::makeResult(SNMP_ERROR_PDU_TYPE, base, pdu.getData());
+	}
+	*pduType = pdu.getTag() &0x1F;
+	BerReader fields(pdu);
+
+	// Check responseID
+	u32 responseID;
+	const u8 *at = fields.getPosition();
+	SnmpResult result = Snmpv1Pdu::readInteger(fields, base, &responseID);
+	if(result.status != SNMP_OK) return result;
+	if(checkResponseID && responseID != *reqID && responseID != 0) {
+		return Snmpv1Pdu::makeResult(SNMP_ERROR_REQUEST_ID, base, at);
+	}
+	if(!checkResponseID) {		// Keep the request ID for the possible ACK
+		*reqID = responseID;
+	}
 
-		// Loop each varbind
-		u32 read = 0;
-		while(read < varbindLength) {
+	// Check errors
+	u32 errorStatus, errorDetails;
+	at = fields.getPosition();
+	result = Snmpv1Pdu::readInteger(fields, base, &errorStatus);
+	if(result.status != SNMP_OK) return result;
+	result = Snmpv1Pdu::readInteger(fields, base, &errorDetails);
+	if(result.status != SNMP_OK) return result;
+	if(errorStatus != SNMPV1_ERROR_NOERROR) {
+		result = Snmpv1Pdu::makeResult(SNMP_ERROR_RESPONSE, base, at);
+		result.errorStatus = errorStatus;
+		result.errorIndex = errorDetails;
+		return result;
+	}
 
-			u8 *tmp = *ptr;
+	// Decode the VarBindList
+	BerView vbList;
+	result = Snmpv1Pdu::readField(fields, base, BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE, &vbList);
+	if(result.status != SNMP_OK) return result;
+	BerReader vbReader(vbList);
+	return Snmpv1Pdu::decodeVarBindList(vbReader, base, varBinds);
+}
 
-			// Skip varbind sequence
-			BerSequence::decode(ptr);
+/**
+ * @brief Get the description of a decoding result
+ * @param result Decoding result
+ * @return The description, the same as the exception messages
+ */
+std::string Snmpv1Pdu::getErrorString(const SnmpResult &result) {
+
+	switch(result.status) {
+		case SNMP_OK:					return "OK";
+		case SNMP_ERROR_TIMEOUT:		return "Socket timeout";
+		case SNMP_ERROR_RECV:			return "recvfrom() failed";
+		case SNMP_ERROR_SOURCE_IP:		return "Source IP does not match";
+		case SNMP_ERROR_SOURCE_PORT:	return "Source port does not match";
+		case SNMP_ERROR_VERSION:		return "Not a SNMPv1 PDU";
+		case SNMP_ERROR_COMMUNITY:		return "Community does not match";
+		case SNMP_ERROR_PDU_TYPE:		return "Unexpected PDU type";
+		case SNMP_ERROR_REQUEST_ID:		return "RequestID does not match";
+		case SNMP_ERROR_NOT_NOTIFICATION:	return "This is not a notification PDU";
+		case SNMP_ERROR_SECURITY:		return "SNMPv3 security error";
+		case SNMP_ERROR_SEND:			return "sendto() failed";
+		case SNMP_ERROR_RESPONSE:
+			return std::string("Error in SNMP response: ") + 
+				   std::to_string(result.errorStatus) +
+				   std::string("; Details: ") +
+				   std::to_string(result.errorIndex);
+		default:
+			return BerView::getStatusString((BerStatus)result.status);
+	}
+}
 
-			// Decode OID
-			std::shared_ptr<BerOid> oid = BerOid::decode(ptr);
-#ifdef SNMP_DEBUG
-			oid->print();
-#endif
+/**
+ * @brief Throw an exception for a failed decoding
+ * @param result Decoding result
+ * @note This is what turns the non-throwing API into the throwing one
+ */
+void Snmpv1Pdu::checkResult(const SnmpResult &result) {
+	if(result.status != SNMP_OK) {
+		throw std::runtime_error(Snmpv1Pdu::getErrorString(result));
+	}
+}
+
+/**
+ * @brief Build a VarBindList from received VarBinds
+ * @param varBinds Received VarBinds
+ * @param arena Arena used for the VarBindList (optional)
+ * @return A VarBindList holding a copy of every VarBind
+ * @note Only needed to send the VarBinds back, as in inform-request acknowledgements
+ */
+std::shared_ptr<BerSequence> Snmpv1Pdu::buildVarBindList(const std::vector<SnmpVarBind> &varBinds, const std::shared_ptr<BerArena> &arena) {
 
-			// Decode value
-			std::shared_ptr<BerField> value = BerField::decode(ptr);
-			read += (*ptr - tmp);
+	try {
+		std::shared_ptr<BerSequence> vbList = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
+		vbList->reserve(varBinds.size());
+
+		for(u32 i = 0; i < varBinds.size(); i++) {
+			u8 *ptr = (u8*)varBinds[i].oid.getData();
+			std::shared_ptr<BerOid> oid = BerOid::decode(&ptr, arena);
+			std::shared_ptr<BerField> value = varBinds[i].value.toBerField(arena);
 #ifdef SNMP_DEBUG
+			oid->print();
 			value->print();
 #endif
-
-			// Add pair OID,value to the varbindlist
-			Snmpv1Pdu::addVarBind(vbList, oid, value);
+			Snmpv1Pdu::addVarBind(vbList, oid, value, arena);
 		}
 
-		// Return the loaded VarBindList
 		return vbList;
-
 	} catch (const std::runtime_error &e) {
 		throw;
 	} catch (const std::bad_alloc &e) {
@@ -283,140 +478,223 @@ std::shared_ptr<BerSequence> Snmpv1Pdu::recvResponse(u8 **ptr, bool checkRespons
 }
 
 /**
- * @brief Receive a response from the agent
+ * @brief Receive a packet into the reception buffer
  * @param sock Socket used for reception
  * @param ip Expected source IP
  * @param port Expected port
- * @param expectedPduType Expected PDU type
- * @return Type of response PDU obtained (=expectedPduType, or obtained PDU if SNMP_PDU_ANY)
+ * @param size Received size (output)
+ * @return The reception result
  */
-u8 Snmpv1Pdu::recvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 expectedPduType) {
+SnmpResult Snmpv1Pdu::recvPacket(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 *size) {
+
+	s32 recvSize = sock->tryRecvPacket(this->getRecvBuffer(), SNMP_MAX_PDU_SIZE, ip, port);
+	switch(recvSize) {
+		case UDPSOCKET_ERROR_TIMEOUT:		return Snmpv1Pdu::makeResult(SNMP_ERROR_TIMEOUT, NULL, NULL);
+		case UDPSOCKET_ERROR_RECV:			return Snmpv1Pdu::makeResult(SNMP_ERROR_RECV, NULL, NULL);
+		case UDPSOCKET_ERROR_SOURCE_IP:		return Snmpv1Pdu::makeResult(SNMP_ERROR_SOURCE_IP, NULL, NULL);
+		case UDPSOCKET_ERROR_SOURCE_PORT:	return Snmpv1Pdu::makeResult(SNMP_ERROR_SOURCE_PORT, NULL, NULL);
+	}
 
-	try {
-		// Create recv buffer
-		std::unique_ptr<u8> data(new u8[SNMP_MAX_PDU_SIZE]);
+	*size = recvSize;
+	return Snmpv1Pdu::makeResult(SNMP_OK, NULL, NULL);
+}
 
-		// Receive packet data
-		sock->recvPacket(data.get(), SNMP_MAX_PDU_SIZE, ip, port);
-		u8 *ptr = data.get();
+/**
+ * @brief Decode a response from a buffer, without copying its contents nor throwing
+ * @param data Buffer data
+ * @param size Buffer size
+ * @param checkResponseID Check response ID?
+ * @param expectedPduType Expected PDU type
+ * @param pduType Type of response PDU obtained (=expectedPduType, or obtained PDU if SNMP_PDU_ANY)
+ * @return The decoding result
+ * @note The decoded VarBinds point into data, see getVarBind()
+ */
+SnmpResult Snmpv1Pdu::tryParseResponse(const u8 *data, u32 size, bool checkResponseID, u32 expectedPduType, u8 *pduType) {
 
-		// Read response header
-		this->checkHeader(&ptr);
+	BerReader reader(data, size);
+	BerView messageSeq;
+	SnmpResult result = Snmpv1Pdu::readField(reader, data, BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE, &messageSeq);
+	if(result.status != SNMP_OK) return result;
+	BerReader message(messageSeq);
 
-		// Read PDU fields
-		u8 pduType;
-		this->varBindList = Snmpv1Pdu::recvResponse(&ptr, port != 0, this->reqID, &pduType, expectedPduType);
-		return pduType;
+	// Read response header
+	result = this->checkHeader(message, data);
+	if(result.status != SNMP_OK) return result;
 
-	} catch (const std::runtime_error &e) {
-		throw;
-	} catch (const std::bad_alloc &e) {
-		throw;
-	}
+	// Read PDU fields
+	return Snmpv1Pdu::decodeResponse(message, data, checkResponseID, &this->reqID, pduType, expectedPduType, this->varBinds);
 }
 
 /**
- * @brief Receive a TRAP pdu
- * @param sock Socket listening to some udp port
+ * @brief Decode a response from a buffer, without copying its contents
+ * @param data Buffer data
+ * @param size Buffer size
+ * @param checkResponseID Check response ID?
+ * @param expectedPduType Expected PDU type
+ * @return Type of response PDU obtained (=expectedPduType, or obtained PDU if SNMP_PDU_ANY)
+ * @note The decoded VarBinds point into data, see getVarBind()
  */
-void Snmpv1Pdu::recvTrap(std::shared_ptr<UdpSocket> sock) {
-
-	try {
-		// Create recv buffer
-		std::unique_ptr<u8> data(new u8[SNMP_MAX_PDU_SIZE]);
-
-		// Receive packet data
-		sock->recvPacket(data.get(), SNMP_MAX_PDU_SIZE);
-		u8 *ptr = data.get();
-
-		// Read response header
-		this->checkHeader(&ptr);
+u8 Snmpv1Pdu::parseResponse(const u8 *data, u32 size, bool checkResponseID, u32 expectedPduType) {
+	u8 pduType;
+	Snmpv1Pdu::checkResult(this->tryParseResponse(data, size, checkResponseID, expectedPduType, &pduType));
+	return pduType;
+}
 
-		// Skip trap sequence
-		BerSequence::decode(&ptr, SNMPV1_TAGCLASS, SNMPV1_TRAP);
+/**
+ * @brief Receive a response from the agent, without throwing on malformed or unexpected packets
+ * @param sock Socket used for reception
+ * @param ip Expected source IP
+ * @param port Expected port
+ * @param expectedPduType Expected PDU type
+ * @param pduType Type of response PDU obtained (=expectedPduType, or obtained PDU if SNMP_PDU_ANY)
+ * @return The reception result
+ * @note The received VarBinds are valid until the next reception
+ */
+SnmpResult Snmpv1Pdu::tryRecvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 expectedPduType, u8 *pduType) {
 
-		// Add enterprise OID to the list
-		this->fields.push_back(BerOid::decode(&ptr));
-		
-		// Add agent address to the list
-		this->fields.push_back(BerOctetString::decode(&ptr));
+	// Receive packet data
+	u32 size;
+	SnmpResult result = this->recvPacket(sock, ip, port, &size);
+	if(result.status != SNMP_OK) return result;
 
-		// Add generic and specific trap to the list
-		this->fields.push_back(BerInteger::decode(&ptr, false));
-		this->fields.push_back(BerInteger::decode(&ptr, false));
+	// Decode it in place
+	return this->tryParseResponse(this->recvBuffer.get(), size, port != 0, expectedPduType, pduType);
+}
 
-		// Add timestamp to the list
-		this->fields.push_back(BerInteger::decode(&ptr, false));
+/**
+ * @brief Receive a response from the agent
+ * @param sock Socket used for reception
+ * @param ip Expected source IP
+ * @param port Expected port
+ * @param expectedPduType Expected PDU type
+ * @return Type of response PDU obtained (=expectedPduType, or obtained PDU if SNMP_PDU_ANY)
+ * @note The received VarBinds are valid until the next reception
+ */
+u8 Snmpv1Pdu::recvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 expectedPduType) {
+	u8 pduType;
+	Snmpv1Pdu::checkResult(this->tryRecvResponse(sock, ip, port, expectedPduType, &pduType));
+	return pduType;
+}
 
-#ifdef SNMP_DEBUG
-		for(u8 i = 0; i < 5; i++) {
-			this->fields[i]->print();
+/**
+ * @brief Decode a TRAP pdu from a buffer, without copying its contents nor throwing
+ * @param data Buffer data
+ * @param size Buffer size
+ * @return The decoding result
+ * @note The decoded fields point into data, see getTrapField() and getVarBind()
+ */
+SnmpResult Snmpv1Pdu::tryParseTrap(const u8 *data, u32 size) {
+
+	// A malformed trap leaves the fields it did not reach empty
+	this->clearTrapFields();
+
+	BerReader reader(data, size);
+	BerView messageSeq;
+	SnmpResult result = Snmpv1Pdu::readField(reader, data, BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE, &messageSeq);
+	if(result.status != SNMP_OK) return result;
+	BerReader message(messageSeq);
+
+	// Read response header
+	result = this->checkHeader(message, data);
+	if(result.status != SNMP_OK) return result;
+
+	// Read trap fields
+	static const u8 trapTags[SNMPV1_TRAP_NFIELDS] = {
+		BER_TAGCLASS_OID | BER_TAG_OID,
+		SNMPV1_TAGCLASS_NETWORKADDRESS | SNMPV1_TAG_NETWORKADDRESS,
+		BER_TAGCLASS_INTEGER | BER_TAG_INTEGER,
+		BER_TAGCLASS_INTEGER | BER_TAG_INTEGER,
+		SNMPV1_TAGCLASS_TIMETICKS | SNMPV1_TAG_TIMETICKS
+	};
+	BerView trapPdu;
+	result = Snmpv1Pdu::readField(message, data, SNMPV1_TAGCLASS | SNMPV1_TRAP, &trapPdu);
+	if(result.status != SNMP_OK) return result;
+	BerReader trap(trapPdu);
+	for(u8 i = 0; i < SNMPV1_TRAP_NFIELDS; i++) {
+		result = Snmpv1Pdu::readField(trap, data, trapTags[i], &this->trapFields[i]);
+		if(result.status != SNMP_OK) return result;
+		BerStatus status = BerField::validate(this->trapFields[i]);
+		if(status != BER_OK) {
+			return Snmpv1Pdu::makeResult((SnmpStatus)status, data, this->trapFields[i].getData());
 		}
-#endif
+	}
 
-		// Skip varbindlist sequence
-		u32 varbindLength = BerSequence::decode(&ptr);
+	// Decode the VarBindList
+	BerView vbList;
+	result = Snmpv1Pdu::readField(trap, data, BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE, &vbList);
+	if(result.status != SNMP_OK) return result;
+	BerReader vbReader(vbList);
+	return Snmpv1Pdu::decodeVarBindList(vbReader, data, this->varBinds);
+}
 
-		// Loop each varbind
-		u32 read = 0;
-		while(read < varbindLength) {
+/**
+ * @brief Decode a TRAP pdu from a buffer, without copying its contents
+ * @param data Buffer data
+ * @param size Buffer size
+ * @note The decoded fields point into data, see getTrapField() and getVarBind()
+ */
+void Snmpv1Pdu::parseTrap(const u8 *data, u32 size) {
+	Snmpv1Pdu::checkResult(this->tryParseTrap(data, size));
+}
 
-			u8 *tmp = ptr;
+/**
+ * @brief Receive a TRAP pdu, without throwing on malformed or foreign packets
+ * @param sock Socket listening to some udp port
+ * @return The reception result
+ * @note The trap fields and VarBinds are valid until the next reception
+ */
+SnmpResult Snmpv1Pdu::tryRecvTrap(std::shared_ptr<UdpSocket> sock) {
 
-			// Skip varbind sequence
-			BerSequence::decode(&ptr);
+	// Receive packet data
+	u32 size;
+	SnmpResult result = this->recvPacket(sock, 0, 0, &size);
+	if(result.status != SNMP_OK) return result;
 
-			// Decode OID and value
-			std::shared_ptr<BerOid> oid = BerOid::decode(&ptr);
-			std::shared_ptr<BerField> value = BerField::decode(&ptr);
-			read += (ptr - tmp);
-#ifdef SNMP_DEBUG
-			oid->print();
-			value->print();
-#endif
-
-			// Add pair OID-value to the varbindlist
-			this->addVarBind(oid, value);
-		}
-	} catch (const std::runtime_error &e) {
-		this->clear();
-		throw;
-	} catch (const std::bad_alloc &e) {
-		this->clear();
-		throw;
-	}
+	// Decode it in place
+	return this->tryParseTrap(this->recvBuffer.get(), size);
 }
 
 /**
- * @brief Destructor for a SNMPv1 PDU
+ * @brief Receive a TRAP pdu
+ * @param sock Socket listening to some udp port
  */
-Snmpv1Pdu::~Snmpv1Pdu() { }
+void Snmpv1Pdu::recvTrap(std::shared_ptr<UdpSocket> sock) {
+	SnmpResult result = this->tryRecvTrap(sock);
+	if(result.status != SNMP_OK) {
+		this->clear();
+		Snmpv1Pdu::checkResult(result);
+	}
+}
 
 /**
- * @brief Get a VarBind from the PDU
- * @param i VarBind index
- * @return Desired VarBind
+ * @brief Get the identity of the received trap, as a SNMPv2 notification (RFC 3584)
+ * @param trapOid		snmpTrapOID.0 value: snmpTraps.(generic-trap + 1), or enterprise.0.specific-trap (output)
+ * @param enterprise	Enterprise of the trap (output)
+ * @return false if no trap was received
  */
-std::shared_ptr<BerField> Snmpv1Pdu::getVarBind(u16 i) {
-	try {
-		return std::static_pointer_cast<BerSequence>(this->varBindList->getChild(i))->getChild(1);
-	} catch (const std::out_of_range &e){
-		throw;
+bool Snmpv1Pdu::getTrapOid(CompactOid &trapOid, CompactOid &enterprise) {
+
+	const BerView &enterpriseField = this->trapFields[SNMPV1_TRAP_ENTERPRISE];
+	if(enterpriseField.isEmpty()) return false;
+	enterprise = CompactOid(enterpriseField.getValue(), enterpriseField.getLength());
+
+	u32 generic = this->trapFields[SNMPV1_TRAP_GENERIC].getValueU32();
+	if(generic == SNMPV1_TRAP_ENTERPRISESPECIFIC) {
+		trapOid = enterprise;
+		trapOid.append(0);
+		trapOid.append(this->trapFields[SNMPV1_TRAP_SPECIFIC].getValueU32());
+	} else {
+		static const CompactOid snmpTraps(SNMP_TRAPS_OID);
+		trapOid = snmpTraps;
+		trapOid.append(generic + 1);
 	}
+	return true;
 }
 
 /**
- * @brief Get a VarBind OID from the PDU
- * @param i VarBind index
- * @return Desired VarBind OID
+ * @brief Destructor for a SNMPv1 PDU
  */
-std::shared_ptr<BerOid> Snmpv1Pdu::getVarBindOid(u16 i) {
-    try {
-		return std::static_pointer_cast<BerOid>(std::static_pointer_cast<BerSequence>(this->varBindList->getChild(i))->getChild(0));
-	} catch (const std::out_of_range &e){
-		throw;
-	}
-}
+Snmpv1Pdu::~Snmpv1Pdu() { }
 
 /**
  * @brief Serialize a SNMPv1 trap into a JSON
@@ -430,30 +708,30 @@ std::shared_ptr<json_t> Snmpv1Pdu::serializeTrap() {
     json_object_set_new(root.get(), "data", data);
 
     Utils::addJsonField(data, "Enterprise ID");
-    Utils::addJsonField(data, fields[0]->print());
+    Utils::addJsonField(data, trapFields[SNMPV1_TRAP_ENTERPRISE].print());
 
     Utils::addJsonField(data, "Agent address");
-    auto agentAddress = std::static_pointer_cast<BerOctetString>(fields[1])->getValue();
-    if(agentAddress.length() == 4) {
-        Utils::addJsonField(data, std::to_string(agentAddress[0]) + "." + std::to_string(agentAddress[1]) + "." +
-                               std::to_string(agentAddress[2]) + "." + std::to_string(agentAddress[3]));
+    const BerView &agentAddress = trapFields[SNMPV1_TRAP_AGENTADDR];
+    if(agentAddress.getLength() == 4) {
+        const u8 *address = agentAddress.getValue();
+        Utils::addJsonField(data, std::to_string(address[0]) + "." + std::to_string(address[1]) + "." +
+                               std::to_string(address[2]) + "." + std::to_string(address[3]));
+    } else {
+        Utils::addJsonField(data, "Invalid (" + std::to_string(agentAddress.getLength()) + " bytes)");   // Keeps the label paired with a value
     }
 
-    Utils::addJsonField(data, "Generic trap: " + fields[2]->print());
-    Utils::addJsonField(data, "Specific trap: " + fields[3]->print());
+    Utils::addJsonField(data, "Generic trap: " + trapFields[SNMPV1_TRAP_GENERIC].print());
+    Utils::addJsonField(data, "Specific trap: " + trapFields[SNMPV1_TRAP_SPECIFIC].print());
     
-    u32 timestamp = std::static_pointer_cast<BerInteger>(fields[4])->getValueU32() / 100;
+    u32 timestamp = trapFields[SNMPV1_TRAP_TIMESTAMP].getValueU32() / 100;
     u8 hour = timestamp / 3600;
     u8 minute = (timestamp % 3600) / 60;
     u8 second = (timestamp % 3600) % 60;
     Utils::addJsonField(data, "Timestamp: " + std::to_string(hour) + ":" + std::to_string(minute) + ":" + std::to_string(second));
 
-    if(varBindList != nullptr) {
-        for(u32 i = 0; i < varBindList->getNChildren(); i++) {
-            auto child = std::static_pointer_cast<BerSequence>(this->varBindList->getChild(i));
-            Utils::addJsonField(data, "OID: " + child->getChild(0)->print());
-            Utils::addJsonField(data, "Value: " + child->getChild(1)->print());
-        }
+    for(u32 i = 0; i < varBinds.size(); i++) {
+        Utils::addJsonField(data, "OID: " + varBinds[i].oid.print());
+        Utils::addJsonField(data, "Value: " + varBinds[i].value.print());
     }
 
     return root;
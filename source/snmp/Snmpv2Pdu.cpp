@@ -4,6 +4,7 @@
  */
 
 // Includes C/C++
+#include <string.h>
 #include <netinet/in.h>
 
 // Own includes
@@ -29,12 +30,13 @@ Snmpv2Pdu::Snmpv2Pdu(const std::string &community) : Snmpv1Pdu(community) {
  */
 std::shared_ptr<BerSequence> Snmpv2Pdu::generateBulkRequest(u32 nonRepeaters, u32 maxRepetitions) {
 
-	std::shared_ptr<BerSequence> getBulkRequest = std::make_shared<BerSequence>(SNMPV1_TAGCLASS, SNMPV2_GETBULKREQUEST);
+	std::shared_ptr<BerArena> arena = this->getArena();
+	std::shared_ptr<BerSequence> getBulkRequest = makeBerField<BerSequence>(arena, SNMPV1_TAGCLASS, SNMPV2_GETBULKREQUEST, arena);
 
-	this->reqID = ++Snmpv1Pdu::requestID;
-	std::shared_ptr<BerInteger> reqid = std::make_shared<BerInteger>(&this->reqID, sizeof(u32), false);
-	std::shared_ptr<BerInteger> nrField = std::make_shared<BerInteger>(&nonRepeaters, sizeof(u32), false);
-	std::shared_ptr<BerInteger> mrField = std::make_shared<BerInteger>(&maxRepetitions, sizeof(u32), false);
+	this->reqID = this->generateRequestID();
+	std::shared_ptr<BerInteger> reqid = makeBerField<BerInteger>(arena, &this->reqID, sizeof(u32), false);
+	std::shared_ptr<BerInteger> nrField = makeBerField<BerInteger>(arena, &nonRepeaters, sizeof(u32), false);
+	std::shared_ptr<BerInteger> mrField = makeBerField<BerInteger>(arena, &maxRepetitions, sizeof(u32), false);
 	getBulkRequest->addChild(reqid);				// RequestID
 	getBulkRequest->addChild(nrField);				// Non repeaters
 	getBulkRequest->addChild(mrField);	    		// Max repetitions
@@ -44,14 +46,14 @@ std::shared_ptr<BerSequence> Snmpv2Pdu::generateBulkRequest(u32 nonRepeaters, u3
 }
 
 /**
- * @brief Send a SNMPv2 GetBulk request
+ * @brief Encode a SNMPv2 GetBulk request without sending it
  * @param nonRepeaters      Number of scalar objects to fetch
  * @param maxRepetitions    Number of rows to get for the remaining objects
- * @param sock              Socket used for transmission
- * @param ip                Destination IP address
- * @param port              Destination port
+ * @param size              Encoded message size (output)
+ * @return The encoded message, inside the send buffer
+ * @note The message fields are kept until clear() is called
  */
-void Snmpv2Pdu::sendBulkRequest(u32 nonRepeaters, u32 maxRepetitions, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port) {
+u8 *Snmpv2Pdu::encodeBulkRequest(u32 nonRepeaters, u32 maxRepetitions, u32 *size) {
 
 	try {
 
@@ -66,7 +68,7 @@ void Snmpv2Pdu::sendBulkRequest(u32 nonRepeaters, u32 maxRepetitions, std::share
 		message->addChild(getBulkRequest);
 
 		this->fields.push_back(message);
-		BerPdu::send(sock, ip, port);
+		return this->encode(this->getSendBuffer(), BERPDU_MAX_SIZE, size);
 
 	} catch (const std::bad_alloc &e) {
 		this->fields.clear();
@@ -75,32 +77,59 @@ void Snmpv2Pdu::sendBulkRequest(u32 nonRepeaters, u32 maxRepetitions, std::share
 		this->fields.clear();
 		throw;
 	}
+}
+
+/**
+ * @brief Send a SNMPv2 GetBulk request
+ * @param nonRepeaters      Number of scalar objects to fetch
+ * @param maxRepetitions    Number of rows to get for the remaining objects
+ * @param sock              Socket used for transmission
+ * @param ip                Destination IP address
+ * @param port              Destination port
+ */
+void Snmpv2Pdu::sendBulkRequest(u32 nonRepeaters, u32 maxRepetitions, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port) {
+
+	try {
+		u32 size;
+		u8 *data = this->encodeBulkRequest(nonRepeaters, maxRepetitions, &size);
+		sock->sendPacket(data, size, ip, port);
+	} catch (const std::bad_alloc &e) {
+		this->fields.clear();
+		throw;
+	} catch (const std::runtime_error &e) {
+		this->fields.clear();
+		throw;
+	}
 
 	// Clear data
-	this->fields.clear();
-	this->varBindList.reset();
+	this->clear();
 }
 
 /**
- * @brief Receive a SNMPv2 trap or inform-request (acknowledged trap)
+ * @brief Receive a SNMPv2 trap or inform-request (acknowledged trap), without throwing on malformed or foreign packets
  * @param sock Socket used for reception
+ * @return The reception result
  */
-void Snmpv2Pdu::recvTrap(std::shared_ptr<UdpSocket> sock) {
+SnmpResult Snmpv2Pdu::tryRecvTrap(std::shared_ptr<UdpSocket> sock) {
 
     try {
 
         // Receive a trap or inform-request PDU
-        u8 pduType = this->recvResponse(sock, INADDR_ANY, 0, SNMP_PDU_ANY);
+        u8 pduType;
+        SnmpResult result = this->tryRecvResponse(sock, INADDR_ANY, 0, SNMP_PDU_ANY, &pduType);
+        if(result.status != SNMP_OK) return result;
 
         // Error if not a notification was received
         if(pduType != SNMPV2_TRAP && pduType != SNMPV2_INFORMREQUEST) {
-            throw std::runtime_error("This is not a notification PDU");
+            return Snmpv1Pdu::makeResult(SNMP_ERROR_NOT_NOTIFICATION, NULL, NULL);
         }
 
         // If it was an inform-request, send the acknowledgement
-        if(pduType == SNMPV2_INFORMREQUEST) {
-            this->sendRequest(SNMPV2_GETRESPONSE, sock, 0, 0);    // Use inform-request origin IP-port as destination IP-port
+        if(pduType == SNMPV2_INFORMREQUEST && !this->sendInformAck(sock)) {
+            return Snmpv1Pdu::makeResult(SNMP_ERROR_SEND, NULL, NULL);
         }
+
+        return result;
     } catch (const std::runtime_error &e) {
 		throw;
 	} catch (const std::bad_alloc &e) {
@@ -108,6 +137,88 @@ void Snmpv2Pdu::recvTrap(std::shared_ptr<UdpSocket> sock) {
 	}
 }
 
+/**
+ * @brief Acknowledge the received inform-request, keeping its VarBinds for the caller
+ * @param sock Socket the inform-request was received from
+ * @return false if the acknowledgement could not be encoded or sent
+ * @note sendRequest() is not used, as it would clear() the received PDU
+ */
+bool Snmpv2Pdu::sendInformAck(std::shared_ptr<UdpSocket> sock) {
+
+	u32 fixedReqID = this->fixedReqID;
+	bool sent = true;
+	try {
+		u32 size;
+		this->varBindList = Snmpv1Pdu::buildVarBindList(this->varBinds, this->getArena());
+		this->setRequestID(this->reqID);							// Answer with the inform-request ID
+		u8 *data = this->encodeRequest(SNMPV2_GETRESPONSE, &size);
+		sock->sendPacket(data, size, 0, 0);							// Use inform-request origin IP-port as destination IP-port
+	} catch (const std::bad_alloc &e) {
+		this->fixedReqID = fixedReqID;
+		this->fields.clear();
+		this->varBindList.reset();
+		throw;
+	} catch (const std::runtime_error &e) {
+		sent = false;
+	}
+
+	// Drop the encoded response only
+	this->fixedReqID = fixedReqID;
+	this->fields.clear();
+	this->varBindList.reset();
+	return sent;
+}
+
+/**
+ * @brief Find the identity of a notification in its VarBinds
+ * @param varBinds		Received VarBinds
+ * @param trapOid		snmpTrapOID.0 value (output)
+ * @param enterprise	snmpTrapEnterprise.0 value if sent, or the trap OID without its last arc and a trailing 0 (output)
+ * @return false if there is no snmpTrapOID.0
+ * @note The generic traps (under snmpTraps) without snmpTrapEnterprise.0 get snmpTraps as enterprise, as in RFC 3584
+ */
+bool Snmpv2Pdu::findTrapOid(const std::vector<SnmpVarBind> &varBinds, CompactOid &trapOid, CompactOid &enterprise) {
+
+    static const CompactOid snmpTrapOid(SNMP_TRAPOID_OID);
+    static const CompactOid snmpTrapEnterprise(SNMP_TRAPENTERPRISE_OID);
+    static const CompactOid snmpTraps(SNMP_TRAPS_OID);
+
+    bool found = false, foundEnterprise = false;
+    for(u32 i = 0; i < varBinds.size(); i++) {
+        const BerView &oid = varBinds[i].oid;
+        const VarBindValue &value = varBinds[i].value;
+        if(value.getType() != VARBIND_OID) continue;
+        if(!found && oid.getLength() == snmpTrapOid.getLength() && memcmp(oid.getValue(), snmpTrapOid.getData(), oid.getLength()) == 0) {
+            trapOid = CompactOid(value.getOctets(), value.getLength());
+            found = true;
+        } else if(!foundEnterprise && oid.getLength() == snmpTrapEnterprise.getLength() && memcmp(oid.getValue(), snmpTrapEnterprise.getData(), oid.getLength()) == 0) {
+            enterprise = CompactOid(value.getOctets(), value.getLength());
+            foundEnterprise = true;
+        }
+    }
+    if(!found || foundEnterprise) return found;
+
+    if(snmpTraps.isPrefixOf(trapOid)) {
+        enterprise = snmpTraps;
+    } else {
+        enterprise = trapOid;
+        u32 nArcs = enterprise.getNArcs();
+        if(nArcs > 2) enterprise.truncate(--nArcs);
+        if(nArcs > 2 && enterprise.getArc(nArcs - 1) == 0) enterprise.truncate(nArcs - 1);
+    }
+    return true;
+}
+
+/**
+ * @brief Get the identity of the received notification
+ * @param trapOid		snmpTrapOID.0 value (output)
+ * @param enterprise	Enterprise of the notification (output)
+ * @return false if it has no snmpTrapOID.0
+ */
+bool Snmpv2Pdu::getTrapOid(CompactOid &trapOid, CompactOid &enterprise) {
+    return Snmpv2Pdu::findTrapOid(this->varBinds, trapOid, enterprise);
+}
+
 /**
  * @brief Serialize a SNMPv2 trap into a JSON
  * @return The serialized trap
@@ -119,12 +230,9 @@ std::shared_ptr<json_t> Snmpv2Pdu::serializeTrap() {
     json_t *data = json_array();
     json_object_set_new(root.get(), "data", data);
 
-    if(varBindList != nullptr) {
-        for(u32 i = 0; i < varBindList->getNChildren(); i++) {
-            auto child = std::static_pointer_cast<BerSequence>(this->varBindList->getChild(i));
-            Utils::addJsonField(data, "OID: " + child->getChild(0)->print());
-            Utils::addJsonField(data, "Value: " + child->getChild(1)->print());
-        }
+    for(u32 i = 0; i < varBinds.size(); i++) {
+        Utils::addJsonField(data, "OID: " + varBinds[i].oid.print());
+        Utils::addJsonField(data, "Value: " + varBinds[i].value.print());
     }
 
     return root;
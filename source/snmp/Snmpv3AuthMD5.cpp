@@ -5,6 +5,7 @@
 
 // Includes C/C++
 #include <string.h>
+#include <stdexcept>
 
 // Includes mbedtls
 #include <mbedtls/md5.h>
@@ -24,58 +25,58 @@ Snmpv3AuthMD5::Snmpv3AuthMD5() { }
  */
 Snmpv3AuthMD5::~Snmpv3AuthMD5() { }
 
+/**
+ * @brief Hash the HMAC-MD5 key pads, once per key
+ * @param key       Localized key, zero padded to SNMPV3_AUTH_KEYLENGTH
+ * @param context   Hash states (output)
+ */
+void Snmpv3AuthMD5::initContext(const u8 *key, Snmpv3AuthContext &context) {
+
+    // Hash K1 = key XOR ipad
+    u8 pad[SNMPV3_AUTH_KEYLENGTH];
+    for(u8 i = 0; i < SNMPV3_AUTH_KEYLENGTH; i++) {
+        pad[i] = key[i] ^ 0x36;
+    }
+    mbedtls_md5_init(&context.md5[0]);
+    mbedtls_md5_starts_ret(&context.md5[0]);
+    mbedtls_md5_update_ret(&context.md5[0], pad, SNMPV3_AUTH_KEYLENGTH);
+
+    // Hash K2 = key XOR opad
+    for(u8 i = 0; i < SNMPV3_AUTH_KEYLENGTH; i++) {
+        pad[i] = key[i] ^ 0x5C;
+    }
+    mbedtls_md5_init(&context.md5[1]);
+    mbedtls_md5_starts_ret(&context.md5[1]);
+    mbedtls_md5_update_ret(&context.md5[1], pad, SNMPV3_AUTH_KEYLENGTH);
+}
+
 /**
  * @brief Create a HMAC-96-MD5 hash
  * @param data      Data to be hashed
  * @param length    Length of the data
- * @param params    Security parameters
- * @param keyptr    Pointer to the user key
- * @note The hash is stored in the security parameters
+ * @param hash      Output hash, SNMPV3_AUTH_HASHLENGTH octets
+ * @param context   HMAC context of the user key
  */
-void Snmpv3AuthMD5::createHash(const u8 *data, u32 length, Snmpv3SecurityParams &params, std::shared_ptr<u8> keyptr) {
+void Snmpv3AuthMD5::createHash(const u8 *data, u32 length, u8 *hash, const Snmpv3AuthContext &context) {
 
     try {
-
-        // Generate the key
         u8 digest[16];      // Final digest
-        std::unique_ptr<u8> message(new u8[SNMPV3_AUTH_KEYLENGTH + length]);
-        u8 *messagePtr = message.get();
-        u8 *key = keyptr.get();
-
-        // Generate K1
-        u8 k[SNMPV3_AUTH_KEYLENGTH];
-        u8 filler[SNMPV3_AUTH_KEYLENGTH];
-        memset(filler, 0x36, SNMPV3_AUTH_KEYLENGTH);
-        for(u8 i = 0; i < SNMPV3_AUTH_KEYLENGTH; i++) {
-            k[i] = key[i] ^ filler[i];
-        }
-
-        // Perform MD5(K1 + data)
-        memcpy(messagePtr, k, SNMPV3_AUTH_KEYLENGTH);
-        memcpy(messagePtr + SNMPV3_AUTH_KEYLENGTH, data, length);
         mbedtls_md5_context MD;
         mbedtls_md5_init(&MD);
-        mbedtls_md5_starts_ret(&MD);
-        mbedtls_md5_update_ret(&MD, messagePtr, SNMPV3_AUTH_KEYLENGTH + length);
-        mbedtls_md5_finish_ret(&MD, digest);
-        mbedtls_md5_free(&MD);
 
-        // Generate K2
-        memset(filler, 0x5C, SNMPV3_AUTH_KEYLENGTH);
-        for(u8 i = 0; i < SNMPV3_AUTH_KEYLENGTH; i++) {
-            k[i] = key[i] ^ filler[i];
-        }
+        // Perform MD5(K1 + data), straight from the message
+        mbedtls_md5_clone(&MD, &context.md5[0]);
+        mbedtls_md5_update_ret(&MD, data, length);
+        mbedtls_md5_finish_ret(&MD, digest);
 
         // Perform MD5(K2 + previous MD5)
-        memcpy(messagePtr, k, SNMPV3_AUTH_KEYLENGTH);
-        memcpy(messagePtr + SNMPV3_AUTH_KEYLENGTH, digest, 16);
-        mbedtls_md5_starts_ret(&MD);
-        mbedtls_md5_update_ret(&MD, messagePtr, SNMPV3_AUTH_KEYLENGTH + 16);
+        mbedtls_md5_clone(&MD, &context.md5[1]);
+        mbedtls_md5_update_ret(&MD, digest, 16);
         mbedtls_md5_finish_ret(&MD, digest);
         mbedtls_md5_free(&MD);
 
         // Save the final hash (its 12 first octets)
-        params.msgAuthenticationParameters = std::string((char*)digest, 12);
+        memcpy(hash, digest, SNMPV3_AUTH_HASHLENGTH);
 
     } catch(const std::bad_alloc &e) {
         throw;
@@ -85,13 +86,12 @@ void Snmpv3AuthMD5::createHash(const u8 *data, u32 length, Snmpv3SecurityParams
 }
 
 /**
- * @brief Get a key from a password
+ * @brief Get the master key of a password
  * @param password  Password
- * @param params    Security parameters
- * @return The key for that password
+ * @return The master key, the same for every engine
  */
-std::shared_ptr<u8> Snmpv3AuthMD5::passwordToKey(const std::string &password, Snmpv3SecurityParams &params) {
-
+std::shared_ptr<u8> Snmpv3AuthMD5::passwordToMasterKey(const std::string &password) {
+    
     // Adapted from https://tools.ietf.org/html/rfc3414#appendix-A.2.1
 
     // Variables
@@ -128,17 +128,44 @@ std::shared_ptr<u8> Snmpv3AuthMD5::passwordToKey(const std::string &password, Sn
         mbedtls_md5_finish_ret(&MD, key);
         mbedtls_md5_free(&MD);
 
+        // Return the created key
+        return keybuffer;
+    } catch (const std::bad_alloc &e) {
+        throw;
+    } catch (const std::runtime_error &e) {
+        throw;
+    }
+}
+
+/**
+ * @brief Localize a master key to an engine
+ * @param masterKey Master key
+ * @param engineID  Authoritative engine ID
+ * @return The localized key
+ */
+std::shared_ptr<u8> Snmpv3AuthMD5::localizeKey(std::shared_ptr<u8> masterKey, const std::string &engineID) {
+
+    // Variables
+    mbedtls_md5_context MD;
+    u_char password_buf[64];
+
+    try {
+        std::shared_ptr<u8> keybuffer(new u8[SNMPV3_AUTH_KEYLENGTH]);
+        u8 *key = keybuffer.get();
+        memset(key, 0, SNMPV3_AUTH_KEYLENGTH);
+
         /*****************************************************/
         /* Now localize the key with the engineID and pass   */
         /* through MD5 to produce final key                  */
-        /* May want to ensure that engineLength <= 32,       */
-        /* otherwise need to use a buffer larger than 64     */
         /*****************************************************/
-        std::string &engineID = params.msgAuthoritativeEngineID;
-        memcpy(password_buf, key, 16);
+        if(engineID.length() > 32) {                    // snmpEngineID is at most 32 octets
+            throw std::runtime_error("Engine ID too long");
+        }
+        memcpy(password_buf, masterKey.get(), 16);
         memcpy(password_buf + 16, engineID.c_str(), engineID.length());
-        memcpy(password_buf + 16 + engineID.length(), key, 16);
+        memcpy(password_buf + 16 + engineID.length(), masterKey.get(), 16);
 
+        mbedtls_md5_init(&MD);
         mbedtls_md5_starts_ret(&MD);
         mbedtls_md5_update_ret(&MD, password_buf, 32 + engineID.length());
         mbedtls_md5_finish_ret(&MD, key);
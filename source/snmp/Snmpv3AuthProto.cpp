@@ -3,6 +3,9 @@
  * @brief SNMPv3 Authentication protocol interface
  */
 
+// Includes C/C++
+#include <string.h>
+
 // Own includes
 #include "snmp/Snmpv3AuthProto.h"
 
@@ -10,23 +13,45 @@ namespace NetMan {
 
 /**
  * @brief Authenticate a SNMPv3 PDU
- * @param data      Data to be authenticated
+ * @param data      Data to be authenticated, with zeroed authentication parameters
  * @param length    Data length
- * @param password  Password for the HMAC
- * @param params    Security parameters
+ * @param params    Security parameters, holding the received hash
+ * @param context   HMAC context of the user key
  * @return Whether the authentication was successful or not
  */
-bool Snmpv3AuthProto::authenticate(const u8 *data, u32 length, Snmpv3SecurityParams &params, std::shared_ptr<u8> keyptr) {
+bool Snmpv3AuthProto::authenticate(const u8 *data, u32 length, Snmpv3SecurityParams &params, const Snmpv3AuthContext &context) {
 
-    std::string digest = params.msgAuthenticationParameters;
+    if(params.msgAuthenticationParameters.length() != SNMPV3_AUTH_HASHLENGTH) {
+        return false;
+    }
 
     try {
+        // Generate the hash
+        u8 digest[SNMPV3_AUTH_HASHLENGTH];
+        this->createHash(data, length, digest, context);
+
+        // Compare it with the received one, taking the same time wherever they differ
+        u8 diff = 0;
+        for(u32 i = 0; i < SNMPV3_AUTH_HASHLENGTH; i++) {
+            diff |= digest[i] ^ (u8)params.msgAuthenticationParameters[i];
+        }
+        return diff == 0;
+    } catch(const std::bad_alloc &e) {
+        throw;
+    } catch(const std::runtime_error &e) {
+        throw;
+    }
+}
 
-        // Generate the SHA1 hash
-        this->createHash(data, length, params, keyptr);
-
-        // Compare it with the previous one
-        return (digest.compare(params.msgAuthenticationParameters) == 0);
+/**
+ * @brief Get a key from a password
+ * @param password  Password
+ * @param params    Security parameters
+ * @return The key for that password, localized to the authoritative engine
+ */
+std::shared_ptr<u8> Snmpv3AuthProto::passwordToKey(const std::string &password, Snmpv3SecurityParams &params) {
+    try {
+        return this->localizeKey(this->passwordToMasterKey(password), params.msgAuthoritativeEngineID);
     } catch(const std::bad_alloc &e) {
         throw;
     } catch(const std::runtime_error &e) {
@@ -5,6 +5,7 @@
 
 // Includes C/C++
 #include <string.h>
+#include <stdexcept>
 
 // Includes mbedtls
 #include <mbedtls/sha1.h>
@@ -24,58 +25,58 @@ Snmpv3AuthSHA1::Snmpv3AuthSHA1() { }
 */
 Snmpv3AuthSHA1::~Snmpv3AuthSHA1() { }
 
+/**
+ * @brief Hash the HMAC-SHA1 key pads, once per key
+ * @param key       Localized key, zero padded to SNMPV3_AUTH_KEYLENGTH
+ * @param context   Hash states (output)
+ */
+void Snmpv3AuthSHA1::initContext(const u8 *key, Snmpv3AuthContext &context) {
+
+    // Hash K1 = key XOR ipad
+    u8 pad[SNMPV3_AUTH_KEYLENGTH];
+    for(u8 i = 0; i < SNMPV3_AUTH_KEYLENGTH; i++) {
+        pad[i] = key[i] ^ 0x36;
+    }
+    mbedtls_sha1_init(&context.sha1[0]);
+    mbedtls_sha1_starts_ret(&context.sha1[0]);
+    mbedtls_sha1_update_ret(&context.sha1[0], pad, SNMPV3_AUTH_KEYLENGTH);
+
+    // Hash K2 = key XOR opad
+    for(u8 i = 0; i < SNMPV3_AUTH_KEYLENGTH; i++) {
+        pad[i] = key[i] ^ 0x5C;
+    }
+    mbedtls_sha1_init(&context.sha1[1]);
+    mbedtls_sha1_starts_ret(&context.sha1[1]);
+    mbedtls_sha1_update_ret(&context.sha1[1], pad, SNMPV3_AUTH_KEYLENGTH);
+}
+
 /**
  * @brief Create a HMAC-96-SHA1 hash
  * @param data      Data to be hashed
  * @param length    Length of the data
- * @param password  Password for the HMAC
- * @param params    Security parameters
- * @note The hash is stored in the security parameters
+ * @param hash      Output hash, SNMPV3_AUTH_HASHLENGTH octets
+ * @param context   HMAC context of the user key
  */
-void Snmpv3AuthSHA1::createHash(const u8 *data, u32 length, Snmpv3SecurityParams &params, std::shared_ptr<u8> keyptr) {
+void Snmpv3AuthSHA1::createHash(const u8 *data, u32 length, u8 *hash, const Snmpv3AuthContext &context) {
 
     try {
-
-        // Generate the key
         u8 digest[20];      // Final digest
-        std::unique_ptr<u8> message(new u8[SNMPV3_AUTH_KEYLENGTH + length]);
-        u8 *messagePtr = message.get();
-        u8 *key = keyptr.get();
-
-        // Generate K1
-        u8 k[SNMPV3_AUTH_KEYLENGTH];
-        u8 filler[SNMPV3_AUTH_KEYLENGTH];
-        memset(filler, 0x36, SNMPV3_AUTH_KEYLENGTH);
-        for(u8 i = 0; i < SNMPV3_AUTH_KEYLENGTH; i++) {
-            k[i] = key[i] ^ filler[i];
-        }
-
-        // Perform SHA1(K1 + data)
-        memcpy(messagePtr, k, SNMPV3_AUTH_KEYLENGTH);
-        memcpy(messagePtr + SNMPV3_AUTH_KEYLENGTH, data, length);
         mbedtls_sha1_context SH;
         mbedtls_sha1_init(&SH);
-        mbedtls_sha1_starts_ret(&SH);
-        mbedtls_sha1_update_ret(&SH, messagePtr, SNMPV3_AUTH_KEYLENGTH + length);
-        mbedtls_sha1_finish_ret(&SH, digest);
-        mbedtls_sha1_free(&SH);
 
-        // Generate K2
-        memset(filler, 0x5C, SNMPV3_AUTH_KEYLENGTH);
-        for(u8 i = 0; i < SNMPV3_AUTH_KEYLENGTH; i++) {
-            k[i] = key[i] ^ filler[i];
-        }
+        // Perform SHA1(K1 + data), straight from the message
+        mbedtls_sha1_clone(&SH, &context.sha1[0]);
+        mbedtls_sha1_update_ret(&SH, data, length);
+        mbedtls_sha1_finish_ret(&SH, digest);
 
         // Perform SHA1(K2 + previous SHA1)
-        memcpy(messagePtr, k, SNMPV3_AUTH_KEYLENGTH);
-        memcpy(messagePtr + SNMPV3_AUTH_KEYLENGTH, digest, 20);
-        mbedtls_sha1_starts_ret(&SH);
-        mbedtls_sha1_update_ret(&SH, messagePtr, SNMPV3_AUTH_KEYLENGTH + 20);
+        mbedtls_sha1_clone(&SH, &context.sha1[1]);
+        mbedtls_sha1_update_ret(&SH, digest, 20);
         mbedtls_sha1_finish_ret(&SH, digest);
         mbedtls_sha1_free(&SH);
 
         // Save the final hash (its 12 first octets)
-        params.msgAuthenticationParameters = std::string((char*)digest, 12);
+        memcpy(hash, digest, SNMPV3_AUTH_HASHLENGTH);
 
     } catch(const std::bad_alloc &e) {
         throw;
@@ -85,18 +86,17 @@ void Snmpv3AuthSHA1::createHash(const u8 *data, u32 length, Snmpv3SecurityParams
 }
 
 /**
- * @brief Get a key from a password
+ * @brief Get the master key of a password
  * @param password  Password
- * @param params    Security parameters
- * @return The key for that password
+ * @return The master key, the same for every engine
  */
-std::shared_ptr<u8> Snmpv3AuthSHA1::passwordToKey(const std::string &password, Snmpv3SecurityParams &params) {
+std::shared_ptr<u8> Snmpv3AuthSHA1::passwordToMasterKey(const std::string &password) {
     
     // Adapted from https://tools.ietf.org/html/rfc3414#appendix-A.2.2
 
     // Variables
     mbedtls_sha1_context SH;
-    u_char *cp, password_buf[72];
+    u_char *cp, password_buf[64];
     u_long password_index = 0;
     u_long count = 0, i;
 
@@ -128,17 +128,44 @@ std::shared_ptr<u8> Snmpv3AuthSHA1::passwordToKey(const std::string &password, S
         mbedtls_sha1_finish_ret(&SH, key);
         mbedtls_sha1_free(&SH);
 
+        // Return the created key
+        return keybuffer;
+    } catch (const std::bad_alloc &e) {
+        throw;
+    } catch (const std::runtime_error &e) {
+        throw;
+    }
+}
+
+/**
+ * @brief Localize a master key to an engine
+ * @param masterKey Master key
+ * @param engineID  Authoritative engine ID
+ * @return The localized key
+ */
+std::shared_ptr<u8> Snmpv3AuthSHA1::localizeKey(std::shared_ptr<u8> masterKey, const std::string &engineID) {
+
+    // Variables
+    mbedtls_sha1_context SH;
+    u_char password_buf[72];
+
+    try {
+        std::shared_ptr<u8> keybuffer(new u8[SNMPV3_AUTH_KEYLENGTH]);
+        u8 *key = keybuffer.get();
+        memset(key, 0, SNMPV3_AUTH_KEYLENGTH);
+
         /*****************************************************/
         /* Now localize the key with the engineID and pass   */
         /* through SHA1 to produce final key                 */
-        /* May want to ensure that engineLength <= 32,       */
-        /* otherwise need to use a buffer larger than 64     */
         /*****************************************************/
-        std::string &engineID = params.msgAuthoritativeEngineID;
-        memcpy(password_buf, key, 20);
+        if(engineID.length() > 32) {                    // snmpEngineID is at most 32 octets
+            throw std::runtime_error("Engine ID too long");
+        }
+        memcpy(password_buf, masterKey.get(), 20);
         memcpy(password_buf + 20, engineID.c_str(), engineID.length());
-        memcpy(password_buf + 20 + engineID.length(), key, 20);
+        memcpy(password_buf + 20 + engineID.length(), masterKey.get(), 20);
 
+        mbedtls_sha1_init(&SH);
         mbedtls_sha1_starts_ret(&SH);
         mbedtls_sha1_update_ret(&SH, password_buf, 40 + engineID.length());
         mbedtls_sha1_finish_ret(&SH, key);
@@ -0,0 +1,224 @@
+/**
+ * @file Snmpv3EngineCache.cpp
+ * @brief Cache of the SNMPv3 agent engines
+ */
+
+// Includes C/C++
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// Own includes
+#include "snmp/Snmpv3EngineCache.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a SNMPv3 engine cache
+ */
+Snmpv3EngineCache::Snmpv3EngineCache() {
+	LightLock_Init(&this->lock);
+	load();
+}
+
+/**
+ * @brief Load the engine cache from a file
+ * @note Missing or malformed entries are skipped
+ */
+void Snmpv3EngineCache::load() {
+
+	std::ifstream infile(SNMPV3_ENGINECACHE_PATH, std::ios::in);
+	if(!infile.is_open()) return;
+
+	LightLock_Lock(&this->lock);
+
+	// Read every line: ip port engineID(hex) engineBoots engineTime receivedAt
+	std::string line;
+	while(std::getline(infile, line)) {
+		std::istringstream iss(line);
+		u32 ip, port;
+		std::string hexID;
+		Snmpv3EngineCacheEntry entry;
+		if(!(iss >> ip >> port >> hexID >> entry.engineBoots >> entry.engineTime >> entry.receivedAt)) continue;
+		if(hexID.size() % 2 != 0) continue;
+
+		for(u32 i = 0; i < hexID.size(); i += 2) {
+			entry.engineID.push_back((char)strtoul(hexID.substr(i, 2).c_str(), NULL, 16));
+		}
+		this->entries[Snmpv3EngineCache::getKey(ip, port)] = entry;
+	}
+
+	LightLock_Unlock(&this->lock);
+	infile.close();
+}
+
+/**
+ * @brief Save the engine cache to a file, with the cache already locked
+ */
+void Snmpv3EngineCache::saveLocked() {
+
+	// Open the file
+	FILE *f = fopen(SNMPV3_ENGINECACHE_PATH, "wb");
+	if(f == NULL) {
+		throw std::runtime_error(std::string("Couldn't open ") + SNMPV3_ENGINECACHE_PATH);
+	}
+
+	// Write the engines
+	for(auto &it : this->entries) {
+		const Snmpv3EngineCacheEntry &entry = it.second;
+		fprintf(f, "%lu %lu ", (u32)(it.first >> 16), (u32)(it.first &0xFFFF));
+		for(u32 i = 0; i < entry.engineID.size(); i++) {
+			fprintf(f, "%02X", (u8)entry.engineID[i]);
+		}
+		fprintf(f, " %lu %lu %llu\n", entry.engineBoots, entry.engineTime, entry.receivedAt);
+	}
+
+	// Close the file
+	fclose(f);
+}
+
+/**
+ * @brief Save the engine cache to a file
+ */
+void Snmpv3EngineCache::save() {
+	LightLock_Lock(&this->lock);
+	try {
+		this->saveLocked();
+	} catch (const std::runtime_error &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	}
+	LightLock_Unlock(&this->lock);
+}
+
+/**
+ * @brief Estimate the current engineTime of an agent
+ * @param entry	Cached engine
+ * @param now	Current time, in osGetTime() ms
+ * @return The received engineTime plus the seconds elapsed since then
+ */
+u32 Snmpv3EngineCache::estimateTime(const Snmpv3EngineCacheEntry &entry, u64 now) {
+	if(now <= entry.receivedAt) return entry.engineTime;		// The clock went back
+	u64 time = entry.engineTime + (now - entry.receivedAt) / 1000;
+	return (time > SNMPV3_ENGINECACHE_MAX_TIME) ? SNMPV3_ENGINECACHE_MAX_TIME : time;
+}
+
+/**
+ * @brief Get the authoritative engine of an agent
+ * @param ip			Agent IP
+ * @param port			Agent port
+ * @param engineID		Agent engine ID (output)
+ * @param engineBoots	Agent engineBoots (output)
+ * @param engineTime	Estimated agent engineTime (output)
+ * @return If the agent is cached
+ */
+bool Snmpv3EngineCache::get(in_addr_t ip, u16 port, std::string &engineID, u32 *engineBoots, u32 *engineTime) {
+
+	LightLock_Lock(&this->lock);
+	auto it = this->entries.find(Snmpv3EngineCache::getKey(ip, port));
+	if(it == this->entries.end()) {
+		LightLock_Unlock(&this->lock);
+		return false;
+	}
+
+	engineID = it->second.engineID;
+	*engineBoots = it->second.engineBoots;
+	*engineTime = Snmpv3EngineCache::estimateTime(it->second, osGetTime());
+	LightLock_Unlock(&this->lock);
+	return true;
+}
+
+/**
+ * @brief Drop the least recently synchronized engine
+ */
+void Snmpv3EngineCache::evict() {
+	auto oldest = this->entries.begin();
+	for(auto it = this->entries.begin(); it != this->entries.end(); it++) {
+		if(it->second.receivedAt < oldest->second.receivedAt) oldest = it;
+	}
+	if(oldest != this->entries.end()) this->entries.erase(oldest);
+}
+
+/**
+ * @brief Store the authoritative engine of an agent, as just received from it
+ * @param ip			Agent IP
+ * @param port			Agent port
+ * @param engineID		Agent engine ID
+ * @param engineBoots	Agent engineBoots
+ * @param engineTime	Agent engineTime
+ * @note The file is only written when the engine changes, or when the estimated engineTime was too far
+ */
+void Snmpv3EngineCache::update(in_addr_t ip, u16 port, const std::string &engineID, u32 engineBoots, u32 engineTime) {
+
+	if(engineID.empty()) return;
+
+	LightLock_Lock(&this->lock);
+	try {
+		u64 now = osGetTime();
+		u64 key = Snmpv3EngineCache::getKey(ip, port);
+		bool changed = true;
+		auto it = this->entries.find(key);
+		if(it != this->entries.end()) {
+			const Snmpv3EngineCacheEntry &entry = it->second;
+			s64 drift = (s64)Snmpv3EngineCache::estimateTime(entry, now) - engineTime;
+			changed = entry.engineID != engineID || entry.engineBoots != engineBoots ||
+				drift > SNMPV3_ENGINECACHE_MAX_DRIFT || drift < -SNMPV3_ENGINECACHE_MAX_DRIFT;
+		} else if(this->entries.size() >= SNMPV3_ENGINECACHE_MAX_ENTRIES) {
+			this->evict();
+		}
+
+		Snmpv3EngineCacheEntry &entry = this->entries[key];
+		entry.engineID = engineID;
+		entry.engineBoots = engineBoots;
+		entry.engineTime = engineTime;
+		entry.receivedAt = now;
+
+		// A failed save only loses the entry on the next run
+		if(changed) {
+			try {
+				this->saveLocked();
+			} catch (const std::runtime_error &e) { }
+		}
+	} catch (const std::bad_alloc &e) {
+		LightLock_Unlock(&this->lock);
+		throw;
+	}
+	LightLock_Unlock(&this->lock);
+}
+
+/**
+ * @brief Forget the engine of an agent
+ * @param ip	Agent IP
+ * @param port	Agent port
+ */
+void Snmpv3EngineCache::remove(in_addr_t ip, u16 port) {
+	LightLock_Lock(&this->lock);
+	this->entries.erase(Snmpv3EngineCache::getKey(ip, port));
+	LightLock_Unlock(&this->lock);
+}
+
+/**
+ * @brief Forget every engine
+ */
+void Snmpv3EngineCache::clear() {
+	LightLock_Lock(&this->lock);
+	this->entries.clear();
+	LightLock_Unlock(&this->lock);
+}
+
+/**
+ * @brief Destructor for a SNMPv3 engine cache
+ */
+Snmpv3EngineCache::~Snmpv3EngineCache() { }
+
+/**
+ * @brief Get the engine cache instance
+ * @return The instance
+ */
+Snmpv3EngineCache &Snmpv3EngineCache::getInstance() {
+	static Snmpv3EngineCache instance;
+	return instance;
+}
+
+}
@@ -4,6 +4,7 @@
  */
 
 // Includes C/C++
+#include <stdio.h>
 #include <string.h>
 
 // Own includes
@@ -26,6 +27,7 @@ u32 Snmpv3Pdu::requestID = 0;
  */
 Snmpv3Pdu::Snmpv3Pdu(const std::string &engineID, const std::string &contextName, const std::string &userName) {
     this->reqID = 0;
+	this->fixedReqID = 0;
 	this->contextName = contextName;
 	secParams.msgAuthoritativeEngineID = engineID;
     secParams.msgAuthoritativeEngineBoots = 0;
@@ -34,207 +36,167 @@ Snmpv3Pdu::Snmpv3Pdu(const std::string &engineID, const std::string &contextName
     secParams.msgAuthenticationParameters = "";
     secParams.msgPrivacyParameters = "";
 	this->varBindList = nullptr;
+	this->pduResult = {SNMP_OK, 0, SNMPV1_ERROR_NOERROR, 0};
+	this->maxSize = SNMPV3_MAX_MSG_SIZE;
+	this->agentMaxSize = 0;
+	this->engineSynced = false;
 }
 
 /**
- * @brief Generate a SNMPv3 header
- * @param type			PDU type
- * @param reportable	Reportable flag set?
- * @param scopedPdu		Scoped PDU data
- * @return A sequence containing a SNMPv3 header
+ * @brief Write an unsigned INTEGER field
+ * @param writer	Output writer
+ * @param value		Integer value
  */
-std::shared_ptr<BerSequence> Snmpv3Pdu::generateHeader(u32 type, bool reportable, std::shared_ptr<BerField> scopedPdu) {
+static void snmpv3_write_uint(BerWriter &writer, u32 value) {
+	u32 start = writer.getSize();
+	do {
+		writer.writeByte(value &0xFF);
+		value >>= 8;
+	} while(value != 0);
+	if(*writer.getData() &0x80) writer.writeByte(0);		// Keep it positive
+	writer.writeLength(writer.getSize() - start);
+	writer.writeTag(BER_TAGCLASS_INTEGER, BER_TAG_INTEGER);
+}
 
-    try {
-		std::shared_ptr<BerSequence> message = std::make_shared<BerSequence>();
-
-		// Header (common to all SNMPv3 PDUs)
-        u32 ver = SNMPV3_VERSION;
-		std::shared_ptr<BerInteger> msgVersion = std::make_shared<BerInteger>(&ver, sizeof(u32), false);
-        std::shared_ptr<BerSequence> msgGlobalData = std::make_shared<BerSequence>();
-
-		// Prepare flags
-		u8 flags = 0;
-		Snmpv3UserStore &store = Snmpv3UserStore::getInstance();
-		Snmpv3UserStoreEntry &user = store.getUser(secParams.msgUserName);
-		if(reportable) flags |= SNMPV3_FLAG_REPORTABLE;
-		if(type != SNMPV2_REPORT) {		// Reports are not secured
-			if(user.authProto != SNMPV3_AUTHPROTO_NONE) flags |= SNMPV3_FLAG_AUTH;
-			if(user.privProto != SNMPV3_PRIVPROTO_NONE) flags |= SNMPV3_FLAG_PRIV;
-		}
+/**
+ * @brief Write an OCTET STRING field
+ * @param writer	Output writer
+ * @param value		String value
+ */
+static void snmpv3_write_string(BerWriter &writer, const std::string &value) {
+	writer.writeBytes(value.data(), value.size());
+	writer.writeLength(value.size());
+	writer.writeTag(BER_TAGCLASS_OCTETSTRING, BER_TAG_OCTETSTRING);
+}
 
-        // Fill msgGlobalData
-        this->reqID = ++Snmpv3Pdu::requestID;
-        std::shared_ptr<BerInteger> msgID = std::make_shared<BerInteger>(&this->reqID, sizeof(u32), false);
-        u32 maxSize = SNMP_MAX_PDU_SIZE;
-        std::shared_ptr<BerInteger> msgMaxSize = std::make_shared<BerInteger>(&maxSize, sizeof(u32), false);
-        std::shared_ptr<BerOctetString> msgFlags = std::make_shared<BerOctetString>(std::string(1, flags));
-        u32 securityModel = SNMPV3_USM_MODEL;
-        std::shared_ptr<BerInteger> msgSecurityModel = std::make_shared<BerInteger>(&securityModel, sizeof(u32), false);
-        msgGlobalData->addChild(msgID);
-        msgGlobalData->addChild(msgMaxSize);
-        msgGlobalData->addChild(msgFlags);
-        msgGlobalData->addChild(msgSecurityModel);
-
-        // Fill msgSecurityParameters
-        std::shared_ptr<BerPdu> securityParams = std::make_shared<BerPdu>();
-        std::shared_ptr<BerSequence> securityParamsSeq = std::make_shared<BerSequence>();
-        std::shared_ptr<BerOctetString> contextEngineID = std::make_shared<BerOctetString>(secParams.msgAuthoritativeEngineID);
-        std::shared_ptr<BerInteger> engineBoots = std::make_shared<BerInteger>(&secParams.msgAuthoritativeEngineBoots, sizeof(u32), false);
-        std::shared_ptr<BerInteger> engineTime = std::make_shared<BerInteger>(&secParams.msgAuthoritativeEngineTime, sizeof(u32), false);
-        std::shared_ptr<BerOctetString> userName = std::make_shared<BerOctetString>(secParams.msgUserName);
-        std::shared_ptr<BerOctetString> authParams = std::make_shared<BerOctetString>(secParams.msgAuthenticationParameters);
-        std::shared_ptr<BerOctetString> privParams = std::make_shared<BerOctetString>(secParams.msgPrivacyParameters);
-
-		// Add fields
-        securityParamsSeq->addChild(contextEngineID);
-        securityParamsSeq->addChild(engineBoots);
-        securityParamsSeq->addChild(engineTime);
-        securityParamsSeq->addChild(userName);
-        securityParamsSeq->addChild(authParams);
-        securityParamsSeq->addChild(privParams);
-        securityParams->addField(securityParamsSeq);
-
-		// Serialize security parameters as an OCTET STRING
-        u32 securityParamsSize;
-        std::unique_ptr<u8> serializedParams = securityParams->serialize(&securityParamsSize);
-        std::shared_ptr<BerOctetString> msgSecurityParameters = std::make_shared<BerOctetString>(std::string((char*)serializedParams.get(), securityParamsSize));
-
-        // Add each structure to the header
-        message->addChild(msgVersion);
-		message->addChild(msgGlobalData);
-        message->addChild(msgSecurityParameters);
-        message->addChild(scopedPdu);
-
-		// Return the generated message
-		return message;
-	} catch (const std::bad_alloc &e) {
-		throw;
+/**
+ * @brief Write a SNMPv3 header in front of the message data, closing the message
+ * @param writer		Output writer, holding only msgData
+ * @param flags			msgFlags
+ * @param authParams	Where msgAuthenticationParameters is, inside the writer buffer (output). NULL if not authenticated.
+ */
+void Snmpv3Pdu::writeHeader(BerWriter &writer, u8 flags, u8 **authParams) {
+
+	// msgSecurityParameters, an OCTET STRING holding a sequence
+	u32 start = writer.getSize();
+	snmpv3_write_string(writer, secParams.msgPrivacyParameters);
+	*authParams = NULL;
+	if(flags &SNMPV3_FLAG_AUTH) {
+		writer.writeZeros(SNMPV3_AUTH_HASHLENGTH);		// Filled once the whole message is written
+		*authParams = writer.getData();
+		writer.writeLength(SNMPV3_AUTH_HASHLENGTH);
+		writer.writeTag(BER_TAGCLASS_OCTETSTRING, BER_TAG_OCTETSTRING);
+	} else {
+		snmpv3_write_string(writer, secParams.msgAuthenticationParameters);
 	}
+	snmpv3_write_string(writer, secParams.msgUserName);
+	snmpv3_write_uint(writer, secParams.msgAuthoritativeEngineTime);
+	snmpv3_write_uint(writer, secParams.msgAuthoritativeEngineBoots);
+	snmpv3_write_string(writer, secParams.msgAuthoritativeEngineID);
+	writer.writeLength(writer.getSize() - start);
+	writer.writeTag(BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE);
+	writer.writeLength(writer.getSize() - start);
+	writer.writeTag(BER_TAGCLASS_OCTETSTRING, BER_TAG_OCTETSTRING);
+
+	// msgGlobalData
+	this->reqID = (this->fixedReqID != 0) ? this->fixedReqID : ++Snmpv3Pdu::requestID;
+	start = writer.getSize();
+	snmpv3_write_uint(writer, SNMPV3_USM_MODEL);
+	writer.writeByte(flags);
+	writer.writeLength(1);
+	writer.writeTag(BER_TAGCLASS_OCTETSTRING, BER_TAG_OCTETSTRING);
+	snmpv3_write_uint(writer, this->maxSize);
+	snmpv3_write_uint(writer, this->reqID);
+	writer.writeLength(writer.getSize() - start);
+	writer.writeTag(BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE);
+
+	// msgVersion, and the whole message
+	snmpv3_write_uint(writer, SNMPV3_VERSION);
+	writer.writeLength(writer.getSize());
+	writer.writeTag(BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE);
 }
 
 /**
  * @brief Check a SNMPv3 header
- * @param ptr 			Data buffer
+ * @param message 		Reader placed at the beginning of the message contents
  * @param checkMsgID	Check message ID?
  * @param params		Security parameters (input)
- * @param sock			Socket used to generate reports to an agent
+ * @param sock			Socket used to generate reports to an agent, or nullptr to not send them
  * @param flags			SNMPv3 header flags
- * @return Encrypted PDU, or nullptr if it is not encrypted
+ * @return The msgData field: the encrypted PDU if privacy is used, the scoped PDU otherwise
+ * @note If the message is authenticated, its authParams are zeroed in the reception buffer
  */
-std::shared_ptr<BerOctetString> Snmpv3Pdu::checkHeader(u8 **ptr, bool checkMsgID, Snmpv3SecurityParams &params, std::shared_ptr<UdpSocket> sock, u8 *flags) {
+BerView Snmpv3Pdu::checkHeader(BerReader &message, bool checkMsgID, Snmpv3SecurityParams &params, std::shared_ptr<UdpSocket> sock, u8 *flags) {
 
     try {
 
-		// Read response header
-		BerSequence::decode(ptr);
-
 		// Check version
-		std::shared_ptr<BerInteger> version = BerInteger::decode(ptr, false);
-		if(version->getValueU32() != SNMPV3_VERSION) {
+		BerView version = message.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER);
+		if(version.getValueU32() != SNMPV3_VERSION) {
 			throw std::runtime_error("Not a SNMPv3 PDU");
 		}
 #ifdef SNMP_DEBUG
-	version->print();
+	printf("%s\n", version.print().c_str());
 #endif
 
 		// Check msgID
-		BerSequence::decode(ptr);
-		std::shared_ptr<BerInteger> msgID = BerInteger::decode(ptr, false);
-		if(checkMsgID && msgID->getValueU32() != this->reqID) {
+		BerReader globalData(message.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE));
+		u32 msgID = globalData.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+		if(checkMsgID && msgID != this->reqID) {
 			throw std::runtime_error("msgID does not match");
 		}
-		if(!checkMsgID) {	// Update the requestID for the possible ACK being sent
-			Snmpv3Pdu::requestID = msgID->getValueU32() - 1;
+		if(!checkMsgID) {	// Keep the msgID for the possible ACK being sent
+			this->reqID = msgID;
 		}
-#ifdef SNMP_DEBUG
-	msgID->print();
-#endif
 
-		// Skip maxSize and flags
-		BerInteger::decode(ptr, false);
-		*flags = BerOctetString::decode(ptr)->getValue().c_str()[0];
+		// Keep the agent maxSize, to not ask for more than it can send, and get flags
+		u32 msgMaxSize = globalData.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+		this->agentMaxSize = (msgMaxSize < SNMPV3_MIN_MSG_SIZE) ? SNMPV3_MIN_MSG_SIZE : msgMaxSize;
+		BerView flagsField = globalData.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING);
+		*flags = flagsField.getLength() > 0 ? flagsField.getValue()[0] : 0;
 
 		// Check msgSecurityModel
-		std::shared_ptr<BerInteger> msgSecurityModel = BerInteger::decode(ptr, false);
-		if(msgSecurityModel->getValueU32() != SNMPV3_USM_MODEL) {
-			if(*flags &SNMPV3_FLAG_REPORTABLE) {
+		u32 msgSecurityModel = globalData.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+		if(msgSecurityModel != SNMPV3_USM_MODEL) {
+			if((*flags &SNMPV3_FLAG_REPORTABLE) && sock != nullptr) {
 				Snmpv3Pdu::sendReportTo(sock, 0, 0, SNMPV3_SECMODEL_MISMATCH, this->secParams);
 			}
 			throw std::runtime_error("msgSecurityModel does not match");
 		}
-#ifdef SNMP_DEBUG
-	msgSecurityModel->print();
-#endif
 
 		// Get securityParameters
-		u8 *secParamsPtr = *ptr;		// Used if authentication is needed
-		std::shared_ptr<BerOctetString> securityParams = BerOctetString::decode(ptr);
-		secParamsPtr += securityParams->getTagAndLengthSize();	// Beginning of the OCTET STRING data
+		BerReader securityParams(message.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING));
+		BerReader paramsSeq(securityParams.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE));
 
-		// Check securityParameters
-		u8 *paramsPtr = (u8*)securityParams->getValue().c_str();
-		BerSequence::decode(&paramsPtr);
-		
-		// Check engineID
-		std::shared_ptr<BerOctetString> engineID = BerOctetString::decode(&paramsPtr);
-		params.msgAuthoritativeEngineID = engineID->getValue();
-#ifdef SNMP_DEBUG
-	engineID->print();
-#endif
-
-		// Check engineBoots
-		std::shared_ptr<BerInteger> engineBoots = BerInteger::decode(&paramsPtr, false);
-		params.msgAuthoritativeEngineBoots = engineBoots->getValueU32();
-#ifdef SNMP_DEBUG
-	engineBoots->print();
-#endif
-
-		// Check engineTime
-		std::shared_ptr<BerInteger> engineTime = BerInteger::decode(&paramsPtr, false);
-		params.msgAuthoritativeEngineTime = engineTime->getValueU32();
-#ifdef SNMP_DEBUG
-	engineTime->print();
-#endif
-
-		// Check userName
-		std::shared_ptr<BerOctetString> userName = BerOctetString::decode(&paramsPtr);
-		params.msgUserName = userName->getValue();
-#ifdef SNMP_DEBUG
-	userName->print();
-#endif
+		// Check engineID, engineBoots, engineTime and userName
+		params.msgAuthoritativeEngineID = paramsSeq.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING).getString();
+		params.msgAuthoritativeEngineBoots = paramsSeq.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+		params.msgAuthoritativeEngineTime = paramsSeq.next(BER_TAGCLASS_INTEGER | BER_TAG_INTEGER).getValueU32();
+		params.msgUserName = paramsSeq.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING).getString();
 
 		// Check authParams
-		secParamsPtr += (paramsPtr - (u8*)securityParams->getValue().c_str());
-		std::shared_ptr<BerOctetString> authParams = BerOctetString::decode(&paramsPtr);
-		secParamsPtr += authParams->getTagAndLengthSize();
-		if((*flags &SNMPV3_FLAG_AUTH) && authParams->getValue().length() != 12) {
+		BerView authParams = paramsSeq.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING);
+		if((*flags &SNMPV3_FLAG_AUTH) && authParams.getLength() != 12) {
 			throw std::runtime_error("authParam is not 12 octets");
 		}
-		params.msgAuthenticationParameters = authParams->getValue();
-#ifdef SNMP_DEBUG
-	authParams->print();
-#endif
+		params.msgAuthenticationParameters = authParams.getString();
 
 		// If data must be authenticated, fill the authParams in the packet with zeros
 		if(*flags &SNMPV3_FLAG_AUTH) {
-			memset(secParamsPtr, 0, 12);
+			memset((u8*)authParams.getValue(), 0, 12);
 		}
 
 		// Check privParams
-		std::shared_ptr<BerOctetString> privParams = BerOctetString::decode(&paramsPtr);
-		params.msgPrivacyParameters = privParams->getValue();
+		params.msgPrivacyParameters = paramsSeq.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING).getString();
 #ifdef SNMP_DEBUG
-	privParams->print();
+	printf("%s %lu %lu %s\n", params.msgUserName.c_str(), params.msgAuthoritativeEngineBoots, params.msgAuthoritativeEngineTime, params.msgPrivacyParameters.c_str());
 #endif
 
-		// Get the encrypted PDU, if any
+		// Get the encrypted PDU or the scoped PDU
 		if(*flags &SNMPV3_FLAG_PRIV) {
-			return BerOctetString::decode(ptr);
+			return message.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING);
 		}
-
-		// If the PDU was not encrypted...
-		return nullptr;
+		return message.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE);
 	} catch (const std::runtime_error &e) {
 		throw;
 	} catch (const std::bad_alloc &e) {
@@ -242,12 +204,25 @@ std::shared_ptr<BerOctetString> Snmpv3Pdu::checkHeader(u8 **ptr, bool checkMsgID
 	}
 }
 
+/**
+ * @brief Set the authoritative engine parameters used by the next requests
+ * @param engineID		Agent engine ID
+ * @param engineBoots	Agent engineBoots
+ * @param engineTime	Agent engineTime
+ */
+void Snmpv3Pdu::setEngine(const std::string &engineID, u32 engineBoots, u32 engineTime) {
+	this->secParams.msgAuthoritativeEngineID = engineID;
+	this->secParams.msgAuthoritativeEngineBoots = engineBoots;
+	this->secParams.msgAuthoritativeEngineTime = engineTime;
+}
+
 /**
  * @brief Clear a SNMPv3 PDU for further usage
  */
 void Snmpv3Pdu::clear() {
-	BerPdu::clear();		// Varbindlist can't be here
 	this->varBindList.reset();
+	this->varBinds.clear();
+	BerPdu::clear();		// Varbindlist can't be here, drop it first so the arena can be reused
 }
 
 /**
@@ -257,8 +232,9 @@ void Snmpv3Pdu::clear() {
  */
 void Snmpv3Pdu::addVarBind(std::shared_ptr<BerOid> oid, std::shared_ptr<BerField> value) {
 	try {
-		if(this->varBindList == nullptr) this->varBindList = std::make_shared<BerSequence>();
-		Snmpv1Pdu::addVarBind(this->varBindList, oid, value);
+		std::shared_ptr<BerArena> arena = this->getArena();
+		if(this->varBindList == nullptr) this->varBindList = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
+		Snmpv1Pdu::addVarBind(this->varBindList, oid, value, arena);
 	} catch (const std::bad_alloc &e) {
 		throw;
 	}
@@ -269,12 +245,13 @@ void Snmpv3Pdu::addVarBind(std::shared_ptr<BerOid> oid, std::shared_ptr<BerField
  * @param pdu	The corresponding SNMPv2 PDU
  * @return The generated scoped PDU
  */
-std::shared_ptr<BerSequence> Snmpv3Pdu::generateScopedPdu(std::shared_ptr<BerSequence> pdu) {
+std::shared_ptr<BerSequence> Snmpv3Pdu::generateScopedPdu(std::shared_ptr<BerField> pdu) {
 
 	// Generate the scopedPDU
-	std::shared_ptr<BerSequence> msgData = std::make_shared<BerSequence>();
-    std::shared_ptr<BerOctetString> contextNameField = std::make_shared<BerOctetString>(contextName);
-	std::shared_ptr<BerOctetString> contextEngineID = std::make_shared<BerOctetString>(secParams.msgAuthoritativeEngineID);
+	std::shared_ptr<BerArena> arena = this->getArena();
+	std::shared_ptr<BerSequence> msgData = makeBerField<BerSequence>(arena, BER_TAGCLASS_SEQUENCE, BER_TAG_SEQUENCE, arena);
+    std::shared_ptr<BerOctetString> contextNameField = makeBerField<BerOctetString>(arena, contextName);
+	std::shared_ptr<BerOctetString> contextEngineID = makeBerField<BerOctetString>(arena, secParams.msgAuthoritativeEngineID);
     msgData->addChild(contextEngineID);		// = msgAuthoritativeEngineID (?)
     msgData->addChild(contextNameField);
 	msgData->addChild(pdu);
@@ -284,15 +261,15 @@ std::shared_ptr<BerSequence> Snmpv3Pdu::generateScopedPdu(std::shared_ptr<BerSeq
 }
 
 /**
- * @brief Send a SNMPv3 request
+ * @brief Encode a SNMPv3 request without sending it
  * @param type				Type of SNMP request
- * @param sock				Socket used for transmission
- * @param ip				Destination IP. If zero, it uses the last socket's origin IP
- * @param port				Destination port
+ * @param size				Encoded message size (output)
  * @param nonRepeaters		Non-repeaters field for GetBulkRequest
  * @param maxRepetitions	Max-repetitions field for GetBulkRequest
+ * @return The encoded message, inside the send buffer
+ * @note The message fields are kept until clear() is called
  */
-void Snmpv3Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 nonRepeaters, u32 maxRepetitions) {
+u8 *Snmpv3Pdu::encodeRequest(u32 type, u32 *size, u32 nonRepeaters, u32 maxRepetitions) {
 
     try {
 		
@@ -304,6 +281,8 @@ void Snmpv3Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t
         // Generate a get-request
 		std::shared_ptr<Snmpv2Pdu> snmpv2Pdu = std::make_shared<Snmpv2Pdu>("");
 		snmpv2Pdu->varBindList = this->varBindList;
+		snmpv2Pdu->arena = this->getArena();		// Build the request in our own arena
+		snmpv2Pdu->setRequestID(this->fixedReqID);	// With a fixed msgID, the request ID is the same
 		std::shared_ptr<BerSequence> pdu = nullptr;
 		if(type == SNMPV2_GETBULKREQUEST) {
 			pdu = snmpv2Pdu->generateBulkRequest(nonRepeaters, maxRepetitions);
@@ -311,63 +290,132 @@ void Snmpv3Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t
 			pdu = snmpv2Pdu->generateRequest(type);
 		}
 		std::shared_ptr<BerSequence> scopedPdu = this->generateScopedPdu(pdu);
+		return this->encodeMessage(type, scopedPdu, size);
+
+	} catch (const std::bad_alloc &e) {
+		this->fields.clear();
+		throw;
+	} catch (const std::runtime_error &e) {
+		this->fields.clear();
+		throw;
+	}
+}
+
+/**
+ * @brief Encode a SNMPv3 request again, with the current engine parameters
+ * @param pdu	Encoded SNMP PDU of the request, from getRequestPdu()
+ * @param size	Encoded message size (output)
+ * @return The encoded message, inside the send buffer
+ * @note The message fields are kept until clear() is called
+ */
+u8 *Snmpv3Pdu::encodeRequest(const std::string &pdu, u32 *size) {
+
+	try {
+		// The PDU goes as it is, only the scoped PDU and the header change
+		BerReader reader((const u8*)pdu.data(), pdu.size());
+		BerView view = reader.next();
+		std::shared_ptr<BerArena> arena = this->getArena();
+		std::shared_ptr<BerOctetString> rawPdu = makeBerField<BerOctetString>(arena, std::string((const char*)view.getValue(), view.getLength()), view.getTag() &0xE0, view.getTag() &0x1F);
+		std::shared_ptr<BerSequence> scopedPdu = this->generateScopedPdu(rawPdu);
+		return this->encodeMessage(view.getTag() &0x1F, scopedPdu, size);
+
+	} catch (const std::bad_alloc &e) {
+		this->fields.clear();
+		throw;
+	} catch (const std::runtime_error &e) {
+		this->fields.clear();
+		throw;
+	}
+}
 
-		// Serialize the scoped PDU
-		std::shared_ptr<BerPdu> serializerPdu = std::make_shared<BerPdu>();
-		u32 serializedPduSize;
-		serializerPdu->addField(scopedPdu);
-        std::unique_ptr<u8> serializedPdu = serializerPdu->serialize(&serializedPduSize, 8);	// Because of CBC-DES alignment
+/**
+ * @brief Encrypt, authenticate and encode a scoped PDU
+ * @param type			Type of SNMP PDU
+ * @param scopedPdu		Scoped PDU
+ * @param size			Encoded message size (output)
+ * @return The encoded message, inside the send buffer
+ * @note The message is written once, backwards. The HMAC is then computed over it and put in its place.
+ */
+u8 *Snmpv3Pdu::encodeMessage(u32 type, std::shared_ptr<BerSequence> scopedPdu, u32 *size) {
 
+	try {
 		// Get the authentication and privacy protocols
 		Snmpv3UserStore &userStore = Snmpv3UserStore::getInstance();
-		Snmpv3UserStoreEntry &user = userStore.getUser(secParams.msgUserName);
+		Snmpv3UserStoreEntry user = userStore.getUser(secParams.msgUserName);
 		std::shared_ptr<Snmpv3PrivProto> privProto = nullptr;
 		std::shared_ptr<Snmpv3AuthProto> authProto = nullptr;
 		if(type != SNMPV2_REPORT) {		// Reports are not secured
-			privProto = userStore.getPrivProto(user);
 			authProto = userStore.getAuthProto(user);
+			if(authProto != nullptr) privProto = userStore.getPrivProto(user);
 		}
-
-		// Encrypt the PDU, if needed
-		std::shared_ptr<BerOctetString> encryptedPdu = nullptr;
-		if(authProto != nullptr && privProto != nullptr) {
-			std::shared_ptr<u8> userCryptKey = authProto->passwordToKey(user.privPass, this->secParams);
-			encryptedPdu = privProto->encrypt(serializedPdu.get(), serializedPduSize, this->secParams, userCryptKey);
-		}
-
-		// Generate a header
-		std::shared_ptr<BerSequence> message = nullptr;
-		if(authProto != nullptr) {
-			// Initialize the authentication parameter
-			this->secParams.msgAuthenticationParameters = std::string(12, '\0');
-		}
+		u8 flags = SNMPV3_FLAG_REPORTABLE;
+		if(authProto != nullptr) flags |= SNMPV3_FLAG_AUTH;
+		if(privProto != nullptr) flags |= SNMPV3_FLAG_PRIV;
+
+		// Write the scoped PDU at the end of the send buffer, leaving room for the CBC-DES padding
+		u8 *buffer = this->getSendBuffer();
+		BerWriter writer(buffer, BERPDU_MAX_SIZE - 8);
+		scopedPdu->encode(writer);
+
+		// Keep the SNMP PDU, to send the request again if the agent engine parameters change
+		BerReader scopedReader(writer.getData(), writer.getSize());
+		BerReader scopedFields(scopedReader.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE));
+		scopedFields.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING);
+		scopedFields.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING);
+		BerView requestPdu = scopedFields.next();
+		this->requestPdu.assign((const char*)requestPdu.getData(), requestPdu.getTotalSize());
+
+		// Encrypt the PDU in place, padded with zeros, and make it an OCTET STRING
+		BerWriter msgWriter = writer;
 		if(privProto != nullptr) {
-			message = this->generateHeader(type, true, encryptedPdu);
-		} else {
-			message = this->generateHeader(type, true, scopedPdu);
+			u8 *pdu = writer.getData();
+			u32 paddedSize = (writer.getSize() + 7) &~7;
+			memset(buffer + BERPDU_MAX_SIZE - 8, 0, 8);
+			std::shared_ptr<u8> userCryptKey = userStore.getPrivKey(this->secParams.msgUserName, this->secParams.msgAuthoritativeEngineID);
+			privProto->encrypt(pdu, paddedSize, this->secParams, userCryptKey);
+			msgWriter = BerWriter(buffer, (pdu - buffer) + paddedSize);
+			msgWriter.skip(paddedSize);
+			msgWriter.writeLength(paddedSize);
+			msgWriter.writeTag(BER_TAGCLASS_OCTETSTRING, BER_TAG_OCTETSTRING);
 		}
 
-		// Authenticate the whole message
+		// Write the header in front of it
+		u8 *authParams;
+		this->writeHeader(msgWriter, flags, &authParams);
+
+		// Authenticate the whole message, in place
 		if(authProto != nullptr) {
-			serializerPdu->clear();
-			serializerPdu->addField(message);
-        	serializedPdu = serializerPdu->serialize(&serializedPduSize);
-			std::shared_ptr<u8> userAuthKey = authProto->passwordToKey(user.authPass, this->secParams);
-			authProto->createHash(serializedPdu.get(), serializedPduSize, this->secParams, userAuthKey);
-
-			// Regenerate the header
-			Snmpv3Pdu::requestID --;
-			if(privProto != nullptr) {
-				message = this->generateHeader(type, true, encryptedPdu);
-			} else {
-				message = this->generateHeader(type, true, scopedPdu);
-			}
+			std::shared_ptr<Snmpv3AuthContext> authContext = userStore.getAuthContext(this->secParams.msgUserName, this->secParams.msgAuthoritativeEngineID);
+			authProto->createHash(msgWriter.getData(), msgWriter.getSize(), authParams, *authContext);
 		}
 
-		// Send the PDU
-		this->fields.push_back(message);
-		BerPdu::send(sock, ip, port);
+		*size = msgWriter.getSize();
+		return msgWriter.getData();
+
+	} catch (const std::bad_alloc &e) {
+		this->fields.clear();
+		throw;
+	} catch (const std::runtime_error &e) {
+		this->fields.clear();
+		throw;
+	}
+}
+
+/**
+ * @brief Send a SNMPv3 request
+ * @param type				Type of SNMP request
+ * @param sock				Socket used for transmission
+ * @param ip				Destination IP. If zero, it uses the last socket's origin IP
+ * @param port				Destination port
+ * @param nonRepeaters		Non-repeaters field for GetBulkRequest
+ * @param maxRepetitions	Max-repetitions field for GetBulkRequest
+ */
+void Snmpv3Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 nonRepeaters, u32 maxRepetitions) {
 
+	try {
+		u32 size;
+		u8 *data = this->encodeRequest(type, &size, nonRepeaters, maxRepetitions);
+		sock->sendPacket(data, size, ip, port);
 	} catch (const std::bad_alloc &e) {
 		this->fields.clear();
 		throw;
@@ -377,8 +425,7 @@ void Snmpv3Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t
 	}
 
 	// Clear data
-	this->fields.clear();
-	this->varBindList.reset();
+	this->clear();
 }
 
 /**
@@ -388,22 +435,51 @@ void Snmpv3Pdu::sendRequest(u32 type, std::shared_ptr<UdpSocket> sock, in_addr_t
  * @param port				Expected source port
  * @param expectedPduType	Expected PDU type
  * @return The received PDU type
+ * @note The received VarBinds are valid until the next reception
  */
 u8 Snmpv3Pdu::recvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 port, u32 expectedPduType) {
     
     try {
-		// Create recv buffer
-		std::unique_ptr<u8> data(new u8[SNMP_MAX_PDU_SIZE]);
+		// Create recv buffer, only once
+		if(this->recvBuffer == nullptr) {
+			this->recvBuffer = std::unique_ptr<u8[]>(new u8[SNMP_MAX_PDU_SIZE]);
+		}
+		u8 *data = this->recvBuffer.get();
 
 		// Receive packet data
-		u32 packetSize = sock->recvPacket(data.get(), SNMP_MAX_PDU_SIZE, ip, port);
-		u8 *ptr = data.get();
+		u32 packetSize = sock->recvPacket(data, SNMP_MAX_PDU_SIZE, ip, port);
+		return this->parseResponse(data, packetSize, port != 0, expectedPduType, sock);
+	} catch (const std::runtime_error &e) {
+		throw;
+	} catch (const std::bad_alloc &e) {
+		throw;
+	}
+}
+
+/**
+ * @brief Decode a SNMPv3 message already in memory
+ * @param data				Message data. If it is authenticated its authParams are zeroed, and if it is encrypted it is decrypted, in place
+ * @param size				Message size
+ * @param checkMsgID		Check the msgID against the last request?
+ * @param expectedPduType	Expected PDU type
+ * @param sock				Socket used to send reports back, or nullptr to not send them
+ * @return The received PDU type
+ * @note The received VarBinds point into data and are valid while it is alive
+ */
+u8 Snmpv3Pdu::parseResponse(u8 *data, u32 size, bool checkMsgID, u32 expectedPduType, std::shared_ptr<UdpSocket> sock) {
+
+    this->pduResult = {SNMP_OK, 0, SNMPV1_ERROR_NOERROR, 0};
+	this->engineSynced = false;
+
+    try {
+		BerReader reader(data, size);
+		BerReader message(reader.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE));
 
 		// Read response header
 		Snmpv3SecurityParams params;
 		u8 flags;
-		std::shared_ptr<BerOctetString> encryptedPdu = this->checkHeader(&ptr, port != 0, params, sock, &flags);
-		bool reportable = flags &SNMPV3_FLAG_REPORTABLE;
+		BerView msgData = this->checkHeader(message, checkMsgID, params, sock, &flags);
+		bool reportable = (flags &SNMPV3_FLAG_REPORTABLE) && sock != nullptr;
 
 		// Send report if username does not match
 		Snmpv3UserStore &userStore = Snmpv3UserStore::getInstance();
@@ -422,12 +498,12 @@ u8 Snmpv3Pdu::recvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 po
 		std::shared_ptr<Snmpv3AuthProto> authProto = userStore.getAuthProto(user);
 
 		// Authenticate the PDU
-		std::unique_ptr<u8> decryptedPdu = nullptr;
+		BerView scopedPdu = msgData;
 		if(flags &SNMPV3_FLAG_AUTH && authProto != nullptr) {
 
 			// Check the authentication status
-			std::shared_ptr<u8> userAuthKey = authProto->passwordToKey(user.authPass, params);
-			bool authResult = authProto->authenticate(data.get(), packetSize, params, userAuthKey);
+			std::shared_ptr<Snmpv3AuthContext> authContext = userStore.getAuthContext(params.msgUserName, params.msgAuthoritativeEngineID);
+			bool authResult = authProto->authenticate(data, size, params, *authContext);
 			if(!authResult) {
 				if(reportable) {
 					Snmpv3Pdu::sendReportTo(sock, 0, 0, SNMPV3_AUTH_WRONG, secParams);
@@ -438,36 +514,38 @@ u8 Snmpv3Pdu::recvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 po
 			// Decrypt the PDU
 			if(flags &SNMPV3_FLAG_PRIV && privProto != nullptr) {
 				try {
-					std::shared_ptr<u8> userPrivKey = authProto->passwordToKey(user.privPass, params);
-					decryptedPdu = privProto->decrypt(encryptedPdu, params, userPrivKey);
+					std::shared_ptr<u8> userPrivKey = userStore.getPrivKey(params.msgUserName, params.msgAuthoritativeEngineID);
+					privProto->decrypt((u8*)msgData.getValue(), msgData.getLength(), params, userPrivKey);
 				} catch (const std::runtime_error &e) {
 					if(reportable) {
 						Snmpv3Pdu::sendReportTo(sock, 0, 0, SNMPV3_PRIV_WRONG, secParams);
 					}
 					throw;
 				}
-				ptr = decryptedPdu.get();	// Update the read pointer to the decrypted PDU
+				BerReader decrypted(msgData.getValue(), msgData.getLength());
+				scopedPdu = decrypted.next(BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE);
 			}
 		}
 
-		// Skip msgData sequence
-		BerSequence::decode(&ptr);
+		// An encrypted PDU we could not decrypt can't be read
+		if(scopedPdu.getTag() != (BER_TAGCLASS_SEQUENCE | BER_TAG_SEQUENCE)) {
+			throw std::runtime_error("Unexpected BER tag");
+		}
+		BerReader msgDataReader(scopedPdu);
 
 		// Skip contextEngineID
-		BerOctetString::decode(&ptr);
+		msgDataReader.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING);
 
 		// Check contextName
-		std::shared_ptr<BerOctetString> contextNameStr = BerOctetString::decode(&ptr);
-		if(contextNameStr->getValue().compare(contextName) != 0) {
+		if(!msgDataReader.next(BER_TAGCLASS_OCTETSTRING | BER_TAG_OCTETSTRING).equals(contextName)) {
 			throw std::runtime_error("contextName does not match");
 		}
-#ifdef SNMP_DEBUG
-	contextNameStr->print();
-#endif
 
 		// Decode SNMP PDU
 		u8 pduType;
-		std::shared_ptr<BerSequence> vbList = Snmpv2Pdu::recvResponse(&ptr, port != 0, this->reqID, &pduType, SNMP_PDU_ANY);
+		u32 pduReqID = this->reqID;
+		this->pduResult = Snmpv2Pdu::decodeResponse(msgDataReader, scopedPdu.getData(), checkMsgID, &pduReqID, &pduType, SNMP_PDU_ANY, this->varBinds);
+		Snmpv2Pdu::checkResult(this->pduResult);
 		if(pduType != SNMPV2_REPORT) {
 			if(pduType != expectedPduType && expectedPduType != SNMP_PDU_ANY) {
 				throw std::runtime_error("Received undesired PDU");
@@ -480,14 +558,24 @@ u8 Snmpv3Pdu::recvResponse(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16 po
 					}
 					throw std::runtime_error("EngineID does not match");
 				}
-				this->varBindList = vbList;
+
+				// Follow the agent clock, with the authenticated messages only (RFC 3414 3.2.7)
+				if(flags &SNMPV3_FLAG_AUTH && authProto != nullptr &&
+					(params.msgAuthoritativeEngineBoots > secParams.msgAuthoritativeEngineBoots ||
+					(params.msgAuthoritativeEngineBoots == secParams.msgAuthoritativeEngineBoots &&
+					params.msgAuthoritativeEngineTime > secParams.msgAuthoritativeEngineTime))) {
+					secParams.msgAuthoritativeEngineBoots = params.msgAuthoritativeEngineBoots;
+					secParams.msgAuthoritativeEngineTime = params.msgAuthoritativeEngineTime;
+					this->engineSynced = true;
+				}
 			}
 		} else {
 			// Learn from the report
 			secParams.msgAuthoritativeEngineID = params.msgAuthoritativeEngineID;
 			secParams.msgAuthoritativeEngineBoots = params.msgAuthoritativeEngineBoots;
 			secParams.msgAuthoritativeEngineTime = params.msgAuthoritativeEngineTime;
-			std::string oid = std::static_pointer_cast<BerOid>(std::static_pointer_cast<BerSequence>(vbList->getChild(0))->getChild(0))->print();
+			std::string oid = this->varBinds.empty() ? "" : this->varBinds[0].oid.print();
+			this->engineSynced = oid == SNMPV3_ENGINEID_MISMATCH || oid == SNMPV3_NOT_IN_TIME_WINDOW;
 			throw std::runtime_error("REPORT received: " + oid);
 		}
 
@@ -519,7 +607,7 @@ bool Snmpv3Pdu::recvTrap(std::shared_ptr<UdpSocket> sock) {
 
         // If it was an inform-request, send back the acknowledgement
         if(pduType == SNMPV2_INFORMREQUEST) {
-            this->sendRequest(SNMPV2_GETRESPONSE, sock, 0, 0);    // Use inform-request origin IP-port as destination IP-port
+            this->sendInformAck(sock);
             return true;
         }
 
@@ -532,6 +620,38 @@ bool Snmpv3Pdu::recvTrap(std::shared_ptr<UdpSocket> sock) {
 	}
 }
 
+/**
+ * @brief Acknowledge the received inform-request, keeping its VarBinds for the caller
+ * @param sock Socket the inform-request was received from
+ * @note sendRequest() is not used, as it would clear() the received PDU
+ */
+void Snmpv3Pdu::sendInformAck(std::shared_ptr<UdpSocket> sock) {
+
+	u32 fixedReqID = this->fixedReqID;
+	try {
+		u32 size;
+		this->varBindList = Snmpv2Pdu::buildVarBindList(this->varBinds, this->getArena());
+		this->setRequestID(this->reqID);							// Answer with the inform-request msgID
+		u8 *data = this->encodeRequest(SNMPV2_GETRESPONSE, &size, 0, 0);
+		sock->sendPacket(data, size, 0, 0);							// Use inform-request origin IP-port as destination IP-port
+	} catch (const std::bad_alloc &e) {
+		this->fixedReqID = fixedReqID;
+		this->fields.clear();
+		this->varBindList.reset();
+		throw;
+	} catch (const std::runtime_error &e) {
+		this->fixedReqID = fixedReqID;
+		this->fields.clear();
+		this->varBindList.reset();
+		throw;
+	}
+
+	// Drop the encoded response only
+	this->fixedReqID = fixedReqID;
+	this->fields.clear();
+	this->varBindList.reset();
+}
+
 /**
  * @brief Wrapper to send a bulk-request
  * @param nonRepeaters		Non-repeaters field
@@ -544,32 +664,6 @@ void Snmpv3Pdu::sendBulkRequest(u32 nonRepeaters, u32 maxRepetitions, std::share
 	this->sendRequest(SNMPV2_GETBULKREQUEST, sock, ip, port, nonRepeaters, maxRepetitions);
 }
 
-/**
- * @brief Get a VarBind from a SNMPv3 PDU
- * @param i		VarBind index
- * @return The desired VarBind
- */
-std::shared_ptr<BerField> Snmpv3Pdu::getVarBind(u16 i) {
-    try {
-		return std::static_pointer_cast<BerSequence>(this->varBindList->getChild(i))->getChild(1);
-	} catch (const std::out_of_range &e){
-		throw;
-	}
-}
-
-/**
- * @brief Get a VarBind OID from the PDU
- * @param i VarBind index
- * @return Desired VarBind OID
- */
-std::shared_ptr<BerOid> Snmpv3Pdu::getVarBindOid(u16 i) {
-    try {
-		return std::static_pointer_cast<BerOid>(std::static_pointer_cast<BerSequence>(this->varBindList->getChild(i))->getChild(0));
-	} catch (const std::out_of_range &e){
-		throw;
-	}
-}
-
 /**
  * @brief Destructor for a SNMPv3 PDU
  */
@@ -598,6 +692,16 @@ void Snmpv3Pdu::sendReportTo(std::shared_ptr<UdpSocket> sock, in_addr_t ip, u16
 	}
 }
 
+/**
+ * @brief Get the identity of the received notification
+ * @param trapOid		snmpTrapOID.0 value (output)
+ * @param enterprise	Enterprise of the notification (output)
+ * @return false if it has no snmpTrapOID.0
+ */
+bool Snmpv3Pdu::getTrapOid(CompactOid &trapOid, CompactOid &enterprise) {
+    return Snmpv2Pdu::findTrapOid(this->varBinds, trapOid, enterprise);
+}
+
 /**
  * @brief Serialize a SNMPv3 trap into a JSON
  * @return The serialized trap
@@ -609,12 +713,9 @@ std::shared_ptr<json_t> Snmpv3Pdu::serializeTrap() {
     json_t *data = json_array();
     json_object_set_new(root.get(), "data", data);
 
-    if(varBindList != nullptr) {
-        for(u32 i = 0; i < varBindList->getNChildren(); i++) {
-            auto child = std::static_pointer_cast<BerSequence>(this->varBindList->getChild(i));
-            Utils::addJsonField(data, "OID: " + child->getChild(0)->print());
-            Utils::addJsonField(data, "Value: " + child->getChild(1)->print());
-        }
+    for(u32 i = 0; i < varBinds.size(); i++) {
+        Utils::addJsonField(data, "OID: " + varBinds[i].oid.print());
+        Utils::addJsonField(data, "Value: " + varBinds[i].value.print());
     }
 
     return root;
@@ -57,6 +57,7 @@ u32 Snmpv3UserStore::getPrivProtoID(const std::string &text) {
  */
 Snmpv3UserStore::Snmpv3UserStore() {
     this->userTable = std::unordered_map<std::string, Snmpv3UserStoreEntry>();
+    LightLock_Init(&this->keyCacheLock);
     load();
 }
 
@@ -89,7 +90,18 @@ void Snmpv3UserStore::load() {
 
         std::istringstream iss(line);
         if (iss >> name >> entry.authProto >> entry.authPass >> entry.privProto >> entry.privPass) {
-            this->userTable[name] = entry;
+            LightLock_Lock(&this->keyCacheLock);
+            try {
+                this->userTable[name] = entry;
+                this->deriveMasterKeys(name, entry);
+            } catch (const std::runtime_error &e) {
+                LightLock_Unlock(&this->keyCacheLock);
+                throw;
+            } catch (const std::bad_alloc &e) {
+                LightLock_Unlock(&this->keyCacheLock);
+                throw;
+            }
+            LightLock_Unlock(&this->keyCacheLock);
         }
     }
 
@@ -104,13 +116,18 @@ void Snmpv3UserStore::load() {
  */
 void Snmpv3UserStore::addUser(const std::string &name, const Snmpv3UserStoreEntry &entry) {
 
+    LightLock_Lock(&this->keyCacheLock);
     try {
         this->userTable[name] = entry;
+        this->deriveMasterKeys(name, entry);
     } catch (const std::runtime_error &e) {
+        LightLock_Unlock(&this->keyCacheLock);
         throw;
     } catch (const std::bad_alloc &e) {
+        LightLock_Unlock(&this->keyCacheLock);
         throw;
     }
+    LightLock_Unlock(&this->keyCacheLock);
 }
 
 /**
@@ -118,25 +135,72 @@ void Snmpv3UserStore::addUser(const std::string &name, const Snmpv3UserStoreEntr
  * @param name  User name
  */
 void Snmpv3UserStore::removeUser(const std::string &name) {
+    LightLock_Lock(&this->keyCacheLock);
     this->userTable.erase(name);
+    this->keyCache.erase(name);
+    LightLock_Unlock(&this->keyCacheLock);
 }
 
 /**
- * @brief Get an user from the user store
+ * @brief Drop every derived key, so that they are derived again when used
+ */
+void Snmpv3UserStore::clearKeyCache() {
+    LightLock_Lock(&this->keyCacheLock);
+    this->keyCache.clear();
+    LightLock_Unlock(&this->keyCacheLock);
+}
+
+/**
+ * @brief Find an user in the user store, with the user table already locked
  * @param name  User name
  * @return The user entry
  */
-Snmpv3UserStoreEntry &Snmpv3UserStore::getUser(const std::string &name) {
+Snmpv3UserStoreEntry &Snmpv3UserStore::findUser(const std::string &name) {
+
+    auto it = this->userTable.find(name);
+    if(it == this->userTable.end()) {
+        throw std::runtime_error("User " + name + " not found");
+    }
+
+    return it->second;
+}
 
+/**
+ * @brief Get an user from the user store
+ * @param name  User name
+ * @return A copy of the user entry
+ */
+Snmpv3UserStoreEntry Snmpv3UserStore::getUser(const std::string &name) {
+
+    LightLock_Lock(&this->keyCacheLock);
     try {
-        if(this->userTable.find(name) == this->userTable.end()) {
-            throw std::runtime_error("User " + name + " not found");
-        }
-    } catch(const std::runtime_error &e) {
+        Snmpv3UserStoreEntry user = this->findUser(name);
+        LightLock_Unlock(&this->keyCacheLock);
+        return user;
+    } catch (const std::runtime_error &e) {
+        LightLock_Unlock(&this->keyCacheLock);
+        throw;
+    } catch (const std::bad_alloc &e) {
+        LightLock_Unlock(&this->keyCacheLock);
         throw;
     }
+}
 
-    return this->userTable[name];
+/**
+ * @brief Get every user of the user store
+ * @return A copy of the user table, by user name
+ */
+std::unordered_map<std::string, Snmpv3UserStoreEntry> Snmpv3UserStore::getUserTable() {
+
+    LightLock_Lock(&this->keyCacheLock);
+    try {
+        std::unordered_map<std::string, Snmpv3UserStoreEntry> users = this->userTable;
+        LightLock_Unlock(&this->keyCacheLock);
+        return users;
+    } catch (const std::bad_alloc &e) {
+        LightLock_Unlock(&this->keyCacheLock);
+        throw;
+    }
 }
 
 /**
@@ -151,7 +215,8 @@ void Snmpv3UserStore::save() {
     }
 
     // Write the user store
-    for(std::pair<std::string, Snmpv3UserStoreEntry> user : userTable) {
+    std::unordered_map<std::string, Snmpv3UserStoreEntry> users = this->getUserTable();
+    for(std::pair<std::string, Snmpv3UserStoreEntry> user : users) {
         Snmpv3UserStoreEntry &entry = user.second;
         fprintf(f, "%s %ld %s %ld %s\n", user.first.c_str(), entry.authProto, entry.authPass.c_str(), entry.privProto, entry.privPass.c_str());
     }
@@ -195,6 +260,143 @@ std::shared_ptr<Snmpv3PrivProto> Snmpv3UserStore::getPrivProto(const Snmpv3UserS
     return nullptr;
 }
 
+/**
+ * @brief Derive the master keys of an user, dropping its previous keys, with the key cache already locked
+ * @param name  User name
+ * @param user  User parameters
+ * @return The key cache entry of the user
+ */
+Snmpv3KeyCacheEntry &Snmpv3UserStore::deriveMasterKeys(const std::string &name, const Snmpv3UserStoreEntry &user) {
+
+    try {
+        Snmpv3KeyCacheEntry &entry = this->keyCache[name];
+        entry.authProto = user.authProto;
+        entry.privProto = user.privProto;
+        entry.authPass = user.authPass;
+        entry.privPass = user.privPass;
+        entry.authMasterKey = nullptr;
+        entry.privMasterKey = nullptr;
+        entry.localizedKeys.clear();
+
+        // The privacy key is derived with the authentication protocol too (RFC 3414, section 8.1.1.1)
+        std::shared_ptr<Snmpv3AuthProto> authProto = this->getAuthProto(user);
+        if(authProto != nullptr) {
+            if(!user.authPass.empty()) {
+                entry.authMasterKey = authProto->passwordToMasterKey(user.authPass);
+            }
+            if(user.privProto != SNMPV3_PRIVPROTO_NONE && !user.privPass.empty()) {
+                entry.privMasterKey = authProto->passwordToMasterKey(user.privPass);
+            }
+        }
+
+        return entry;
+    } catch (const std::runtime_error &e) {
+        this->keyCache.erase(name);
+        throw;
+    } catch (const std::bad_alloc &e) {
+        this->keyCache.erase(name);
+        throw;
+    }
+}
+
+/**
+ * @brief Get the keys of an user for an engine, deriving them if needed
+ * @param name      User name
+ * @param engineID  Authoritative engine ID
+ * @return A copy of the localized keys, which stays valid after the cache changes
+ */
+Snmpv3LocalizedKeys Snmpv3UserStore::getLocalizedKeys(const std::string &name, const std::string &engineID) {
+
+    LightLock_Lock(&this->keyCacheLock);
+    try {
+        Snmpv3UserStoreEntry &user = this->findUser(name);
+
+        // The keys are checked against the user entry, in case it changed since they were derived
+        auto it = this->keyCache.find(name);
+        Snmpv3KeyCacheEntry *entry;
+        if(it == this->keyCache.end() || it->second.authProto != user.authProto || it->second.privProto != user.privProto ||
+           it->second.authPass != user.authPass || it->second.privPass != user.privPass) {
+            entry = &this->deriveMasterKeys(name, user);
+        } else {
+            entry = &it->second;
+        }
+
+        Snmpv3LocalizedKeys localized;
+        auto keys = entry->localizedKeys.find(engineID);
+        if(keys != entry->localizedKeys.end()) {
+            localized = keys->second;
+            LightLock_Unlock(&this->keyCacheLock);
+            return localized;
+        }
+
+        if(entry->localizedKeys.size() >= SNMPV3_KEYCACHE_ENGINES) {
+            entry->localizedKeys.clear();
+        }
+
+        std::shared_ptr<Snmpv3AuthProto> authProto = this->getAuthProto(user);
+        if(authProto != nullptr && entry->authMasterKey != nullptr) {
+            localized.authKey = authProto->localizeKey(entry->authMasterKey, engineID);
+            localized.authContext = std::make_shared<Snmpv3AuthContext>();
+            authProto->initContext(localized.authKey.get(), *localized.authContext);
+        }
+        if(authProto != nullptr && entry->privMasterKey != nullptr) {
+            localized.privKey = authProto->localizeKey(entry->privMasterKey, engineID);
+        }
+
+        entry->localizedKeys[engineID] = localized;
+        LightLock_Unlock(&this->keyCacheLock);
+        return localized;
+    } catch (const std::runtime_error &e) {
+        LightLock_Unlock(&this->keyCacheLock);
+        throw;
+    } catch (const std::bad_alloc &e) {
+        LightLock_Unlock(&this->keyCacheLock);
+        throw;
+    }
+}
+
+/**
+ * @brief Get the authentication key of an user for an engine
+ * @param name      User name
+ * @param engineID  Authoritative engine ID
+ * @return The localized key
+ */
+std::shared_ptr<u8> Snmpv3UserStore::getAuthKey(const std::string &name, const std::string &engineID) {
+    std::shared_ptr<u8> key = this->getLocalizedKeys(name, engineID).authKey;
+    if(key == nullptr) {
+        throw std::runtime_error("User " + name + " has no authentication password");
+    }
+    return key;
+}
+
+/**
+ * @brief Get the privacy key of an user for an engine
+ * @param name      User name
+ * @param engineID  Authoritative engine ID
+ * @return The localized key
+ */
+std::shared_ptr<u8> Snmpv3UserStore::getPrivKey(const std::string &name, const std::string &engineID) {
+    std::shared_ptr<u8> key = this->getLocalizedKeys(name, engineID).privKey;
+    if(key == nullptr) {
+        throw std::runtime_error("User " + name + " has no privacy password");
+    }
+    return key;
+}
+
+/**
+ * @brief Get the HMAC context of the authentication key of an user for an engine
+ * @param name      User name
+ * @param engineID  Authoritative engine ID
+ * @return The HMAC context
+ */
+std::shared_ptr<Snmpv3AuthContext> Snmpv3UserStore::getAuthContext(const std::string &name, const std::string &engineID) {
+    std::shared_ptr<Snmpv3AuthContext> context = this->getLocalizedKeys(name, engineID).authContext;
+    if(context == nullptr) {
+        throw std::runtime_error("User " + name + " has no authentication password");
+    }
+    return context;
+}
+
 /**
  * @brief Get the authentication protocol string
  * @param id The protocol ID
@@ -0,0 +1,182 @@
+/**
+ * @file TimingWheel.cpp
+ * @brief Hierarchical timing wheel
+ */
+
+// Own includes
+#include "snmp/TimingWheel.h"
+
+namespace NetMan {
+
+/**
+ * @brief Constructor for a TimingWheel
+ * @param tickMs	Timer resolution, in ms
+ * @param now		Current time, in ms
+ */
+TimingWheel::TimingWheel(u32 tickMs, u64 now) {
+	this->tick = 0;
+	this->tickTime = now;
+	this->tickMs = (tickMs != 0) ? tickMs : 1;
+	this->nTimers = 0;
+	for(u32 i = 0; i < TIMINGWHEEL_LEVELS; i++) {
+		for(u32 j = 0; j < TIMINGWHEEL_SLOTS; j++) {
+			this->slots[i][j].prev = &this->slots[i][j];
+			this->slots[i][j].next = &this->slots[i][j];
+		}
+	}
+}
+
+/**
+ * @brief Initialize a timer, before its first use
+ * @param timer		Timer to initialize
+ * @param callback	Called when the timer expires
+ * @param args		Callback arguments
+ */
+void TimingWheel::initTimer(TimingWheelTimer *timer, TimingWheelCallback callback, void *args) {
+	timer->prev = NULL;
+	timer->next = NULL;
+	timer->expires = 0;
+	timer->callback = callback;
+	timer->args = args;
+}
+
+/**
+ * @brief Put a timer in the slot of its expiration tick
+ * @param timer Timer to link
+ */
+void TimingWheel::link(TimingWheelTimer *timer) {
+
+	u64 delta = timer->expires - this->tick;
+	u32 level = 0;
+	while(level < TIMINGWHEEL_LEVELS - 1 && delta >= (1ULL << ((level + 1) * TIMINGWHEEL_SLOT_BITS))) {
+		level++;
+	}
+
+	TimingWheelTimer *head = &this->slots[level][(timer->expires >> (level * TIMINGWHEEL_SLOT_BITS)) & TIMINGWHEEL_SLOT_MASK];
+	timer->prev = head->prev;
+	timer->next = head;
+	head->prev->next = timer;
+	head->prev = timer;
+}
+
+/**
+ * @brief Take a timer out of its list
+ * @param timer Timer to unlink
+ */
+void TimingWheel::unlink(TimingWheelTimer *timer) {
+	timer->prev->next = timer->next;
+	timer->next->prev = timer->prev;
+	timer->prev = NULL;
+	timer->next = NULL;
+}
+
+/**
+ * @brief Move every timer of a list to another, empty one
+ * @param from	Head of the list to empty
+ * @param to	Head of the destination list
+ */
+void TimingWheel::moveList(TimingWheelTimer *from, TimingWheelTimer *to) {
+	if(from->next == from) {
+		to->prev = to;
+		to->next = to;
+		return;
+	}
+	to->next = from->next;
+	to->prev = from->prev;
+	to->next->prev = to;
+	to->prev->next = to;
+	from->prev = from;
+	from->next = from;
+}
+
+/**
+ * @brief Schedule a timer, rescheduling it if it was already scheduled
+ * @param timer		Initialized timer
+ * @param delayMs	Time until it expires, in ms. It is rounded up to the next tick, and limited to TIMINGWHEEL_MAX_TICKS.
+ */
+void TimingWheel::schedule(TimingWheelTimer *timer, u64 delayMs) {
+
+	if(timer->next != NULL) {
+		this->cancel(timer);
+	}
+
+	u64 ticks = (delayMs + this->tickMs - 1) / this->tickMs;
+	if(ticks == 0) ticks = 1;
+	if(ticks > TIMINGWHEEL_MAX_TICKS) ticks = TIMINGWHEEL_MAX_TICKS;
+
+	timer->expires = this->tick + ticks;
+	this->link(timer);
+	this->nTimers++;
+}
+
+/**
+ * @brief Cancel a timer
+ * @param timer Timer to cancel. Nothing is done if it is not scheduled.
+ */
+void TimingWheel::cancel(TimingWheelTimer *timer) {
+	if(timer->next == NULL) return;
+	TimingWheel::unlink(timer);
+	this->nTimers--;
+}
+
+/**
+ * @brief Move the timers of the current slot of a wheel down to the finer wheels
+ * @param level Wheel to cascade
+ */
+void TimingWheel::cascade(u32 level) {
+
+	TimingWheelTimer list;
+	TimingWheel::moveList(&this->slots[level][(this->tick >> (level * TIMINGWHEEL_SLOT_BITS)) & TIMINGWHEEL_SLOT_MASK], &list);
+
+	while(list.next != &list) {
+		TimingWheelTimer *timer = list.next;
+		TimingWheel::unlink(timer);
+		this->link(timer);
+	}
+}
+
+/**
+ * @brief Advance one tick, firing its timers
+ * @return Number of fired timers
+ */
+u32 TimingWheel::step() {
+
+	this->tick++;
+	this->tickTime += this->tickMs;
+
+	// Each time a wheel turns around, the next slot of the coarser wheel comes down
+	for(u32 level = 1; level < TIMINGWHEEL_LEVELS; level++) {
+		if(((this->tick >> ((level - 1) * TIMINGWHEEL_SLOT_BITS)) & TIMINGWHEEL_SLOT_MASK) != 0) break;
+		this->cascade(level);
+	}
+
+	// The callbacks may schedule or cancel any timer, including the ones about to fire
+	TimingWheelTimer list;
+	TimingWheel::moveList(&this->slots[0][this->tick & TIMINGWHEEL_SLOT_MASK], &list);
+
+	u32 fired = 0;
+	while(list.next != &list) {
+		TimingWheelTimer *timer = list.next;
+		TimingWheel::unlink(timer);
+		this->nTimers--;
+		fired++;
+		timer->callback(timer->args);
+	}
+
+	return fired;
+}
+
+/**
+ * @brief Fire every timer expired up to some time
+ * @param now Current time, in ms
+ * @return Number of fired timers
+ */
+u32 TimingWheel::advance(u64 now) {
+	u32 fired = 0;
+	while(this->tickTime + this->tickMs <= now) {
+		fired += this->step();
+	}
+	return fired;
+}
+
+}
@@ -66,6 +66,31 @@ void UdpSocket::sendPacket(void *data, u32 size, in_addr_t ip, u16 port) {
  */
 u32 UdpSocket::recvPacket(void *data, u32 size, in_addr_t ip, u16 port) {
 
+	s32 recvSize = this->tryRecvPacket(data, size, ip, port);
+	switch(recvSize) {
+		case UDPSOCKET_ERROR_TIMEOUT:
+			throw std::runtime_error("Socket timeout");
+		case UDPSOCKET_ERROR_RECV:
+			throw std::runtime_error("recvfrom() failed");
+		case UDPSOCKET_ERROR_SOURCE_IP:
+			throw std::runtime_error("Source IP does not match");
+		case UDPSOCKET_ERROR_SOURCE_PORT:
+			throw std::runtime_error("Source port does not match");
+	}
+
+	return recvSize;
+}
+
+/**
+ * @brief Receive a UDP datagram, without throwing
+ * @param data Data to be received
+ * @param size Size of the incoming data
+ * @param ip IPv4 address of the source
+ * @param port Expected source port
+ * @return The number of bytes received, or UDPSOCKET_ERROR_*
+ */
+s32 UdpSocket::tryRecvPacket(void *data, u32 size, in_addr_t ip, u16 port) {
+
 	struct sockaddr_in src;
 	socklen_t src_len = sizeof(src);
 
@@ -73,21 +98,22 @@ u32 UdpSocket::recvPacket(void *data, u32 size, in_addr_t ip, u16 port) {
 	FD_ZERO(&set);
 	FD_SET(this->fd, &set);
 
-	if(select(this->fd + 1, &set, NULL, NULL, &this->tv) <= 0 || !FD_ISSET(this->fd, &set)) {
-		throw std::runtime_error("Socket timeout");
+	struct timeval timeout = this->tv;		// select() may modify it
+	if(select(this->fd + 1, &set, NULL, NULL, &timeout) <= 0 || !FD_ISSET(this->fd, &set)) {
+		return UDPSOCKET_ERROR_TIMEOUT;
 	}
 
-	u32 recvSize;
+	s32 recvSize;
 	if((recvSize = recvfrom(this->fd, data, size, 0, (struct sockaddr*)&src, &src_len)) <= 0) {
-		throw std::runtime_error("recvfrom() failed");
+		return UDPSOCKET_ERROR_RECV;
 	}
 
 	if(ip != 0 && src.sin_addr.s_addr != ip) {
-		throw std::runtime_error("Source IP does not match");
+		return UDPSOCKET_ERROR_SOURCE_IP;
 	}
 
 	if(port && src.sin_port != htons(port)) {
-		throw std::runtime_error("Source port does not match");
+		return UDPSOCKET_ERROR_SOURCE_PORT;
 	}
 
 	this->lastOrigin = src.sin_addr.s_addr;
@@ -112,6 +138,15 @@ void UdpSocket::bindTo(u16 port) {
 	}
 }
 
+/**
+ * @brief Change the reception timeout
+ * @param timeoutMs Timeout, in milliseconds
+ */
+void UdpSocket::setTimeoutMs(u32 timeoutMs) {
+	this->tv.tv_sec = timeoutMs / 1000;
+	this->tv.tv_usec = (timeoutMs % 1000) * 1000;
+}
+
 /**
  * @brief Destructor for a socket
  */